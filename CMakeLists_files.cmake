@@ -38,6 +38,7 @@ list (APPEND MAIN_SOURCE_FILES
   opm/autodiff/multiPhaseUpwind.cpp
   opm/autodiff/SimulatorFullyImplicitBlackoilOutput.cpp
   opm/autodiff/SimulatorIncompTwophaseAd.cpp
+  opm/autodiff/TimerRegistry.cpp
   opm/autodiff/TransportSolverTwophaseAd.cpp
   opm/autodiff/BlackoilPropsAdFromDeck.cpp
   opm/autodiff/BlackoilModelParameters.cpp
@@ -79,9 +80,19 @@ list (APPEND MAIN_SOURCE_FILES
 # originally generated with the command:
 # find tests -name '*.cpp' -a ! -wholename '*/not-unit/*' -printf '\t%p\n' | sort
 list (APPEND TEST_SOURCE_FILES
+  tests/test_andersonacceleration.cpp
   tests/test_autodiffhelpers.cpp
   tests/test_autodiffmatrix.cpp
   tests/test_block.cpp
+  tests/test_blockcpr.cpp
+  tests/test_matrixblockkernels.cpp
+  tests/test_matrixreordering.cpp
+  tests/test_paralleloverlappingilu0.cpp
+  tests/test_interleavedmatrixbuilder.cpp
+  tests/test_linearsystemio.cpp
+  tests/test_communicationreducingsolvers.cpp
+  tests/test_timestepcontrol.cpp
+  tests/test_nonlinearsolver.cpp
   tests/test_boprops_ad.cpp
   tests/test_rateconverter.cpp
   tests/test_span.cpp
@@ -92,11 +103,16 @@ list (APPEND TEST_SOURCE_FILES
   tests/test_vfpproperties.cpp
   tests/test_singlecellsolves.cpp
   tests/test_multiphaseupwind.cpp
+  tests/test_componentnewtonsolver.cpp
   tests/test_wellmodel.cpp
   # tests/test_thresholdpressure.cpp
   tests/test_wellswitchlogger.cpp
   tests/test_timer.cpp
+  tests/test_timerregistry.cpp
+  tests/test_threadhandle.cpp
   tests/test_invert.cpp
+  tests/test_mswellhelpers.cpp
+  tests/test_standardwellhelpers.cpp
   tests/test_event.cpp
   )
 
@@ -118,6 +134,7 @@ list (APPEND EXAMPLE_SOURCE_FILES
   examples/flow_reorder.cpp
   examples/flow_sequential.cpp
   examples/flow.cpp
+  examples/replay_linear_system.cpp
   examples/sim_2p_incomp.cpp
   examples/sim_2p_incomp_ad.cpp
   examples/sim_2p_comp_reorder.cpp
@@ -142,14 +159,24 @@ list (APPEND PROGRAM_SOURCE_FILES
   examples/flow_reorder.cpp
   examples/flow_sequential.cpp
   examples/opm_init_check.cpp
+  examples/replay_linear_system.cpp
   examples/sim_poly2p_comp_reorder.cpp
   examples/sim_poly2p_incomp_reorder.cpp
   )
 
+# micro-benchmarks of the kernels of the linear solver and the well model,
+# only compiled when BUILD_BENCHMARKS is enabled
+list (APPEND BENCHMARK_SOURCE_FILES
+  benchmarks/benchmark_autodiff.cpp
+  benchmarks/benchmark_linearsolver.cpp
+  benchmarks/benchmark_wellmodel.cpp
+  )
+
 # originally generated with the command:
 # find opm -name '*.h*' -a ! -name '*-pch.hpp' -printf '\t%p\n' | sort
 list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/AdditionalObjectDeleter.hpp
+  opm/autodiff/AndersonAcceleration.hpp
   opm/autodiff/AutoDiffBlock.hpp
   opm/autodiff/AutoDiffHelpers.hpp
   opm/autodiff/AutoDiffMatrix.hpp
@@ -163,6 +190,8 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/BlackoilModelParameters.hpp
   opm/autodiff/BlackoilPressureModel.hpp
   opm/autodiff/BlackoilPropsAdFromDeck.hpp
+  opm/autodiff/BlockCPRPreconditioner.hpp
+  opm/autodiff/CommunicationReducingSolvers.hpp
   opm/autodiff/Compat.hpp
   opm/autodiff/CPRPreconditioner.hpp
   opm/autodiff/createGlobalCellArray.hpp
@@ -170,8 +199,11 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/BlackoilSequentialModel.hpp
   opm/autodiff/BlackoilReorderingTransportModel.hpp
   opm/autodiff/BlackoilTransportModel.hpp
+  opm/autodiff/ComponentNewtonSolver.hpp
   opm/autodiff/fastSparseOperations.hpp
   opm/autodiff/DebugTimeReport.hpp
+  opm/autodiff/LinearSystemIO.hpp
+  opm/autodiff/TimerRegistry.hpp
   opm/autodiff/DuneMatrix.hpp
   opm/autodiff/ExtractParallelGridInformationToISTL.hpp
   opm/autodiff/FlowMain.hpp
@@ -183,9 +215,14 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/GridInit.hpp
   opm/autodiff/ImpesTPFAAD.hpp
   opm/autodiff/ISTLSolver.hpp
+  opm/autodiff/InterleavedMatrixBuilder.hpp
   opm/autodiff/IterationReport.hpp
   opm/autodiff/moduleVersion.hpp
   opm/autodiff/multiPhaseUpwind.hpp
+  opm/autodiff/MatrixBlockKernels.hpp
+  opm/autodiff/MatrixReordering.hpp
+  opm/autodiff/ForwardingPreconditioner.hpp
+  opm/autodiff/MixedPrecisionPreconditioner.hpp
   opm/autodiff/NewtonIterationBlackoilCPR.hpp
   opm/autodiff/NewtonIterationBlackoilInterface.hpp
   opm/autodiff/NewtonIterationBlackoilInterleaved.hpp
@@ -224,6 +261,7 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/MultisegmentWell.hpp
   opm/autodiff/MultisegmentWell_impl.hpp
   opm/autodiff/MSWellHelpers.hpp
+  opm/autodiff/StandardWellHelpers.hpp
   opm/autodiff/BlackoilWellModel.hpp
   opm/autodiff/BlackoilWellModel_impl.hpp
   opm/autodiff/MissingFeatures.hpp
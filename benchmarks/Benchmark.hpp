@@ -0,0 +1,176 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_BENCHMARK_HEADER_INCLUDED
+#define OPM_BENCHMARK_HEADER_INCLUDED
+
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef OPM_BENCHMARK_DATA_DIR
+#define OPM_BENCHMARK_DATA_DIR "."
+#endif
+
+namespace Opm
+{
+namespace benchmark
+{
+    /// \brief Timings of one kernel, in seconds per call.
+    struct Result
+    {
+        std::string name;
+        int repetitions;
+        int calls;        // calls of the kernel per repetition
+        double min;
+        double median;
+        double mean;
+        double max;
+    };
+
+    /// \brief Runs the kernels of a benchmark program and writes the timings as JSON.
+    ///
+    /// The parameters common to all benchmark programs are
+    ///   output=<file>      the JSON file, the timings are written to standard output if not given
+    ///   repetitions=<n>    the number of timed repetitions of each kernel, default 10, at least 1
+    ///   data_dir=<path>    the directory of the test data, default the tests/ directory of the source tree
+    class Suite
+    {
+    public:
+        Suite(const std::string& name, int argc, char** argv)
+            : name_(name)
+            , param_(argc, argv, false, false)
+        {
+            // at least one repetition, the statistics of the timings need one
+            repetitions_ = std::max(param_.getDefault("repetitions", 10), 1);
+            output_ = param_.getDefault<std::string>("output", "");
+            dataDir_ = param_.getDefault<std::string>("data_dir", OPM_BENCHMARK_DATA_DIR);
+        }
+
+        const ParameterGroup& param() const { return param_; }
+
+        /// \brief The path of a file of the test data.
+        std::string dataFile(const std::string& file) const
+        {
+            return dataDir_ + "/" + file;
+        }
+
+        /// \brief Record a parameter of the benchmark, e.g. the size of the grid.
+        template <class T>
+        void addParameter(const std::string& name, const T& value)
+        {
+            std::ostringstream os;
+            os << value;
+            parameters_.emplace_back(name, os.str());
+        }
+
+        /// \brief Time the kernel, which performs `calls` calls of the timed operation.
+        ///
+        /// The kernel is called once before the timing to warm up the caches.
+        template <class Kernel>
+        void run(const std::string& name, Kernel&& kernel, const int calls = 1)
+        {
+            typedef std::chrono::high_resolution_clock Clock;
+
+            kernel();
+
+            std::vector<double> times(repetitions_);
+            for (double& time : times) {
+                const auto start = Clock::now();
+                kernel();
+                const std::chrono::duration<double> elapsed = Clock::now() - start;
+                time = elapsed.count() / calls;
+            }
+            std::sort(times.begin(), times.end());
+
+            Result result;
+            result.name = name;
+            result.repetitions = repetitions_;
+            result.calls = calls;
+            result.min = times.front();
+            result.median = times[times.size() / 2];
+            result.mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+            result.max = times.back();
+            results_.push_back(result);
+
+            std::cerr << std::left << std::setw(40) << name << " " << std::scientific
+                      << std::setprecision(3) << result.median << " s" << std::endl;
+        }
+
+        /// \brief Write the timings to the output file or standard output.
+        void report() const
+        {
+            if (output_.empty()) {
+                write(std::cout);
+            } else {
+                std::ofstream os(output_);
+                write(os);
+            }
+        }
+
+    private:
+        void write(std::ostream& os) const
+        {
+            os << std::setprecision(9);
+            os << "{\n  \"suite\": \"" << name_ << "\",\n  \"parameters\": {";
+            for (std::size_t i = 0; i < parameters_.size(); ++i) {
+                os << (i == 0 ? "\n" : ",\n") << "    \"" << parameters_[i].first << "\": \""
+                   << parameters_[i].second << "\"";
+            }
+            os << "\n  },\n  \"benchmarks\": [";
+            for (std::size_t i = 0; i < results_.size(); ++i) {
+                const Result& r = results_[i];
+                os << (i == 0 ? "\n" : ",\n")
+                   << "    { \"name\": \"" << r.name << "\", \"repetitions\": " << r.repetitions
+                   << ", \"calls\": " << r.calls << ", \"unit\": \"s\", \"min\": " << r.min
+                   << ", \"median\": " << r.median << ", \"mean\": " << r.mean
+                   << ", \"max\": " << r.max << " }";
+            }
+            os << "\n  ]\n}" << std::endl;
+        }
+
+        std::string name_;
+        ParameterGroup param_;
+        int repetitions_;
+        std::string output_;
+        std::string dataDir_;
+        std::vector<std::pair<std::string, std::string> > parameters_;
+        std::vector<Result> results_;
+    };
+
+    /// \brief Keep the compiler from removing the computation of a value.
+    template <class T>
+    inline void doNotOptimize(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+} // namespace benchmark
+} // namespace Opm
+
+#endif // OPM_BENCHMARK_HEADER_INCLUDED
@@ -0,0 +1,128 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Timings of the arithmetic of AutoDiffBlock with three primary variables per
+// cell and of fastSparseProduct for the products of the Jacobians of a seven
+// point stencil on a synthetic Cartesian grid of nx x ny x nz cells.
+
+#include <config.h>
+
+#include "Benchmark.hpp"
+
+#include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/fastSparseOperations.hpp>
+
+#include <Eigen/Sparse>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // seven point stencil with a dominant diagonal
+    Eigen::SparseMatrix<double> createStencil(const int nx, const int ny, const int nz)
+    {
+        const int n = nx * ny * nz;
+        std::vector<Eigen::Triplet<double> > entries;
+        entries.reserve(7 * n);
+        for (int k = 0; k < nz; ++k) {
+            for (int j = 0; j < ny; ++j) {
+                for (int i = 0; i < nx; ++i) {
+                    const int c = i + nx * (j + ny * k);
+                    entries.emplace_back(c, c, 6.5);
+                    if (i > 0)      entries.emplace_back(c, c - 1, -1.0);
+                    if (i < nx - 1) entries.emplace_back(c, c + 1, -1.0);
+                    if (j > 0)      entries.emplace_back(c, c - nx, -1.0);
+                    if (j < ny - 1) entries.emplace_back(c, c + nx, -1.0);
+                    if (k > 0)      entries.emplace_back(c, c - nx*ny, -1.0);
+                    if (k < nz - 1) entries.emplace_back(c, c + nx*ny, -1.0);
+                }
+            }
+        }
+        Eigen::SparseMatrix<double> A(n, n);
+        A.setFromTriplets(entries.begin(), entries.end());
+        return A;
+    }
+}
+
+int main(int argc, char** argv)
+try
+{
+    typedef Opm::AutoDiffBlock<double> ADB;
+
+    Opm::benchmark::Suite suite("autodiff", argc, argv);
+    const int nx = suite.param().getDefault("nx", 60);
+    const int ny = suite.param().getDefault("ny", 60);
+    const int nz = suite.param().getDefault("nz", 20);
+    const int n = nx * ny * nz;
+    suite.addParameter("cells", n);
+
+    // pressure, water and gas saturation as primary variables
+    std::vector<ADB::V> initial(3, ADB::V(n));
+    for (int c = 0; c < n; ++c) {
+        initial[0][c] = 2.0e7 + 1.0e5 * std::sin(1.0 * c);
+        initial[1][c] = 0.2 + 0.1 * std::cos(1.0 * c);
+        initial[2][c] = 0.1 + 0.05 * std::sin(2.0 * c);
+    }
+    const std::vector<ADB> vars = ADB::variables(initial);
+    const ADB& p = vars[0];
+    const ADB& sw = vars[1];
+    const ADB& sg = vars[2];
+
+    suite.run("adb_add", [&]() {
+            const ADB result = p + sw + sg;
+            Opm::benchmark::doNotOptimize(result);
+        });
+    suite.run("adb_mult", [&]() {
+            const ADB result = p * sw * sg;
+            Opm::benchmark::doNotOptimize(result);
+        });
+    suite.run("adb_div", [&]() {
+            const ADB result = sw / p;
+            Opm::benchmark::doNotOptimize(result);
+        });
+    const ADB::V one = ADB::V::Ones(n);
+    suite.run("adb_expression", [&]() {
+            // a mass density like expression of the saturations and the pressure
+            const ADB so = one - sw - sg;
+            const ADB result = so * (one + 1.0e-9 * p) + sw * sw / (one + sg);
+            Opm::benchmark::doNotOptimize(result);
+        });
+
+    const Eigen::SparseMatrix<double> A = createStencil(nx, ny, nz);
+    suite.addParameter("nonzeroes", A.nonZeros());
+    Eigen::SparseMatrix<double> AA;
+    suite.run("fastsparseproduct", [&]() {
+            Opm::fastSparseProduct(A, A, AA);
+            Opm::benchmark::doNotOptimize(AA);
+        });
+    suite.run("eigen_sparseproduct", [&]() {
+            AA = A * A;
+            Opm::benchmark::doNotOptimize(AA);
+        });
+
+    suite.report();
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
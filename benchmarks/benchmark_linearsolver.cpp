@@ -0,0 +1,240 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Timings of the kernels of the linear solver for a seven point stencil with
+// blocks of 3x3 on a synthetic Cartesian grid of nx x ny x nz cells:
+// the setup and application of ParallelOverlappingILU0 and the application of
+// WellModelMatrixAdapter with a vertical well in every well_spacing-th column.
+
+#include <config.h>
+
+#include "Benchmark.hpp"
+
+#include <opm/autodiff/BlackoilModelEbos.hpp>
+#include <opm/autodiff/MatrixBlockKernels.hpp>
+#include <opm/autodiff/MatrixReordering.hpp>
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/paamg/pinfo.hh>
+
+#include <cmath>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    const int numEq = 3;
+
+    typedef Dune::FieldMatrix<double, numEq, numEq> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, numEq> > Vector;
+
+    // seven point stencil with diagonally dominant blocks
+    Matrix createMatrix(const int nx, const int ny, const int nz)
+    {
+        const int n = nx * ny * nz;
+        Matrix A(n, n, 7*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int c = row.index();
+            const int i = c % nx;
+            const int j = (c / nx) % ny;
+            const int k = c / (nx * ny);
+            if (k > 0)      row.insert(c - nx*ny);
+            if (j > 0)      row.insert(c - nx);
+            if (i > 0)      row.insert(c - 1);
+            row.insert(c);
+            if (i < nx - 1) row.insert(c + 1);
+            if (j < ny - 1) row.insert(c + nx);
+            if (k < nz - 1) row.insert(c + nx*ny);
+        }
+
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                const bool diagonal = col.index() == row.index();
+                for (int p = 0; p < numEq; ++p) {
+                    for (int q = 0; q < numEq; ++q) {
+                        const double value = 0.1 * std::sin(1.0 + row.index() + 3*p + q);
+                        (*col)[p][q] = (p == q) ? (diagonal ? 8.0 : -1.0) : value;
+                    }
+                }
+            }
+        }
+        return A;
+    }
+
+    // The well model part of the operator with the structure of StandardWell,
+    // one well equation coupled to the cells of a vertical column of perforations.
+    class SyntheticWellModel
+    {
+    public:
+        typedef Dune::FieldMatrix<double, 1, numEq> OffDiagBlock;
+        typedef Dune::BCRSMatrix<OffDiagBlock> OffDiagMatrix;
+        typedef Dune::BlockVector<Dune::FieldVector<double, 1> > WellVector;
+
+        SyntheticWellModel(const int nx, const int ny, const int nz, const int spacing)
+        {
+            for (int j = 0; j < ny; j += spacing) {
+                for (int i = 0; i < nx; i += spacing) {
+                    std::vector<int> cells;
+                    for (int k = 0; k < nz; ++k) {
+                        cells.push_back(i + nx * (j + ny * k));
+                    }
+                    addWell(cells, nx * ny * nz);
+                }
+            }
+        }
+
+        std::size_t numWells() const { return wells_.size(); }
+
+        void apply(const Vector& x, Vector& Ax) const
+        {
+            for (const auto& well : wells_) {
+                well.B.mv(x, well.Bx);
+                well.invDBx[0] = well.invD * well.Bx[0];
+                well.C.mmtv(well.invDBx, Ax);
+            }
+        }
+
+        void applyScaleAdd(const double alpha, const Vector& x, Vector& Ax) const
+        {
+            scaleAddRes_.resize(Ax.size());
+            scaleAddRes_ = 0.0;
+            apply(x, scaleAddRes_);
+            Ax.axpy(alpha, scaleAddRes_);
+        }
+
+    private:
+        struct Well
+        {
+            OffDiagMatrix B;
+            OffDiagMatrix C;
+            double invD;
+            mutable WellVector Bx;
+            mutable WellVector invDBx;
+        };
+
+        void addWell(const std::vector<int>& cells, const int numCells)
+        {
+            Well well;
+            for (OffDiagMatrix* M : { &well.B, &well.C }) {
+                M->setBuildMode(OffDiagMatrix::row_wise);
+                M->setSize(1, numCells, cells.size());
+                for (auto row = M->createbegin(); row != M->createend(); ++row) {
+                    for (const int cell : cells) {
+                        row.insert(cell);
+                    }
+                }
+                for (const int cell : cells) {
+                    for (int q = 0; q < numEq; ++q) {
+                        (*M)[0][cell][0][q] = 1.0e-3 * (q + 1);
+                    }
+                }
+            }
+            well.invD = 1.0 / (1.0 + cells.size());
+            well.Bx.resize(1);
+            well.invDBx.resize(1);
+            wells_.push_back(well);
+        }
+
+        std::vector<Well> wells_;
+        mutable Vector scaleAddRes_;
+    };
+
+    template <class ILU>
+    void benchmarkILU(Opm::benchmark::Suite& suite, const std::string& name, const Matrix& A,
+                      const std::vector<std::size_t>& ordering)
+    {
+        suite.run(name + "_setup", [&]() {
+                ILU ilu(A, 0, 1.0, ordering);
+                Opm::benchmark::doNotOptimize(ilu);
+            });
+
+        ILU ilu(A, 0, 1.0, ordering);
+        Vector v(A.N()), d(A.N());
+        d = 1.0;
+        suite.run(name + "_apply", [&]() {
+                ilu.apply(v, d);
+                Opm::benchmark::doNotOptimize(v);
+            });
+    }
+}
+
+int main(int argc, char** argv)
+try
+{
+    Opm::benchmark::Suite suite("linearsolver", argc, argv);
+    const int nx = suite.param().getDefault("nx", 60);
+    const int ny = suite.param().getDefault("ny", 60);
+    const int nz = suite.param().getDefault("nz", 20);
+    const int spacing = suite.param().getDefault("well_spacing", 10);
+    suite.addParameter("cells", nx * ny * nz);
+    suite.addParameter("block_size", numEq);
+
+    const Matrix A = createMatrix(nx, ny, nz);
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector, Dune::Amg::SequentialInformation, float> FloatILU;
+    benchmarkILU<ILU>(suite, "ilu0", A, std::vector<std::size_t>());
+    benchmarkILU<FloatILU>(suite, "ilu0_float", A, std::vector<std::size_t>());
+    suite.run("rcm_ordering", [&]() {
+            const auto ordering = Opm::reverseCuthillMcKee(A);
+            Opm::benchmark::doNotOptimize(ordering);
+        });
+    benchmarkILU<ILU>(suite, "ilu0_rcm", A, Opm::reverseCuthillMcKee(A));
+
+    Vector x(A.N()), y(A.N());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        x[i] = std::cos(1.0 * i);
+    }
+    suite.run("bcrs_mv", [&]() {
+            A.mv(x, y);
+            Opm::benchmark::doNotOptimize(y);
+        });
+    suite.run("bcrs_mv_blockkernels", [&]() {
+            Opm::blockkernels::bcrsMv(A, x, y);
+            Opm::benchmark::doNotOptimize(y);
+        });
+
+    typedef Opm::BlackoilModelEbos<TTAG(EclFlowProblem)> Model;
+    typedef Model::WellModelMatrixAdapter<Matrix, Vector, Vector, SyntheticWellModel, false> Operator;
+    const SyntheticWellModel wellModel(nx, ny, nz, spacing);
+    suite.addParameter("wells", wellModel.numWells());
+    const Operator op(A, wellModel);
+    suite.run("wellmodelmatrixadapter_apply", [&]() {
+            op.apply(x, y);
+            Opm::benchmark::doNotOptimize(y);
+        });
+    suite.run("wellmodelmatrixadapter_applyscaleadd", [&]() {
+            op.applyscaleadd(-1.0, x, y);
+            Opm::benchmark::doNotOptimize(y);
+        });
+
+    suite.report();
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Timings of the kernels of the well model evaluated once per well: the
+// interpolation of bhp and thp in the production table of tests/VFPPROD1, for
+// `wells` rate combinations spread over the table, and the coefficients of the
+// conversion of surface rates to reservoir voidage rates for tests/fluid.data.
+
+#include <config.h>
+
+#include "Benchmark.hpp"
+
+#include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
+#include <opm/autodiff/RateConverter.hpp>
+#include <opm/autodiff/VFPProdProperties.hpp>
+#include <opm/autodiff/VFPHelpers.hpp>
+
+#include <opm/core/grid/GridHelpers.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/simulator/BlackoilState.hpp>
+
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/Tables/VFPProdTable.hpp>
+#include <opm/parser/eclipse/Units/UnitSystem.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char** argv)
+try
+{
+    Opm::benchmark::Suite suite("wellmodel", argc, argv);
+    const int num_wells = suite.param().getDefault("wells", 10000);
+    suite.addParameter("wells", num_wells);
+
+    Opm::Parser parser;
+    Opm::ParseContext parse_context;
+    const Opm::Deck deck = parser.parseFile(suite.dataFile("VFPPROD1"), parse_context);
+    Opm::VFPProdTable table;
+    table.init(deck.getKeyword("VFPPROD", 0), Opm::UnitSystem::newMETRIC());
+    const Opm::VFPProdProperties properties(&table);
+    const int table_id = table.getTableNum();
+
+    // liquid rates from 100 to 20000 SM3/day, water cuts from 0 to 1,
+    // GORs from 90 to 10000 and THPs from 16 to 61 barsa, in SI units
+    std::vector<int> table_ids(num_wells, table_id);
+    std::vector<double> aqua(num_wells), liquid(num_wells), vapour(num_wells);
+    std::vector<double> thp(num_wells), alq(num_wells, 0.0), bhp(num_wells);
+    for (int w = 0; w < num_wells; ++w) {
+        const double s = (w + 0.5) / num_wells;
+        const double liq = -(100.0 + 19900.0 * s) / 86400.0;
+        const double wct = (w % 11) / 10.0;
+        const double gor = 90.0 + 9910.0 * ((w * 7) % 13) / 12.0;
+        aqua[w] = wct * liq;
+        liquid[w] = liq - aqua[w];
+        vapour[w] = gor * liquid[w];
+        thp[w] = (16.0 + 45.0 * ((w * 3) % 17) / 16.0) * 1.0e5;
+    }
+
+    suite.run("bhp", [&]() {
+            for (int w = 0; w < num_wells; ++w) {
+                bhp[w] = properties.bhp(table_id, aqua[w], liquid[w], vapour[w], thp[w], alq[w]);
+            }
+            Opm::benchmark::doNotOptimize(bhp);
+        }, num_wells);
+
+    std::vector<Opm::detail::VFPInterpHint> hints(num_wells);
+    suite.run("bhp_hint", [&]() {
+            for (int w = 0; w < num_wells; ++w) {
+                bhp[w] = properties.bhp(table_id, aqua[w], liquid[w], vapour[w], thp[w], alq[w], hints[w]);
+            }
+            Opm::benchmark::doNotOptimize(bhp);
+        }, num_wells);
+
+    std::vector<Opm::detail::VFPEvaluation> evaluations;
+    suite.run("bhp_wells", [&]() {
+            properties.bhp(table_ids, aqua, liquid, vapour, thp, alq, hints, evaluations);
+            Opm::benchmark::doNotOptimize(evaluations);
+        }, num_wells);
+
+    std::vector<double> thp_back(num_wells);
+    suite.run("thp", [&]() {
+            for (int w = 0; w < num_wells; ++w) {
+                thp_back[w] = properties.thp(table_id, aqua[w], liquid[w], vapour[w], bhp[w], alq[w]);
+            }
+            Opm::benchmark::doNotOptimize(thp_back);
+        }, num_wells);
+
+    suite.run("thp_wells", [&]() {
+            properties.thp(table_ids, aqua, liquid, vapour, bhp, alq, hints, thp_back);
+            Opm::benchmark::doNotOptimize(thp_back);
+        }, num_wells);
+
+    {
+        typedef std::vector<int> Region;
+        typedef Opm::RateConverter::
+            SurfaceToReservoirVoidage<Opm::BlackoilPropsAdFromDeck::FluidSystem, Region> RateConverterType;
+
+        const Opm::Deck fluid_deck = parser.parseFile(suite.dataFile("fluid.data"), parse_context);
+        const Opm::EclipseState ecl_state(fluid_deck, parse_context);
+        const Opm::GridManager grid(ecl_state.getInputGrid());
+        const Opm::BlackoilPropsAdFromDeck props(fluid_deck, ecl_state, *grid.c_grid(), false);
+        const int num_cells = Opm::UgGridHelpers::numCells(*grid.c_grid());
+
+        RateConverterType rate_converter(props.phaseUsage(), Region(num_cells, 0));
+        const Opm::BlackoilState state(num_cells, Opm::UgGridHelpers::numFaces(*grid.c_grid()), 3);
+        rate_converter.defineState(state);
+
+        std::vector<double> coeff(3 * num_wells, 0.0);
+        suite.run("rateconverter_calccoeff", [&]() {
+                for (int w = 0; w < num_wells; ++w) {
+                    double* well_coeff = &coeff[3 * w];
+                    rate_converter.calcCoeff(0, 0, well_coeff);
+                }
+                Opm::benchmark::doNotOptimize(coeff);
+            }, num_wells);
+    }
+
+    suite.report();
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Solve the linear systems written by flow with linear_system_capture_dir=<dir>
+// again with the linear solver of flow, e.g. to tune its parameters:
+//
+//   replay_linear_system linear_solver_use_cpr=true ilu_fillin_level=1 <dir>/linear_system_*.bin
+//
+// All parameters of the linear solver of flow are accepted. The systems are
+// solved in the order of the simulation, such that preconditioners are kept
+// as in the run with preconditioner_reuse. Further parameters are
+//   repetitions=<n>    solve each system n times and report the fastest solve, default 1
+//   use_timers=true    report the time of the preconditioner setup and application
+
+#include <config.h>
+
+// Define making clear that the replay supports AMG like flow
+#define FLOW_SUPPORT_AMG 1
+
+#include <opm/autodiff/ISTLSolver.hpp>
+#include <opm/autodiff/LinearSystemIO.hpp>
+#include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
+#include <opm/autodiff/TimerRegistry.hpp>
+#include <opm/common/Exceptions.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/timer.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    struct CapturedFile
+    {
+        std::string name;
+        Opm::LinearSystemInfo info;
+    };
+
+    template <int numEq>
+    void replay(const Opm::ParameterGroup& param, const std::vector<CapturedFile>& files, const int repetitions)
+    {
+        typedef Dune::FieldMatrix<double, numEq, numEq> MatrixBlockType;
+        typedef Dune::FieldVector<double, numEq> VectorBlockType;
+        typedef Dune::BCRSMatrix<MatrixBlockType> Matrix;
+        typedef Dune::BlockVector<VectorBlockType> Vector;
+        typedef Opm::LinearSystemOperator<Matrix, Vector, Vector> Operator;
+
+        const Opm::NewtonIterationBlackoilInterleavedParameters parameters(param);
+        Opm::ISTLSolver<MatrixBlockType, VectorBlockType> solver(parameters);
+
+        std::cout << std::left << std::setw(40) << "System" << std::right
+                  << std::setw(10) << "rows" << std::setw(7) << "wells"
+                  << std::setw(8) << "iter" << std::setw(12) << "time [s]"
+                  << std::setw(14) << "reduction" << "\n";
+
+        int totalIterations = 0;
+        double totalTime = 0.0;
+        int failures = 0;
+        int lastReportStep = -1;
+        int lastSubStep = -1;
+        for (const CapturedFile& file : files) {
+            Matrix A;
+            Vector b;
+            std::vector<Opm::LinearSystemWell> wells;
+            Opm::readLinearSystem(file.name, A, b, wells);
+            Operator opA(A, wells);
+
+            // the preconditioner is kept within a time step only, as in the simulation
+            if (file.info.reportStep != lastReportStep || file.info.subStep != lastSubStep) {
+                solver.beginTimeStep();
+                lastReportStep = file.info.reportStep;
+                lastSubStep = file.info.subStep;
+            }
+
+            double time = std::numeric_limits<double>::max();
+            bool converged = true;
+            Vector x(b.size());
+            for (int rep = 0; rep < repetitions; ++rep) {
+                Vector rhs(b);
+                x = 0.0;
+                Dune::Timer timer;
+                try {
+                    solver.solve(opA, x, rhs);
+                }
+                catch (const Opm::LinearSolverProblem&) {
+                    converged = false;
+                }
+                time = std::min(time, timer.elapsed());
+            }
+
+            // the reduction of the residual of the full system with the wells eliminated
+            Vector residual(b);
+            opA.applyscaleadd(-1.0, x, residual);
+            const double reduction = residual.two_norm() / std::max(b.two_norm(), std::numeric_limits<double>::min());
+
+            std::cout << std::left << std::setw(40) << file.name.substr(file.name.rfind('/') + 1) << std::right
+                      << std::setw(10) << A.N() << std::setw(7) << wells.size()
+                      << std::setw(8) << solver.iterations() << std::fixed << std::setprecision(4)
+                      << std::setw(12) << time << std::scientific << std::setprecision(2)
+                      << std::setw(14) << reduction << (converged ? "" : "  not converged") << "\n";
+            std::cout.unsetf(std::ios_base::floatfield);
+
+            totalIterations += solver.iterations();
+            totalTime += time;
+            failures += converged ? 0 : 1;
+        }
+
+        std::cout << "\nSystems: " << files.size() << "  linear iterations: " << totalIterations
+                  << "  solve time: " << std::fixed << std::setprecision(4) << totalTime << " s"
+                  << "  not converged: " << failures << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+try
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    Opm::ParameterGroup param(argc, argv, false, false);
+    if (param.unhandledArguments().empty()) {
+        std::cerr << "Usage: " << argv[0] << " [linear solver parameters] <linear system files>\n";
+        return EXIT_FAILURE;
+    }
+    const int repetitions = std::max(param.getDefault("repetitions", 1), 1);
+    if (param.getDefault("use_timers", false)) {
+        Opm::TimerRegistry::instance().enable();
+    }
+
+    // replay in the order of the simulation
+    std::vector<CapturedFile> files;
+    for (const std::string& name : param.unhandledArguments()) {
+        files.push_back(CapturedFile{ name, Opm::readLinearSystemInfo(name) });
+    }
+    std::stable_sort(files.begin(), files.end(), [](const CapturedFile& a, const CapturedFile& b) {
+            return std::make_tuple(a.info.reportStep, a.info.subStep, a.info.iteration)
+                < std::make_tuple(b.info.reportStep, b.info.subStep, b.info.iteration);
+        });
+
+    const int blockSize = files.front().info.blockSize;
+    for (const CapturedFile& file : files) {
+        if (file.info.blockSize != blockSize) {
+            OPM_THROW(std::runtime_error, "The linear systems have different block sizes");
+        }
+    }
+
+    switch (blockSize) {
+    case 2:
+        replay<2>(param, files, repetitions);
+        break;
+    case 3:
+        replay<3>(param, files, repetitions);
+        break;
+    case 4:
+        replay<4>(param, files, repetitions);
+        break;
+    default:
+        OPM_THROW(std::runtime_error, "Linear systems with blocks of size " << blockSize << " are not supported");
+    }
+
+    if (Opm::TimerRegistry::instance().enabled()) {
+        std::cout << "\n";
+        Opm::TimerRegistry::instance().report(std::cout);
+    }
+
+    if (param.anyUnused()) {
+        std::cout << "--------------------   Unused parameters:   --------------------\n";
+        param.displayUsage();
+        std::cout << "----------------------------------------------------------------" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,210 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_ANDERSONACCELERATION_HEADER_INCLUDED
+#define OPM_ANDERSONACCELERATION_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Anderson acceleration of the nonlinear updates of Newton's method.
+    ///
+    /// The Newton iteration is regarded as the fixed point iteration
+    /// x_{k+1} = x_k - f_k, where f_k is the Newton update. The accelerated
+    /// update is the combination of the last updates which minimizes the
+    /// linearized update, i.e.
+    ///
+    ///     s_k = f_k - sum_j gamma_j (dS_j + dF_j),
+    ///     gamma = argmin || f_k - sum_j gamma_j dF_j ||,
+    ///
+    /// with the differences dF_j of consecutive updates and the applied
+    /// updates dS_j of the previous iterations. These are kept in a ring
+    /// buffer of the given depth, the vectors are allocated once and reused.
+    ///
+    /// \tparam Vector  The vector type of the updates, e.g. a Dune::BlockVector.
+    template <class Vector>
+    class AndersonAcceleration
+    {
+    public:
+        /// Construct with the number of previous updates used.
+        explicit AndersonAcceleration(const int depth)
+            : depth_(std::max(depth, 0))
+            , dF_(depth_)
+            , dS_(depth_)
+            , numPairs_(0)
+            , next_(0)
+            , hasPrevious_(false)
+        {
+        }
+
+        /// The number of previous updates used.
+        int depth() const { return depth_; }
+
+        /// The number of previous updates currently stored.
+        int size() const { return numPairs_; }
+
+        /// Forget all previous updates, e.g. at the beginning of a time step
+        /// or after the update has been modified otherwise.
+        void reset()
+        {
+            numPairs_ = 0;
+            next_ = 0;
+            hasPrevious_ = false;
+        }
+
+        /// Replace a Newton update by the accelerated update.
+        /// \param[in, out] dx            Newton update on input, accelerated update on output.
+        /// \param[in]      innerProduct  Object providing dot(a, b) for two vectors. In
+        ///                               parallel runs this has to be the global inner product.
+        template <class InnerProduct>
+        void apply(Vector& dx, const InnerProduct& innerProduct)
+        {
+            if (depth_ == 0) {
+                return;
+            }
+
+            // store the pair of the last iteration, overwriting the oldest one
+            if (hasPrevious_) {
+                dF_[next_] = dx;
+                dF_[next_] -= fPrevious_;
+                dS_[next_] = sPrevious_;
+                next_ = (next_ + 1) % depth_;
+                numPairs_ = std::min(numPairs_ + 1, depth_);
+            }
+            fPrevious_ = dx;
+
+            if (numPairs_ > 0) {
+                std::vector<double> gamma;
+                if (solveLeastSquares(dx, innerProduct, gamma)) {
+                    for (int j = 0; j < numPairs_; ++j) {
+                        dx.axpy(-gamma[j], dS_[j]);
+                        dx.axpy(-gamma[j], dF_[j]);
+                    }
+                }
+                else {
+                    // keep the Newton update and start over
+                    reset();
+                    fPrevious_ = dx;
+                }
+            }
+
+            sPrevious_ = dx;
+            hasPrevious_ = true;
+        }
+
+        /// Replace the update stored by the last apply() with the update actually
+        /// applied, when the accelerated update has been relaxed or chopped before
+        /// it was added to the solution.
+        /// \param[in] dx  Applied update, with the same sign convention as in apply().
+        void setAppliedUpdate(const Vector& dx)
+        {
+            if (hasPrevious_) {
+                sPrevious_ = dx;
+            }
+        }
+
+    protected:
+        /// Solve the normal equations of the least squares problem for gamma.
+        /// \return false if the problem is (numerically) singular.
+        template <class InnerProduct>
+        bool solveLeastSquares(const Vector& f, const InnerProduct& innerProduct,
+                               std::vector<double>& gamma) const
+        {
+            const int m = numPairs_;
+            // augmented matrix [ dF^T dF | dF^T f ]
+            std::vector<double> a(m * (m + 1));
+            double trace = 0.0;
+            for (int i = 0; i < m; ++i) {
+                for (int j = 0; j <= i; ++j) {
+                    const double value = innerProduct.dot(dF_[i], dF_[j]);
+                    a[i * (m + 1) + j] = value;
+                    a[j * (m + 1) + i] = value;
+                }
+                a[i * (m + 1) + m] = innerProduct.dot(dF_[i], f);
+                trace += a[i * (m + 1) + i];
+            }
+            if (!(trace > 0.0) || !std::isfinite(trace)) {
+                return false;
+            }
+
+            // Tikhonov regularization against nearly parallel differences
+            const double regularization = 1e-10 * trace;
+            for (int i = 0; i < m; ++i) {
+                a[i * (m + 1) + i] += regularization;
+            }
+
+            // Gaussian elimination with partial pivoting
+            for (int k = 0; k < m; ++k) {
+                int pivot = k;
+                for (int i = k + 1; i < m; ++i) {
+                    if (std::abs(a[i * (m + 1) + k]) > std::abs(a[pivot * (m + 1) + k])) {
+                        pivot = i;
+                    }
+                }
+                if (std::abs(a[pivot * (m + 1) + k]) <= 1e-14 * trace) {
+                    return false;
+                }
+                if (pivot != k) {
+                    for (int j = k; j <= m; ++j) {
+                        std::swap(a[k * (m + 1) + j], a[pivot * (m + 1) + j]);
+                    }
+                }
+                for (int i = k + 1; i < m; ++i) {
+                    const double factor = a[i * (m + 1) + k] / a[k * (m + 1) + k];
+                    for (int j = k; j <= m; ++j) {
+                        a[i * (m + 1) + j] -= factor * a[k * (m + 1) + j];
+                    }
+                }
+            }
+
+            gamma.assign(m, 0.0);
+            for (int i = m - 1; i >= 0; --i) {
+                double value = a[i * (m + 1) + m];
+                for (int j = i + 1; j < m; ++j) {
+                    value -= a[i * (m + 1) + j] * gamma[j];
+                }
+                gamma[i] = value / a[i * (m + 1) + i];
+                if (!std::isfinite(gamma[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        const int depth_;
+        // differences of consecutive Newton updates and the applied updates
+        std::vector<Vector> dF_;
+        std::vector<Vector> dS_;
+        int numPairs_;
+        // position of the next pair to be overwritten
+        int next_;
+        // Newton update and applied update of the last iteration
+        Vector fPrevious_;
+        Vector sPrevious_;
+        bool hasPrevious_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_ANDERSONACCELERATION_HEADER_INCLUDED
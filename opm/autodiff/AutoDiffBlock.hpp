@@ -338,26 +338,14 @@ namespace Opm
             int num_blocks = numBlocks();
             std::vector<M> jac(num_blocks);
             assert(numBlocks() == rhs.numBlocks());
-            M D1(val_.matrix().asDiagonal());
-            M D2(rhs.val_.matrix().asDiagonal());
+            // d(u*v) = v*du + u*dv
 #if HAVE_OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif // HAVE_OPENMP
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac_[block].rows() == rhs.jac_[block].rows());
                 assert(jac_[block].cols() == rhs.jac_[block].cols());
-                if( jac_[block].nonZeros() == 0 && rhs.jac_[block].nonZeros() == 0 ) {
-                    jac[block] = M( D2.rows(), jac_[block].cols() );
-                }
-                else if( jac_[block].nonZeros() == 0 )
-                    jac[block] = D1*rhs.jac_[block];
-                else if ( rhs.jac_[block].nonZeros() == 0 ) {
-                    jac[block] = D2*jac_[block];
-                }
-                else {
-                    jac[block]  = D2*jac_[block];
-                    jac[block] += D1*rhs.jac_[block];
-                }
+                M::diagProductSum(rhs.val_.data(), jac_[block], val_.data(), rhs.jac_[block], jac[block]);
             }
             return function(val_ * rhs.val_, std::move(jac));
         }
@@ -377,28 +365,16 @@ namespace Opm
             int num_blocks = numBlocks();
             std::vector<M> jac(num_blocks);
             assert(numBlocks() == rhs.numBlocks());
-            M D1(val_.matrix().asDiagonal());
-            M D2(rhs.val_.matrix().asDiagonal());
-            M D3((1.0/(rhs.val_*rhs.val_)).matrix().asDiagonal());
+            // d(u/v) = (1/v)*du - (u/v^2)*dv
+            const V inv_rhs = 1.0 / rhs.val_;
+            const V dquot_drhs = -val_ * inv_rhs * inv_rhs;
 #if HAVE_OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif // HAVE_OPENMP
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac_[block].rows() == rhs.jac_[block].rows());
                 assert(jac_[block].cols() == rhs.jac_[block].cols());
-                if( jac_[block].nonZeros() == 0 && rhs.jac_[block].nonZeros() == 0 ) {
-                    jac[block] = M( D3.rows(), jac_[block].cols() );
-                }
-                else if( jac_[block].nonZeros() == 0 ) {
-                    jac[block] =  D3 * ( D1*rhs.jac_[block]) * (-1.0);
-                }
-                else if ( rhs.jac_[block].nonZeros() == 0 )
-                {
-                    jac[block] = D3 * (D2*jac_[block]);
-                }
-                else {
-                    jac[block] = D3 * (D2*jac_[block] + (D1*rhs.jac_[block]*(-1.0)));
-                }
+                M::diagProductSum(inv_rhs.data(), jac_[block], dquot_drhs.data(), rhs.jac_[block], jac[block]);
             }
             return function(val_ / rhs.val_, std::move(jac));
         }
@@ -539,7 +515,16 @@ namespace Opm
     AutoDiffBlock<Scalar> operator*(const typename AutoDiffBlock<Scalar>::V& lhs,
                                     const AutoDiffBlock<Scalar>& rhs)
     {
-        return AutoDiffBlock<Scalar>::constant(lhs, rhs.blockPattern()) * rhs;
+        // Scale the rows of the jacobians directly instead of going
+        // through the product with a constant of zero jacobians.
+        assert(lhs.size() == rhs.size());
+        const int num_blocks = rhs.numBlocks();
+        std::vector<typename AutoDiffBlock<Scalar>::M> jac(num_blocks);
+        for (int block = 0; block < num_blocks; ++block) {
+            jac[block] = AutoDiffBlock<Scalar>::M::diagProduct(lhs.data(), rhs.derivative()[block]);
+        }
+        typename AutoDiffBlock<Scalar>::V val = lhs * rhs.value();
+        return AutoDiffBlock<Scalar>::function(std::move(val), std::move(jac));
     }
 
 
@@ -602,7 +587,14 @@ namespace Opm
     AutoDiffBlock<Scalar> operator/(const AutoDiffBlock<Scalar>& lhs,
                                     const typename AutoDiffBlock<Scalar>::V& rhs)
     {
-        return lhs / AutoDiffBlock<Scalar>::constant(rhs, lhs.blockPattern());
+        const typename AutoDiffBlock<Scalar>::V inv_rhs = 1.0 / rhs;
+        const int num_blocks = lhs.numBlocks();
+        std::vector<typename AutoDiffBlock<Scalar>::M> jac(num_blocks);
+        for (int block = 0; block < num_blocks; ++block) {
+            jac[block] = AutoDiffBlock<Scalar>::M::diagProduct(inv_rhs.data(), lhs.derivative()[block]);
+        }
+        typename AutoDiffBlock<Scalar>::V val = lhs.value() / rhs;
+        return AutoDiffBlock<Scalar>::function(std::move(val), std::move(jac));
     }
 
 
@@ -654,11 +646,10 @@ namespace Opm
     {
         const typename AutoDiffBlock<Scalar>::V val = base.value().pow(exponent);
         const typename AutoDiffBlock<Scalar>::V derivative = exponent * base.value().pow(exponent - 1.0);
-        const typename AutoDiffBlock<Scalar>::M derivative_diag(derivative.matrix().asDiagonal());
 
         std::vector< typename AutoDiffBlock<Scalar>::M > jac (base.numBlocks());
         for (int block = 0; block < base.numBlocks(); block++) {
-             fastSparseProduct(derivative_diag, base.derivative()[block], jac[block]);
+             jac[block] = AutoDiffBlock<Scalar>::M::diagProduct(derivative.data(), base.derivative()[block]);
         }
 
         return AutoDiffBlock<Scalar>::function( std::move(val), std::move(jac) );
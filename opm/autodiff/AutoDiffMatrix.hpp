@@ -29,12 +29,131 @@
 
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/autodiff/fastSparseOperations.hpp>
+#include <mutex>
 #include <vector>
 
 
 namespace Opm
 {
 
+    /**
+     * SparseStorageArena recycles the memory of sparse AutoDiffMatrix objects.
+     * While an arena is active (see SparseStorageArena::Scope), the storage of
+     * sparse matrices is handed to the arena when they are destroyed, and new
+     * sparse results are built in recycled storage of matching size. Repeated
+     * assemblies of equations with the same structure, such as the Newton
+     * iterations of a time step, then mostly run without allocating values
+     * and sparsity patterns.
+     */
+    class SparseStorageArena
+    {
+    public:
+        typedef Eigen::SparseMatrix<double> SparseRep;
+
+        /**
+         * Creates an arena keeping at most max_stored matrices.
+         */
+        explicit SparseStorageArena(const int max_stored = 256)
+            : max_stored_(max_stored)
+        {
+            free_.reserve(max_stored_);
+        }
+
+        /**
+         * Activates an arena for the lifetime of the scope object.
+         */
+        class Scope
+        {
+        public:
+            explicit Scope(SparseStorageArena& arena)
+                : previous_(active())
+            {
+                active() = &arena;
+            }
+
+            ~Scope()
+            {
+                active() = previous_;
+            }
+
+        private:
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            SparseStorageArena* previous_;
+        };
+
+        /**
+         * Replaces the storage of s by recycled storage of the active arena
+         * which is suitable for outer_size columns and nnz non-zeros.
+         * Does nothing if no arena is active.
+         */
+        static void acquire(SparseRep& s, const int outer_size, const int nnz)
+        {
+            SparseStorageArena* arena = active();
+            if (arena != nullptr) {
+                arena->take(s, outer_size, nnz);
+            }
+        }
+
+        /**
+         * Hands the storage of s to the active arena, leaving s empty.
+         * Does nothing if no arena is active.
+         */
+        static void release(SparseRep& s)
+        {
+            SparseStorageArena* arena = active();
+            if (arena != nullptr && s.data().allocatedSize() > 0) {
+                arena->put(s);
+            }
+        }
+
+        /**
+         * Returns the number of matrices currently kept by the arena.
+         */
+        int numStored() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return free_.size();
+        }
+
+    private:
+        static SparseStorageArena*& active()
+        {
+            static SparseStorageArena* arena = nullptr;
+            return arena;
+        }
+
+        void take(SparseRep& s, const int outer_size, const int nnz)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // Search the most recently released matrices first, they are
+            // the most likely to match the current sequence of operations.
+            for (int i = free_.size() - 1; i >= 0; --i) {
+                if (free_[i].outerSize() == outer_size && free_[i].data().allocatedSize() >= nnz) {
+                    s.swap(free_[i]);
+                    free_[i].swap(free_.back());
+                    free_.pop_back();
+                    return;
+                }
+            }
+        }
+
+        void put(SparseRep& s)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (static_cast<int>(free_.size()) < max_stored_) {
+                free_.emplace_back();
+                free_.back().swap(s);
+            }
+        }
+
+        const int max_stored_;
+        std::vector<SparseRep> free_;
+        mutable std::mutex mutex_;
+    };
+
+
     /**
      * AutoDiffMatrix is a wrapper class that optimizes matrix operations.
      * Internally, an AutoDiffMatrix can be either Zero, Identity, Diagonal,
@@ -114,7 +233,19 @@ namespace Opm
 
 
 
-        AutoDiffMatrix(const AutoDiffMatrix& other) = default;
+        AutoDiffMatrix(const AutoDiffMatrix& other)
+            : type_(other.type_),
+              rows_(other.rows_),
+              cols_(other.cols_),
+              diag_(other.diag_),
+              sparse_()
+        {
+            if (type_ == Sparse) {
+                SparseStorageArena::acquire(sparse_, other.sparse_.outerSize(), other.sparse_.nonZeros());
+                sparse_ = other.sparse_;
+            }
+        }
+
         AutoDiffMatrix& operator=(const AutoDiffMatrix& other) = default;
 
 
@@ -139,6 +270,13 @@ namespace Opm
 
 
 
+        ~AutoDiffMatrix()
+        {
+            SparseStorageArena::release(sparse_);
+        }
+
+
+
         void swap(AutoDiffMatrix& other)
         {
             std::swap(type_, other.type_);
@@ -407,6 +545,107 @@ namespace Opm
 
 
 
+        /**
+         * Multiplies an AutoDiffMatrix with the diagonal matrix diag(d) from
+         * the left, i.e. scales row r by d[r], without forming the diagonal
+         * matrix.
+         */
+        static AutoDiffMatrix diagProduct(const double* d, const AutoDiffMatrix& rhs)
+        {
+            switch (rhs.type_) {
+            case Zero:
+                return AutoDiffMatrix(rhs.rows_, rhs.cols_);
+            case Identity:
+            case Diagonal:
+                {
+                    AutoDiffMatrix retval(Diagonal, rhs.rows_, rhs.cols_);
+                    if (rhs.type_ == Identity) {
+                        retval.diag_.assign(d, d + rhs.rows_);
+                    } else {
+                        retval.diag_.resize(rhs.rows_);
+                        for (int r = 0; r < rhs.rows_; ++r) {
+                            retval.diag_[r] = d[r] * rhs.diag_[r];
+                        }
+                    }
+                    return retval;
+                }
+            case Sparse:
+                {
+                    AutoDiffMatrix retval(Sparse, rhs.rows_, rhs.cols_);
+                    SparseStorageArena::acquire(retval.sparse_, rhs.sparse_.outerSize(), rhs.sparse_.nonZeros());
+                    retval.sparse_ = rhs.sparse_;
+                    for (int col = 0; col < retval.cols_; ++col) {
+                        for (SparseRep::InnerIterator it(retval.sparse_, col); it; ++it) {
+                            it.valueRef() *= d[it.row()];
+                        }
+                    }
+                    return retval;
+                }
+            default:
+                OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << rhs.type_);
+            }
+        }
+
+
+
+        /**
+         * Computes res = diag(a) * lhs + diag(b) * rhs without forming the
+         * diagonal matrices or intermediate products. If lhs and rhs are
+         * sparse matrices with the same sparsity pattern, which is the common
+         * case for products and quotients of functions of the same variables,
+         * the values of the result are computed in one pass over the pattern.
+         */
+        static void diagProductSum(const double* a, const AutoDiffMatrix& lhs,
+                                   const double* b, const AutoDiffMatrix& rhs,
+                                   AutoDiffMatrix& res)
+        {
+            assert(lhs.rows_ == rhs.rows_);
+            assert(lhs.cols_ == rhs.cols_);
+            if (lhs.nonZeros() == 0 && rhs.nonZeros() == 0) {
+                res = AutoDiffMatrix(lhs.rows_, lhs.cols_);
+            }
+            else if (rhs.nonZeros() == 0) {
+                res = diagProduct(a, lhs);
+            }
+            else if (lhs.nonZeros() == 0) {
+                res = diagProduct(b, rhs);
+            }
+            else if (lhs.type_ == Sparse && rhs.type_ == Sparse
+                     && lhs.sparse_.isCompressed() && rhs.sparse_.isCompressed()
+                     && equalSparsityPattern(lhs.sparse_, rhs.sparse_)) {
+                AutoDiffMatrix retval(Sparse, lhs.rows_, lhs.cols_);
+                SparseStorageArena::acquire(retval.sparse_, lhs.sparse_.outerSize(), lhs.sparse_.nonZeros());
+                retval.sparse_ = lhs.sparse_;
+                const int nnz = retval.sparse_.nonZeros();
+                const auto* row = retval.sparse_.innerIndexPtr();
+                const double* lhs_val = lhs.sparse_.valuePtr();
+                const double* rhs_val = rhs.sparse_.valuePtr();
+                double* val = retval.sparse_.valuePtr();
+                for (int k = 0; k < nnz; ++k) {
+                    val[k] = a[row[k]] * lhs_val[k] + b[row[k]] * rhs_val[k];
+                }
+                res = std::move(retval);
+            }
+            else if (lhs.type_ != Sparse && rhs.type_ != Sparse) {
+                AutoDiffMatrix retval(Diagonal, lhs.rows_, lhs.cols_);
+                retval.diag_.resize(lhs.rows_);
+                for (int r = 0; r < lhs.rows_; ++r) {
+                    const double lhs_diag = (lhs.type_ == Identity) ? 1.0 : lhs.diag_[r];
+                    const double rhs_diag = (rhs.type_ == Identity) ? 1.0 : rhs.diag_[r];
+                    retval.diag_[r] = a[r] * lhs_diag + b[r] * rhs_diag;
+                }
+                res = std::move(retval);
+            }
+            else {
+                res = diagProduct(a, lhs);
+                res += diagProduct(b, rhs);
+            }
+        }
+
+
+
+
+
         // Add identity to identity
         static AutoDiffMatrix addII(const AutoDiffMatrix& lhs, const AutoDiffMatrix& rhs)
         {
@@ -500,6 +739,7 @@ namespace Opm
             retval.type_ = Sparse;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
+            SparseStorageArena::acquire(retval.sparse_, rhs.sparse_.outerSize(), rhs.sparse_.nonZeros());
             fastDiagSparseProduct(lhs.diag_, rhs.sparse_, retval.sparse_);
             return retval;
         }
@@ -513,6 +753,7 @@ namespace Opm
             retval.type_ = Sparse;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
+            SparseStorageArena::acquire(retval.sparse_, lhs.sparse_.outerSize(), lhs.sparse_.nonZeros());
             fastSparseDiagProduct(lhs.sparse_, rhs.diag_, retval.sparse_);
             return retval;
         }
@@ -351,6 +351,9 @@ namespace Opm {
 
         LinearisedBlackoilResidual residual_;
 
+        /// \brief Recycled storage for the jacobians of the assembly.
+        SparseStorageArena jacobian_storage_;
+
         /// \brief Whether we print something to std::cout
         bool terminal_output_;
         /// \brief The number of cells of the global grid.
@@ -259,6 +259,9 @@ typedef Eigen::Array<double,
             dx_old_ = V::Zero(sizeNonLinear());
         }
         try {
+            // The temporaries of one assembly have the same structure as
+            // the ones of the previous iteration, recycle their storage.
+            SparseStorageArena::Scope storage_scope(jacobian_storage_);
             report += asImpl().assemble(reservoir_state, well_state, iteration == 0);
             report.assemble_time += perfTimer.stop();
         }
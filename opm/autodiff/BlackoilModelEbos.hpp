@@ -27,10 +27,14 @@
 #include <ebos/eclproblem.hh>
 #include <ewoms/common/start.hh>
 
+#include <opm/autodiff/AndersonAcceleration.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/autodiff/BlackoilWellModel.hpp>
 #include <opm/autodiff/GridHelpers.hpp>
 #include <opm/autodiff/GeoProps.hpp>
+#include <opm/autodiff/LinearSystemIO.hpp>
+#include <opm/autodiff/MatrixBlockKernels.hpp>
+#include <opm/autodiff/TimerRegistry.hpp>
 #include <opm/autodiff/BlackoilDetails.hpp>
 #include <opm/autodiff/NewtonIterationBlackoilInterface.hpp>
 
@@ -45,6 +49,9 @@
 #include <opm/parser/eclipse/Units/Units.hpp>
 #include <opm/core/well_controls.h>
 #include <opm/simulators/timestepping/SimulatorTimer.hpp>
+#include <opm/simulators/timestepping/TimeStepControl.hpp>
+#include <opm/simulators/timestepping/TimeStepControlInterface.hpp>
+#include <opm/simulators/ensureDirectoryExists.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/Tables/TableManager.hpp>
@@ -57,11 +64,15 @@
 #include <dune/common/timer.hh>
 #include <dune/common/unused.hh>
 
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <algorithm>
 //#include <fstream>
@@ -161,6 +172,17 @@ namespace Opm {
             {
                 OPM_THROW(std::logic_error,"solver down cast to ISTLSolver failed");
             }
+
+            // the cells owned by this process, their order defines the order of the reductions
+            const auto& elemMapper = ebosSimulator_.model().elementMapper();
+            const auto& gridView = ebosSimulator_.gridView();
+            const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
+            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
+                 elemIt != elemEndIt;
+                 ++elemIt)
+            {
+                interior_cells_.push_back(elemMapper.index(*elemIt));
+            }
         }
 
         bool isParallel() const
@@ -180,15 +202,17 @@ namespace Opm {
 
             // update the solution variables in ebos
 
-            // if the last time step failed we need to update the curent solution
-            // and recalculate the Intesive Quantities.
+            // if the last time step failed the state needs to be restored,
+            // unless this has already been done by rollbackState().
             if ( timer.lastStepFailed() ) {
-                ebosSimulator_.model().solution( 0 /* timeIdx */ ) = ebosSimulator_.model().solution( 1 /* timeIdx */ );
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                if ( ! state_rolled_back_ ) {
+                    rollbackState( /*keepLastIterate=*/false );
+                }
             } else {
                 // set the initial solution.
                 ebosSimulator_.model().solution( 1 /* timeIdx */ ) = ebosSimulator_.model().solution( 0 /* timeIdx */ );
             }
+            state_rolled_back_ = false;
 
             // set the timestep size and index in ebos explicitly
             // we use our own time stepper.
@@ -199,12 +223,18 @@ namespace Opm {
 
             ebosSimulator_.problem().beginTimeStep();
 
+            // the solution may have been reset
+            cell_quantities_valid_ = false;
+
             unsigned numDof = ebosSimulator_.model().numGridDof();
             wasSwitched_.resize(numDof);
             std::fill(wasSwitched_.begin(), wasSwitched_.end(), false);
 
             wellModel().beginTimeStep();
 
+            // let the linear solver decide whether to keep its preconditioner
+            istlSolver().beginTimeStep();
+
             if (param_.update_equations_scaling_) {
                 std::cout << "equation scaling not suported yet" << std::endl;
                 //updateEquationsScaling();
@@ -237,8 +267,14 @@ namespace Opm {
                 // For each iteration we store in a vector the norms of the residual of
                 // the mass balance for each active phase, the well flux and the well equations.
                 residual_norms_history_.clear();
+                mass_balance_history_.clear();
                 current_relaxation_ = 1.0;
                 dx_old_ = 0.0;
+                line_search_residual_.clear();
+                if (!anderson_ || anderson_->depth() != nonlinear_solver.andersonDepth()) {
+                    anderson_.reset(new AndersonAcceleration<BVector>(nonlinear_solver.andersonDepth()));
+                }
+                anderson_->reset();
             }
 
             report.total_linearizations = 1;
@@ -255,10 +291,14 @@ namespace Opm {
             }
 
             std::vector<double> residual_norms;
+            std::vector<double> mass_balance_norms;
             perfTimer.reset();
             perfTimer.start();
-            // the step is not considered converged until at least minIter iterations is done
-            report.converged = getConvergence(timer, iteration,residual_norms) && iteration > nonlinear_solver.minIter();
+            {
+                ScopedTimer convergenceTimer("convergence");
+                // the step is not considered converged until at least minIter iterations is done
+                report.converged = getConvergence(timer, iteration, residual_norms, mass_balance_norms) && iteration > nonlinear_solver.minIter();
+            }
 
              // checking whether the group targets are converged
              if (wellModel().wellCollection().groupControlActive()) {
@@ -267,6 +307,31 @@ namespace Opm {
 
             report.update_time += perfTimer.stop();
             residual_norms_history_.push_back(residual_norms);
+            mass_balance_history_.push_back(mass_balance_norms);
+
+            // cut the last update if it did not reduce the residual sufficiently
+            if (!report.converged && !line_search_residual_.empty()
+                && line_search_step_ > nonlinear_solver.lineSearchMinStep()
+                && nonlinear_solver.rejectLineSearchStep(line_search_residual_, residual_norms, line_search_step_)) {
+                perfTimer.reset();
+                perfTimer.start();
+                line_search_step_ *= 0.5;
+                cutLastUpdate_();
+                report.update_time += perfTimer.stop();
+                if (terminalOutputEnabled()) {
+                    OpmLog::debug("    Line search: update cut to " + std::to_string(line_search_step_));
+                }
+                return report;
+            }
+
+            // give up early on time steps which will not converge anyway
+            if (!report.converged && param_.use_newton_divergence_abort_
+                && newtonDiverges_(nonlinear_solver.maxIter())) {
+                failureReport_ += report;
+                OPM_THROW_NOLOG(Opm::NumericalProblem, "Newton iterations diverge, time step aborted after "
+                                << iteration << " iterations");
+            }
+
             if (!report.converged) {
                 perfTimer.reset();
                 perfTimer.start();
@@ -280,6 +345,7 @@ namespace Opm {
                 BVector x(nc);
 
                 try {
+                    selectLinearSystemCapture_(timer, iteration);
                     solveJacobianSystem(x);
                     report.linear_solve_time += perfTimer.stop();
                     report.total_linear_iterations += linearIterationsLastSolve();
@@ -294,10 +360,15 @@ namespace Opm {
 
                 perfTimer.reset();
                 perfTimer.start();
+                ScopedTimer updateTimer("update");
 
                 // handling well state update before oscillation treatment is a decision based
                 // on observation to avoid some big performance degeneration under some circumstances.
                 // there is no theorectical explanation which way is better for sure.
+                // The accelerated update is used for the wells as well.
+                if (anderson_->depth() > 0) {
+                    anderson_->apply(x, ScaledInnerProduct(*this));
+                }
                 wellModel().recoverWellSolutionAndUpdateWellState(x);
 
                 if (param_.use_update_stabilization_) {
@@ -317,9 +388,24 @@ namespace Opm {
                     nonlinear_solver.stabilizeNonlinearUpdate(x, dx_old_, current_relaxation_);
                 }
 
+                if (nonlinear_solver.useLineSearch() || anderson_->depth() > 0) {
+                    // remember the state before the update in case it has to be cut,
+                    // and to find the update actually applied
+                    solution_before_update_ = ebosSimulator_.model().solution( 0 /* timeIdx */ );
+                }
+                if (nonlinear_solver.useLineSearch()) {
+                    was_switched_before_update_ = wasSwitched_;
+                    line_search_dx_ = x;
+                    line_search_residual_ = residual_norms;
+                    line_search_step_ = 1.0;
+                }
+
                 // Apply the update, with considering model-dependent limitations and
                 // chopping of the update.
                 updateState(x);
+                if (anderson_->depth() > 0) {
+                    recordAppliedUpdate_();
+                }
 
                 report.update_time += perfTimer.stop();
             }
@@ -352,6 +438,21 @@ namespace Opm {
 
         }
 
+        /// Restore the state of the last accepted time step after a failed one.
+        /// The model keeps this state itself, i.e. the old solution of ebos and
+        /// the previous well state, so no copies of the state objects are needed.
+        /// \param[in] keepLastIterate  if true, the last Newton iterate is kept
+        ///                             as the initial guess of the repeated step
+        void rollbackState(const bool keepLastIterate)
+        {
+            if ( ! keepLastIterate ) {
+                ebosSimulator_.model().solution( 0 /* timeIdx */ ) = ebosSimulator_.model().solution( 1 /* timeIdx */ );
+                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                wellModel().resetWellState();
+            }
+            state_rolled_back_ = true;
+        }
+
         /// Assemble the residual and Jacobian of the nonlinear system.
         /// \param[in]      reservoir_state   reservoir state variables
         /// \param[in, out] well_state        well state variables
@@ -359,20 +460,30 @@ namespace Opm {
         SimulatorReport assemble(const SimulatorTimerInterface& timer,
                                  const int iterationIdx)
         {
+            ScopedTimer assemblyTimer("assembly");
+
             // -------- Mass balance equations --------
-            ebosSimulator_.model().newtonMethod().setIterationIndex(iterationIdx);
-            ebosSimulator_.problem().beginIteration();
-            ebosSimulator_.model().linearizer().linearize();
-            ebosSimulator_.problem().endIteration();
+            {
+                ScopedTimer reservoirTimer("reservoir_assembly");
+                ebosSimulator_.model().newtonMethod().setIterationIndex(iterationIdx);
+                ebosSimulator_.problem().beginIteration();
+                ebosSimulator_.model().linearizer().linearize();
+                ebosSimulator_.problem().endIteration();
+            }
+
+            // the intensive quantities are up to date after the linearization, gather
+            // what the wells and the convergence check need from them in one sweep
+            updateCellQuantities_();
 
             // -------- Well equations ----------
             double dt = timer.currentStepLength();
 
             try
             {
+                ScopedTimer wellTimer("well_assembly");
                 // assembles the well equations and applies the wells to
                 // the reservoir equations as a source term.
-                wellModel().assemble(iterationIdx, dt);
+                wellModel().assemble(iterationIdx, dt, B_avg_);
             }
             catch ( const Dune::FMatrixError& e  )
             {
@@ -386,81 +497,66 @@ namespace Opm {
         template <class Dummy>
         double relativeChange(const Dummy&, const Dummy&) const
         {
-            Scalar resultDelta = 0.0;
-            Scalar resultDenom = 0.0;
-
-            const auto& elemMapper = ebosSimulator_.model().elementMapper();
-            const auto& gridView = ebosSimulator_.gridView();
-            auto elemIt = gridView.template begin</*codim=*/0>();
-            const auto& elemEndIt = gridView.template end</*codim=*/0>();
-            for (; elemIt != elemEndIt; ++elemIt) {
-                const auto& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    continue;
-
-		unsigned globalElemIdx = elemMapper.index(elem);
-                const auto& priVarsNew = ebosSimulator_.model().solution(/*timeIdx=*/0)[globalElemIdx];
-
-                Scalar pressureNew;
-		pressureNew = priVarsNew[Indices::pressureSwitchIdx];
-
-		Scalar saturationsNew[FluidSystem::numPhases] = { 0.0 };
-                Scalar oilSaturationNew = 1.0;
-                if (FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx)) {
-                    saturationsNew[FluidSystem::waterPhaseIdx] = priVarsNew[Indices::waterSaturationIdx];
-                    oilSaturationNew -= saturationsNew[FluidSystem::waterPhaseIdx];
-                }
-
-                if (FluidSystem::phaseIsActive(FluidSystem::gasPhaseIdx) && priVarsNew.primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg) {
-                    saturationsNew[FluidSystem::gasPhaseIdx] = priVarsNew[Indices::compositionSwitchIdx];
-                    oilSaturationNew -= saturationsNew[FluidSystem::gasPhaseIdx];
-                }
-
-                if (FluidSystem::phaseIsActive(FluidSystem::oilPhaseIdx)) {
-                    saturationsNew[FluidSystem::oilPhaseIdx] = oilSaturationNew;
-                }
-
-                const auto& priVarsOld = ebosSimulator_.model().solution(/*timeIdx=*/1)[globalElemIdx];
-
-                Scalar pressureOld;
-                pressureOld = priVarsOld[Indices::pressureSwitchIdx];
+            const auto& solutionNew = ebosSimulator_.model().solution(/*timeIdx=*/0);
+            const auto& solutionOld = ebosSimulator_.model().solution(/*timeIdx=*/1);
 
-                Scalar saturationsOld[FluidSystem::numPhases] = { 0.0 };
-                Scalar oilSaturationOld = 1.0;
-                if (FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx)) {
-                    saturationsOld[FluidSystem::waterPhaseIdx] = priVarsOld[Indices::waterSaturationIdx];
-                    oilSaturationOld -= saturationsOld[FluidSystem::waterPhaseIdx];
-                }
+            // squared change and squared norm of the solution
+            typedef std::array<Scalar, 2> Result;
+            const Result local = reduceInteriorCells_(Result{{ 0.0, 0.0 }},
+                [&](const unsigned globalElemIdx, Result& result)
+                {
+                    const auto& priVarsNew = solutionNew[globalElemIdx];
+                    const auto& priVarsOld = solutionOld[globalElemIdx];
+
+                    Scalar saturationsNew[FluidSystem::numPhases] = { 0.0 };
+                    Scalar saturationsOld[FluidSystem::numPhases] = { 0.0 };
+                    saturations_(priVarsNew, saturationsNew);
+                    saturations_(priVarsOld, saturationsOld);
+
+                    const Scalar pressureNew = priVarsNew[Indices::pressureSwitchIdx];
+                    const Scalar pressureOld = priVarsOld[Indices::pressureSwitchIdx];
+                    Scalar tmp = pressureNew - pressureOld;
+                    result[0] += tmp*tmp;
+                    result[1] += pressureNew*pressureNew;
+
+                    for (unsigned phaseIdx = 0; phaseIdx < FluidSystem::numPhases; ++ phaseIdx) {
+                        tmp = saturationsNew[phaseIdx] - saturationsOld[phaseIdx];
+                        result[0] += tmp*tmp;
+                        result[1] += saturationsNew[phaseIdx]*saturationsNew[phaseIdx];
+                    }
+                },
+                [](Result& result, const Result& partial)
+                {
+                    result[0] += partial[0];
+                    result[1] += partial[1];
+                });
 
-                if (FluidSystem::phaseIsActive(FluidSystem::gasPhaseIdx) && priVarsOld.primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg) {
-                    saturationsOld[FluidSystem::gasPhaseIdx] = priVarsOld[Indices::compositionSwitchIdx];
-                    oilSaturationOld -= saturationsOld[FluidSystem::gasPhaseIdx];
-                }
+            const auto& comm = ebosSimulator_.gridView().comm();
+            const Scalar resultDelta = comm.sum(local[0]);
+            const Scalar resultDenom = comm.sum(local[1]);
 
-                if (FluidSystem::phaseIsActive(FluidSystem::oilPhaseIdx)) {
-                    saturationsOld[FluidSystem::oilPhaseIdx] = oilSaturationOld;
-                }
+            if (resultDenom > 0.0)
+                return resultDelta/resultDenom;
+            return 0.0;
+        }
 
-                Scalar tmp = pressureNew - pressureOld;
-                resultDelta += tmp*tmp;
-                resultDenom += pressureNew*pressureNew;
 
-                for (unsigned phaseIdx = 0; phaseIdx < FluidSystem::numPhases; ++ phaseIdx) {
-                    Scalar tmp = saturationsNew[phaseIdx] - saturationsOld[phaseIdx];
-		    resultDelta += tmp*tmp;
-                    resultDenom += saturationsNew[phaseIdx]*saturationsNew[phaseIdx];
-                }
+        /// Convergence behaviour of the Newton iterations of the last time step, taken
+        /// from the CNV and mass balance residuals. Used by the time step control to
+        /// choose the size of a repeated step after a failure.
+        NonlinearConvergenceInfo convergenceInfo() const
+        {
+            const int numResiduals = residual_norms_history_.size();
+            std::vector<double> cnv(numResiduals), mb(numResiduals);
+            for (int iteration = 0; iteration < numResiduals; ++iteration) {
+                cnv[iteration] = relativeCnvResidual_(iteration);
+                const auto& norms = mass_balance_history_[iteration];
+                const double maxNorm = norms.empty() ? 0.0 : *std::max_element(norms.begin(), norms.end());
+                mb[iteration] = maxNorm / param_.tolerance_mb_;
             }
-
-            resultDelta = gridView.comm().sum(resultDelta);
-            resultDenom = gridView.comm().sum(resultDenom);
-
-	    if (resultDenom > 0.0)
-	      return resultDelta/resultDenom;
-	    return 0.0;
+            return estimateNonlinearConvergence(cnv, mb, param_.max_strict_iter_);
         }
 
-
         /// Number of linear iterations used in last call to solveJacobianSystem().
         int linearIterationsLastSolve() const
         {
@@ -471,6 +567,7 @@ namespace Opm {
         /// r is the residual.
         void solveJacobianSystem(BVector& x) const
         {
+            ScopedTimer linearSolveTimer("linear_solve");
             const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
             auto& ebosResid = ebosSimulator_.model().linearizer().residual();
 
@@ -486,6 +583,10 @@ namespace Opm {
             // apply well residual to the residual.
             wellModel().apply(ebosResid);
 
+            if (!linear_system_capture_file_.empty()) {
+                captureLinearSystem_(ebosJac, ebosResid);
+            }
+
             // set initial guess
             x = 0.0;
 
@@ -554,7 +655,7 @@ namespace Opm {
 
           virtual void apply( const X& x, Y& y ) const
           {
-            A_.mv( x, y );
+            blockkernels::bcrsMv( A_, x, y );
             // add well model modification to y
             wellMod_.apply(x, y );
 
@@ -567,7 +668,7 @@ namespace Opm {
           // y += \alpha * A * x
           virtual void applyscaleadd (field_type alpha, const X& x, Y& y) const
           {
-            A_.usmv(alpha,x,y);
+            blockkernels::bcrsUsmv( alpha, A_, x, y );
             // add scaled well model modification to y
             wellMod_.applyScaleAdd( alpha, x, y );
 
@@ -590,6 +691,116 @@ namespace Opm {
           std::unique_ptr< communication_type > comm_;
         };
 
+        /// Inner product of the updates for the Anderson acceleration. The pressure
+        /// updates are taken relative to the pressure of the cells such that they are
+        /// comparable to the updates of the saturations, only interior cells count.
+        class ScaledInnerProduct
+        {
+        public:
+            explicit ScaledInnerProduct(const BlackoilModelEbos& model)
+                : model_(model)
+            {}
+
+            double dot(const BVector& a, const BVector& b) const
+            {
+                const auto& solution = model_.ebosSimulator_.model().solution( 0 /* timeIdx */ );
+                const double local = model_.reduceInteriorCells_(0.0,
+                    [&](const unsigned cellIdx, double& result)
+                    {
+                        const double pressure = std::max(std::abs(solution[cellIdx][Indices::pressureSwitchIdx]), 1.0);
+                        for (int eq = 0; eq < numEq; ++eq) {
+                            const double weight = eq == Indices::pressureSwitchIdx ? 1.0 / (pressure * pressure) : 1.0;
+                            result += weight * a[cellIdx][eq] * b[cellIdx][eq];
+                        }
+                    },
+                    [](double& result, const double partial) { result += partial; });
+                return model_.ebosSimulator_.gridView().comm().sum(local);
+            }
+
+        private:
+            const BlackoilModelEbos& model_;
+        };
+
+        /// Choose the file the next linear system is written to according to the
+        /// linear_system_capture_* parameters, an empty name for no capture.
+        void selectLinearSystemCapture_(const SimulatorTimerInterface& timer, const int iteration)
+        {
+            linear_system_capture_file_.clear();
+            if (param_.linear_system_capture_dir_.empty()
+                || (param_.linear_system_capture_report_step_ >= 0 && param_.linear_system_capture_report_step_ != timer.reportStepNum())
+                || (param_.linear_system_capture_iteration_ >= 0 && param_.linear_system_capture_iteration_ != iteration)) {
+                return;
+            }
+            if (isParallel()) {
+                if (!linear_system_capture_warned_ && terminalOutputEnabled()) {
+                    OpmLog::warning("Linear system capture", "The linear systems of parallel runs are not written.");
+                }
+                linear_system_capture_warned_ = true;
+                return;
+            }
+
+            ensureDirectoryExists(param_.linear_system_capture_dir_);
+            linear_system_capture_info_.reportStep = timer.reportStepNum();
+            linear_system_capture_info_.subStep = timer.currentStepNum();
+            linear_system_capture_info_.iteration = iteration;
+            std::ostringstream file;
+            file << param_.linear_system_capture_dir_ << "/linear_system_" << timer.reportStepNum()
+                 << "_" << timer.currentStepNum() << "_" << iteration << ".bin";
+            linear_system_capture_file_ = file.str();
+        }
+
+        /// Write the system handed to the linear solver, i.e. the Jacobian of the reservoir
+        /// equations, the residual with the wells eliminated and the blocks of the wells.
+        void captureLinearSystem_(const Mat& jacobian, const BVector& residual) const
+        {
+            std::vector<LinearSystemWell> wells;
+            const int notCaptured = wellModel().captureLinearSystem(wells);
+            if (notCaptured > 0 && !linear_system_capture_warned_) {
+                OpmLog::warning("Linear system capture", std::to_string(notCaptured)
+                                + " wells without D^-1, e.g. multisegment wells, are missing in the written linear systems.");
+                linear_system_capture_warned_ = true;
+            }
+            writeLinearSystem(linear_system_capture_file_, linear_system_capture_info_, jacobian, residual, wells);
+        }
+
+        /// Restore the state before the last update and apply the update again,
+        /// cut by a factor of two. Only the reservoir variables are affected, the
+        /// wells keep their full update.
+        void cutLastUpdate_()
+        {
+            ebosSimulator_.model().solution( 0 /* timeIdx */ ) = solution_before_update_;
+            wasSwitched_ = was_switched_before_update_;
+            line_search_dx_ *= 0.5;
+            updateState(line_search_dx_);
+
+            // the previous updates do not fit the modified one
+            anderson_->reset();
+        }
+
+        /// Store the update made by the last updateState() in the history of the
+        /// Anderson acceleration. It differs from the accelerated update by the
+        /// relaxation and the chopping. Switched primary variables do not have the
+        /// same meaning before and after the update, the history is dropped then.
+        void recordAppliedUpdate_()
+        {
+            const SolutionVector& solution = ebosSimulator_.model().solution( 0 /* timeIdx */ );
+            int switched = std::find(wasSwitched_.begin(), wasSwitched_.end(), true) != wasSwitched_.end();
+            // all processes have to keep the same history for the global inner products
+            switched = grid_.comm().max(switched);
+            if (switched) {
+                anderson_->reset();
+                return;
+            }
+
+            applied_update_.resize(solution.size());
+            for (std::size_t cell_idx = 0; cell_idx < solution.size(); ++cell_idx) {
+                for (int eq = 0; eq < numEq; ++eq) {
+                    applied_update_[cell_idx][eq] = solution_before_update_[cell_idx][eq] - solution[cell_idx][eq];
+                }
+            }
+            anderson_->setAppliedUpdate(applied_update_);
+        }
+
         /// Apply an update to the primary variables, chopped if appropriate.
         /// \param[in]      dx                updates to apply to primary variables
         /// \param[in, out] reservoir_state   reservoir state variables
@@ -731,6 +942,7 @@ namespace Opm {
 
             // if the solution is updated the intensive Quantities need to be recalculated
             ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+            cell_quantities_valid_ = false;
 
         }
 
@@ -744,8 +956,7 @@ namespace Opm {
         double convergenceReduction(const CollectiveCommunication& comm,
                                     const double pvSumLocal,
                                     std::vector< Scalar >& R_sum,
-                                    std::vector< Scalar >& maxCoeff,
-                                    std::vector< Scalar >& B_avg)
+                                    std::vector< Scalar >& maxCoeff)
         {
             // Compute total pore volume (use only owned entries)
             double pvSum = pvSumLocal;
@@ -755,12 +966,11 @@ namespace Opm {
                 // global reduction
                 std::vector< Scalar > sumBuffer;
                 std::vector< Scalar > maxBuffer;
-                const int numComp = B_avg.size();
-                sumBuffer.reserve( 2*numComp + 1 ); // +1 for pvSum
+                const int numComp = R_sum.size();
+                sumBuffer.reserve( numComp + 1 ); // +1 for pvSum
                 maxBuffer.reserve( numComp );
                 for( int compIdx = 0; compIdx < numComp; ++compIdx )
                 {
-                    sumBuffer.push_back( B_avg[ compIdx ] );
                     sumBuffer.push_back( R_sum[ compIdx ] );
                     maxBuffer.push_back( maxCoeff[ compIdx ] );
                 }
@@ -775,16 +985,9 @@ namespace Opm {
                 comm.max( maxBuffer.data(), maxBuffer.size() );
 
                 // restore values to local variables
-                for( int compIdx = 0, buffIdx = 0; compIdx < numComp; ++compIdx, ++buffIdx )
-                {
-                    B_avg[ compIdx ]    = sumBuffer[ buffIdx ];
-                    ++buffIdx;
-
-                    R_sum[ compIdx ]       = sumBuffer[ buffIdx ];
-                }
-
                 for( int compIdx = 0; compIdx < numComp; ++compIdx )
                 {
+                    R_sum[ compIdx ]    = sumBuffer[ compIdx ];
                     maxCoeff[ compIdx ] = maxBuffer[ compIdx ];
                 }
 
@@ -801,7 +1004,10 @@ namespace Opm {
         /// \param[in]   timer       simulation timer
         /// \param[in]   dt          timestep length
         /// \param[in]   iteration   current iteration number
-        bool getConvergence(const SimulatorTimerInterface& timer, const int iteration, std::vector<double>& residual_norms)
+        /// \param[out]  residual_norms      CNV residual of each component
+        /// \param[out]  mass_balance_norms  mass balance residual of each component
+        bool getConvergence(const SimulatorTimerInterface& timer, const int iteration, std::vector<double>& residual_norms,
+                            std::vector<double>& mass_balance_norms)
         {
             typedef std::vector< Scalar > Vector;
 
@@ -812,75 +1018,71 @@ namespace Opm {
             const int np = numPhases();
             const int numComp = numComponents();
 
-            Vector R_sum(numComp, 0.0 );
-            Vector B_avg(numComp, 0.0 );
-            Vector maxCoeff(numComp, std::numeric_limits< Scalar >::lowest() );
+            if (!cell_quantities_valid_) {
+                updateCellQuantities_();
+            }
+            // the averages over the global grid
+            const Vector& B_avg = B_avg_;
 
             const auto& ebosModel = ebosSimulator_.model();
             const auto& ebosProblem = ebosSimulator_.problem();
 
             const auto& ebosResid = ebosSimulator_.model().linearizer().residual();
 
-            ElementContext elemCtx(ebosSimulator_);
-            const auto& gridView = ebosSimulator().gridView();
-            const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
+            // sums of the residuals, maximum of the scaled residuals and the pore volume
+            const int pvIdx = 2*numComp;
+            Vector init(2*numComp + 1, 0.0);
+            std::fill(init.begin() + numComp, init.begin() + pvIdx, std::numeric_limits< Scalar >::lowest());
 
-            double pvSumLocal = 0.0;
-            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
-            {
-                const auto& elem = *elemIt;
-                elemCtx.updatePrimaryStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-                const unsigned cell_idx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& fs = intQuants.fluidState();
-
-                const double pvValue = ebosProblem.porosity(cell_idx) * ebosModel.dofTotalVolume( cell_idx );
-                pvSumLocal += pvValue;
-
-                for ( int phaseIdx = 0; phaseIdx < np; ++phaseIdx )
+            const Vector local = reduceInteriorCells_(init,
+                [&](const unsigned cell_idx, Vector& result)
                 {
-                    const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phaseIdx);
-                    const int ebosCompIdx = flowPhaseToEbosCompIdx(phaseIdx);
+                    Scalar* R_sum = result.data();
+                    Scalar* maxCoeff = result.data() + numComp;
 
-                    B_avg[ phaseIdx ] += 1.0 / fs.invB(ebosPhaseIdx).value();
-                    const auto R2 = ebosResid[cell_idx][ebosCompIdx];
+                    const double pvValue = ebosProblem.porosity(cell_idx) * ebosModel.dofTotalVolume( cell_idx );
+                    result[ pvIdx ] += pvValue;
 
-                    R_sum[ phaseIdx ] += R2;
-                    maxCoeff[ phaseIdx ] = std::max( maxCoeff[ phaseIdx ], std::abs( R2 ) / pvValue );
-                }
+                    for ( int phaseIdx = 0; phaseIdx < np; ++phaseIdx )
+                    {
+                        const int ebosCompIdx = flowPhaseToEbosCompIdx(phaseIdx);
+                        const auto R2 = ebosResid[cell_idx][ebosCompIdx];
 
-                if ( has_solvent_ ) {
-                    B_avg[ contiSolventEqIdx ] += 1.0 / intQuants.solventInverseFormationVolumeFactor().value();
-                    const auto R2 = ebosResid[cell_idx][contiSolventEqIdx];
-                    R_sum[ contiSolventEqIdx ] += R2;
-                    maxCoeff[ contiSolventEqIdx ] = std::max( maxCoeff[ contiSolventEqIdx ], std::abs( R2 ) / pvValue );
-                }
-                if (has_polymer_ ) {
-                    B_avg[ contiPolymerEqIdx ] += 1.0 / fs.invB(FluidSystem::waterPhaseIdx).value();
-                    const auto R2 = ebosResid[cell_idx][contiPolymerEqIdx];
-                    R_sum[ contiPolymerEqIdx ] += R2;
-                    maxCoeff[ contiPolymerEqIdx ] = std::max( maxCoeff[ contiPolymerEqIdx ], std::abs( R2 ) / pvValue );
-                }
+                        R_sum[ phaseIdx ] += R2;
+                        maxCoeff[ phaseIdx ] = std::max( maxCoeff[ phaseIdx ], std::abs( R2 ) / pvValue );
+                    }
 
-            }
+                    if ( has_solvent_ ) {
+                        const auto R2 = ebosResid[cell_idx][contiSolventEqIdx];
+                        R_sum[ contiSolventEqIdx ] += R2;
+                        maxCoeff[ contiSolventEqIdx ] = std::max( maxCoeff[ contiSolventEqIdx ], std::abs( R2 ) / pvValue );
+                    }
+                    if (has_polymer_ ) {
+                        const auto R2 = ebosResid[cell_idx][contiPolymerEqIdx];
+                        R_sum[ contiPolymerEqIdx ] += R2;
+                        maxCoeff[ contiPolymerEqIdx ] = std::max( maxCoeff[ contiPolymerEqIdx ], std::abs( R2 ) / pvValue );
+                    }
+                },
+                [numComp, pvIdx](Vector& result, const Vector& partial)
+                {
+                    for ( int compIdx = 0; compIdx < numComp; ++compIdx )
+                    {
+                        result[ compIdx ] += partial[ compIdx ];
+                        result[ numComp + compIdx ] = std::max( result[ numComp + compIdx ], partial[ numComp + compIdx ] );
+                    }
+                    result[ pvIdx ] += partial[ pvIdx ];
+                });
 
-            // compute local average in terms of global number of elements
-            const int bSize = B_avg.size();
-            for ( int i = 0; i<bSize; ++i )
-            {
-                B_avg[ i ] /= Scalar( global_nc_ );
-            }
+            Vector R_sum(local.begin(), local.begin() + numComp);
+            Vector maxCoeff(local.begin() + numComp, local.begin() + pvIdx);
 
             // TODO: we remove the maxNormWell for now because the convergence of wells are on a individual well basis.
             // Anyway, we need to provide some infromation to help debug the well iteration process.
 
 
             // compute global sum and max of quantities
-            const double pvSum = convergenceReduction(grid_.comm(), pvSumLocal,
-                                                      R_sum, maxCoeff, B_avg);
+            const double pvSum = convergenceReduction(grid_.comm(), local[ pvIdx ],
+                                                      R_sum, maxCoeff);
 
             Vector CNV(numComp);
             Vector mass_balance_residual(numComp);
@@ -896,6 +1098,7 @@ namespace Opm {
                 converged_CNV               = converged_CNV && (CNV[compIdx] < tol_cnv);
 
                 residual_norms.push_back(CNV[compIdx]);
+                mass_balance_norms.push_back(mass_balance_residual[compIdx]);
             }
 
             const bool converged_Well = wellModel().getWellConvergence(B_avg);
@@ -1014,41 +1217,22 @@ namespace Opm {
                 fip_.fip[i].resize(nc,0.0);
             }
 
-            ElementContext elemCtx(ebosSimulator_);
-            const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
-            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
-            {
-                elemCtx.updatePrimaryStencil(*elemIt);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-
-                const unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& fs = intQuants.fluidState();
+            // the fluid in place of the cells is computed together with the
+            // other cell quantities, only the region sums are left to do
+            if (!cell_quantities_valid_) {
+                updateCellQuantities_();
+            }
 
+            for (const unsigned cellIdx : interior_cells_)
+            {
                 const int regionIdx = fipnum[cellIdx] - 1;
                 if (regionIdx < 0) {
                     // the given cell is not attributed to any region
                     continue;
                 }
 
-                // calculate the pore volume of the current cell. Note that the porosity
-                // returned by the intensive quantities is defined as the ratio of pore
-                // space to total cell volume and includes all pressure dependent (->
-                // rock compressibility) and static modifiers (MULTPV, MULTREGP, NTG,
-                // PORV, MINPV and friends). Also note that because of this, the porosity
-                // returned by the intensive quantities can be outside of the physical
-                // range [0, 1] in pathetic cases.
-                const double pv =
-                    ebosSimulator_.model().dofTotalVolume(cellIdx)
-                    * intQuants.porosity().value();
-
                 for (int phase = 0; phase < maxnp; ++phase) {
-                    const double b = fs.invB(flowPhaseToEbosPhaseIdx(phase)).value();
-                    const double s = fs.saturation(flowPhaseToEbosPhaseIdx(phase)).value();
-
-                    fip_.fip[phase][cellIdx] = b * s * pv;
+                    fip_.fip[phase][cellIdx] = cell_fip_[phase][cellIdx];
 
                     if (active_[ phase ]) {
                         regionValues[regionIdx][phase] += fip_.fip[phase][cellIdx];
@@ -1057,17 +1241,16 @@ namespace Opm {
 
                 if (active_[ Oil ] && active_[ Gas ]) {
                     // Account for gas dissolved in oil and vaporized oil
-                    fip_.fip[FIPDataType::FIP_DISSOLVED_GAS][cellIdx] = fs.Rs().value() * fip_.fip[FIPDataType::FIP_LIQUID][cellIdx];
-                    fip_.fip[FIPDataType::FIP_VAPORIZED_OIL][cellIdx] = fs.Rv().value() * fip_.fip[FIPDataType::FIP_VAPOUR][cellIdx];
+                    fip_.fip[FIPDataType::FIP_DISSOLVED_GAS][cellIdx] = cell_fip_[FIPDataType::FIP_DISSOLVED_GAS][cellIdx];
+                    fip_.fip[FIPDataType::FIP_VAPORIZED_OIL][cellIdx] = cell_fip_[FIPDataType::FIP_VAPORIZED_OIL][cellIdx];
 
                     regionValues[regionIdx][FIPData::FIP_DISSOLVED_GAS] += fip_.fip[FIPData::FIP_DISSOLVED_GAS][cellIdx];
                     regionValues[regionIdx][FIPData::FIP_VAPORIZED_OIL] += fip_.fip[FIPData::FIP_VAPORIZED_OIL][cellIdx];
                 }
 
-                const double hydrocarbon = fs.saturation(FluidSystem::oilPhaseIdx).value() + fs.saturation(FluidSystem::gasPhaseIdx).value();
-
+                const double pv = cell_fip_[FIPDataType::FIP_PV][cellIdx];
                 tpv[regionIdx] += pv;
-                hcpv[regionIdx] += pv * hydrocarbon;
+                hcpv[regionIdx] += pv * cell_hydrocarbon_[cellIdx];
             }
 
             // sum tpv (-> total pore volume of the regions) and hcpv (-> pore volume of the
@@ -1075,45 +1258,24 @@ namespace Opm {
             comm.sum(tpv.data(), tpv.size());
             comm.sum(hcpv.data(), hcpv.size());
 
-            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
+            for (const unsigned cellIdx : interior_cells_)
             {
-                const auto& elem = *elemIt;
-
-                elemCtx.updatePrimaryStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-
-                unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
                 const int regionIdx = fipnum[cellIdx] - 1;
                 if (regionIdx < 0) {
                     // the cell is not attributed to any region. ignore it!
                     continue;
                 }
 
-                const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& fs = intQuants.fluidState();
-
-                // calculate the pore volume of the current cell. Note that the
-                // porosity returned by the intensive quantities is defined as the
-                // ratio of pore space to total cell volume and includes all pressure
-                // dependent (-> rock compressibility) and static modifiers (MULTPV,
-                // MULTREGP, NTG, PORV, MINPV and friends). Also note that because of
-                // this, the porosity returned by the intensive quantities can be
-                // outside of the physical range [0, 1] in pathetic cases.
-                const double pv =
-                    ebosSimulator_.model().dofTotalVolume(cellIdx)
-                    * intQuants.porosity().value();
-
+                const double pv = cell_fip_[FIPDataType::FIP_PV][cellIdx];
                 fip_.fip[FIPDataType::FIP_PV][cellIdx] = pv;
-                const double hydrocarbon = fs.saturation(FluidSystem::oilPhaseIdx).value() + fs.saturation(FluidSystem::gasPhaseIdx).value();
+                const double hydrocarbon = cell_hydrocarbon_[cellIdx];
 
                 //Compute hydrocarbon pore volume weighted average pressure.
                 //If we have no hydrocarbon in region, use pore volume weighted average pressure instead
                 if (hcpv[regionIdx] > 1e-10) {
-                    fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * fs.pressure(FluidSystem::oilPhaseIdx).value() * hydrocarbon / hcpv[regionIdx];
+                    fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * cell_pressure_[cellIdx] * hydrocarbon / hcpv[regionIdx];
                 } else {
-                    fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * fs.pressure(FluidSystem::oilPhaseIdx).value() / tpv[regionIdx];
+                    fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * cell_pressure_[cellIdx] / tpv[regionIdx];
                 }
 
                 regionValues[regionIdx][FIPDataType::FIP_PV] += fip_.fip[FIPDataType::FIP_PV][cellIdx];
@@ -1456,6 +1618,205 @@ namespace Opm {
             return *istlSolver_;
         }
 
+        /// Reduce over the interior cells with OpenMP threads. cellOp(cellIdx, result)
+        /// accumulates the contribution of a cell and combine(result, partial) merges
+        /// two partial results. The cells are split into chunks of fixed size whose
+        /// results are combined in order, hence the result does not depend on the
+        /// number of threads.
+        template <class Result, class CellOp, class Combine>
+        Result reduceInteriorCells_(const Result& init, const CellOp& cellOp, const Combine& combine) const
+        {
+            const int chunkSize = 2048;
+            const int numCells = interior_cells_.size();
+            const int numChunks = (numCells + chunkSize - 1) / chunkSize;
+
+            std::vector<Result> partial(numChunks, init);
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif // HAVE_OPENMP
+            for (int chunk = 0; chunk < numChunks; ++chunk) {
+                const int end = std::min(numCells, (chunk + 1) * chunkSize);
+                for (int i = chunk * chunkSize; i < end; ++i) {
+                    cellOp(interior_cells_[i], partial[chunk]);
+                }
+            }
+
+            Result result = init;
+            for (const auto& chunkResult : partial) {
+                combine(result, chunkResult);
+            }
+            return result;
+        }
+
+        // largest CNV residual of a Newton iteration relative to the tolerance
+        double relativeCnvResidual_(const int iteration) const
+        {
+            const auto& norms = residual_norms_history_[iteration];
+            const double maxNorm = norms.empty() ? 0.0 : *std::max_element(norms.begin(), norms.end());
+            return maxNorm / param_.tolerance_cnv_;
+        }
+
+        // Whether the Newton iterations of the current time step are not going to
+        // converge. This is the case if the residual grew over the last two iterations,
+        // or if the rate of convergence predicts far more than maxIter iterations.
+        bool newtonDiverges_(const int maxIter) const
+        {
+            const int iteration = residual_norms_history_.size() - 1;
+            if (iteration < 2 || iteration >= param_.max_strict_iter_) {
+                return false;
+            }
+
+            const double r0 = relativeCnvResidual_(iteration - 2);
+            const double r1 = relativeCnvResidual_(iteration - 1);
+            const double r2 = relativeCnvResidual_(iteration);
+            if (r2 >= r1 && r1 >= r0 && r2 > 1.0) {
+                return true;
+            }
+
+            const NonlinearConvergenceInfo info = convergenceInfo();
+            if (info.rate > 0.0 && info.rate < 1.0 && info.residual > 1.0) {
+                // allow for the faster convergence close to the solution
+                const double remaining = std::log(info.residual) / -std::log(info.rate);
+                return iteration + remaining > 2.0 * maxIter;
+            }
+            return false;
+        }
+
+        /// Make sure that the intensive quantities of all interior cells are cached.
+        /// This is the case after the linearization, but e.g. not before the first one.
+        void ensureIntensiveQuantitiesCached_() const
+        {
+            const auto& ebosModel = ebosSimulator_.model();
+            const auto isCached = [&ebosModel](const unsigned cellIdx) {
+                return ebosModel.cachedIntensiveQuantities(cellIdx, /*timeIdx=*/0) != nullptr;
+            };
+            if (std::all_of(interior_cells_.begin(), interior_cells_.end(), isCached)) {
+                return;
+            }
+
+            // updating the intensive quantities of an element context fills the cache
+            ElementContext elemCtx(ebosSimulator_);
+            const auto& gridView = ebosSimulator_.gridView();
+            const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
+            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
+                 elemIt != elemEndIt;
+                 ++elemIt)
+            {
+                elemCtx.updatePrimaryStencil(*elemIt);
+                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+            }
+
+            if (!std::all_of(interior_cells_.begin(), interior_cells_.end(), isCached)) {
+                OPM_THROW(std::logic_error, "The intensive quantities of the cells need to be cached");
+            }
+        }
+
+        /// Compute in one parallel sweep over the intensive quantities of the interior
+        /// cells the average formation volume factors over the global grid and the
+        /// fluid in place of the cells.
+        ///
+        /// The average formation volume factors are ordered as the conservation
+        /// equations: the phases, then solvent and polymer. They are used by the
+        /// convergence check and by the well model, whose components are the first
+        /// BlackoilWellModel::numComponents() entries, i.e. the phases and solvent.
+        /// The polymer entry is not used by the wells.
+        void updateCellQuantities_() const
+        {
+            ensureIntensiveQuantitiesCached_();
+            // the well model stores the solvent component at solventSaturationIdx
+            assert(!has_solvent_ || contiSolventEqIdx == solventSaturationIdx);
+
+            const auto& ebosModel = ebosSimulator_.model();
+            const int np = numPhases();
+            const int numComp = numComponents();
+            const int maxnp = Opm::BlackoilPhases::MaxNumPhases;
+            const int nc = ebosModel.numGridDof();
+
+            for (auto& values : cell_fip_) {
+                values.resize(nc, 0.0);
+            }
+            cell_pressure_.resize(nc, 0.0);
+            cell_hydrocarbon_.resize(nc, 0.0);
+
+            typedef std::vector< Scalar > Vector;
+            B_avg_ = reduceInteriorCells_(Vector(numComp, 0.0),
+                [&](const unsigned cellIdx, Vector& B_avg)
+                {
+                    const auto& intQuants = *ebosModel.cachedIntensiveQuantities(cellIdx, /*timeIdx=*/0);
+                    const auto& fs = intQuants.fluidState();
+
+                    for ( int phaseIdx = 0; phaseIdx < np; ++phaseIdx )
+                    {
+                        const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phaseIdx);
+                        B_avg[ phaseIdx ] += 1.0 / fs.invB(ebosPhaseIdx).value();
+                    }
+                    if ( has_solvent_ ) {
+                        B_avg[ contiSolventEqIdx ] += 1.0 / intQuants.solventInverseFormationVolumeFactor().value();
+                    }
+                    if ( has_polymer_ ) {
+                        B_avg[ contiPolymerEqIdx ] += 1.0 / fs.invB(FluidSystem::waterPhaseIdx).value();
+                    }
+
+                    // calculate the pore volume of the current cell. Note that the porosity
+                    // returned by the intensive quantities is defined as the ratio of pore
+                    // space to total cell volume and includes all pressure dependent (->
+                    // rock compressibility) and static modifiers (MULTPV, MULTREGP, NTG,
+                    // PORV, MINPV and friends). Also note that because of this, the porosity
+                    // returned by the intensive quantities can be outside of the physical
+                    // range [0, 1] in pathetic cases.
+                    const double pv = ebosModel.dofTotalVolume(cellIdx) * intQuants.porosity().value();
+
+                    for (int phase = 0; phase < maxnp; ++phase) {
+                        const double b = fs.invB(flowPhaseToEbosPhaseIdx(phase)).value();
+                        const double s = fs.saturation(flowPhaseToEbosPhaseIdx(phase)).value();
+                        cell_fip_[phase][cellIdx] = b * s * pv;
+                    }
+
+                    if (active_[ Oil ] && active_[ Gas ]) {
+                        // Account for gas dissolved in oil and vaporized oil
+                        cell_fip_[FIPDataType::FIP_DISSOLVED_GAS][cellIdx] = fs.Rs().value() * cell_fip_[FIPDataType::FIP_LIQUID][cellIdx];
+                        cell_fip_[FIPDataType::FIP_VAPORIZED_OIL][cellIdx] = fs.Rv().value() * cell_fip_[FIPDataType::FIP_VAPOUR][cellIdx];
+                    }
+
+                    cell_fip_[FIPDataType::FIP_PV][cellIdx] = pv;
+                    cell_pressure_[cellIdx] = fs.pressure(FluidSystem::oilPhaseIdx).value();
+                    cell_hydrocarbon_[cellIdx] = fs.saturation(FluidSystem::oilPhaseIdx).value() + fs.saturation(FluidSystem::gasPhaseIdx).value();
+                },
+                [numComp](Vector& B_avg, const Vector& partial)
+                {
+                    for ( int compIdx = 0; compIdx < numComp; ++compIdx ) {
+                        B_avg[ compIdx ] += partial[ compIdx ];
+                    }
+                });
+
+            // compute the global average
+            grid_.comm().sum(B_avg_.data(), B_avg_.size());
+            for (auto& B : B_avg_) {
+                B /= Scalar( global_nc_ );
+            }
+
+            cell_quantities_valid_ = true;
+        }
+
+        /// The saturations given by the primary variables of a cell.
+        static void saturations_(const PrimaryVariables& priVars, Scalar* saturations)
+        {
+            Scalar oilSaturation = 1.0;
+            if (FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx)) {
+                saturations[FluidSystem::waterPhaseIdx] = priVars[Indices::waterSaturationIdx];
+                oilSaturation -= saturations[FluidSystem::waterPhaseIdx];
+            }
+
+            if (FluidSystem::phaseIsActive(FluidSystem::gasPhaseIdx) && priVars.primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg) {
+                saturations[FluidSystem::gasPhaseIdx] = priVars[Indices::compositionSwitchIdx];
+                oilSaturation -= saturations[FluidSystem::gasPhaseIdx];
+            }
+
+            if (FluidSystem::phaseIsActive(FluidSystem::oilPhaseIdx)) {
+                saturations[FluidSystem::oilPhaseIdx] = oilSaturation;
+            }
+        }
+
         // ---------  Data members  ---------
 
         Simulator& ebosSimulator_;
@@ -1483,9 +1844,37 @@ namespace Opm {
         long int global_nc_;
 
         std::vector<std::vector<double>> residual_norms_history_;
+        std::vector<std::vector<double>> mass_balance_history_;
         double current_relaxation_;
         BVector dx_old_;
         mutable FIPDataType fip_;
+        // Anderson acceleration of the Newton updates
+        std::unique_ptr<AndersonAcceleration<BVector>> anderson_;
+        // update of the primary variables made by the last updateState()
+        BVector applied_update_;
+        // state before the last update and the update itself, for the line search
+        SolutionVector solution_before_update_;
+        std::vector<bool> was_switched_before_update_;
+        BVector line_search_dx_;
+        // residual norms before the last update, empty if there is nothing to cut
+        std::vector<double> line_search_residual_;
+        double line_search_step_ = 1.0;
+        // whether the state of a failed time step has been restored by rollbackState()
+        bool state_rolled_back_ = false;
+        // the file the next linear system is written to, empty for no capture
+        std::string linear_system_capture_file_;
+        LinearSystemInfo linear_system_capture_info_;
+        mutable bool linear_system_capture_warned_ = false;
+
+        // the cells owned by this process
+        std::vector<unsigned> interior_cells_;
+        // quantities of the cells computed from the cached intensive quantities
+        // of the current iterate by updateCellQuantities_()
+        mutable bool cell_quantities_valid_ = false;
+        mutable std::vector<Scalar> B_avg_;
+        mutable std::array<std::vector<double>, FIPDataType::fipValues> cell_fip_;
+        mutable std::vector<double> cell_pressure_;
+        mutable std::vector<double> cell_hydrocarbon_;
 
     public:
         /// return the StandardWells object
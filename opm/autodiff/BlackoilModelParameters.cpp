@@ -58,12 +58,18 @@ namespace Opm
             use_inner_iterations_ms_wells_ = param.getDefault("use_inner_iterations_ms_wells", use_inner_iterations_ms_wells_);
             max_inner_iter_ms_wells_ = param.getDefault("max_inner_iter_ms_wells", max_inner_iter_ms_wells_);
         }
+        use_parallel_wells_ = param.getDefault("use_parallel_wells", use_parallel_wells_);
+        use_well_coupling_operator_ = param.getDefault("use_well_coupling_operator", use_well_coupling_operator_);
+        linear_system_capture_dir_ = param.getDefault("linear_system_capture_dir", linear_system_capture_dir_);
+        linear_system_capture_report_step_ = param.getDefault("linear_system_capture_report_step", linear_system_capture_report_step_);
+        linear_system_capture_iteration_ = param.getDefault("linear_system_capture_iteration", linear_system_capture_iteration_);
         maxSinglePrecisionTimeStep_ = unit::convert::from(
                 param.getDefault("max_single_precision_days", unit::convert::to( maxSinglePrecisionTimeStep_, unit::day) ), unit::day );
         max_strict_iter_ = param.getDefault("max_strict_iter",8);
         solve_welleq_initially_ = param.getDefault("solve_welleq_initially",solve_welleq_initially_);
         update_equations_scaling_ = param.getDefault("update_equations_scaling", update_equations_scaling_);
         use_update_stabilization_ = param.getDefault("use_update_stabilization", use_update_stabilization_);
+        use_newton_divergence_abort_ = param.getDefault("use_newton_divergence_abort", use_newton_divergence_abort_);
         deck_file_name_ = param.template get<std::string>("deck_filename");
     }
 
@@ -92,7 +98,13 @@ namespace Opm
         solve_welleq_initially_ = true;
         update_equations_scaling_ = false;
         use_update_stabilization_ = true;
+        use_newton_divergence_abort_ = false;
         use_multisegment_well_ = false;
+        use_parallel_wells_ = false;
+        use_well_coupling_operator_ = false;
+        linear_system_capture_dir_ = "";
+        linear_system_capture_report_step_ = -1;
+        linear_system_capture_iteration_ = -1;
     }
 
 
@@ -81,6 +81,11 @@ namespace Opm
         /// Try to detect oscillation or stagnation.
         bool use_update_stabilization_;
 
+        /// Abort the Newton iterations of a time step after a few iterations if the
+        /// CNV residuals grow, or if their rate of convergence predicts that the
+        /// step will not converge within the maximum number of iterations.
+        bool use_newton_divergence_abort_;
+
         /// Whether to use MultisegmentWell to handle multisegment wells
         /// it is something temporary before the multisegment well model is considered to be
         /// well developed and tested.
@@ -88,6 +93,26 @@ namespace Opm
         /// the default behavoir for the moment. Later, we might set it to be true by default if necessary
         bool use_multisegment_well_;
 
+        /// Whether to process the wells concurrently with OpenMP threads when assembling
+        /// the well equations, applying the well contributions to the reservoir system
+        /// and recovering the well solutions.
+        bool use_parallel_wells_;
+
+        /// Whether to combine the contributions C^T D^-1 B of all standard wells into
+        /// one sparse matrix after the assembly, such that the wells are applied in the
+        /// linear solver by a single matrix-vector product.
+        bool use_well_coupling_operator_;
+
+        /// The directory the linear systems handed to the linear solver are written to,
+        /// to be solved again with replay_linear_system. No systems are written if empty.
+        std::string linear_system_capture_dir_;
+
+        /// The report step of the written linear systems, -1 for all report steps.
+        int linear_system_capture_report_step_;
+
+        /// The Newton iteration of the written linear systems, -1 for all iterations.
+        int linear_system_capture_iteration_;
+
         /// The file name of the deck
         std::string deck_file_name_;
 
@@ -25,12 +25,26 @@
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/autodiff/DebugTimeReport.hpp>
 #include <opm/autodiff/multiPhaseUpwind.hpp>
+#include <opm/autodiff/MSWellHelpers.hpp>
+#include <opm/autodiff/ComponentNewtonSolver.hpp>
+#include <opm/common/Exceptions.hpp>
 #include <opm/core/grid.h>
 #include <opm/core/transport/reorder/reordersequence.h>
 #include <opm/core/simulator/BlackoilState.hpp>
 
 #include <opm/autodiff/BlackoilTransportModel.hpp>
 
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
 namespace Opm {
 
 
@@ -82,6 +96,22 @@ namespace Opm {
 
 
 
+        inline double valueOf(const double value)
+        {
+            return value;
+        }
+
+
+
+        template <typename Scalar>
+        double valueOf(const Scalar& value)
+        {
+            return value.value();
+        }
+
+
+
+
         struct Connection
         {
             Connection(const int ind, const double s) : index(ind), sign(s) {}
@@ -316,6 +346,11 @@ namespace Opm {
                 for (int ii = 0; ii < 5; ++ii) {
                     DebugTimeReport tr2("Solving components single sweep.");
                     solveComponents();
+                    // A sweep without updates leaves the state unchanged,
+                    // so all further sweeps would do the same.
+                    if (max_change_.updates == 0) {
+                        break;
+                    }
                 }
             }
 
@@ -356,6 +391,8 @@ namespace Opm {
         using Vec2 = Dune::FieldVector<double, 2>;
         using Mat22 = Dune::FieldMatrix<double, 2, 2>;
         using Eval = DenseAd::Evaluation<double, 2>;
+        using CompMatrix = Dune::BCRSMatrix<Mat22>;
+        using CompVector = Dune::BlockVector<Vec2>;
 
 
 
@@ -372,6 +409,32 @@ namespace Opm {
 
 
 
+        /// Largest changes of the two unknowns, the cells they
+        /// occurred in, and the number of cell updates in a sweep.
+        struct MaxChange
+        {
+            MaxChange() : dx{{ 0.0, 0.0 }}, cell{{ -1, -1 }}, updates(0) {}
+
+            void merge(const MaxChange& other)
+            {
+                for (int ii = 0; ii < 2; ++ii) {
+                    if (other.dx[ii] > dx[ii]) {
+                        dx[ii] = other.dx[ii];
+                        cell[ii] = other.cell[ii];
+                    }
+                }
+                updates += other.updates;
+            }
+
+            std::array<double, 2> dx;
+            std::array<int, 2> cell;
+            int updates;
+        };
+
+
+
+
+
         template <typename ScalarT>
         struct CellState
         {
@@ -444,12 +507,17 @@ namespace Opm {
         V gas_wellflux_cell_;
         std::vector<int> sequence_;
         std::vector<int> components_;
+        // Component of each cell, and index of each cell within its component.
+        std::vector<int> component_of_cell_;
+        std::vector<int> cell_local_index_;
+        // Components grouped by level, level l is [level_start_[l], level_start_[l+1]).
+        std::vector<int> level_start_;
+        std::vector<int> level_components_;
         V trans_all_;
         V gdz_;
         DataBlock rhos_;
 
-        std::array<double, 2> max_abs_dx_;
-        std::array<int, 2> max_abs_dx_cell_;
+        MaxChange max_change_;
 
         // TODO: remove this, for debug only.
         BlackoilTransportModel<Grid, WellModel> tr_model_;
@@ -598,35 +666,114 @@ namespace Opm {
             compute_sequence(&grid_, flux_on_all_faces.data(), sequence_.data(), components_.data(), &num_components);
             OpmLog::debug(std::string("Number of components: ") + std::to_string(num_components));
             components_.resize(num_components + 1); // resize to fit actually used part
+            computeComponentLevels();
         }
 
 
 
 
-        void solveComponents()
+        /// Returns the cell on the other side of a connection, or -1 on the boundary.
+        int neighbourCell(const int cell, const detail::Connection& conn) const
         {
-            // Zero the max changed.
-            max_abs_dx_[0] = 0.0;
-            max_abs_dx_[1] = 0.0;
-            max_abs_dx_cell_[0] = -1;
-            max_abs_dx_cell_[1] = -1;
+            const auto conn_cells = graph_.connectionCells(conn.index);
+            if (conn_cells[0] < 0 || conn_cells[1] < 0) {
+                return -1;
+            }
+            return conn_cells[0] == cell ? conn_cells[1] : conn_cells[0];
+        }
+
+
+
 
-            // Solve the equations.
+        /// Group the components in levels for parallel solution. The level of a
+        /// component is one more than the highest level of its neighbours that
+        /// come earlier in the sequence. Components of the same level are
+        /// therefore not connected, and the neighbours that the sequential
+        /// sweep would solve first are all in lower levels.
+        void computeComponentLevels()
+        {
+            const int num_cells = sequence_.size();
             const int num_components = components_.size() - 1;
+            component_of_cell_.resize(num_cells);
+            cell_local_index_.resize(num_cells);
             for (int comp = 0; comp < num_components; ++comp) {
-                const int comp_size = components_[comp + 1] - components_[comp];
-                if (comp_size == 1) {
-                    solveSingleCell(sequence_[components_[comp]]);
-                } else {
-                    solveMultiCell(comp_size, &sequence_[components_[comp]]);
+                for (int ii = components_[comp]; ii < components_[comp + 1]; ++ii) {
+                    component_of_cell_[sequence_[ii]] = comp;
                 }
             }
 
+            std::vector<int> level(num_components, 0);
+            int num_levels = 0;
+            for (int comp = 0; comp < num_components; ++comp) {
+                int comp_level = 0;
+                for (int ii = components_[comp]; ii < components_[comp + 1]; ++ii) {
+                    const int cell = sequence_[ii];
+                    for (auto conn : graph_.cellConnections(cell)) {
+                        const int other = neighbourCell(cell, conn);
+                        if (other < 0) {
+                            continue;
+                        }
+                        const int other_comp = component_of_cell_[other];
+                        if (other_comp < comp) {
+                            comp_level = std::max(comp_level, level[other_comp] + 1);
+                        }
+                    }
+                }
+                level[comp] = comp_level;
+                num_levels = std::max(num_levels, comp_level + 1);
+            }
+
+            // Sort the components by level, keeping the sequence within each level.
+            level_start_.assign(num_levels + 1, 0);
+            for (int comp = 0; comp < num_components; ++comp) {
+                ++level_start_[level[comp] + 1];
+            }
+            for (int l = 0; l < num_levels; ++l) {
+                level_start_[l + 1] += level_start_[l];
+            }
+            level_components_.resize(num_components);
+            std::vector<int> pos(level_start_.begin(), level_start_.end() - 1);
+            for (int comp = 0; comp < num_components; ++comp) {
+                level_components_[pos[level[comp]]++] = comp;
+            }
+            OpmLog::debug(std::string("Number of component levels: ") + std::to_string(num_levels));
+        }
+
+
+
+
+        void solveComponents()
+        {
+            MaxChange max_change;
+
+            // Solve the equations, level by level. This gives the same
+            // result as solving the components in sequence.
+            const int num_levels = level_start_.size() - 1;
+#if HAVE_OPENMP
+#pragma omp parallel
+#endif // HAVE_OPENMP
+            {
+                MaxChange change;
+                for (int level = 0; level < num_levels; ++level) {
+#if HAVE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif // HAVE_OPENMP
+                    for (int ii = level_start_[level]; ii < level_start_[level + 1]; ++ii) {
+                        solveComponent(level_components_[ii], change);
+                    }
+                }
+#if HAVE_OPENMP
+#pragma omp critical
+#endif // HAVE_OPENMP
+                max_change.merge(change);
+            }
+            max_change_ = max_change;
+
             // Log the max change.
             {
                 std::ostringstream os;
-                os << "===  Max abs dx[0]: " << max_abs_dx_[0] << " (cell " << max_abs_dx_cell_[0]
-                   <<")  dx[1]: " << max_abs_dx_[1] << " (cell " << max_abs_dx_cell_[1] << ")";
+                os << "===  Max abs dx[0]: " << max_change_.dx[0] << " (cell " << max_change_.cell[0]
+                   <<")  dx[1]: " << max_change_.dx[1] << " (cell " << max_change_.cell[1] << ")";
                 OpmLog::debug(os.str());
             }
         }
@@ -635,7 +782,21 @@ namespace Opm {
 
 
 
-        void solveSingleCell(const int cell)
+        void solveComponent(const int comp, MaxChange& change)
+        {
+            const int comp_size = components_[comp + 1] - components_[comp];
+            if (comp_size == 1) {
+                solveSingleCell(sequence_[components_[comp]], change);
+            } else {
+                solveMultiCell(comp, comp_size, &sequence_[components_[comp]], change);
+            }
+        }
+
+
+
+
+
+        void solveSingleCell(const int cell, MaxChange& change)
         {
 
             Vec2 res;
@@ -650,37 +811,19 @@ namespace Opm {
                 Vec2 dx;
                 jac.solve(dx, res);
                 dx *= relaxation;
-                // const auto hcstate_old = state_.reservoir_state.hydroCarbonState()[cell];
-                updateState(cell, -dx);
-                // const auto hcstate = state_.reservoir_state.hydroCarbonState()[cell];
+                updateState(cell, -dx, change);
                 assembleSingleCell(cell, res, jac);
                 ++iter;
-                if (iter > 10) {
-                    relaxation = 0.85;
-                    if (iter > 15) {
-                        relaxation = 0.70;
-                    }
-                    if (iter > 20) {
-                        relaxation = 0.55;
-                    }
-                    if (iter > 25) {
-                        relaxation = 0.40;
-                    }
-                    if (iter > 30) {
-                        relaxation = 0.25;
-                    }
-                    // std::ostringstream os;
-                    // os << "Iteration " << iter << " in cell " << cell << ", residual = " << res
-                    //    << ", cell values { s = ( " << cstate_[cell].s[Water] << ", " << cstate_[cell].s[Oil] << ", " << cstate_[cell].s[Gas]
-                    //    << " ), rs = " << cstate_[cell].rs << ", rv = " << cstate_[cell].rv << "}, dx = " << dx << ", hcstate: " << hcstate_old << " -> " << hcstate;
-                    // OpmLog::debug(os.str());
-                }
+                relaxation = reorderingNewtonRelaxation(iter);
             }
             if (iter == max_iter) {
                 std::ostringstream os;
                 os << "Failed to converge in cell " << cell << ", residual = " << res
                    << ", cell values { s = ( " << cstate_[cell].s[Water] << ", " << cstate_[cell].s[Oil] << ", " << cstate_[cell].s[Gas]
                    << " ), rs = " << cstate_[cell].rs << ", rv = " << cstate_[cell].rv << " }";
+#if HAVE_OPENMP
+#pragma omp critical
+#endif // HAVE_OPENMP
                 OpmLog::debug(os.str());
             }
         }
@@ -689,11 +832,142 @@ namespace Opm {
 
 
 
-        void solveMultiCell(const int comp_size, const int* cell_array)
+        /// The coupled equations of the cells of a strongly connected
+        /// component, as required by solveComponentNewton().
+        class ComponentSystem
+        {
+        public:
+            ComponentSystem(BlackoilReorderingTransportModel& model, const int comp, const int comp_size,
+                            const int* cell_array, MaxChange& change)
+                : model_(model), comp_(comp), comp_size_(comp_size), cell_array_(cell_array), change_(change)
+            {
+            }
+
+            void assemble(CompVector& res, CompMatrix& jac)
+            {
+                model_.assembleMultiCell(comp_, comp_size_, cell_array_, res, jac);
+            }
+
+            bool converged(const CompVector& res)
+            {
+                return model_.getConvergence(comp_size_, cell_array_, res);
+            }
+
+            CompVector solve(const CompMatrix& jac, const CompVector& res)
+            {
+#if HAVE_UMFPACK
+                return mswellhelpers::invDXDirect(jac, res);
+#else
+                return mswellhelpers::invDX(jac, res);
+#endif // HAVE_UMFPACK
+            }
+
+            void update(const CompVector& dx)
+            {
+                for (int ii = 0; ii < comp_size_; ++ii) {
+                    model_.updateState(cell_array_[ii], -dx[ii], change_);
+                }
+            }
+
+            /// Keep the variables of all cells changed by update() and assemble().
+            void saveState()
+            {
+                auto& rstate = model_.state_.reservoir_state;
+                saturation_.resize(3*comp_size_);
+                rs_.resize(comp_size_);
+                rv_.resize(comp_size_);
+                hcstate_.resize(comp_size_);
+                cstate_.resize(comp_size_);
+                for (int ii = 0; ii < comp_size_; ++ii) {
+                    const int cell = cell_array_[ii];
+                    std::copy_n(rstate.saturation().data() + 3*cell, 3, saturation_.data() + 3*ii);
+                    rs_[ii] = rstate.gasoilratio()[cell];
+                    rv_[ii] = rstate.rv()[cell];
+                    hcstate_[ii] = rstate.hydroCarbonState()[cell];
+                    cstate_[ii] = model_.cstate_[cell];
+                }
+                change_saved_ = change_;
+            }
+
+            void restoreState()
+            {
+                auto& rstate = model_.state_.reservoir_state;
+                for (int ii = 0; ii < comp_size_; ++ii) {
+                    const int cell = cell_array_[ii];
+                    std::copy_n(saturation_.data() + 3*ii, 3, rstate.saturation().data() + 3*cell);
+                    rstate.gasoilratio()[cell] = rs_[ii];
+                    rstate.rv()[cell] = rv_[ii];
+                    rstate.hydroCarbonState()[cell] = hcstate_[ii];
+                    model_.cstate_[cell] = cstate_[ii];
+                }
+                // the updates of the diverged iterations are discarded
+                change_ = change_saved_;
+            }
+
+        private:
+            BlackoilReorderingTransportModel& model_;
+            const int comp_;
+            const int comp_size_;
+            const int* cell_array_;
+            MaxChange& change_;
+            std::vector<double> saturation_;
+            std::vector<double> rs_;
+            std::vector<double> rv_;
+            std::vector<HydroCarbonState> hcstate_;
+            std::vector<CellState<double>> cstate_;
+            MaxChange change_saved_;
+        };
+
+
+
+
+
+        /// Solve the equations of a strongly connected component with a
+        /// Newton method on the coupled system of all its cells. If the
+        /// linear solver fails or Newton does not converge, the cells
+        /// are solved one by one instead, starting from their state before
+        /// the Newton iterations.
+        void solveMultiCell(const int comp, const int comp_size, const int* cell_array, MaxChange& change)
         {
-            // OpmLog::warning("solveMultiCell", "solveMultiCell() called with component size " + std::to_string(comp_size));
             for (int ii = 0; ii < comp_size; ++ii) {
-                solveSingleCell(cell_array[ii]);
+                cell_local_index_[cell_array[ii]] = ii;
+            }
+
+            // Create the sparsity pattern of the component Jacobian.
+            int nnz = comp_size;
+            for (int ii = 0; ii < comp_size; ++ii) {
+                for (auto conn : graph_.cellConnections(cell_array[ii])) {
+                    const int other = neighbourCell(cell_array[ii], conn);
+                    if (other >= 0 && component_of_cell_[other] == comp) {
+                        ++nnz;
+                    }
+                }
+            }
+            CompMatrix jac(comp_size, comp_size, nnz, CompMatrix::row_wise);
+            for (auto row = jac.createbegin(); row != jac.createend(); ++row) {
+                const int cell = cell_array[row.index()];
+                row.insert(row.index());
+                for (auto conn : graph_.cellConnections(cell)) {
+                    const int other = neighbourCell(cell, conn);
+                    if (other >= 0 && component_of_cell_[other] == comp) {
+                        row.insert(cell_local_index_[other]);
+                    }
+                }
+            }
+
+            CompVector res(comp_size);
+            ComponentSystem system(*this, comp, comp_size, cell_array, change);
+            const int max_iter = 100;
+            if (!solveComponentNewton(system, res, jac, max_iter)) {
+                std::ostringstream os;
+                os << "Failed to converge in component of " << comp_size << " cells, solving cell by cell.";
+#if HAVE_OPENMP
+#pragma omp critical
+#endif // HAVE_OPENMP
+                OpmLog::debug(os.str());
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    solveSingleCell(cell_array[ii], change);
+                }
             }
         }
 
@@ -731,13 +1005,97 @@ namespace Opm {
 
 
 
-        void assembleSingleCell(const int cell, Vec2& res, Mat22& jac)
+        /// Computes the oil and gas fluxes out of a cell over one of its connections.
+        /// Derivatives are with respect to the variables of the cell state given as
+        /// Eval, the other state is treated as constant.
+        template <typename ScalarCell, typename ScalarOther>
+        void connectionFlux(const detail::Connection& conn,
+                            const CellState<ScalarCell>& st,
+                            const CellState<ScalarOther>& so,
+                            Eval& oilflux,
+                            Eval& gasflux)
         {
-            assert(numPhases() == 3); // I apologize for this to my future self, that will have to fix it.
+            const double vt = conn.sign * total_flux_[conn.index];
+            const double gdz = conn.sign * gdz_[conn.index];
+
+            Eval dh[3];
+            Eval dh_sat[3];
+            const Eval grad_oil_press = so.p[Oil] - st.p[Oil];
+            for (int phase : { Water, Oil, Gas }) {
+                const Eval gradp = so.p[phase] - st.p[phase];
+                const Eval rhoavg = 0.5 * (st.rho[phase] + so.rho[phase]);
+                dh[phase] = gradp - rhoavg * gdz;
+                if (Base::use_threshold_pressure_) {
+                    applyThresholdPressure(conn.index, dh[phase]);
+                }
+                dh_sat[phase] = grad_oil_press - dh[phase];
+            }
+            const double tran = trans_all_[conn.index]; // TODO: include tr_mult effect.
+            const auto& m1 = st.lambda;
+            const auto& m2 = so.lambda;
+            const auto upw = connectionMultiPhaseUpwind({{ dh_sat[Water].value(), dh_sat[Oil].value(), dh_sat[Gas].value() }},
+                                                        {{ detail::valueOf(m1[Water]), detail::valueOf(m1[Oil]), detail::valueOf(m1[Gas]) }},
+                                                        {{ detail::valueOf(m2[Water]), detail::valueOf(m2[Oil]), detail::valueOf(m2[Gas]) }},
+                                                        tran, vt);
+            Eval b[3];
+            Eval mob[3];
+            Eval tot_mob = Eval::createConstant(0.0);
+            for (int phase : { Water, Oil, Gas }) {
+                if (upw[phase] > 0.0) {
+                    b[phase] = st.b[phase];
+                    mob[phase] = m1[phase];
+                } else {
+                    b[phase] = so.b[phase];
+                    mob[phase] = m2[phase];
+                }
+                tot_mob += mob[phase];
+            }
+            Eval rs;
+            Eval rv;
+            if (upw[Oil] > 0.0) {
+                rs = st.rs;
+            } else {
+                rs = so.rs;
+            }
+            if (upw[Gas] > 0.0) {
+                rv = st.rv;
+            } else {
+                rv = so.rv;
+            }
+
+            Eval flux[3];
+            for (int phase : { Oil, Gas }) {
+                Eval gflux = Eval::createConstant(0.0);
+                for (int other_phase : { Water, Oil, Gas }) {
+                    if (phase != other_phase) {
+                        gflux += mob[other_phase] * (dh_sat[phase] - dh_sat[other_phase]);
+                    }
+                }
+                flux[phase] = b[phase] * (mob[phase] / tot_mob) * (vt + tran*gflux);
+            }
+            oilflux = flux[Oil] + rv*flux[Gas];
+            gasflux = flux[Gas] + rs*flux[Oil];
+        }
+
 
+
+
+        void assembleSingleCell(const int cell, Vec2& res, Mat22& jac)
+        {
             CellState<Eval> st;
             computeCellState(cell, state_, st);
             cstate_[cell] = st.template flatten<double>();
+            assembleCell(cell, st, res, jac);
+        }
+
+
+
+
+        /// Assemble the residual and the Jacobian with respect to the cell's own
+        /// variables. The states of all neighbours are taken from cstate_.
+        void assembleCell(const int cell, const CellState<Eval>& st, Vec2& res, Mat22& jac)
+        {
+            assert(numPhases() == 3); // I apologize for this to my future self, that will have to fix it.
 
             // Accumulation terms.
             const double pvm0 = state0_.pv_mult[cell];
@@ -751,67 +1109,22 @@ namespace Opm {
             Eval div_oilflux = Eval::createConstant(0.0);
             Eval div_gasflux = Eval::createConstant(0.0);
             for (auto conn : graph_.cellConnections(cell)) {
-                auto conn_cells = graph_.connectionCells(conn.index);
-                const int from = conn_cells[0];
-                const int to = conn_cells[1];
-                if (from < 0 || to < 0) {
+                const int other = neighbourCell(cell, conn);
+                if (other < 0) {
                     continue; // Boundary.
                 }
-                assert((from == cell) == (conn.sign > 0.0));
-                const int other = from == cell ? to : from;
-                const double vt = conn.sign * total_flux_[conn.index];
-                const double gdz = conn.sign * gdz_[conn.index];
+                assert((graph_.connectionCells(conn.index)[0] == cell) == (conn.sign > 0.0));
 
                 // From this point, we treat everything about this
                 // connection as going from 'cell' to 'other'. Since
                 // we don't want derivatives from the 'other' cell to
                 // participate in the solution, we use the constant
                 // values from cstate_[other].
-                Eval dh[3];
-                Eval dh_sat[3];
-                const Eval grad_oil_press = cstate_[other].p[Oil] - st.p[Oil];
-                for (int phase : { Water, Oil, Gas }) {
-                    const Eval gradp = cstate_[other].p[phase] - st.p[phase];
-                    const Eval rhoavg = 0.5 * (st.rho[phase] + cstate_[other].rho[phase]);
-                    dh[phase] = gradp - rhoavg * gdz;
-                    if (Base::use_threshold_pressure_) {
-                        applyThresholdPressure(conn.index, dh[phase]);
-                    }
-                    dh_sat[phase] = grad_oil_press - dh[phase];
-                }
-                const double tran = trans_all_[conn.index]; // TODO: include tr_mult effect.
-                const auto& m1 = st.lambda;
-                const auto& m2 = cstate_[other].lambda;
-                const auto upw = connectionMultiPhaseUpwind({{ dh_sat[Water].value(), dh_sat[Oil].value(), dh_sat[Gas].value() }},
-                                                            {{ m1[Water].value(), m1[Oil].value(), m1[Gas].value() }},
-                                                            {{ m2[Water], m2[Oil], m2[Gas] }},
-                                                            tran, vt);
-                // if (upw[0] != upw[1] || upw[1] != upw[2]) {
-                //     OpmLog::debug("Detected countercurrent flow between cells " + std::to_string(from) + " and " + std::to_string(to));
-                // }
-                Eval b[3];
-                Eval mob[3];
-                Eval tot_mob = Eval::createConstant(0.0);
-                for (int phase : { Water, Oil, Gas }) {
-                    b[phase] = upw[phase] > 0.0 ? st.b[phase] : cstate_[other].b[phase];
-                    mob[phase] = upw[phase] > 0.0 ? m1[phase] : m2[phase];
-                    tot_mob += mob[phase];
-                }
-                Eval rs = upw[Oil] > 0.0 ? st.rs : cstate_[other].rs;
-                Eval rv = upw[Gas] > 0.0 ? st.rv : cstate_[other].rv;
-
-                Eval flux[3];
-                for (int phase : { Oil, Gas }) {
-                    Eval gflux = Eval::createConstant(0.0);
-                    for (int other_phase : { Water, Oil, Gas }) {
-                        if (phase != other_phase) {
-                            gflux += mob[other_phase] * (dh_sat[phase] - dh_sat[other_phase]);
-                        }
-                    }
-                    flux[phase] = b[phase] * (mob[phase] / tot_mob) * (vt + tran*gflux);
-                }
-                div_oilflux += flux[Oil] + rv*flux[Gas];
-                div_gasflux += flux[Gas] + rs*flux[Oil];
+                Eval oilflux;
+                Eval gasflux;
+                connectionFlux(conn, st, cstate_[other], oilflux, gasflux);
+                div_oilflux += oilflux;
+                div_gasflux += gasflux;
             }
 
             // Well fluxes.
@@ -844,6 +1157,46 @@ namespace Opm {
 
 
 
+        /// Assemble the residual and the Jacobian of all cells of a component,
+        /// including the derivatives with respect to the neighbours within it.
+        void assembleMultiCell(const int comp, const int comp_size, const int* cell_array,
+                               CompVector& res, CompMatrix& jac)
+        {
+            // Update all cell states first, the cells are coupled.
+            std::vector<CellState<Eval>> st(comp_size);
+            for (int ii = 0; ii < comp_size; ++ii) {
+                computeCellState(cell_array[ii], state_, st[ii]);
+                cstate_[cell_array[ii]] = st[ii].template flatten<double>();
+            }
+
+            jac = 0.0;
+            for (int ii = 0; ii < comp_size; ++ii) {
+                const int cell = cell_array[ii];
+                assembleCell(cell, st[ii], res[ii], jac[ii][ii]);
+
+                // Derivatives of the fluxes with respect to the neighbours
+                // in the component.
+                for (auto conn : graph_.cellConnections(cell)) {
+                    const int other = neighbourCell(cell, conn);
+                    if (other < 0 || component_of_cell_[other] != comp) {
+                        continue;
+                    }
+                    const int jj = cell_local_index_[other];
+                    Eval oilflux;
+                    Eval gasflux;
+                    connectionFlux(conn, cstate_[cell], st[jj], oilflux, gasflux);
+                    Mat22& block = jac[ii][jj];
+                    block[0][0] += oilflux.derivative(0);
+                    block[0][1] += oilflux.derivative(1);
+                    block[1][0] += gasflux.derivative(0);
+                    block[1][1] += gasflux.derivative(1);
+                }
+            }
+        }
+
+
+
+
 
         bool getConvergence(const int cell, const Vec2& res)
         {
@@ -857,17 +1210,32 @@ namespace Opm {
 
 
 
+        bool getConvergence(const int comp_size, const int* cell_array, const CompVector& res)
+        {
+            for (int ii = 0; ii < comp_size; ++ii) {
+                if (!getConvergence(cell_array[ii], res[ii])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+
+
+
         void updateState(const int cell,
-                         const Vec2& dx)
+                         const Vec2& dx,
+                         MaxChange& change)
         {
-            if (std::fabs(dx[0]) > max_abs_dx_[0]) {
-                max_abs_dx_cell_[0] = cell;
+            if (std::fabs(dx[0]) > change.dx[0]) {
+                change.cell[0] = cell;
             }
-            if (std::fabs(dx[1]) > max_abs_dx_[1]) {
-                max_abs_dx_cell_[1] = cell;
+            if (std::fabs(dx[1]) > change.dx[1]) {
+                change.cell[1] = cell;
             }
-            max_abs_dx_[0] = std::max(max_abs_dx_[0], std::fabs(dx[0]));
-            max_abs_dx_[1] = std::max(max_abs_dx_[1], std::fabs(dx[1]));
+            change.dx[0] = std::max(change.dx[0], std::fabs(dx[0]));
+            change.dx[1] = std::max(change.dx[1], std::fabs(dx[1]));
+            ++change.updates;
 
             // Get saturation updates.
             const double dsw = dx[0];
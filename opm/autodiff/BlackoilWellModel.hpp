@@ -29,8 +29,18 @@
 #include <opm/common/utility/platform_dependent/disable_warnings.h>
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
+#include <exception>
+#include <map>
+#include <memory>
+#include <set>
 #include <tuple>
+#include <unordered_map>
 
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 
@@ -87,6 +97,7 @@ namespace Opm {
             // or there is some other strategy, like TypeTag
             typedef Dune::FieldVector<Scalar, numEq    > VectorBlockType;
             typedef Dune::BlockVector<VectorBlockType> BVector;
+            typedef typename WellInterface<TypeTag>::Mat Mat;
 
             typedef Ewoms::BlackOilPolymerModule<TypeTag> PolymerModule;
 
@@ -99,9 +110,13 @@ namespace Opm {
                               const bool terminal_output);
 
             // compute the well fluxes and assemble them in to the reservoir equations as source terms
-            // and in the well equations.
+            // and in the well equations. B_avg are the average formation volume factors of the
+            // components over the global grid, used to scale the residuals of the well equations.
+            // Only the first numComponents() entries are used, further entries of the reservoir
+            // equations (polymer) are ignored.
             void assemble(const int iterationIdx,
-                                     const double dt);
+                          const double dt,
+                          const std::vector<Scalar>& B_avg);
 
             // substract Binv(D)rw from r;
             void apply( BVector& r) const;
@@ -112,6 +127,10 @@ namespace Opm {
             // apply well model with scaling of alpha
             void applyScaleAdd(const Scalar alpha, const BVector& x, BVector& Ax) const;
 
+            // copy B, C and D^-1 of the wells to wells for the capture of the linear
+            // system, returns the number of wells which could not be captured
+            int captureLinearSystem(std::vector<LinearSystemWell>& wells) const;
+
             // using the solution x to recover the solution xw for wells and applying
             // xw to update Well State
             void recoverWellSolutionAndUpdateWellState(const BVector& x);
@@ -136,6 +155,8 @@ namespace Opm {
 
             // called at the beginning of a time step
             void beginTimeStep();
+            // restore the well state of the last successful time step
+            void resetWellState();
             // called at the end of a time step
             void timeStepSucceeded();
 
@@ -167,6 +188,34 @@ namespace Opm {
             // create the well container
             std::vector<WellInterfacePtr > createWellContainer(const int time_step) const;
 
+            // indices of the wells ordered by decreasing computational cost, grouped such that
+            // no two wells of the same group perforate the same cell. wells of one group can
+            // write to the reservoir system concurrently.
+            std::vector<std::vector<int> > well_colors_;
+            // indices of all the wells ordered by decreasing computational cost
+            std::vector<int> wells_by_cost_;
+
+            // compute well_colors_ and wells_by_cost_ for the current well container
+            void computeWellColoring();
+
+            // apply op to each well. With use_parallel_wells_, the wells are processed
+            // concurrently, and if writes_to_cells is true only wells that do not share
+            // perforated cells are processed at the same time.
+            template <class Op>
+            void forEachWell(const bool writes_to_cells, const Op& op) const;
+
+            // the combined contributions - C^T D^-1 B of the wells supporting it,
+            // only created with use_well_coupling_operator_
+            std::unique_ptr<Mat> coupling_operator_;
+            // number of wells contained in coupling_operator_
+            int num_wells_in_coupling_operator_ = 0;
+
+            // create the sparsity pattern of coupling_operator_ for the current well container
+            void createCouplingOperator();
+
+            // compute the entries of coupling_operator_ from the assembled well equations
+            void updateCouplingOperator();
+
             WellState well_state_;
             WellState previous_well_state_;
 
@@ -209,8 +258,6 @@ namespace Opm {
             void computeRepRadiusPerfLength(const Grid& grid);
 
 
-            void computeAverageFormationFactor(std::vector<double>& B_avg) const;
-
             void applyVREPGroupControl();
 
             void computeWellVoidageRates(std::vector<double>& well_voidage_rates,
@@ -230,7 +277,8 @@ namespace Opm {
             /// at the beginning of the time step and no derivatives are included in these quantities
             void calculateExplicitQuantities() const;
 
-            SimulatorReport solveWellEq(const double dt);
+            SimulatorReport solveWellEq(const double dt,
+                                        const std::vector<Scalar>& B_avg);
 
             void initPrimaryVariablesEvaluation() const;
 
@@ -122,6 +122,13 @@ namespace Opm {
             well->init(&phase_usage_, &active_, depth_, gravity_, number_of_cells_);
         }
 
+        // group the wells for the concurrent processing
+        computeWellColoring();
+
+        if (param_.use_well_coupling_operator_) {
+            createCouplingOperator();
+        }
+
         // calculate the efficiency factors for each well
         calculateEfficiencyFactors();
 
@@ -149,14 +156,22 @@ namespace Opm {
     void
     BlackoilWellModel<TypeTag>::
     beginTimeStep() {
-        well_state_ = previous_well_state_;
-
+        // the well state equals the previous one unless a failed time step is
+        // repeated from its last iterate, see resetWellState()
         if (wellCollection().havingVREPGroups() ) {
             rateConverter_->template defineState<ElementContext>(ebosSimulator_);
 
         }
     }
 
+    // called when a failed time step is repeated
+    template<typename TypeTag>
+    void
+    BlackoilWellModel<TypeTag>::
+    resetWellState() {
+        well_state_ = previous_well_state_;
+    }
+
     // only use this for restart.
     template<typename TypeTag>
     void
@@ -241,14 +256,177 @@ namespace Opm {
 
 
 
+
     template<typename TypeTag>
     void
     BlackoilWellModel<TypeTag>::
-    assemble(const int iterationIdx,
-             const double dt)
+    computeWellColoring()
     {
+        const int nw = well_container_.size();
+
+        wells_by_cost_.resize(nw);
+        std::vector<double> cost(nw);
+        for (int w = 0; w < nw; ++w) {
+            wells_by_cost_[w] = w;
+            cost[w] = well_container_[w]->computationalCost();
+        }
+        // the expensive wells are scheduled first to balance the load between threads
+        std::stable_sort(wells_by_cost_.begin(), wells_by_cost_.end(),
+                         [&cost](const int a, const int b) { return cost[a] > cost[b]; });
+
+        // greedy coloring, a well gets the first color not used by any
+        // other well perforating one of its cells
+        well_colors_.clear();
+        std::unordered_map<int, std::vector<int> > colors_of_cell;
+        std::vector<bool> used;
+        for (const int w : wells_by_cost_) {
+            const auto& cells = well_container_[w]->cells();
+            used.assign(well_colors_.size(), false);
+            for (const int cell : cells) {
+                const auto it = colors_of_cell.find(cell);
+                if (it != colors_of_cell.end()) {
+                    for (const int color : it->second) {
+                        used[color] = true;
+                    }
+                }
+            }
+            const int color = std::find(used.begin(), used.end(), false) - used.begin();
+            if (color == int(well_colors_.size())) {
+                well_colors_.emplace_back();
+            }
+            well_colors_[color].push_back(w);
+            for (const int cell : cells) {
+                colors_of_cell[cell].push_back(color);
+            }
+        }
+    }
+
+
 
 
+
+    template<typename TypeTag>
+    void
+    BlackoilWellModel<TypeTag>::
+    createCouplingOperator()
+    {
+        // each well couples all its perforated cells
+        std::map<int, std::set<int> > pattern;
+        num_wells_in_coupling_operator_ = 0;
+        for (const auto& well : well_container_) {
+            if (well->supportsCouplingOperator()) {
+                const auto& cells = well->cells();
+                for (const int cell : cells) {
+                    pattern[cell].insert(cells.begin(), cells.end());
+                }
+                ++num_wells_in_coupling_operator_;
+            }
+        }
+
+        size_t nnz = 0;
+        for (const auto& row : pattern) {
+            nnz += row.second.size();
+        }
+
+        const int nc = number_of_cells_;
+        coupling_operator_.reset(new Mat(nc, nc, nnz, Mat::row_wise));
+        auto pattern_row = pattern.begin();
+        const auto endrow = coupling_operator_->createend();
+        for (auto row = coupling_operator_->createbegin(); row != endrow; ++row) {
+            if (pattern_row != pattern.end() && pattern_row->first == int(row.index())) {
+                for (const int col : pattern_row->second) {
+                    row.insert(col);
+                }
+                ++pattern_row;
+            }
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    BlackoilWellModel<TypeTag>::
+    updateCouplingOperator()
+    {
+        Mat& coupling = *coupling_operator_;
+        coupling = 0.0;
+        // a well only writes to the rows of its perforated cells
+        forEachWell(true, [&coupling](const WellInterface<TypeTag>& well) {
+            if (well.supportsCouplingOperator()) {
+                well.addWellContributions(coupling);
+            }
+        });
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    template <class Op>
+    void
+    BlackoilWellModel<TypeTag>::
+    forEachWell(const bool writes_to_cells, const Op& op) const
+    {
+#if HAVE_OPENMP
+        if (param_.use_parallel_wells_ && omp_get_max_threads() > 1) {
+            // exceptions must not leave the parallel region, the first
+            // one is stored and rethrown afterwards
+            std::exception_ptr exception;
+            const std::vector<int>* groups = writes_to_cells ? well_colors_.data() : &wells_by_cost_;
+            const int num_groups = writes_to_cells ? well_colors_.size() : 1;
+#pragma omp parallel
+            {
+                for (int g = 0; g < num_groups; ++g) {
+                    const std::vector<int>& group = groups[g];
+                    const int group_size = group.size();
+#pragma omp for schedule(dynamic, 1)
+                    for (int i = 0; i < group_size; ++i) {
+                        try {
+                            op(*well_container_[group[i]]);
+                        }
+                        catch (...) {
+#pragma omp critical
+                            {
+                                if (!exception) {
+                                    exception = std::current_exception();
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+            return;
+        }
+#else
+        static_cast<void>(writes_to_cells);
+#endif // HAVE_OPENMP
+
+        for (const auto& well : well_container_) {
+            op(*well);
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    BlackoilWellModel<TypeTag>::
+    assemble(const int iterationIdx,
+             const double dt,
+             const std::vector<Scalar>& B_avg)
+    {
+        // the entries after the well components, e.g. for polymer, are not used
+        assert(int(B_avg.size()) >= numComponents());
+
         last_report_ = SimulatorReport();
 
         if ( ! wellsActive() ) {
@@ -271,10 +449,14 @@ namespace Opm {
 
         if (param_.solve_welleq_initially_ && iterationIdx == 0) {
             // solve the well equations as a pre-processing step
-            last_report_ = solveWellEq(dt);
+            last_report_ = solveWellEq(dt, B_avg);
         }
         assembleWellEq(dt, false);
 
+        if (coupling_operator_) {
+            updateCouplingOperator();
+        }
+
         last_report_.converged = true;
     }
 
@@ -288,9 +470,11 @@ namespace Opm {
     assembleWellEq(const double dt,
                    bool only_wells)
     {
-        for (int w = 0; w < numWells(); ++w) {
-            well_container_[w]->assembleWellEq(ebosSimulator_, dt, well_state_, only_wells);
-        }
+        // the wells write to the reservoir system and temporarily switch the
+        // saturation region of their perforated cells
+        forEachWell(true, [&](WellInterface<TypeTag>& well) {
+            well.assembleWellEq(ebosSimulator_, dt, well_state_, only_wells);
+        });
     }
 
 
@@ -308,9 +492,9 @@ namespace Opm {
             return;
         }
 
-        for (auto& well : well_container_) {
-            well->apply(r);
-        }
+        forEachWell(true, [&r](const WellInterface<TypeTag>& well) {
+            well.apply(r);
+        });
     }
 
 
@@ -328,9 +512,20 @@ namespace Opm {
             return;
         }
 
-        for (auto& well : well_container_) {
-            well->apply(x, Ax);
+        if (coupling_operator_) {
+            // the wells contained in the coupling operator in a single product
+            coupling_operator_->umv(x, Ax);
+            if (num_wells_in_coupling_operator_ == int(well_container_.size())) {
+                return;
+            }
         }
+
+        const bool skip_coupled = bool(coupling_operator_);
+        forEachWell(true, [&x, &Ax, skip_coupled](const WellInterface<TypeTag>& well) {
+            if (!(skip_coupled && well.supportsCouplingOperator())) {
+                well.apply(x, Ax);
+            }
+        });
     }
 
 
@@ -362,6 +557,32 @@ namespace Opm {
 
 
 
+    template<typename TypeTag>
+    int
+    BlackoilWellModel<TypeTag>::
+    captureLinearSystem(std::vector<LinearSystemWell>& wells) const
+    {
+        wells.clear();
+        if ( ! localWellsActive() ) {
+            return 0;
+        }
+
+        int not_captured = 0;
+        for (const auto& well : well_container_) {
+            LinearSystemWell captured;
+            if (well->captureLinearSystem(captured)) {
+                wells.push_back(std::move(captured));
+            } else {
+                ++not_captured;
+            }
+        }
+        return not_captured;
+    }
+
+
+
+
+
     template<typename TypeTag>
     void
     BlackoilWellModel<TypeTag>::
@@ -370,9 +591,10 @@ namespace Opm {
         if (!localWellsActive())
             return;
 
-        for (auto& well : well_container_) {
-            well->recoverWellSolutionAndUpdateWellState(x, well_state_);
-        }
+        // only the state of the well itself is updated
+        forEachWell(false, [&](const WellInterface<TypeTag>& well) {
+            well.recoverWellSolutionAndUpdateWellState(x, well_state_);
+        });
     }
 
 
@@ -470,15 +692,12 @@ namespace Opm {
     template<typename TypeTag>
     SimulatorReport
     BlackoilWellModel<TypeTag>::
-    solveWellEq(const double dt)
+    solveWellEq(const double dt,
+                const std::vector<Scalar>& B_avg)
     {
         const int nw = numWells();
         WellState well_state0 = well_state_;
 
-        const int numComp = numComponents();
-        std::vector< Scalar > B_avg( numComp, Scalar() );
-        computeAverageFormationFactor(B_avg);
-
         const int max_iter = param_.max_welleq_iter_;
 
         int it  = 0;
@@ -663,6 +882,13 @@ namespace Opm {
         well_potentials.resize(nw * np, 0.0);
 
         for (int w = 0; w < nw; ++w) {
+            // the potentials are only used for the guide rates of the wells with guide rates
+            // based on the well potentials, the potentials of the other wells are left as zero
+            const WellNode& well_node = wellCollection().findWellNode(well_container_[w]->name());
+            if ( !well_node.isGuideRateWellPotential() ) {
+                continue;
+            }
+
             std::vector<double> potentials;
             well_container_[w]->computeWellPotentials(ebosSimulator_, well_state_, potentials);
 
@@ -999,52 +1225,6 @@ namespace Opm {
 
 
 
-    template<typename TypeTag>
-    void
-    BlackoilWellModel<TypeTag>::
-    computeAverageFormationFactor(std::vector<double>& B_avg) const
-    {
-        const int np = numPhases();
-
-        const auto& grid = ebosSimulator_.gridManager().grid();
-        const auto& gridView = grid.leafGridView();
-        ElementContext elemCtx(ebosSimulator_);
-        const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
-
-        for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-             elemIt != elemEndIt; ++elemIt)
-        {
-            elemCtx.updatePrimaryStencil(*elemIt);
-            elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-
-            const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-            const auto& fs = intQuants.fluidState();
-
-            for ( int phaseIdx = 0; phaseIdx < np; ++phaseIdx )
-            {
-                auto& B  = B_avg[ phaseIdx ];
-                const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phaseIdx);
-
-                B += 1 / fs.invB(ebosPhaseIdx).value();
-            }
-            if (has_solvent_) {
-                auto& B  = B_avg[solventSaturationIdx];
-                B += 1 / intQuants.solventInverseFormationVolumeFactor().value();
-            }
-        }
-
-        // compute global average
-        grid.comm().sum(B_avg.data(), B_avg.size());
-        for(auto& bval: B_avg)
-        {
-            bval/=global_nc_;
-        }
-    }
-
-
-
-
-
     template<typename TypeTag>
     void
     BlackoilWellModel<TypeTag>::
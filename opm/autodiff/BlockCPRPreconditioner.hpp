@@ -0,0 +1,359 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_BLOCKCPRPRECONDITIONER_HEADER_INCLUDED
+#define OPM_BLOCKCPRPRECONDITIONER_HEADER_INCLUDED
+
+#include <opm/autodiff/CPRPreconditioner.hpp>
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/paamg/pinfo.hh>
+
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Opm
+{
+
+    /*!
+      \brief Two-stage constrained pressure residual (CPR) preconditioner for block systems.
+
+      In contrast to CPRPreconditioner, which needs the elliptic part as a separate
+      matrix, this preconditioner works directly on the block-structured matrix of
+      the fully implicit system. The pressure equation of each cell is decoupled as
+      a linear combination of the cell equations. With quasi-IMPES weights these are
+      chosen such that the derivatives of the combined equation with respect to the
+      non-pressure variables of the cell itself vanish, otherwise the equations are
+      simply added. The scalar pressure system is approximately solved by AMG
+      V-cycles, and the remaining residual of the full system, including the
+      contributions of the wells contained in the operator, is treated by the given
+      block ILU0 preconditioner.
+
+      \tparam Operator      The type of the linear operator of the full system. It has
+                            to provide the matrix of the reservoir equations by getmat().
+      \tparam Smoother      The type of the preconditioner of the second stage.
+      \tparam pressureIndex The index of the pressure in the vector blocks.
+      \tparam P             Type of the parallel information. If not provided
+                            this will be Dune::Amg::SequentialInformation.
+    */
+    template<class Operator, class Smoother, int pressureIndex,
+             class P=Dune::Amg::SequentialInformation>
+    class BlockCPRPreconditioner
+        : public Dune::Preconditioner<typename Operator::domain_type, typename Operator::range_type>
+    {
+        // prohibit copying for now
+        BlockCPRPreconditioner( const BlockCPRPreconditioner& );
+
+    public:
+        //! \brief The type describing the parallel information
+        typedef P ParallelInformation;
+        //! \brief The matrix type the preconditioner is for.
+        typedef typename std::remove_const<typename Operator::matrix_type>::type matrix_type;
+        //! \brief The domain type of the preconditioner.
+        typedef typename Operator::domain_type domain_type;
+        //! \brief The range type of the preconditioner.
+        typedef typename Operator::range_type range_type;
+        //! \brief The field type of the preconditioner.
+        typedef typename domain_type::field_type field_type;
+
+        typedef typename matrix_type::block_type block_type;
+        typedef typename matrix_type::size_type  size_type;
+
+        // define the category
+        enum {
+            //! \brief The category the preconditioner is part of.
+            category = std::is_same<P,Dune::Amg::SequentialInformation>::value?
+            Dune::SolverCategory::sequential:Dune::SolverCategory::overlapping
+        };
+
+        static const int blockSize = block_type::rows;
+
+        //! \brief The weights of the equations of one cell forming the pressure equation.
+        typedef Dune::FieldVector<field_type, blockSize> WeightType;
+
+        //! \brief The scalar pressure system.
+        typedef Dune::BCRSMatrix< Dune::FieldMatrix<field_type, 1, 1> > PressureMatrix;
+        typedef Dune::BlockVector< Dune::FieldVector<field_type, 1> >   PressureVector;
+
+        typedef ISTLUtility::CPRSelector<PressureMatrix, PressureVector, PressureVector, P> PressureSelector;
+        //! \brief The operator of the pressure system.
+        typedef typename PressureSelector::Operator PressureOperator;
+        //! \brief The AMG used for the pressure system.
+        typedef typename PressureSelector::AMG      PressureAMG;
+
+        /*! \brief Constructor.
+
+          \param op          The linear operator of the full system.
+          \param smoother    The preconditioner for the second stage, e.g. block ILU0.
+          \param vcycles     The number of AMG V-cycles for the pressure system.
+          \param quasiImpes  If true, quasi-IMPES weights are used for decoupling the
+                             pressure equation, otherwise the cell equations are added.
+          \param comm        The information about the parallelization, it has to
+                             outlive the preconditioner or the next call to update().
+        */
+        BlockCPRPreconditioner(const Operator& op,
+                               std::unique_ptr< Smoother > smoother,
+                               const int vcycles,
+                               const bool quasiImpes,
+                               const ParallelInformation& comm = ParallelInformation())
+            : op_( &op ),
+              A_( &op.getmat() ),
+              smoother_( std::move( smoother ) ),
+              comm_( &comm ),
+              vcycles_( std::max( vcycles, 1 ) ),
+              quasiImpes_( quasiImpes ),
+              weights_( A_->N() ),
+              Ap_( A_->N(), A_->M(), A_->nonzeroes(), PressureMatrix::row_wise ),
+              rp_( A_->N() ),
+              xp_( A_->N() ),
+              dp_( A_->N() ),
+              cp_( A_->N() ),
+              dmodified_( A_->N() ),
+              vilu_( A_->N() )
+        {
+            assert( smoother_ );
+            createPressureMatrix();
+            computeWeights();
+            computePressureMatrix();
+
+            opAp_.reset( PressureSelector::makeOperator( Ap_, *comm_ ) );
+            const double relax = 1.0;
+            ISTLUtility::createAMGPreconditionerPointer( *opAp_, relax, *comm_, amg_ );
+        }
+
+        /*! \brief Recompute the preconditioner for new values of the matrix.
+
+          The matrix of op has to have the sparsity pattern of the one used for the
+          construction. The weights and the pressure matrix are recomputed in the
+          storage of the previous ones, the AMG of the pressure system is set up
+          anew, as its smoothers and coarse solver would otherwise keep the
+          factorizations of the previous pressure matrix, and the smoother keeps
+          its storage and recomputes its factorization. As the operator of the
+          pressure system refers to the parallel information it was set up with,
+          this is only available for sequential runs.
+
+          \param op    The linear operator of the full system.
+          \param comm  The information about the parallelization.
+        */
+        void update(const Operator& op, const ParallelInformation& comm)
+        {
+            static_assert( std::is_same<P, Dune::Amg::SequentialInformation>::value,
+                           "The CPR preconditioner can only be updated in sequential runs" );
+            op_ = &op;
+            A_ = &op.getmat();
+            comm_ = &comm;
+            assert( A_->N() == Ap_.N() && A_->nonzeroes() == Ap_.nonzeroes() );
+
+            computeWeights();
+            computePressureMatrix();
+            amg_.reset();
+            const double relax = 1.0;
+            ISTLUtility::createAMGPreconditionerPointer( *opAp_, relax, *comm_, amg_ );
+            smoother_->update( *A_ );
+        }
+
+        /*!
+          \brief Prepare the preconditioner.
+
+          \copydoc Preconditioner::pre(X&,Y&)
+        */
+        virtual void pre (domain_type& x, range_type& b)
+        {
+            // the AMG sets up the vector hierarchies needed for apply
+            xp_ = 0.0;
+            rp_ = 0.0;
+            amg_->pre( xp_, rp_ );
+            smoother_->pre( x, b );
+        }
+
+        /*!
+          \brief Apply the preconditoner.
+
+          \copydoc Preconditioner::apply(X&,const Y&)
+        */
+        virtual void apply (domain_type& v, const range_type& d)
+        {
+            // Restrict the residual to the pressure equation.
+            const size_type size = d.size();
+            for( size_type i = 0; i < size; ++i ) {
+                rp_[ i ] = weights_[ i ] * d[ i ];
+            }
+
+            // Approximate pressure solve by AMG V-cycles.
+            xp_ = 0.0;
+            for( int cycle = 0; cycle < vcycles_; ++cycle )
+            {
+                dp_ = rp_;
+                if( cycle > 0 ) {
+                    opAp_->applyscaleadd( -1.0, xp_, dp_ );
+                }
+                cp_ = 0.0;
+                amg_->apply( cp_, dp_ );
+                xp_ += cp_;
+            }
+            comm_->copyOwnerToAll( xp_, xp_ );
+
+            // Prolongate the pressure correction.
+            v = 0.0;
+            for( size_type i = 0; i < size; ++i ) {
+                v[ i ][ pressureIndex ] = xp_[ i ];
+            }
+
+            // Residual of the full system including the wells.
+            // dmodified = d - A * v
+            dmodified_ = d;
+            op_->applyscaleadd( -1.0, v, dmodified_ );
+
+            // Apply the preconditioner for the whole system.
+            vilu_ = 0.0;
+            smoother_->apply( vilu_, dmodified_ );
+            v += vilu_;
+        }
+
+        /*!
+          \brief Clean up.
+
+          \copydoc Preconditioner::post(X&)
+        */
+        virtual void post (domain_type& x)
+        {
+            amg_->post( xp_ );
+            smoother_->post( x );
+        }
+
+        //! \brief The scalar pressure matrix (for testing).
+        const PressureMatrix& pressureMatrix() const { return Ap_; }
+
+        //! \brief The weights forming the pressure equation of each cell (for testing).
+        const std::vector< WeightType >& weights() const { return weights_; }
+
+    protected:
+        //! \brief Create the sparsity pattern of the pressure matrix from the one of A.
+        void createPressureMatrix()
+        {
+            const auto endRow = Ap_.createend();
+            for( auto row = Ap_.createbegin(); row != endRow; ++row )
+            {
+                const auto& Arow = (*A_)[ row.index() ];
+                const auto endCol = Arow.end();
+                for( auto col = Arow.begin(); col != endCol; ++col ) {
+                    row.insert( col.index() );
+                }
+            }
+        }
+
+        //! \brief Compute the weights of the cell equations forming the pressure equation.
+        void computeWeights()
+        {
+            const auto endi = A_->end();
+            for( auto row = A_->begin(); row != endi; ++row )
+            {
+                const size_type rowIdx = row.index();
+                WeightType& w = weights_[ rowIdx ];
+                w = 1.0;
+                if( ! quasiImpes_ ) {
+                    continue;
+                }
+
+                // w solves D^T w = e_p, i.e. it is the pressure row of the
+                // inverse of the diagonal block D.
+                block_type diagInv( (*row)[ rowIdx ] );
+                try {
+                    diagInv.invert();
+                }
+                catch ( const Dune::FMatrixError& ) {
+                    // keep the unit weights for singular diagonal blocks
+                    continue;
+                }
+
+                for( int eq = 0; eq < blockSize; ++eq ) {
+                    w[ eq ] = diagInv[ pressureIndex ][ eq ];
+                }
+
+                // scale the weights to order one
+                const field_type maxWeight = w.infinity_norm();
+                if( maxWeight > 0.0 ) {
+                    w /= maxWeight;
+                }
+            }
+        }
+
+        //! \brief Compute the values of the pressure matrix from A and the weights.
+        void computePressureMatrix()
+        {
+            auto rowP = Ap_.begin();
+            const auto endi = A_->end();
+            for( auto row = A_->begin(); row != endi; ++row, ++rowP )
+            {
+                const WeightType& w = weights_[ row.index() ];
+                auto colP = (*rowP).begin();
+                const auto endj = (*row).end();
+                for( auto col = (*row).begin(); col != endj; ++col, ++colP )
+                {
+                    assert( col.index() == colP.index() );
+                    field_type value = 0.0;
+                    for( int eq = 0; eq < blockSize; ++eq ) {
+                        value += w[ eq ] * (*col)[ eq ][ pressureIndex ];
+                    }
+                    *colP = value;
+                }
+            }
+        }
+
+        //! \brief The operator of the full system.
+        const Operator* op_;
+        //! \brief The matrix of the full system without wells.
+        const matrix_type* A_;
+        //! \brief The preconditioner of the second stage.
+        std::unique_ptr< Smoother > smoother_;
+        //! \brief The information about the parallelization.
+        const ParallelInformation* comm_;
+
+        const int  vcycles_;
+        const bool quasiImpes_;
+
+        std::vector< WeightType > weights_;
+
+        //! \brief The pressure system and its AMG.
+        PressureMatrix Ap_;
+        std::unique_ptr< PressureOperator > opAp_;
+        std::unique_ptr< PressureAMG > amg_;
+
+        //! \brief temporary variables for the pressure solve
+        PressureVector rp_, xp_, dp_, cp_;
+        //! \brief temporary variables for the solve of the whole system
+        range_type dmodified_;
+        domain_type vilu_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_BLOCKCPRPRECONDITIONER_HEADER_INCLUDED
@@ -0,0 +1,591 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_COMMUNICATIONREDUCINGSOLVERS_HEADER_INCLUDED
+#define OPM_COMMUNICATIONREDUCINGSOLVERS_HEADER_INCLUDED
+
+#include <dune/common/timer.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/pinfo.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solver.hh>
+
+#if HAVE_MPI
+#include <mpi.h>
+#include <dune/istl/owneroverlapcopy.hh>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace Opm
+{
+    namespace detail
+    {
+        /// \brief Global sums of the local dot products of a Krylov solver.
+        ///
+        /// Several dot products are summed over the processes in one
+        /// reduction. The reduction runs in the background between start()
+        /// and wait() if the MPI library supports non-blocking collectives.
+        /// As for the scalar products of dune-istl only the entries owned
+        /// by this process count in parallel runs.
+        template <class X>
+        class GlobalDotProducts
+        {
+        public:
+            explicit GlobalDotProducts(const Dune::Amg::SequentialInformation&)
+#if HAVE_MPI
+                : communicator_( MPI_COMM_NULL )
+                , pending_( false )
+#endif
+            {
+            }
+
+#if HAVE_MPI
+            template <class GlobalIndex, class LocalIndex>
+            explicit GlobalDotProducts(const Dune::OwnerOverlapCopyCommunication<GlobalIndex, LocalIndex>& comm)
+                : communicator_( comm.communicator() )
+                , pending_( false )
+            {
+                const auto& indexSet = comm.indexSet();
+                for( auto idx = indexSet.begin(); idx != indexSet.end(); ++idx ) {
+                    if( idx->local().attribute() != Dune::OwnerOverlapCopyAttributeSet::owner ) {
+                        notOwned_.push_back( idx->local().local() );
+                    }
+                }
+            }
+#endif
+
+            /// \brief The dot product of the entries of a and b owned by this process.
+            double local(const X& a, const X& b) const
+            {
+                double result = 0.0;
+                if( notOwned_.empty() ) {
+                    for( typename X::size_type i = 0; i < a.size(); ++i ) {
+                        result += a[ i ] * b[ i ];
+                    }
+                    return result;
+                }
+
+                // only the owned entries are accumulated, subtracting the others
+                // afterwards may cancel and give a negative norm
+                if( mask_.size() != a.size() ) {
+                    mask_.assign( a.size(), 1.0 );
+                    for( const std::size_t i : notOwned_ ) {
+                        mask_[ i ] = 0.0;
+                    }
+                }
+                for( typename X::size_type i = 0; i < a.size(); ++i ) {
+                    result += mask_[ i ] * ( a[ i ] * b[ i ] );
+                }
+                return result;
+            }
+
+            /// \brief Start summing the values over the processes. The values
+            ///        must not be touched before wait() returns.
+            void start(std::vector<double>& values)
+            {
+#if HAVE_MPI
+                if( communicator_ != MPI_COMM_NULL ) {
+#if MPI_VERSION >= 3
+                    MPI_Iallreduce( MPI_IN_PLACE, values.data(), values.size(), MPI_DOUBLE,
+                                    MPI_SUM, communicator_, &request_ );
+                    pending_ = true;
+#else
+                    MPI_Allreduce( MPI_IN_PLACE, values.data(), values.size(), MPI_DOUBLE,
+                                   MPI_SUM, communicator_ );
+#endif
+                }
+#else
+                static_cast<void>( values );
+#endif
+            }
+
+            /// \brief Wait until the sums started last are available.
+            void wait()
+            {
+#if HAVE_MPI
+                if( pending_ ) {
+                    MPI_Wait( &request_, MPI_STATUS_IGNORE );
+                    pending_ = false;
+                }
+#endif
+            }
+
+            /// \brief Sum the values over the processes.
+            void sum(std::vector<double>& values)
+            {
+                start( values );
+                wait();
+            }
+
+        private:
+            // local indices of the entries owned by other processes
+            std::vector<std::size_t> notOwned_;
+            // 1 for the entries owned by this process and 0 otherwise, built
+            // for the size of the vectors on first use as in dune-istl
+            mutable std::vector<double> mask_;
+#if HAVE_MPI
+            MPI_Comm communicator_;
+            MPI_Request request_;
+            bool pending_;
+#endif
+        };
+
+        //! print the defect of an iteration as the solvers of dune-istl do
+        inline void printKrylovIteration(const double it, const double def, const double defOld)
+        {
+            std::cout << std::setw(5) << it << std::setw(16) << std::scientific << std::setprecision(6) << def;
+            if( defOld > 0.0 ) {
+                std::cout << std::setw(16) << def / defOld;
+            }
+            std::cout << std::endl;
+            std::cout.unsetf( std::ios_base::floatfield );
+        }
+
+        //! fill in the statistics of a solve and print them as dune-istl does
+        inline void finishKrylovSolve(const char* name, Dune::InverseOperatorResult& res, const Dune::Timer& watch,
+                                      const double it, const double def, const double def0,
+                                      const double reduction, const int verbose)
+        {
+            res.iterations = static_cast<int>( std::ceil( it ) );
+            res.reduction = def0 > 0.0 ? def / def0 : 0.0;
+            res.converged = def <= def0 * reduction || def < 1e-30;
+            res.conv_rate = it > 0.0 ? std::pow( res.reduction, 1.0 / it ) : 0.0;
+            res.elapsed = watch.elapsed();
+            if( verbose > 0 ) {
+                std::cout << "=== " << name << ( res.converged ? "" : " did not converge" ) << std::endl
+                          << "=== rate=" << res.conv_rate << ", T=" << res.elapsed
+                          << ", TIT=" << ( it > 0.0 ? res.elapsed / it : 0.0 )
+                          << ", IT=" << it << std::endl;
+            }
+        }
+    } // end namespace detail
+
+    /// \brief Pipelined BiCGStab with right preconditioning.
+    ///
+    /// The method of Cools and Vanroose (Parallel Computing 65, 2017)
+    /// computes the dot products of an iteration from recurrences such
+    /// that they are needed in two groups only. Each group is summed over
+    /// the processes in a single non-blocking reduction, which overlaps
+    /// the application of the operator and the preconditioner. This
+    /// replaces the four blocking reductions of Dune::BiCGSTABSolver at
+    /// the price of more vector updates and storage.
+    ///
+    /// The recurrences let the computed residual drift from the true
+    /// one. Convergence is therefore confirmed with the true residual
+    /// and the iteration restarts from it if necessary.
+    /// \tparam X The type of the vectors.
+    template <class X>
+    class PipelinedBiCGSTABSolver
+    {
+    public:
+        /// \brief Constructor.
+        /// \param op The operator, it has to outlive the solver.
+        /// \param prec The preconditioner, it has to outlive the solver.
+        /// \param comm The parallel information the operator works with.
+        /// \param reduction The reduction of the defect to reach.
+        /// \param maxit The maximum number of iterations.
+        /// \param verbose 0 for no output, 1 for a summary, 2 for each iteration.
+        template <class Comm>
+        PipelinedBiCGSTABSolver(Dune::LinearOperator<X, X>& op, Dune::Preconditioner<X, X>& prec,
+                                const Comm& comm, const double reduction, const int maxit, const int verbose)
+            : op_( op )
+            , prec_( prec )
+            , dots_( comm )
+            , reduction_( reduction )
+            , maxit_( maxit )
+            , verbose_( verbose )
+        {
+        }
+
+        /// \brief Solve op x = b starting from x, b is overwritten.
+        void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+        {
+            Dune::Timer watch;
+            res.clear();
+            prec_.pre( x, b );
+
+            // The hat denotes the preconditioned vectors, w = A r^, t = A w^,
+            // s = A p^, z = A s^, y = A q^ and v = A z^.
+            X r( b ), rHat( b ), w( b ), wHat( b ), t( b ), tHat( b );
+            X p( b ), pHat( b ), s( b ), sHat( b ), z( b ), zHat( b );
+            X q( b ), qHat( b ), y( b ), yHat( b ), v( b ), vHat( b ), r0( b );
+            std::vector<double> values;
+
+            double def0 = -1.0;
+            double def = 0.0;
+            double it = 0.0;
+            while( true )
+            {
+                // (re)start from the true residual
+                r = b;
+                op_.applyscaleadd( -1.0, x, r );
+                values.assign( 1, dots_.local( r, r ) );
+                dots_.sum( values );
+                def = std::sqrt( values[ 0 ] );
+                if( def0 < 0.0 ) {
+                    def0 = def;
+                    if( verbose_ > 1 ) {
+                        std::cout << "=== PipelinedBiCGSTABSolver" << std::endl
+                                  << " Iter          Defect            Rate" << std::endl;
+                        detail::printKrylovIteration( it, def, -1.0 );
+                    }
+                }
+                if( def <= def0 * reduction_ || def < 1e-30 || it >= maxit_ ) {
+                    break;
+                }
+
+                applyPrec( rHat, r );
+                op_.apply( rHat, w );
+                applyPrec( wHat, w );
+                op_.apply( wHat, t );
+                applyPrec( tHat, t );
+                r0 = r;
+                values.assign( 1, dots_.local( r0, w ) );
+                dots_.sum( values );
+                double rho = def * def;
+                if( values[ 0 ] == 0.0 ) {
+                    break;
+                }
+                double alpha = rho / values[ 0 ];
+                double beta = 0.0;
+                double omega = 0.0;
+
+                bool first = true;
+                while( it < maxit_ )
+                {
+                    if( first ) {
+                        p = r;  pHat = rHat;
+                        s = w;  sHat = wHat;
+                        z = t;  zHat = tHat;
+                        first = false;
+                    }
+                    else {
+                        // p = r + beta (p - omega s), s = w + beta (s - omega z), z = t + beta (z - omega v)
+                        update( p, beta, omega, s, r );
+                        update( pHat, beta, omega, sHat, rHat );
+                        update( s, beta, omega, z, w );
+                        update( sHat, beta, omega, zHat, wHat );
+                        update( z, beta, omega, v, t );
+                        update( zHat, beta, omega, vHat, tHat );
+                    }
+                    // q = r - alpha s, y = w - alpha z
+                    q = r;  q.axpy( -alpha, s );
+                    qHat = rHat;  qHat.axpy( -alpha, sHat );
+                    y = w;  y.axpy( -alpha, z );
+                    yHat = wHat;  yHat.axpy( -alpha, zHat );
+
+                    values.assign( { dots_.local( q, y ), dots_.local( y, y ), dots_.local( q, q ) } );
+                    dots_.start( values );
+                    op_.apply( zHat, v );
+                    applyPrec( vHat, v );
+                    dots_.wait();
+
+                    const double defHalf = std::sqrt( values[ 2 ] );
+                    it += 0.5;
+                    if( defHalf <= def0 * reduction_ || values[ 1 ] == 0.0 ) {
+                        x.axpy( alpha, pHat );
+                        if( verbose_ > 1 ) {
+                            detail::printKrylovIteration( it, defHalf, def );
+                        }
+                        break;
+                    }
+                    omega = values[ 0 ] / values[ 1 ];
+
+                    x.axpy( alpha, pHat );
+                    x.axpy( omega, qHat );
+                    // r = q - omega y, w = y - omega (t - alpha v)
+                    r = q;  r.axpy( -omega, y );
+                    rHat = qHat;  rHat.axpy( -omega, yHat );
+                    t.axpy( -alpha, v );
+                    w = y;  w.axpy( -omega, t );
+                    tHat.axpy( -alpha, vHat );
+                    wHat = yHat;  wHat.axpy( -omega, tHat );
+
+                    values.assign( { dots_.local( r0, r ), dots_.local( r0, w ), dots_.local( r0, s ),
+                                     dots_.local( r0, z ), dots_.local( r, r ) } );
+                    dots_.start( values );
+                    op_.apply( wHat, t );
+                    applyPrec( tHat, t );
+                    dots_.wait();
+
+                    const double defNew = std::sqrt( values[ 4 ] );
+                    it += 0.5;
+                    if( verbose_ > 1 ) {
+                        detail::printKrylovIteration( it, defNew, def );
+                    }
+                    def = defNew;
+                    if( def <= def0 * reduction_ || omega == 0.0 || rho == 0.0 ) {
+                        break;
+                    }
+
+                    beta = ( alpha / omega ) * ( values[ 0 ] / rho );
+                    rho = values[ 0 ];
+                    const double denominator = values[ 1 ] + beta * values[ 2 ] - beta * omega * values[ 3 ];
+                    if( denominator == 0.0 ) {
+                        break;
+                    }
+                    alpha = rho / denominator;
+                }
+            }
+
+            prec_.post( x );
+            detail::finishKrylovSolve( "PipelinedBiCGSTABSolver", res, watch, it, def, def0, reduction_, verbose_ );
+        }
+
+        /// \brief Solve op x = b with the given reduction of the defect.
+        void apply(X& x, X& b, const double reduction, Dune::InverseOperatorResult& res)
+        {
+            const double savedReduction = reduction_;
+            reduction_ = reduction;
+            apply( x, b, res );
+            reduction_ = savedReduction;
+        }
+
+    private:
+        void applyPrec(X& v, const X& d)
+        {
+            v = 0.0;
+            prec_.apply( v, d );
+        }
+
+        // a = c + beta (a - omega b)
+        static void update(X& a, const double beta, const double omega, const X& b, const X& c)
+        {
+            a.axpy( -omega, b );
+            a *= beta;
+            a += c;
+        }
+
+        Dune::LinearOperator<X, X>& op_;
+        Dune::Preconditioner<X, X>& prec_;
+        detail::GlobalDotProducts<X> dots_;
+        double reduction_;
+        int maxit_;
+        int verbose_;
+    };
+
+    /// \brief Restarted GMRes with right preconditioning and a single global
+    ///        reduction per iteration.
+    ///
+    /// Dune::RestartedGMResSolver orthogonalizes with the modified
+    /// Gram-Schmidt method, which needs j+2 blocking reductions in the
+    /// j-th iteration of a cycle. Here the classical Gram-Schmidt method
+    /// computes all projections and the norm of the new Krylov vector in
+    /// one reduction, the norm of the orthogonalized vector follows from
+    /// the Pythagorean theorem. If that loses too many digits the vector
+    /// is orthogonalized a second time, at the cost of a second reduction.
+    /// \tparam X The type of the vectors.
+    template <class X>
+    class SingleReductionGMResSolver
+    {
+    public:
+        /// \brief Constructor.
+        /// \param op The operator, it has to outlive the solver.
+        /// \param prec The preconditioner, it has to outlive the solver.
+        /// \param comm The parallel information the operator works with.
+        /// \param reduction The reduction of the defect to reach.
+        /// \param restart The number of iterations before restarting.
+        /// \param maxit The maximum number of iterations.
+        /// \param verbose 0 for no output, 1 for a summary, 2 for each iteration.
+        template <class Comm>
+        SingleReductionGMResSolver(Dune::LinearOperator<X, X>& op, Dune::Preconditioner<X, X>& prec,
+                                   const Comm& comm, const double reduction, const int restart,
+                                   const int maxit, const int verbose)
+            : op_( op )
+            , prec_( prec )
+            , dots_( comm )
+            , reduction_( reduction )
+            , restart_( std::max( restart, 1 ) )
+            , maxit_( maxit )
+            , verbose_( verbose )
+        {
+        }
+
+        /// \brief Solve op x = b starting from x, b is overwritten.
+        void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+        {
+            Dune::Timer watch;
+            res.clear();
+            prec_.pre( x, b );
+
+            const int m = restart_;
+            std::vector<X> v( m + 1, b );
+            X w( b ), z( b );
+            std::vector<std::vector<double> > H( m + 1, std::vector<double>( m, 0.0 ) );
+            std::vector<double> g( m + 1 ), cs( m ), sn( m ), yk( m ), values;
+
+            double def = trueDefect( x, b, w );
+            const double def0 = def;
+            if( verbose_ > 1 ) {
+                std::cout << "=== SingleReductionGMResSolver" << std::endl
+                          << " Iter          Defect            Rate" << std::endl;
+                detail::printKrylovIteration( 0, def, -1.0 );
+            }
+
+            int it = 0;
+            bool breakdown = false;
+            while( def > def0 * reduction_ && def >= 1e-30 && it < maxit_ && ! breakdown )
+            {
+                v[ 0 ] = w;
+                v[ 0 ] *= 1.0 / def;
+                std::fill( g.begin(), g.end(), 0.0 );
+                g[ 0 ] = def;
+
+                int j = 0;
+                while( j < m && it < maxit_ )
+                {
+                    applyPrec( z, v[ j ] );
+                    op_.apply( z, w );
+
+                    // projections onto the basis and norm of w in one reduction
+                    values.resize( j + 2 );
+                    for( int i = 0; i <= j; ++i ) {
+                        values[ i ] = dots_.local( v[ i ], w );
+                    }
+                    values[ j + 1 ] = dots_.local( w, w );
+                    dots_.sum( values );
+                    for( int i = 0; i <= j + 1; ++i ) {
+                        H[ i ][ j ] = 0.0;
+                    }
+                    double norm2 = orthogonalize( j, values, v, w, H );
+
+                    // orthogonalize again if the result is dominated by cancellation
+                    if( norm2 <= 0.5 * values[ j + 1 ] ) {
+                        for( int i = 0; i <= j; ++i ) {
+                            values[ i ] = dots_.local( v[ i ], w );
+                        }
+                        values[ j + 1 ] = dots_.local( w, w );
+                        dots_.sum( values );
+                        norm2 = orthogonalize( j, values, v, w, H );
+                    }
+                    const double hNext = std::sqrt( std::max( norm2, 0.0 ) );
+                    H[ j + 1 ][ j ] = hNext;
+
+                    // apply the previous Givens rotations and eliminate H[j+1][j]
+                    for( int i = 0; i < j; ++i ) {
+                        const double temp = cs[ i ] * H[ i ][ j ] + sn[ i ] * H[ i + 1 ][ j ];
+                        H[ i + 1 ][ j ] = -sn[ i ] * H[ i ][ j ] + cs[ i ] * H[ i + 1 ][ j ];
+                        H[ i ][ j ] = temp;
+                    }
+                    const double denominator = std::sqrt( H[ j ][ j ] * H[ j ][ j ] + hNext * hNext );
+                    if( denominator == 0.0 ) {
+                        breakdown = true;
+                        break;
+                    }
+                    cs[ j ] = H[ j ][ j ] / denominator;
+                    sn[ j ] = hNext / denominator;
+                    H[ j ][ j ] = denominator;
+                    H[ j + 1 ][ j ] = 0.0;
+                    g[ j + 1 ] = -sn[ j ] * g[ j ];
+                    g[ j ] = cs[ j ] * g[ j ];
+
+                    ++it;
+                    ++j;
+                    const double defNew = std::abs( g[ j ] );
+                    if( verbose_ > 1 ) {
+                        detail::printKrylovIteration( it, defNew, def );
+                    }
+                    def = defNew;
+                    if( def <= def0 * reduction_ || hNext == 0.0 ) {
+                        break;
+                    }
+                    v[ j ] = w;
+                    v[ j ] *= 1.0 / hNext;
+                }
+
+                // x += M^-1 V y with H y = g
+                for( int i = j - 1; i >= 0; --i ) {
+                    double sum = g[ i ];
+                    for( int k = i + 1; k < j; ++k ) {
+                        sum -= H[ i ][ k ] * yk[ k ];
+                    }
+                    yk[ i ] = sum / H[ i ][ i ];
+                }
+                w = 0.0;
+                for( int i = 0; i < j; ++i ) {
+                    w.axpy( yk[ i ], v[ i ] );
+                }
+                applyPrec( z, w );
+                x += z;
+
+                def = trueDefect( x, b, w );
+            }
+
+            prec_.post( x );
+            detail::finishKrylovSolve( "SingleReductionGMResSolver", res, watch, it, def, def0, reduction_, verbose_ );
+        }
+
+        /// \brief Solve op x = b with the given reduction of the defect.
+        void apply(X& x, X& b, const double reduction, Dune::InverseOperatorResult& res)
+        {
+            const double savedReduction = reduction_;
+            reduction_ = reduction;
+            apply( x, b, res );
+            reduction_ = savedReduction;
+        }
+
+    private:
+        void applyPrec(X& v, const X& d)
+        {
+            v = 0.0;
+            prec_.apply( v, d );
+        }
+
+        // store r = b - op x and return its norm
+        double trueDefect(const X& x, const X& b, X& r)
+        {
+            r = b;
+            op_.applyscaleadd( -1.0, x, r );
+            std::vector<double> values( 1, dots_.local( r, r ) );
+            dots_.sum( values );
+            return std::sqrt( values[ 0 ] );
+        }
+
+        // subtract the projections in values onto the basis v from w, accumulate
+        // them in column j of H and return the squared norm of the result
+        static double orthogonalize(const int j, const std::vector<double>& values, const std::vector<X>& v,
+                                    X& w, std::vector<std::vector<double> >& H)
+        {
+            double norm2 = values[ j + 1 ];
+            for( int i = 0; i <= j; ++i ) {
+                H[ i ][ j ] += values[ i ];
+                w.axpy( -values[ i ], v[ i ] );
+                norm2 -= values[ i ] * values[ i ];
+            }
+            return norm2;
+        }
+
+        Dune::LinearOperator<X, X>& op_;
+        Dune::Preconditioner<X, X>& prec_;
+        detail::GlobalDotProducts<X> dots_;
+        double reduction_;
+        int restart_;
+        int maxit_;
+        int verbose_;
+    };
+
+} // end namespace Opm
+
+#endif // OPM_COMMUNICATIONREDUCINGSOLVERS_HEADER_INCLUDED
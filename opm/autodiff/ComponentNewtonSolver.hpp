@@ -0,0 +1,107 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_COMPONENTNEWTONSOLVER_HEADER_INCLUDED
+#define OPM_COMPONENTNEWTONSOLVER_HEADER_INCLUDED
+
+#include <opm/common/Exceptions.hpp>
+
+namespace Opm
+{
+
+    /// Relaxation of the Newton updates in the reordering transport solver,
+    /// decreasing with the number of iterations.
+    inline double reorderingNewtonRelaxation(const int iter)
+    {
+        if (iter > 30) {
+            return 0.25;
+        }
+        if (iter > 25) {
+            return 0.40;
+        }
+        if (iter > 20) {
+            return 0.55;
+        }
+        if (iter > 15) {
+            return 0.70;
+        }
+        if (iter > 10) {
+            return 0.85;
+        }
+        return 1.0;
+    }
+
+
+
+    /// Solve the coupled equations of a strongly connected component of the
+    /// reordering transport solver with Newton's method.
+    ///
+    /// The system has to provide
+    ///
+    ///     void assemble(Vector& res, Matrix& jac);
+    ///     bool converged(const Vector& res);
+    ///     Vector solve(const Matrix& jac, const Vector& res);
+    ///     void update(const Vector& dx);
+    ///     void saveState();
+    ///     void restoreState();
+    ///
+    /// where solve() may throw NumericalProblem and update() subtracts dx
+    /// from the variables of the cells. If the linear solver fails or Newton
+    /// does not converge, the state before the first iteration is restored,
+    /// such that a fallback does not start from a diverged iterate.
+    ///
+    /// \param[in, out] system   Equations of the component.
+    /// \param[in, out] res      Residual, sized for the component.
+    /// \param[in, out] jac      Jacobian with the sparsity pattern of the component.
+    /// \param[in]      maxIter  Maximum number of Newton iterations.
+    /// \return whether Newton converged.
+    template <class System, class Vector, class Matrix>
+    bool solveComponentNewton(System& system, Vector& res, Matrix& jac, const int maxIter)
+    {
+        system.saveState();
+        system.assemble(res, jac);
+
+        int iter = 0;
+        double relaxation = 1.0;
+        bool converged = system.converged(res);
+        while (!converged && iter < maxIter) {
+            Vector dx;
+            try {
+                dx = system.solve(jac, res);
+            }
+            catch (const NumericalProblem&) {
+                break;
+            }
+            dx *= relaxation;
+            system.update(dx);
+            system.assemble(res, jac);
+            converged = system.converged(res);
+            ++iter;
+            relaxation = reorderingNewtonRelaxation(iter);
+        }
+
+        if (!converged) {
+            system.restoreState();
+        }
+        return converged;
+    }
+
+} // namespace Opm
+
+#endif // OPM_COMPONENTNEWTONSOLVER_HEADER_INCLUDED
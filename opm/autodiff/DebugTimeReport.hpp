@@ -20,6 +20,7 @@
 #ifndef OPM_DEBUGTIMEREPORT_HEADER_INCLUDED
 #define OPM_DEBUGTIMEREPORT_HEADER_INCLUDED
 
+#include <opm/autodiff/TimerRegistry.hpp>
 #include <opm/common/OpmLog/OpmLog.hpp>
 #include <opm/core/utility/StopWatch.hpp>
 #include <string>
@@ -32,6 +33,7 @@ namespace Opm
     public:
         explicit DebugTimeReport(const std::string& report_name)
             : report_name_(report_name)
+            , timer_(report_name_.c_str())
         {
             clock_.start();
         }
@@ -46,6 +48,7 @@ namespace Opm
 
     private:
         std::string report_name_;
+        ScopedTimer timer_; // the time is also recorded in the TimerRegistry
         time::StopWatch clock_;
     };
 
@@ -39,6 +39,7 @@
 #include <opm/autodiff/ExtractParallelGridInformationToISTL.hpp>
 #include <opm/autodiff/RedistributeDataHandles.hpp>
 #include <opm/autodiff/SimulatorFullyImplicitBlackoilEbos.hpp>
+#include <opm/autodiff/TimerRegistry.hpp>
 
 #include <opm/core/props/satfunc/RelpermDiagnostics.hpp>
 
@@ -104,6 +105,7 @@ namespace Opm
                     return EXIT_FAILURE;
                 }
 
+                setupTimers();
                 setupEbosSimulator();
                 setupOutput();
                 setupLogging();
@@ -231,6 +233,20 @@ namespace Opm
             return true;
         }
 
+        // Enable the hierarchical timers if requested.
+        // Writes to:
+        //   use_timers_
+        //   timer_trace_file_
+        void setupTimers()
+        {
+            use_timers_ = param_.getDefault("use_timers", false);
+            timer_trace_file_ = param_.getDefault("timer_trace_file", std::string(""));
+            const int maxTraceEvents = param_.getDefault("timer_trace_max_events", 1000000);
+            if (use_timers_) {
+                TimerRegistry::instance().enable(timer_trace_file_.empty() ? 0 : maxTraceEvents);
+            }
+        }
+
         // Set output_to_files_ and set/create output dir. Write parameter file.
         // Writes to:
         //   output_to_files_
@@ -596,6 +612,19 @@ namespace Opm
                     }
                 }
 
+                if (use_timers_) {
+                    // the report is a collective operation
+                    std::ostringstream ss;
+                    ss << "\n================    Timers (all ranks)    ===============\n\n";
+                    TimerRegistry::instance().report(ss);
+                    if (output_cout_) {
+                        OpmLog::info(ss.str());
+                    }
+                    if (!timer_trace_file_.empty()) {
+                        TimerRegistry::instance().writeTrace(timer_trace_file_);
+                    }
+                }
+
             } else {
                 if (output_cout_) {
                     std::cout << "\n\n================ Simulation turned off ===============\n" << std::flush;
@@ -907,6 +936,8 @@ namespace Opm
         ParameterGroup param_;
         bool output_to_files_ = false;
         std::string output_dir_ = std::string(".");
+        bool use_timers_ = false;
+        std::string timer_trace_file_;
         NNC nnc_;
         std::unique_ptr<EclipseIO> eclIO_;
         std::unique_ptr<OutputWriter> output_writer_;
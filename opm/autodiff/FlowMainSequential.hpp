@@ -93,9 +93,6 @@ namespace Opm
             if (solver_approach == cprSolver) {
                 OPM_THROW( std::runtime_error , "CPR solver is not ready for use with sequential simulator.");
             } else if (solver_approach == interleavedSolver) {
-                if (!param_.has("require_full_sparsity_pattern")) {
-                    param_.insertParameter("require_full_sparsity_pattern", "true");
-                }
                 fis_solver_.reset(new NewtonIterationBlackoilInterleaved(param_, parallel_information_));
             } else if (solver_approach == directSolver) {
                 fis_solver_.reset(new NewtonIterationBlackoilSimple(param_, parallel_information_));
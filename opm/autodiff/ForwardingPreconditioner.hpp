@@ -0,0 +1,148 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_FORWARDINGPRECONDITIONER_HEADER_INCLUDED
+#define OPM_FORWARDINGPRECONDITIONER_HEADER_INCLUDED
+
+#include <dune/istl/preconditioner.hh>
+
+#include <type_traits>
+
+namespace Opm
+{
+    namespace detail
+    {
+        //! copy the block vector x to y converting the field type
+        template <class FromVector, class ToVector>
+        void convertVector(const FromVector& x, ToVector& y)
+        {
+            y.resize( x.size() );
+            for( typename FromVector::size_type i = 0; i < x.size(); ++i )
+            {
+                for( int k = 0; k < FromVector::block_type::dimension; ++k )
+                {
+                    y[ i ][ k ] = x[ i ][ k ];
+                }
+            }
+        }
+    } // end namespace detail
+
+    /// \brief Base of the preconditioners wrapping another preconditioner.
+    ///
+    /// pre(), apply() and post() are forwarded to the wrapped preconditioner.
+    /// If it works on vectors of another field type, the vectors are converted
+    /// before and the correction is converted back after each application.
+    /// \tparam X The domain type of the solver.
+    /// \tparam Y The range type of the solver.
+    /// \tparam Precond The type of the wrapped preconditioner.
+    template <class X, class Y, class Precond>
+    class ForwardingPreconditioner : public Dune::Preconditioner<X, Y>
+    {
+    public:
+        //! \brief The domain type of the preconditioner.
+        typedef X domain_type;
+        //! \brief The range type of the preconditioner.
+        typedef Y range_type;
+        //! \brief The field type of the preconditioner.
+        typedef typename X::field_type field_type;
+
+        // define the category
+        enum {
+            //! \brief The category the preconditioner is part of.
+            category = Precond::category
+        };
+
+        /// \brief Constructor.
+        /// \param precond The preconditioner to wrap, it has to outlive this object.
+        explicit ForwardingPreconditioner(Precond& precond)
+            : precond_( precond )
+        {
+        }
+
+        virtual void pre(X& x, Y& b)
+        {
+            forwardPre( x, b, SameVectors() );
+        }
+
+        virtual void apply(X& v, const Y& d)
+        {
+            forwardApply( v, d, SameVectors() );
+        }
+
+        virtual void post(X& x)
+        {
+            forwardPost( x, SameVectors() );
+        }
+
+    protected:
+        typedef std::integral_constant< bool,
+                                        std::is_same< X, typename Precond::domain_type >::value &&
+                                        std::is_same< Y, typename Precond::range_type >::value > SameVectors;
+
+        void forwardPre(X& x, Y& b, std::true_type)
+        {
+            precond_.pre( x, b );
+        }
+
+        void forwardPre(X& x, Y& b, std::false_type)
+        {
+            detail::convertVector( x, v_ );
+            detail::convertVector( b, d_ );
+            precond_.pre( v_, d_ );
+            // pre() may modify the initial guess and the right hand side,
+            // e.g. Dune::Amg::AMG does for rows with only a diagonal entry
+            detail::convertVector( v_, x );
+            detail::convertVector( d_, b );
+        }
+
+        void forwardApply(X& v, const Y& d, std::true_type)
+        {
+            precond_.apply( v, d );
+        }
+
+        void forwardApply(X& v, const Y& d, std::false_type)
+        {
+            detail::convertVector( d, d_ );
+            v_.resize( d_.size() );
+            v_ = 0;
+            precond_.apply( v_, d_ );
+            detail::convertVector( v_, v );
+        }
+
+        void forwardPost(X& x, std::true_type)
+        {
+            precond_.post( x );
+        }
+
+        void forwardPost(X& x, std::false_type)
+        {
+            detail::convertVector( x, v_ );
+            precond_.post( v_ );
+        }
+
+        Precond& precond_;
+        // correction and defect in the precision of the wrapped preconditioner,
+        // only used if it differs from the one of the solver
+        typename Precond::domain_type v_;
+        typename Precond::range_type  d_;
+    };
+
+} // end namespace Opm
+
+#endif // OPM_FORWARDINGPRECONDITIONER_HEADER_INCLUDED
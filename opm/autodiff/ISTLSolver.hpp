@@ -21,12 +21,19 @@
 #define OPM_ISTLSOLVER_HEADER_INCLUDED
 
 #include <opm/autodiff/AdditionalObjectDeleter.hpp>
+#include <opm/autodiff/BlockCPRPreconditioner.hpp>
+#include <opm/autodiff/CommunicationReducingSolvers.hpp>
 #include <opm/autodiff/CPRPreconditioner.hpp>
+#include <opm/autodiff/ForwardingPreconditioner.hpp>
 #include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
 #include <opm/autodiff/NewtonIterationUtilities.hpp>
+#include <opm/autodiff/MixedPrecisionPreconditioner.hpp>
 #include <opm/autodiff/ParallelRestrictedAdditiveSchwarz.hpp>
 #include <opm/autodiff/ParallelOverlappingILU0.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/autodiff/MatrixBlockKernels.hpp>
+#include <opm/autodiff/MatrixReordering.hpp>
+#include <opm/autodiff/TimerRegistry.hpp>
 
 #include <opm/common/Exceptions.hpp>
 #include <opm/core/linalg/ParallelIstlInformation.hpp>
@@ -233,6 +240,19 @@ public:
     {
         ISTLUtility::invertMatrix( *this );
     }
+
+    // products with vector blocks using the kernels for the block size
+    template <class X, class Y>
+    void mv( const X& x, Y& y ) const { Opm::blockkernels::mv( *this, x, y ); }
+
+    template <class X, class Y>
+    void umv( const X& x, Y& y ) const { Opm::blockkernels::umv( *this, x, y ); }
+
+    template <class X, class Y>
+    void mmv( const X& x, Y& y ) const { Opm::blockkernels::mmv( *this, x, y ); }
+
+    template <class X, class Y>
+    void usmv( const typename Y::field_type alpha, const X& x, Y& y ) const { Opm::blockkernels::usmv( alpha, *this, x, y ); }
     const BaseType& asBase() const { return static_cast< const BaseType& > (*this); }
     BaseType& asBase() { return static_cast< BaseType& > (*this); }
 };
@@ -310,6 +330,29 @@ public:
 
 namespace Opm
 {
+    /// \brief Record the applications of a preconditioner as the
+    ///        "preconditioner_apply" timer of the TimerRegistry.
+    /// \tparam X The domain type of the preconditioner.
+    /// \tparam Y The range type of the preconditioner.
+    /// \tparam Precond The type of the wrapped preconditioner.
+    template <class X, class Y, class Precond>
+    class TimedPreconditioner : public ForwardingPreconditioner<X, Y, Precond>
+    {
+    public:
+        /// \brief Constructor.
+        /// \param precond The preconditioner to wrap, it has to outlive this object.
+        explicit TimedPreconditioner(Precond& precond)
+            : ForwardingPreconditioner<X, Y, Precond>( precond )
+        {
+        }
+
+        virtual void apply(X& v, const Y& d)
+        {
+            ScopedTimer applyTimer("preconditioner_apply");
+            ForwardingPreconditioner<X, Y, Precond>::apply( v, d );
+        }
+    };
+
     /// This class solves the fully implicit black-oil system by
     /// solving the reduced system (after eliminating well variables)
     /// as a block-structured matrix (one block for all cell variables) for a fixed
@@ -340,6 +383,13 @@ namespace Opm
         : iterations_( 0 ),
           parallelInformation_(parallelInformation_arg),
           isIORank_(isIORank(parallelInformation_arg)),
+          iluOrderingNonzeroes_( 0 ),
+          precondMatrix_( nullptr ),
+          precondRows_( 0 ),
+          precondNonzeroes_( 0 ),
+          iterationsAfterRebuild_( -1 ),
+          newTimeStep_( true ),
+          rebuildRequested_( true ),
           parameters_( param )
         {
         }
@@ -353,6 +403,13 @@ namespace Opm
         : iterations_( 0 ),
           parallelInformation_(parallelInformation_arg),
           isIORank_(isIORank(parallelInformation_arg)),
+          iluOrderingNonzeroes_( 0 ),
+          precondMatrix_( nullptr ),
+          precondRows_( 0 ),
+          precondNonzeroes_( 0 ),
+          iterationsAfterRebuild_( -1 ),
+          newTimeStep_( true ),
+          rebuildRequested_( true ),
           parameters_( param )
         {
         }
@@ -395,7 +452,20 @@ namespace Opm
             parallelInformation_arg.copyOwnerToAll(istlb, istlb);
 
 #if FLOW_SUPPORT_AMG // activate AMG if either flow_ebos is used or UMFPack is not available
-            if( parameters_.linear_solver_use_amg_ )
+            if( parameters_.linear_solver_use_cpr_ )
+            {
+                if( parameters_.preconditioner_single_precision_ ) {
+                    solveCPR<float>( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+                else {
+                    solveCPR<Scalar>( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+            }
+            else if( parameters_.linear_solver_use_amg_ && parameters_.preconditioner_single_precision_ )
+            {
+                solveFloatAMG( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+            }
+            else if( parameters_.linear_solver_use_amg_ )
             {
                 typedef ISTLUtility::CPRSelector< Matrix, Vector, Vector, POrComm>  CPRSelectorType;
                 typedef typename CPRSelectorType::AMG AMG;
@@ -404,73 +474,399 @@ namespace Opm
                 std::unique_ptr< AMG > amg;
                 std::unique_ptr< MatrixOperator > opA;
 
-                if( ! std::is_same< LinearOperator, MatrixOperator > :: value )
+                // Reuse the hierarchy of the previous solve if allowed.
+                AMG* amgPrecond = reusedAMGPrecond( linearOperator.getmat(), parallelInformation_arg );
+
+                if( ! amgPrecond )
                 {
-                    // create new operator in case linear operator and matrix operator differ
-                    opA.reset( CPRSelectorType::makeOperator( linearOperator.getmat(), parallelInformation_arg ) );
-                }
+                    ScopedTimer setupTimer("preconditioner_setup");
+                    if( ! std::is_same< LinearOperator, MatrixOperator > :: value )
+                    {
+                        // create new operator in case linear operator and matrix operator differ
+                        opA.reset( CPRSelectorType::makeOperator( linearOperator.getmat(), parallelInformation_arg ) );
+                    }
+
+                    const double relax = 1.0;
 
-                const double relax = 1.0;
+                    // Construct preconditioner.
+                    constructAMGPrecond( linearOperator, parallelInformation_arg, amg, opA, relax );
+                    amgPrecond = amg.get();
 
-                // Construct preconditioner.
-                constructAMGPrecond( linearOperator, parallelInformation_arg, amg, opA, relax );
+                    // Keep the hierarchy for later solves if allowed.
+                    keepAMGPrecond( linearOperator.getmat(), parallelInformation_arg, amg, opA );
+                }
 
                 // Solve.
-                solve(linearOperator, x, istlb, *sp, *amg, result);
+                solve(linearOperator, x, istlb, *sp, *amgPrecond, parallelInformation_arg, result);
             }
             else
 #endif
             {
-                // Construct preconditioner.
-                auto precond = constructPrecond(linearOperator, parallelInformation_arg);
-
-                // Solve.
-                solve(linearOperator, x, istlb, *sp, *precond, result);
+                if( parameters_.preconditioner_single_precision_ ) {
+                    solveILU<float>( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+                else {
+                    solveILU<Scalar>( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
             }
         }
 
+        /// \brief Notify the solver that a new time step starts.
+        ///
+        /// Depending on the preconditioner reuse policy this forces
+        /// the preconditioner to be set up from scratch for the next solve.
+        void beginTimeStep() const
+        {
+            newTimeStep_ = true;
+        }
+
 #if DUNE_VERSION_NEWER_REV(DUNE_ISTL, 2 , 5, 1)
         // 3x3 matrix block inversion was unstable at least 2.3 until and including
         // 2.5.0
-        typedef ParallelOverlappingILU0<Matrix,Vector,Vector> SeqPreconditioner;
+        typedef Matrix ILUMatrix;
 #else
-        typedef ParallelOverlappingILU0<Dune::BCRSMatrix<Dune::MatrixBlock<typename Matrix::field_type,
-                                                                           Matrix::block_type::rows,
-                                                                           Matrix::block_type::cols> >,
-                                        Vector, Vector> SeqPreconditioner;
+        typedef Dune::BCRSMatrix<Dune::MatrixBlock<typename Matrix::field_type,
+                                                   Matrix::block_type::rows,
+                                                   Matrix::block_type::cols> > ILUMatrix;
 #endif
 
-        template <class Operator>
-        std::unique_ptr<SeqPreconditioner> constructPrecond(Operator& opA, const Dune::Amg::SequentialInformation&) const
+        /// \brief The block ILU0 for the parallel information POrComm
+        ///        with the factors stored in StorageField.
+        template <class POrComm, class StorageField = Scalar>
+        using ILU0Type = ParallelOverlappingILU0<ILUMatrix, Vector, Vector, POrComm, StorageField>;
+
+        typedef ILU0Type<Dune::Amg::SequentialInformation> SeqPreconditioner;
+        typedef ILU0Type<Dune::Amg::SequentialInformation, float> SeqFloatPreconditioner;
+
+        template <class StorageField, class Operator>
+        std::unique_ptr< ILU0Type<Dune::Amg::SequentialInformation, StorageField> >
+        constructPrecond(Operator& opA, const Dune::Amg::SequentialInformation&) const
         {
+            typedef ILU0Type<Dune::Amg::SequentialInformation, StorageField> Precond;
             const double relax   = parameters_.ilu_relaxation_;
             const int ilu_fillin = parameters_.ilu_fillin_level_;
-            std::unique_ptr<SeqPreconditioner> precond(new SeqPreconditioner(opA.getmat(), ilu_fillin, relax));
+            std::unique_ptr<Precond> precond(new Precond(opA.getmat(), ilu_fillin, relax, iluOrdering(opA.getmat())));
             return precond;
         }
 
+        std::unique_ptr<SeqPreconditioner>& keptPrecond(const SeqPreconditioner*) const { return seqPrecond_; }
+        std::unique_ptr<SeqFloatPreconditioner>& keptPrecond(const SeqFloatPreconditioner*) const { return seqFloatPrecond_; }
+
 #if HAVE_MPI
         typedef Dune::OwnerOverlapCopyCommunication<int, int> Comm;
-#if DUNE_VERSION_NEWER_REV(DUNE_ISTL, 2 , 5, 1)
-        // 3x3 matrix block inversion was unstable from at least 2.3 until and
-        // including 2.5.0
-        typedef ParallelOverlappingILU0<Matrix,Vector,Vector,Comm> ParPreconditioner;
-#else
-        typedef ParallelOverlappingILU0<Dune::BCRSMatrix<Dune::MatrixBlock<typename Matrix::field_type,
-                                                                           Matrix::block_type::rows,
-                                                                           Matrix::block_type::cols> >,
-                                        Vector, Vector, Comm> ParPreconditioner;
-#endif
-        template <class Operator>
-        std::unique_ptr<ParPreconditioner>
+        typedef ILU0Type<Comm> ParPreconditioner;
+        typedef ILU0Type<Comm, float> ParFloatPreconditioner;
+
+        template <class StorageField, class Operator>
+        std::unique_ptr< ILU0Type<Comm, StorageField> >
         constructPrecond(Operator& opA, const Comm& comm) const
         {
-            typedef std::unique_ptr<ParPreconditioner> Pointer;
+            typedef std::unique_ptr< ILU0Type<Comm, StorageField> > Pointer;
             const double relax  = parameters_.ilu_relaxation_;
-            return Pointer(new ParPreconditioner(opA.getmat(), comm, relax));
+            return Pointer(new ILU0Type<Comm, StorageField>(opA.getmat(), comm, relax, iluOrdering(opA.getmat())));
         }
+
+        std::unique_ptr<ParPreconditioner>& keptPrecond(const ParPreconditioner*) const { return parPrecond_; }
+        std::unique_ptr<ParFloatPreconditioner>& keptPrecond(const ParFloatPreconditioner*) const { return parFloatPrecond_; }
 #endif
 
+        /// \brief The order of the rows for the ILU factorization of A.
+        ///
+        /// The ordering only depends on the sparsity pattern and is computed
+        /// once for the grid, i.e. again only if the pattern of A changes.
+        const std::vector<std::size_t>& iluOrdering(const Matrix& A) const
+        {
+            if( parameters_.ilu_reordering_ == NewtonIterationBlackoilInterleavedParameters::REORDER_NONE ) {
+                iluOrdering_.clear();
+            }
+            else if( iluOrdering_.size() != A.N() || iluOrderingNonzeroes_ != A.nonzeroes() ) {
+                iluOrdering_ = reverseCuthillMcKee( A );
+                iluOrderingNonzeroes_ = A.nonzeroes();
+            }
+            return iluOrdering_;
+        }
+
+        template <class Precond>
+        void updatePrecond(Precond& precond, const Matrix& A, const Dune::Amg::SequentialInformation&) const
+        {
+            precond.update( A );
+        }
+
+        template <class Precond, class POrComm>
+        void updatePrecond(Precond& precond, const Matrix& A, const POrComm& comm) const
+        {
+            // The communication object is recreated for each solve.
+            precond.update( A, comm );
+        }
+
+        /// \brief Return the block ILU0 for the matrix of opA, either kept from
+        ///        the previous solve with a refreshed factorization or set up
+        ///        from scratch.
+        template <class StorageField, class Operator, class POrComm>
+        std::unique_ptr< ILU0Type<POrComm, StorageField> >&
+        preconditioner(Operator& opA, const POrComm& comm) const
+        {
+            ScopedTimer setupTimer("preconditioner_setup");
+            typedef ILU0Type<POrComm, StorageField> Precond;
+            std::unique_ptr<Precond>& precond = keptPrecond( static_cast<const Precond*>( nullptr ) );
+            const Matrix& A = opA.getmat();
+            if( precond && ! rebuildPreconditioner( A ) ) {
+                // keep the sparsity pattern and storage, refresh the factorization only
+                updatePrecond( *precond, A, comm );
+            }
+            else {
+                precond.reset();
+                precond = constructPrecond<StorageField>( opA, comm );
+                preconditionerRebuilt( A );
+            }
+            return precond;
+        }
+
+        /// \brief Solve with the block ILU0 with the factors stored in StorageField.
+        template <class StorageField, class LinearOperator, class ScalarProd, class POrComm>
+        void solveILU(LinearOperator& linearOperator, Vector& x, Vector& istlb, ScalarProd& sp,
+                      const POrComm& parallelInformation_arg, Dune::InverseOperatorResult& result) const
+        {
+            // Construct or update preconditioner.
+            auto& precond = preconditioner<StorageField>(linearOperator, parallelInformation_arg);
+
+            // Solve.
+            solve(linearOperator, x, istlb, sp, *precond, parallelInformation_arg, result);
+
+            if( parameters_.preconditioner_reuse_ == NewtonIterationBlackoilInterleavedParameters::REBUILD_ALWAYS ) {
+                precond.reset();
+            }
+        }
+
+        /// \brief The two-stage CPR preconditioner for the parallel information
+        ///        POrComm, the second stage being the block ILU0 with the factors
+        ///        stored in StorageField.
+        template <class POrComm, class StorageField = Scalar>
+        using CPRType = BlockCPRPreconditioner< AssembledLinearOperatorType, ILU0Type<POrComm, StorageField>, pressureIndex, POrComm >;
+
+        typedef CPRType<Dune::Amg::SequentialInformation> SeqCPR;
+        typedef CPRType<Dune::Amg::SequentialInformation, float> SeqFloatCPR;
+
+        std::unique_ptr<SeqCPR>& keptCPRPrecond(const SeqCPR*) const { return seqCPR_; }
+        std::unique_ptr<SeqFloatCPR>& keptCPRPrecond(const SeqFloatCPR*) const { return seqFloatCPR_; }
+
+        template <class StorageField, class POrComm>
+        std::unique_ptr< CPRType<POrComm, StorageField> >
+        constructCPRPrecond(AssembledLinearOperatorType& opA, const POrComm& comm) const
+        {
+            typedef CPRType<POrComm, StorageField> CPR;
+
+            // The block ILU0 of the full system is the second stage of CPR.
+            auto smoother = constructPrecond<StorageField>( opA, comm );
+            return std::unique_ptr<CPR>( new CPR( opA, std::move( smoother ),
+                                                  parameters_.cpr_pressure_vcycles_,
+                                                  parameters_.cpr_use_quasiimpes_,
+                                                  comm ) );
+        }
+
+        /// \brief Return the CPR preconditioner for opA. As for AMG only the
+        ///        preconditioner of sequential runs is kept, cpr holds the one
+        ///        set up for this solve otherwise.
+        template <class StorageField, class POrComm>
+        std::unique_ptr< CPRType<POrComm, StorageField> >&
+        cprPrecond(AssembledLinearOperatorType& opA, const POrComm& comm,
+                   std::unique_ptr< CPRType<POrComm, StorageField> >& cpr) const
+        {
+            ScopedTimer setupTimer("preconditioner_setup");
+            cpr = constructCPRPrecond<StorageField>( opA, comm );
+            return cpr;
+        }
+
+        template <class StorageField>
+        std::unique_ptr< CPRType<Dune::Amg::SequentialInformation, StorageField> >&
+        cprPrecond(AssembledLinearOperatorType& opA, const Dune::Amg::SequentialInformation& info,
+                   std::unique_ptr< CPRType<Dune::Amg::SequentialInformation, StorageField> >& /* cpr */) const
+        {
+            ScopedTimer setupTimer("preconditioner_setup");
+            typedef CPRType<Dune::Amg::SequentialInformation, StorageField> CPR;
+            std::unique_ptr<CPR>& precond = keptCPRPrecond( static_cast<const CPR*>( nullptr ) );
+            const Matrix& A = opA.getmat();
+            if( precond && ! rebuildPreconditioner( A ) ) {
+                // The storage of the pressure matrix and of the ILU0 is kept,
+                // the pressure AMG is set up anew.
+                precond->update( opA, info );
+            }
+            else {
+                precond.reset();
+                precond = constructCPRPrecond<StorageField>( opA, info );
+                preconditionerRebuilt( A );
+            }
+            return precond;
+        }
+
+        /// \brief Solve with the two-stage CPR preconditioner, the second stage
+        ///        being the block ILU0 with the factors stored in StorageField.
+        template <class StorageField, class LinearOperator, class ScalarProd, class POrComm>
+        void solveCPR(LinearOperator& linearOperator, Vector& x, Vector& istlb, ScalarProd& sp,
+                      const POrComm& parallelInformation_arg, Dune::InverseOperatorResult& result) const
+        {
+            // Construct or update preconditioner.
+            std::unique_ptr< CPRType<POrComm, StorageField> > localCPR;
+            auto& precond = cprPrecond<StorageField>( linearOperator, parallelInformation_arg, localCPR );
+
+            // Solve.
+            solve(linearOperator, x, istlb, sp, *precond, parallelInformation_arg, result);
+
+            if( parameters_.preconditioner_reuse_ == NewtonIterationBlackoilInterleavedParameters::REBUILD_ALWAYS ) {
+                precond.reset();
+            }
+        }
+
+        typedef Dune::MatrixBlock<float, Matrix::block_type::rows, Matrix::block_type::cols> FloatMatrixBlock;
+        typedef Dune::BCRSMatrix<FloatMatrixBlock> FloatMatrix;
+        typedef Dune::BlockVector<Dune::FieldVector<float, Vector::block_type::dimension> > FloatVector;
+
+        /// \brief An AMG set up for a single precision copy of the matrix.
+        template <class POrComm>
+        struct FloatAMG
+        {
+            typedef ISTLUtility::CPRSelector< FloatMatrix, FloatVector, FloatVector, POrComm > CPRSelectorType;
+
+            FloatMatrix matrix_;
+            std::unique_ptr< typename CPRSelectorType::Operator > opA_;
+            std::unique_ptr< typename CPRSelectorType::AMG > amg_;
+        };
+
+        template <class POrComm>
+        std::unique_ptr< FloatAMG<POrComm> > constructFloatAMG(const Matrix& A, const POrComm& comm) const
+        {
+            typedef typename FloatAMG<POrComm>::CPRSelectorType CPRSelectorType;
+            std::unique_ptr< FloatAMG<POrComm> > amg( new FloatAMG<POrComm>() );
+            detail::copySparsityPattern( A, amg->matrix_ );
+            detail::convertMatrixValues( A, amg->matrix_ );
+            amg->opA_.reset( CPRSelectorType::makeOperator( amg->matrix_, comm ) );
+            const double relax = 1.0;
+            ISTLUtility::template createAMGPreconditionerPointer<pressureIndex>( *amg->opA_, relax, comm, amg->amg_ );
+            return amg;
+        }
+
+        /// \brief Return the AMG of the single precision copy of A. As for the
+        ///        double precision AMG only the hierarchy of sequential runs is kept.
+        template <class POrComm>
+        FloatAMG<POrComm>& floatAMGPrecond(const Matrix& A, const POrComm& comm,
+                                           std::unique_ptr< FloatAMG<POrComm> >& amg) const
+        {
+            ScopedTimer setupTimer("preconditioner_setup");
+            amg = constructFloatAMG( A, comm );
+            return *amg;
+        }
+
+        FloatAMG<Dune::Amg::SequentialInformation>&
+        floatAMGPrecond(const Matrix& A, const Dune::Amg::SequentialInformation& info,
+                        std::unique_ptr< FloatAMG<Dune::Amg::SequentialInformation> >& /* amg */) const
+        {
+            // The kept AMG is reused unchanged, all of its levels including the
+            // single precision copy of the matrix, the smoothers and the coarse
+            // solver belong to the matrix it was set up for. Recomputing only the
+            // Galerkin products would leave the smoothers and the coarse solver
+            // factorized for that matrix anyway.
+            if( ! seqFloatAMG_ || rebuildPreconditioner( A ) ) {
+                ScopedTimer setupTimer("preconditioner_setup");
+                seqFloatAMG_ = constructFloatAMG( A, info );
+                preconditionerRebuilt( A );
+            }
+            return *seqFloatAMG_;
+        }
+
+        /// \brief Solve with the AMG of a single precision copy of the matrix,
+        ///        the Krylov solver still works in double precision.
+        template <class LinearOperator, class ScalarProd, class POrComm>
+        void solveFloatAMG(LinearOperator& linearOperator, Vector& x, Vector& istlb, ScalarProd& sp,
+                           const POrComm& parallelInformation_arg, Dune::InverseOperatorResult& result) const
+        {
+            typedef typename FloatAMG<POrComm>::CPRSelectorType::AMG AMG;
+
+            std::unique_ptr< FloatAMG<POrComm> > localAMG;
+            FloatAMG<POrComm>& amg = floatAMGPrecond( linearOperator.getmat(), parallelInformation_arg, localAMG );
+            MixedPrecisionPreconditioner< Vector, Vector, AMG > precond( *amg.amg_ );
+
+            // Solve.
+            solve(linearOperator, x, istlb, sp, precond, parallelInformation_arg, result);
+        }
+
+        typedef ISTLUtility::CPRSelector< Matrix, Vector, Vector, Dune::Amg::SequentialInformation > SeqCPRSelector;
+        typedef typename SeqCPRSelector::AMG SeqAMG;
+        typedef typename SeqCPRSelector::Operator SeqMatrixOperator;
+
+        /// \brief Return the AMG of the previous solve or nullptr if it has
+        ///        to be set up from scratch.
+        ///
+        /// AMG hierarchies are only kept in sequential runs, as they refer
+        /// to the parallel information that is recreated for each solve.
+        template <class POrComm>
+        typename ISTLUtility::CPRSelector< Matrix, Vector, Vector, POrComm >::AMG*
+        reusedAMGPrecond(const Matrix& /* A */, const POrComm& /* comm */) const
+        {
+            return nullptr;
+        }
+
+        SeqAMG* reusedAMGPrecond(const Matrix& A, const Dune::Amg::SequentialInformation&) const
+        {
+            if( seqAMG_ && ! rebuildPreconditioner( A ) ) {
+                // The AMG is reused unchanged. Only its finest level refers to
+                // A and has the current values, the coarse matrices, the
+                // smoothers and the coarse solver belong to the matrix it was
+                // set up for. Recomputing only the Galerkin products would leave
+                // the smoothers and the coarse solver factorized for that matrix.
+                return seqAMG_.get();
+            }
+            seqAMG_.reset();
+            seqAMGOperator_.reset();
+            return nullptr;
+        }
+
+        template <class POrComm, class AMG, class MatrixOperator>
+        void keepAMGPrecond(const Matrix& /* A */, const POrComm& /* comm */,
+                            std::unique_ptr< AMG >& /* amg */, std::unique_ptr< MatrixOperator >& /* opA */) const
+        {
+        }
+
+        void keepAMGPrecond(const Matrix& A, const Dune::Amg::SequentialInformation&,
+                            std::unique_ptr< SeqAMG >& amg, std::unique_ptr< SeqMatrixOperator >& opA) const
+        {
+            // Without an operator of our own the hierarchy would refer to
+            // the operator of the caller.
+            if( parameters_.preconditioner_reuse_ != NewtonIterationBlackoilInterleavedParameters::REBUILD_ALWAYS && opA )
+            {
+                seqAMG_ = std::move( amg );
+                seqAMGOperator_ = std::move( opA );
+                preconditionerRebuilt( A );
+            }
+        }
+
+        /// \brief Whether the preconditioner has to be set up from scratch for A.
+        bool rebuildPreconditioner(const Matrix& A) const
+        {
+            if( &A != precondMatrix_ || A.N() != precondRows_ || A.nonzeroes() != precondNonzeroes_ ) {
+                return true;
+            }
+
+            switch( parameters_.preconditioner_reuse_ ) {
+            case NewtonIterationBlackoilInterleavedParameters::REBUILD_TIMESTEP:
+                return newTimeStep_ || rebuildRequested_;
+            case NewtonIterationBlackoilInterleavedParameters::REBUILD_ON_GROWTH:
+                return rebuildRequested_;
+            default:
+                return true;
+            }
+        }
+
+        /// \brief Store the information about the matrix the preconditioner was set up for.
+        void preconditionerRebuilt(const Matrix& A) const
+        {
+            precondMatrix_    = &A;
+            precondRows_      = A.N();
+            precondNonzeroes_ = A.nonzeroes();
+            newTimeStep_      = false;
+            rebuildRequested_ = false;
+            iterationsAfterRebuild_ = -1;
+        }
+
         template <class LinearOperator, class MatrixOperator, class POrComm, class AMG >
         void
         constructAMGPrecond(LinearOperator& /* linearOperator */, const POrComm& comm, std::unique_ptr< AMG >& amg, std::unique_ptr< MatrixOperator >& opA, const double relax ) const
@@ -487,15 +883,31 @@ namespace Opm
         }
 
         /// \brief Solve the system using the given preconditioner and scalar product.
-        template <class Operator, class ScalarProd, class Precond>
-        void solve(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, Precond& precond, Dune::InverseOperatorResult& result) const
+        ///
+        /// The communication reducing solvers do not use the scalar product
+        /// but sum their dot products over the processes of comm themselves.
+        template <class Operator, class ScalarProd, class Precond, class POrComm>
+        void solve(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, Precond& precondArg,
+                   const POrComm& comm, Dune::InverseOperatorResult& result) const
         {
+            ScopedTimer krylovTimer("krylov");
+            TimedPreconditioner< Vector, Vector, Precond > precond( precondArg );
+
             // TODO: Revise when linear solvers interface opm-core is done
             // Construct linear solver.
             // GMRes solver
             int verbosity = ( isIORank_ ) ? parameters_.linear_solver_verbosity_ : 0;
 
-            if ( parameters_.newton_use_gmres_ ) {
+            if ( parameters_.newton_use_gmres_ && parameters_.linear_solver_reduce_communication_ ) {
+                SingleReductionGMResSolver<Vector> linsolve(opA, precond, comm,
+                          parameters_.linear_solver_reduction_,
+                          parameters_.linear_solver_restart_,
+                          parameters_.linear_solver_maxiter_,
+                          verbosity);
+                // Solve system.
+                linsolve.apply(x, istlb, result);
+            }
+            else if ( parameters_.newton_use_gmres_ ) {
                 Dune::RestartedGMResSolver<Vector> linsolve(opA, sp, precond,
                           parameters_.linear_solver_reduction_,
                           parameters_.linear_solver_restart_,
@@ -504,6 +916,14 @@ namespace Opm
                 // Solve system.
                 linsolve.apply(x, istlb, result);
             }
+            else if ( parameters_.linear_solver_reduce_communication_ ) {
+                PipelinedBiCGSTABSolver<Vector> linsolve(opA, precond, comm,
+                          parameters_.linear_solver_reduction_,
+                          parameters_.linear_solver_maxiter_,
+                          verbosity);
+                // Solve system.
+                linsolve.apply(x, istlb, result);
+            }
             else { // BiCGstab solver
                 Dune::BiCGSTABSolver<Vector> linsolve(opA, sp, precond,
                           parameters_.linear_solver_reduction_,
@@ -601,6 +1021,19 @@ namespace Opm
             // store number of iterations
             iterations_ = result.iterations;
 
+            // The first solve after a rebuild gives the reference iteration count.
+            if( iterationsAfterRebuild_ < 0 ) {
+                iterationsAfterRebuild_ = result.iterations;
+            }
+            else if( parameters_.preconditioner_reuse_ == NewtonIterationBlackoilInterleavedParameters::REBUILD_ON_GROWTH &&
+                     result.iterations > (1.0 + parameters_.preconditioner_rebuild_growth_) * std::max( iterationsAfterRebuild_, 1 ) ) {
+                rebuildRequested_ = true;
+            }
+
+            if( ! result.converged ) {
+                rebuildRequested_ = true;
+            }
+
             // Check for failure of linear solver.
             if (!parameters_.ignoreConvergenceFailure_ && !result.converged) {
                 const std::string msg("Convergence failure for linear solver.");
@@ -612,6 +1045,31 @@ namespace Opm
         boost::any parallelInformation_;
         bool isIORank_;
 
+        // preconditioners kept between solves
+        mutable std::unique_ptr< SeqPreconditioner > seqPrecond_;
+        mutable std::unique_ptr< SeqFloatPreconditioner > seqFloatPrecond_;
+#if HAVE_MPI
+        mutable std::unique_ptr< ParPreconditioner > parPrecond_;
+        mutable std::unique_ptr< ParFloatPreconditioner > parFloatPrecond_;
+#endif
+        mutable std::unique_ptr< SeqCPR > seqCPR_;
+        mutable std::unique_ptr< SeqFloatCPR > seqFloatCPR_;
+        mutable std::unique_ptr< SeqMatrixOperator > seqAMGOperator_;
+        mutable std::unique_ptr< SeqAMG > seqAMG_;
+        mutable std::unique_ptr< FloatAMG<Dune::Amg::SequentialInformation> > seqFloatAMG_;
+
+        // order of the rows for the ILU factorization
+        mutable std::vector<std::size_t> iluOrdering_;
+        mutable size_t iluOrderingNonzeroes_;
+
+        // information about the matrix the preconditioner was set up for
+        mutable const Matrix* precondMatrix_;
+        mutable size_t precondRows_;
+        mutable size_t precondNonzeroes_;
+        mutable int iterationsAfterRebuild_;
+        mutable bool newTimeStep_;
+        mutable bool rebuildRequested_;
+
         NewtonIterationBlackoilInterleavedParameters parameters_;
     }; // end ISTLSolver
 
@@ -0,0 +1,202 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_INTERLEAVEDMATRIXBUILDER_HEADER_INCLUDED
+#define OPM_INTERLEAVEDMATRIXBUILDER_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Forms the interleaved (block structured) matrix of a system of np
+    /// equations in np unknowns from its np x np jacobians in compressed
+    /// column storage, e.g. Eigen::SparseMatrix<double>.
+    ///
+    /// The block sparsity structure is the union of the sparsity patterns of
+    /// all jacobians. It is cached together with the position of every
+    /// jacobian entry in it, such that the values can be scattered directly
+    /// into the matrix. The structure is only recomputed when the pattern of
+    /// one of the jacobians changes, e.g. when wells are opened or shut;
+    /// otherwise the matrix keeps its address between the Newton iterations.
+    ///
+    /// \tparam Mat  Block matrix type, e.g. a Dune::BCRSMatrix of np x np blocks.
+    template <class Mat>
+    class InterleavedMatrixBuilder
+    {
+    public:
+        typedef typename Mat::block_type Block;
+        static const int np = Block::rows;
+
+        InterleavedMatrixBuilder()
+            : structures_(0)
+        {
+        }
+
+        /// Form the interleaved matrix.
+        /// \param[in] jacs  The jacobians, jacs[p1*np + p2] is the derivative of
+        ///                  equation p1 with respect to the unknowns p2.
+        /// \return the interleaved matrix, which is owned by this object.
+        template <class SparseRep>
+        Mat& build(const std::vector<const SparseRep*>& jacs)
+        {
+            assert(int(jacs.size()) == np*np);
+            if (!hasStructure(jacs)) {
+                createStructure(jacs);
+            }
+
+            Mat& A = *matrix_;
+            A = 0.0;
+            for (int p1 = 0; p1 < np; ++p1) {
+                for (int p2 = 0; p2 < np; ++p2) {
+                    const std::vector<int>& to_block = jac_to_block_[p1*np + p2];
+                    const double* sa = jacs[p1*np + p2]->valuePtr();
+                    const int nnz = to_block.size();
+                    for (int elem_ix = 0; elem_ix < nnz; ++elem_ix) {
+                        (*blocks_[to_block[elem_ix]])[p1][p2] = sa[elem_ix];
+                    }
+                }
+            }
+            return A;
+        }
+
+        /// The number of times the block sparsity structure has been created.
+        int structureCount() const
+        {
+            return structures_;
+        }
+
+    private:
+        /// Check whether the cached structure matches the sparsity patterns
+        /// of the jacobians.
+        template <class SparseRep>
+        bool hasStructure(const std::vector<const SparseRep*>& jacs) const
+        {
+            if (!matrix_ || int(matrix_->N()) != jacs[0]->rows()) {
+                return false;
+            }
+            for (int pair = 0; pair < np*np; ++pair) {
+                const SparseRep& s = *jacs[pair];
+                const std::vector<int>& outer = jac_outer_[pair];
+                const std::vector<int>& inner = jac_inner_[pair];
+                if (int(outer.size()) != s.outerSize() + 1
+                    || int(inner.size()) != s.nonZeros()
+                    || !std::equal(outer.begin(), outer.end(), s.outerIndexPtr())
+                    || !std::equal(inner.begin(), inner.end(), s.innerIndexPtr())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Create the block sparsity structure as the union of the sparsity
+        /// patterns of all jacobians, and the maps from the jacobian entries
+        /// to the blocks of the interleaved matrix.
+        template <class SparseRep>
+        void createStructure(const std::vector<const SparseRep*>& jacs)
+        {
+            const int size = jacs[0]->rows();
+
+            // Note that that since the jacobians are CSC and not CSR matrices,
+            // the inner indices are row numbers instead of column numbers.
+            std::vector< std::vector<int> > row_cols(size);
+            for (int pair = 0; pair < np*np; ++pair) {
+                const SparseRep& s = *jacs[pair];
+                assert(s.rows() == size && s.cols() == size);
+                const int* ia = s.outerIndexPtr();
+                const int* ja = s.innerIndexPtr();
+                for (int col = 0; col < size; ++col) {
+                    for (int elem_ix = ia[col]; elem_ix < ia[col + 1]; ++elem_ix) {
+                        row_cols[ja[elem_ix]].push_back(col);
+                    }
+                }
+            }
+            int nnz = 0;
+            for (std::vector<int>& cols : row_cols) {
+                std::sort(cols.begin(), cols.end());
+                cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+                nnz += cols.size();
+            }
+
+            // Create the matrix with interleaved rows and columns (block structured).
+            matrix_.reset(new Mat(size, size, nnz, Mat::row_wise));
+            const auto endrow = matrix_->createend();
+            for (auto row = matrix_->createbegin(); row != endrow; ++row) {
+                for (const int col : row_cols[row.index()]) {
+                    row.insert(col);
+                }
+            }
+            ++structures_;
+
+            std::vector<int> row_start(size + 1, 0);
+            for (int row = 0; row < size; ++row) {
+                row_start[row + 1] = row_start[row] + row_cols[row].size();
+            }
+            blocks_.clear();
+            blocks_.reserve(nnz);
+            const auto endi = matrix_->end();
+            for (auto row = matrix_->begin(); row != endi; ++row) {
+                const auto endj = (*row).end();
+                for (auto col = (*row).begin(); col != endj; ++col) {
+                    blocks_.push_back(&(*col));
+                }
+            }
+            assert(int(blocks_.size()) == nnz);
+
+            jac_outer_.assign(np*np, std::vector<int>());
+            jac_inner_.assign(np*np, std::vector<int>());
+            jac_to_block_.assign(np*np, std::vector<int>());
+            for (int pair = 0; pair < np*np; ++pair) {
+                const SparseRep& s = *jacs[pair];
+                const int* ia = s.outerIndexPtr();
+                const int* ja = s.innerIndexPtr();
+                jac_outer_[pair].assign(ia, ia + size + 1);
+                jac_inner_[pair].assign(ja, ja + s.nonZeros());
+                std::vector<int>& to_block = jac_to_block_[pair];
+                to_block.resize(s.nonZeros());
+                for (int col = 0; col < size; ++col) {
+                    for (int elem_ix = ia[col]; elem_ix < ia[col + 1]; ++elem_ix) {
+                        const int row = ja[elem_ix];
+                        const std::vector<int>& cols = row_cols[row];
+                        const int pos = std::lower_bound(cols.begin(), cols.end(), col) - cols.begin();
+                        to_block[elem_ix] = row_start[row] + pos;
+                    }
+                }
+            }
+        }
+
+        // The interleaved matrix, kept between the Newton iterations.
+        std::unique_ptr<Mat> matrix_;
+        // The blocks of matrix_ in row-wise order.
+        std::vector<Block*> blocks_;
+        // Sparsity patterns of the jacobians matrix_ was created for,
+        // indexed by p1*np + p2.
+        std::vector< std::vector<int> > jac_outer_;
+        std::vector< std::vector<int> > jac_inner_;
+        // Index into blocks_ for each entry of the jacobians.
+        std::vector< std::vector<int> > jac_to_block_;
+        int structures_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_INTERLEAVEDMATRIXBUILDER_HEADER_INCLUDED
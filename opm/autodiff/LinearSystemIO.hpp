@@ -0,0 +1,458 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_LINEARSYSTEMIO_HEADER_INCLUDED
+#define OPM_LINEARSYSTEMIO_HEADER_INCLUDED
+
+#include <opm/autodiff/MatrixBlockKernels.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/istl/operators.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+    /// \brief The coupling of a standard well to the reservoir system, i.e.
+    ///        the blocks of B, C and D^-1 of the well equations
+    ///        [A C^T; B D] [x; x_well] = [r; r_well].
+    ///
+    /// The blocks are stored row-major, B and C with one block of
+    /// numWellEq x numEq per perforated cell.
+    struct LinearSystemWell
+    {
+        std::string name;
+        int numWellEq = 0;
+        int numEq = 0;
+        std::vector<int> cellsB;
+        std::vector<double> B;
+        std::vector<int> cellsC;
+        std::vector<double> C;
+        std::vector<double> invD;
+
+        /// \brief Ax = Ax - C^T D^-1 B x
+        template <class X, class Y>
+        void apply(const X& x, Y& Ax) const
+        {
+            Bx_.assign(numWellEq, 0.0);
+            for (std::size_t perf = 0; perf < cellsB.size(); ++perf) {
+                const double* block = &B[perf * numWellEq * numEq];
+                const auto& xc = x[cellsB[perf]];
+                for (int i = 0; i < numWellEq; ++i) {
+                    for (int j = 0; j < numEq; ++j) {
+                        Bx_[i] += block[i * numEq + j] * xc[j];
+                    }
+                }
+            }
+
+            invDBx_.assign(numWellEq, 0.0);
+            for (int i = 0; i < numWellEq; ++i) {
+                for (int j = 0; j < numWellEq; ++j) {
+                    invDBx_[i] += invD[i * numWellEq + j] * Bx_[j];
+                }
+            }
+
+            for (std::size_t perf = 0; perf < cellsC.size(); ++perf) {
+                const double* block = &C[perf * numWellEq * numEq];
+                auto& y = Ax[cellsC[perf]];
+                for (int i = 0; i < numWellEq; ++i) {
+                    for (int j = 0; j < numEq; ++j) {
+                        y[j] -= block[i * numEq + j] * invDBx_[i];
+                    }
+                }
+            }
+        }
+
+    private:
+        mutable std::vector<double> Bx_;
+        mutable std::vector<double> invDBx_;
+    };
+
+
+
+    /// \brief Where a captured linear system comes from.
+    struct LinearSystemInfo
+    {
+        int blockSize = 0;
+        int reportStep = -1;
+        int subStep = -1;
+        int iteration = -1;
+    };
+
+
+
+    namespace detail
+    {
+        // the file starts with the magic string followed by the version of the format
+        const char linearSystemMagic[8] = { 'O', 'P', 'M', 'L', 'S', 'Y', 'S', '\0' };
+        const std::int32_t linearSystemVersion = 1;
+
+        template <class T>
+        void writeBinary(std::ostream& os, const T& value)
+        {
+            os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <class T>
+        void writeBinary(std::ostream& os, const std::vector<T>& values)
+        {
+            writeBinary(os, std::uint64_t(values.size()));
+            os.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+
+        template <class T>
+        void readBinary(std::istream& is, T& value)
+        {
+            is.read(reinterpret_cast<char*>(&value), sizeof(T));
+            if (!is) {
+                OPM_THROW(std::runtime_error, "Unexpected end of the linear system file");
+            }
+        }
+
+        template <class T>
+        void readBinary(std::istream& is, std::vector<T>& values)
+        {
+            std::uint64_t size = 0;
+            readBinary(is, size);
+            values.resize(size);
+            is.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+            if (!is) {
+                OPM_THROW(std::runtime_error, "Unexpected end of the linear system file");
+            }
+        }
+
+        inline void writeInfo(std::ostream& os, const LinearSystemInfo& info)
+        {
+            os.write(linearSystemMagic, sizeof(linearSystemMagic));
+            writeBinary(os, linearSystemVersion);
+            writeBinary(os, std::int32_t(info.blockSize));
+            writeBinary(os, std::int32_t(info.reportStep));
+            writeBinary(os, std::int32_t(info.subStep));
+            writeBinary(os, std::int32_t(info.iteration));
+        }
+
+        inline LinearSystemInfo readInfo(std::istream& is, const std::string& filename)
+        {
+            char magic[sizeof(linearSystemMagic)];
+            is.read(magic, sizeof(magic));
+            if (!is || std::memcmp(magic, linearSystemMagic, sizeof(magic)) != 0) {
+                OPM_THROW(std::runtime_error, filename << " is not a linear system file");
+            }
+            std::int32_t version, blockSize, reportStep, subStep, iteration;
+            readBinary(is, version);
+            if (version != linearSystemVersion) {
+                OPM_THROW(std::runtime_error, "Version " << version << " of the linear system file "
+                          << filename << " is not supported");
+            }
+            readBinary(is, blockSize);
+            readBinary(is, reportStep);
+            readBinary(is, subStep);
+            readBinary(is, iteration);
+
+            LinearSystemInfo info;
+            info.blockSize = blockSize;
+            info.reportStep = reportStep;
+            info.subStep = subStep;
+            info.iteration = iteration;
+            return info;
+        }
+
+        // the sparsity pattern as the number of blocks of each row and the
+        // column indices, followed by the entries of the blocks
+        template <class Matrix>
+        void writeMatrix(std::ostream& os, const Matrix& A)
+        {
+            typedef typename Matrix::block_type Block;
+            std::vector<std::uint32_t> rowSizes;
+            std::vector<std::uint32_t> columns;
+            std::vector<double> values;
+            rowSizes.reserve(A.N());
+            columns.reserve(A.nonzeroes());
+            values.reserve(A.nonzeroes() * Block::rows * Block::cols);
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                rowSizes.push_back((*row).size());
+                for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                    columns.push_back(col.index());
+                    for (int i = 0; i < Block::rows; ++i) {
+                        for (int j = 0; j < Block::cols; ++j) {
+                            values.push_back((*col)[i][j]);
+                        }
+                    }
+                }
+            }
+            writeBinary(os, std::uint64_t(A.M()));
+            writeBinary(os, rowSizes);
+            writeBinary(os, columns);
+            writeBinary(os, values);
+        }
+
+        template <class Matrix>
+        void readMatrix(std::istream& is, Matrix& A)
+        {
+            typedef typename Matrix::block_type Block;
+            std::uint64_t cols = 0;
+            std::vector<std::uint32_t> rowSizes;
+            std::vector<std::uint32_t> columns;
+            std::vector<double> values;
+            readBinary(is, cols);
+            readBinary(is, rowSizes);
+            readBinary(is, columns);
+            readBinary(is, values);
+            if (values.size() != columns.size() * Block::rows * Block::cols) {
+                OPM_THROW(std::runtime_error, "Inconsistent matrix in the linear system file");
+            }
+
+            A.setBuildMode(Matrix::row_wise);
+            A.setSize(rowSizes.size(), cols, columns.size());
+            std::size_t nz = 0;
+            auto rowSize = rowSizes.begin();
+            for (auto row = A.createbegin(); row != A.createend(); ++row, ++rowSize) {
+                for (std::uint32_t k = 0; k < *rowSize; ++k, ++nz) {
+                    if (nz >= columns.size() || columns[nz] >= cols) {
+                        OPM_THROW(std::runtime_error, "Inconsistent matrix in the linear system file");
+                    }
+                    row.insert(columns[nz]);
+                }
+            }
+
+            const double* value = values.data();
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                    for (int i = 0; i < Block::rows; ++i) {
+                        for (int j = 0; j < Block::cols; ++j) {
+                            (*col)[i][j] = *value++;
+                        }
+                    }
+                }
+            }
+        }
+
+        template <class Vector>
+        void writeVector(std::ostream& os, const Vector& b)
+        {
+            std::vector<double> values;
+            values.reserve(b.size() * Vector::block_type::dimension);
+            for (std::size_t i = 0; i < b.size(); ++i) {
+                for (int k = 0; k < Vector::block_type::dimension; ++k) {
+                    values.push_back(b[i][k]);
+                }
+            }
+            writeBinary(os, values);
+        }
+
+        template <class Vector>
+        void readVector(std::istream& is, Vector& b)
+        {
+            std::vector<double> values;
+            readBinary(is, values);
+            if (values.size() % Vector::block_type::dimension != 0) {
+                OPM_THROW(std::runtime_error, "Inconsistent vector in the linear system file");
+            }
+            b.resize(values.size() / Vector::block_type::dimension);
+            const double* value = values.data();
+            for (std::size_t i = 0; i < b.size(); ++i) {
+                for (int k = 0; k < Vector::block_type::dimension; ++k) {
+                    b[i][k] = *value++;
+                }
+            }
+        }
+
+        inline void writeWell(std::ostream& os, const LinearSystemWell& well)
+        {
+            writeBinary(os, std::vector<char>(well.name.begin(), well.name.end()));
+            writeBinary(os, std::int32_t(well.numWellEq));
+            writeBinary(os, std::int32_t(well.numEq));
+            writeBinary(os, well.cellsB);
+            writeBinary(os, well.B);
+            writeBinary(os, well.cellsC);
+            writeBinary(os, well.C);
+            writeBinary(os, well.invD);
+        }
+
+        inline void readWell(std::istream& is, LinearSystemWell& well)
+        {
+            std::vector<char> name;
+            std::int32_t numWellEq, numEq;
+            readBinary(is, name);
+            readBinary(is, numWellEq);
+            readBinary(is, numEq);
+            well.name.assign(name.begin(), name.end());
+            well.numWellEq = numWellEq;
+            well.numEq = numEq;
+            readBinary(is, well.cellsB);
+            readBinary(is, well.B);
+            readBinary(is, well.cellsC);
+            readBinary(is, well.C);
+            readBinary(is, well.invD);
+            const std::size_t blockSize = numWellEq * numEq;
+            if (well.B.size() != well.cellsB.size() * blockSize
+                || well.C.size() != well.cellsC.size() * blockSize
+                || well.invD.size() != std::size_t(numWellEq * numWellEq)) {
+                OPM_THROW(std::runtime_error, "Inconsistent blocks of well " << well.name
+                          << " in the linear system file");
+            }
+        }
+    } // namespace detail
+
+
+
+    /// \brief Write the linear system A x = b, with the wells eliminated by
+    ///        the Schur complement A - C^T D^-1 B, to a binary file.
+    ///
+    /// The numbers are written in the byte order of the machine.
+    template <class Matrix, class Vector>
+    void writeLinearSystem(const std::string& filename, LinearSystemInfo info,
+                           const Matrix& A, const Vector& b,
+                           const std::vector<LinearSystemWell>& wells)
+    {
+        std::ofstream os(filename, std::ios::binary);
+        if (!os) {
+            OPM_THROW(std::runtime_error, "Could not open the linear system file " << filename);
+        }
+        info.blockSize = Vector::block_type::dimension;
+        detail::writeInfo(os, info);
+        detail::writeMatrix(os, A);
+        detail::writeVector(os, b);
+        detail::writeBinary(os, std::uint64_t(wells.size()));
+        for (const auto& well : wells) {
+            detail::writeWell(os, well);
+        }
+        if (!os) {
+            OPM_THROW(std::runtime_error, "Could not write the linear system file " << filename);
+        }
+    }
+
+    /// \brief Read the information about the linear system of a file, e.g. to
+    ///        choose the block size of the matrix for readLinearSystem().
+    inline LinearSystemInfo readLinearSystemInfo(const std::string& filename)
+    {
+        std::ifstream is(filename, std::ios::binary);
+        if (!is) {
+            OPM_THROW(std::runtime_error, "Could not open the linear system file " << filename);
+        }
+        return detail::readInfo(is, filename);
+    }
+
+    /// \brief Read a linear system written by writeLinearSystem() into the newly
+    ///        created matrix A.
+    template <class Matrix, class Vector>
+    LinearSystemInfo readLinearSystem(const std::string& filename, Matrix& A, Vector& b,
+                                      std::vector<LinearSystemWell>& wells)
+    {
+        std::ifstream is(filename, std::ios::binary);
+        if (!is) {
+            OPM_THROW(std::runtime_error, "Could not open the linear system file " << filename);
+        }
+        const LinearSystemInfo info = detail::readInfo(is, filename);
+        if (info.blockSize != Vector::block_type::dimension) {
+            OPM_THROW(std::runtime_error, "The linear system file " << filename << " has blocks of size "
+                      << info.blockSize << ", expected " << Vector::block_type::dimension);
+        }
+        detail::readMatrix(is, A);
+        detail::readVector(is, b);
+        if (A.N() != b.size()) {
+            OPM_THROW(std::runtime_error, "The matrix and the right hand side of the linear system file "
+                      << filename << " do not match");
+        }
+
+        std::uint64_t numWells = 0;
+        detail::readBinary(is, numWells);
+        wells.resize(numWells);
+        for (auto& well : wells) {
+            detail::readWell(is, well);
+            if (well.numEq != info.blockSize) {
+                OPM_THROW(std::runtime_error, "The blocks of well " << well.name << " do not match the matrix");
+            }
+            for (const std::vector<int>* cells : { &well.cellsB, &well.cellsC }) {
+                for (const int cell : *cells) {
+                    if (cell < 0 || std::size_t(cell) >= b.size()) {
+                        OPM_THROW(std::runtime_error, "Well " << well.name << " perforates cell "
+                                  << cell << " outside of the grid");
+                    }
+                }
+            }
+        }
+        return info;
+    }
+
+
+
+    /// \brief The sequential operator A - C^T D^-1 B of a linear system read by
+    ///        readLinearSystem(), applied like the WellModelMatrixAdapter of
+    ///        BlackoilModelEbos.
+    template <class M, class X, class Y>
+    class LinearSystemOperator : public Dune::AssembledLinearOperator<M, X, Y>
+    {
+    public:
+        typedef M matrix_type;
+        typedef X domain_type;
+        typedef Y range_type;
+        typedef typename X::field_type field_type;
+
+        enum {
+            //! \brief The solver category.
+            category = Dune::SolverCategory::sequential
+        };
+
+        /// \brief Constructor, A and wells have to outlive this object.
+        LinearSystemOperator(const M& A, const std::vector<LinearSystemWell>& wells)
+            : A_( A ), wells_( wells )
+        {
+        }
+
+        virtual void apply( const X& x, Y& y ) const
+        {
+            blockkernels::bcrsMv( A_, x, y );
+            for (const auto& well : wells_) {
+                well.apply( x, y );
+            }
+        }
+
+        // y += \alpha * A * x
+        virtual void applyscaleadd (field_type alpha, const X& x, Y& y) const
+        {
+            blockkernels::bcrsUsmv( alpha, A_, x, y );
+            if (wells_.empty()) {
+                return;
+            }
+            scaleAddRes_.resize( y.size() );
+            scaleAddRes_ = 0.0;
+            for (const auto& well : wells_) {
+                well.apply( x, scaleAddRes_ );
+            }
+            y.axpy( alpha, scaleAddRes_ );
+        }
+
+        virtual const matrix_type& getmat() const { return A_; }
+
+    private:
+        const M& A_;
+        const std::vector<LinearSystemWell>& wells_;
+        mutable Y scaleAddRes_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_LINEARSYSTEMIO_HEADER_INCLUDED
@@ -27,7 +27,9 @@
 #if HAVE_UMFPACK
 #include <dune/istl/umfpack.hh>
 #endif // HAVE_UMFPACK
+#include <cassert>
 #include <cmath>
+#include <vector>
 
 namespace Opm {
 
@@ -71,6 +73,218 @@ namespace mswellhelpers
 
 
 
+    /// Direct solver for y = D^-1 * x, which keeps the factorization of D between solves.
+    /// The symbolic factorization only depends on the sparsity pattern of D and is kept
+    /// as long as the pattern does not change, e.g. for the fixed segment topology of a
+    /// multisegment well. The numeric factorization is computed by factorize(), i.e.
+    /// only once for every assembly of D, and reused by all the following solves.
+    template <typename MatrixType>
+    class CachedUMFPack
+    {
+    public:
+        CachedUMFPack() = default;
+
+        ~CachedUMFPack()
+        {
+            freeNumeric();
+            freeSymbolic();
+        }
+
+        CachedUMFPack(const CachedUMFPack&) = delete;
+        CachedUMFPack& operator=(const CachedUMFPack&) = delete;
+
+        /// compute the numeric factorization of D, and the symbolic one if the
+        /// sparsity pattern of D differs from the one of the previous call
+        void factorize(const MatrixType& D)
+        {
+#if HAVE_UMFPACK
+            freeNumeric();
+            if (!symbolic_ || !samePattern(D)) {
+                analyzePattern(D);
+            }
+
+            // copy the values of D into the compressed column storage
+            auto pos = value_pos_.begin();
+            for (auto row = D.begin(); row != D.end(); ++row) {
+                for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                    for (int i = 0; i < blockSize; ++i) {
+                        for (int j = 0; j < blockSize; ++j) {
+                            values_[*pos++] = (*col)[i][j];
+                        }
+                    }
+                }
+            }
+
+            const int status = umfpack_di_numeric(col_start_.data(), row_index_.data(), values_.data(),
+                                                  symbolic_, &numeric_, nullptr, nullptr);
+            // a singular matrix is only a warning, it shows up as inf or nan in the solution
+            if (status < UMFPACK_OK) {
+                freeNumeric();
+                OPM_THROW(Opm::NumericalProblem, "numeric factorization failed in CachedUMFPack with status " << status);
+            }
+#else
+            static_cast<void>(D);
+            OPM_THROW(std::runtime_error, "Cannot use CachedUMFPack without UMFPACK. "
+                      "Reconfigure opm-simulator with SuiteSparse/UMFPACK support and recompile.");
+#endif // HAVE_UMFPACK
+        }
+
+        /// whether a numeric factorization is available
+        bool factorized() const
+        {
+            return numeric_ != nullptr;
+        }
+
+        /// discard the numeric factorization, e.g. because D has been reassembled
+        void reset()
+        {
+            freeNumeric();
+        }
+
+        /// obtain y = D^-1 * x with the factorization of the last call to factorize()
+        template <typename VectorType>
+        VectorType solve(const VectorType& x) const
+        {
+            assert(factorized());
+            VectorType y(x.size());
+#if HAVE_UMFPACK
+            const int n = x.size() * blockSize;
+            rhs_.resize(n);
+            sol_.resize(n);
+            for (size_t i_block = 0; i_block < x.size(); ++i_block) {
+                for (int i_elem = 0; i_elem < blockSize; ++i_elem) {
+                    rhs_[i_block * blockSize + i_elem] = x[i_block][i_elem];
+                }
+            }
+
+            umfpack_di_solve(UMFPACK_A, col_start_.data(), row_index_.data(), values_.data(),
+                             sol_.data(), rhs_.data(), numeric_, nullptr, nullptr);
+
+            // Checking if there is any inf or nan in y
+            // it will be the solution before we find a way to catch the singularity of the matrix
+            for (size_t i_block = 0; i_block < y.size(); ++i_block) {
+                for (int i_elem = 0; i_elem < blockSize; ++i_elem) {
+                    const double value = sol_[i_block * blockSize + i_elem];
+                    if (std::isinf(value) || std::isnan(value)) {
+                        OPM_THROW(Opm::NumericalProblem, "nan or inf value found in CachedUMFPack due to singular matrix");
+                    }
+                    y[i_block][i_elem] = value;
+                }
+            }
+#endif // HAVE_UMFPACK
+            return y;
+        }
+
+    private:
+        static const int blockSize = MatrixType::block_type::rows;
+
+        bool samePattern(const MatrixType& D) const
+        {
+            if (int(D.N()) * blockSize + 1 != int(col_start_.size()) || D.nonzeroes() != block_cols_.size()) {
+                return false;
+            }
+            auto block_col = block_cols_.begin();
+            for (auto row = D.begin(); row != D.end(); ++row) {
+                for (auto col = (*row).begin(); col != (*row).end(); ++col, ++block_col) {
+                    if (int(col.index()) != *block_col) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+#if HAVE_UMFPACK
+        // set up the compressed column storage of D and its symbolic factorization
+        void analyzePattern(const MatrixType& D)
+        {
+            freeSymbolic();
+
+            const int n = D.N() * blockSize;
+            const int nnz = D.nonzeroes() * blockSize * blockSize;
+
+            block_cols_.clear();
+            std::vector<int> col_count(n, 0);
+            for (auto row = D.begin(); row != D.end(); ++row) {
+                for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                    block_cols_.push_back(col.index());
+                    for (int j = 0; j < blockSize; ++j) {
+                        col_count[col.index() * blockSize + j] += blockSize;
+                    }
+                }
+            }
+
+            col_start_.assign(n + 1, 0);
+            for (int c = 0; c < n; ++c) {
+                col_start_[c + 1] = col_start_[c] + col_count[c];
+            }
+
+            // traversing D row by row keeps the row indices sorted within each column
+            row_index_.resize(nnz);
+            values_.resize(nnz);
+            value_pos_.clear();
+            std::vector<int> next(col_start_.begin(), col_start_.end() - 1);
+            for (auto row = D.begin(); row != D.end(); ++row) {
+                for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                    for (int i = 0; i < blockSize; ++i) {
+                        for (int j = 0; j < blockSize; ++j) {
+                            const int c = col.index() * blockSize + j;
+                            row_index_[next[c]] = row.index() * blockSize + i;
+                            value_pos_.push_back(next[c]++);
+                        }
+                    }
+                }
+            }
+
+            const int status = umfpack_di_symbolic(n, n, col_start_.data(), row_index_.data(), values_.data(),
+                                                   &symbolic_, nullptr, nullptr);
+            if (status != UMFPACK_OK) {
+                freeSymbolic();
+                OPM_THROW(Opm::NumericalProblem, "symbolic factorization failed in CachedUMFPack with status " << status);
+            }
+        }
+#endif // HAVE_UMFPACK
+
+        void freeSymbolic()
+        {
+#if HAVE_UMFPACK
+            if (symbolic_) {
+                umfpack_di_free_symbolic(&symbolic_);
+            }
+#endif // HAVE_UMFPACK
+            symbolic_ = nullptr;
+        }
+
+        void freeNumeric()
+        {
+#if HAVE_UMFPACK
+            if (numeric_) {
+                umfpack_di_free_numeric(&numeric_);
+            }
+#endif // HAVE_UMFPACK
+            numeric_ = nullptr;
+        }
+
+        void* symbolic_ = nullptr;
+        void* numeric_ = nullptr;
+
+        // block column indices of D, row by row, to detect changes of the pattern
+        std::vector<int> block_cols_;
+        // D in compressed column storage
+        std::vector<int> col_start_;
+        std::vector<int> row_index_;
+        std::vector<double> values_;
+        // position in values_ of the entries of D, block by block in row-wise order
+        std::vector<int> value_pos_;
+        // work vectors of solve()
+        mutable std::vector<double> rhs_;
+        mutable std::vector<double> sol_;
+    };
+
+
+
+
+
     // obtain y = D^-1 * x with a BICSSTAB iterative solver
     template <typename MatrixType, typename VectorType>
     VectorType
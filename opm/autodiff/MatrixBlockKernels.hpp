@@ -0,0 +1,255 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_MATRIXBLOCKKERNELS_HEADER_INCLUDED
+#define OPM_MATRIXBLOCKKERNELS_HEADER_INCLUDED
+
+#if defined(__AVX__) || defined(__SSE3__)
+#include <immintrin.h>
+#endif
+
+namespace Opm
+{
+
+/// \brief Kernels for the products of the small dense blocks of the
+///        block-structured matrices with the blocks of a vector.
+///
+/// These replace the generic loops of Dune::DenseMatrix in the innermost
+/// loops of the linear solver, i.e. the sparse matrix-vector products and
+/// the triangular solves of the ILU0. The blocks of 2x2 (oil-water, gas-oil)
+/// and 4x4 (solvent, polymer) doubles are handled with SSE3 and AVX
+/// intrinsics when the compiler targets these instruction sets, i.e. with
+/// -march=native on a machine supporting them or with the flags given in the
+/// CMake variable SIMD_FLAGS. The 3x3 blocks of the black-oil model are
+/// written out, all other block sizes and field types use the loops over
+/// the compile-time extents of the block and rely on the compiler to unroll
+/// and vectorize them.
+namespace blockkernels
+{
+    /// \brief The kernels for blocks of n x m entries of type K applied to
+    ///        vectors with entries of type KX and KY.
+    template <class K, int n, int m, class KX, class KY>
+    struct Kernel
+    {
+        //! y = A x
+        template <class Block, class X, class Y>
+        static void mv(const Block& A, const X& x, Y& y)
+        {
+            for (int i = 0; i < n; ++i) {
+                KY sum = 0;
+                for (int j = 0; j < m; ++j) {
+                    sum += A[i][j] * x[j];
+                }
+                y[i] = sum;
+            }
+        }
+
+        //! y += alpha A x
+        template <class Block, class X, class Y>
+        static void usmv(const KY alpha, const Block& A, const X& x, Y& y)
+        {
+            for (int i = 0; i < n; ++i) {
+                KY sum = 0;
+                for (int j = 0; j < m; ++j) {
+                    sum += A[i][j] * x[j];
+                }
+                y[i] += alpha * sum;
+            }
+        }
+    };
+
+    /// \brief 3x3 blocks of the black-oil model, written out such that the
+    ///        rows are independent of each other and do not depend on the
+    ///        compiler unrolling the loops.
+    template <class K, class KX, class KY>
+    struct Kernel<K, 3, 3, KX, KY>
+    {
+        template <class Block, class X, class Y>
+        static void mv(const Block& A, const X& x, Y& y)
+        {
+            const KY x0 = x[0], x1 = x[1], x2 = x[2];
+            y[0] = A[0][0] * x0 + A[0][1] * x1 + A[0][2] * x2;
+            y[1] = A[1][0] * x0 + A[1][1] * x1 + A[1][2] * x2;
+            y[2] = A[2][0] * x0 + A[2][1] * x1 + A[2][2] * x2;
+        }
+
+        template <class Block, class X, class Y>
+        static void usmv(const KY alpha, const Block& A, const X& x, Y& y)
+        {
+            const KY x0 = x[0], x1 = x[1], x2 = x[2];
+            y[0] += alpha * (A[0][0] * x0 + A[0][1] * x1 + A[0][2] * x2);
+            y[1] += alpha * (A[1][0] * x0 + A[1][1] * x1 + A[1][2] * x2);
+            y[2] += alpha * (A[2][0] * x0 + A[2][1] * x1 + A[2][2] * x2);
+        }
+    };
+
+#if defined(__SSE3__)
+    /// \brief 2x2 blocks of doubles, two rows per horizontal add.
+    template <>
+    struct Kernel<double, 2, 2, double, double>
+    {
+        template <class Block, class X>
+        static __m128d product(const Block& A, const X& x)
+        {
+            const __m128d xv = _mm_loadu_pd(&x[0]);
+            const __m128d r0 = _mm_mul_pd(_mm_loadu_pd(&A[0][0]), xv);
+            const __m128d r1 = _mm_mul_pd(_mm_loadu_pd(&A[1][0]), xv);
+            return _mm_hadd_pd(r0, r1);
+        }
+
+        template <class Block, class X, class Y>
+        static void mv(const Block& A, const X& x, Y& y)
+        {
+            _mm_storeu_pd(&y[0], product(A, x));
+        }
+
+        template <class Block, class X, class Y>
+        static void usmv(const double alpha, const Block& A, const X& x, Y& y)
+        {
+            const __m128d ax = _mm_mul_pd(_mm_set1_pd(alpha), product(A, x));
+            _mm_storeu_pd(&y[0], _mm_add_pd(_mm_loadu_pd(&y[0]), ax));
+        }
+    };
+#endif // __SSE3__
+
+#if defined(__AVX__)
+    namespace detail
+    {
+        //! the sums of the rows r0, ..., r3 in one register
+        inline __m256d rowSums(const __m256d r0, const __m256d r1,
+                               const __m256d r2, const __m256d r3)
+        {
+            // [r0_01, r1_01, r0_23, r1_23] and [r2_01, r3_01, r2_23, r3_23]
+            const __m256d t0 = _mm256_hadd_pd(r0, r1);
+            const __m256d t1 = _mm256_hadd_pd(r2, r3);
+            // [r0_01, r1_01, r2_01, r3_01] + [r0_23, r1_23, r2_23, r3_23]
+            return _mm256_add_pd(_mm256_permute2f128_pd(t0, t1, 0x20),
+                                 _mm256_permute2f128_pd(t0, t1, 0x31));
+        }
+
+        //! load a row of four doubles
+        inline __m256d loadRow(const double* row)
+        {
+            return _mm256_loadu_pd(row);
+        }
+
+        //! load a row of four floats, e.g. of the single precision ILU factors
+        inline __m256d loadRow(const float* row)
+        {
+            return _mm256_cvtps_pd(_mm_loadu_ps(row));
+        }
+
+        template <class Block, class X>
+        inline __m256d product4(const Block& A, const X& x)
+        {
+            const __m256d xv = _mm256_loadu_pd(&x[0]);
+            return rowSums(_mm256_mul_pd(loadRow(&A[0][0]), xv),
+                           _mm256_mul_pd(loadRow(&A[1][0]), xv),
+                           _mm256_mul_pd(loadRow(&A[2][0]), xv),
+                           _mm256_mul_pd(loadRow(&A[3][0]), xv));
+        }
+    } // namespace detail
+
+    /// \brief 4x4 blocks of doubles or floats applied to vectors of doubles.
+    template <class K>
+    struct Kernel<K, 4, 4, double, double>
+    {
+        template <class Block, class X, class Y>
+        static void mv(const Block& A, const X& x, Y& y)
+        {
+            _mm256_storeu_pd(&y[0], detail::product4(A, x));
+        }
+
+        template <class Block, class X, class Y>
+        static void usmv(const double alpha, const Block& A, const X& x, Y& y)
+        {
+            const __m256d ax = _mm256_mul_pd(_mm256_set1_pd(alpha), detail::product4(A, x));
+            _mm256_storeu_pd(&y[0], _mm256_add_pd(_mm256_loadu_pd(&y[0]), ax));
+        }
+    };
+#endif // __AVX__
+
+    template <class Block, class X, class Y>
+    struct KernelSelector
+    {
+        typedef Kernel<typename Block::field_type, Block::rows, Block::cols,
+                       typename X::field_type, typename Y::field_type> type;
+    };
+
+    /// \brief y = A x for a matrix block A.
+    template <class Block, class X, class Y>
+    inline void mv(const Block& A, const X& x, Y& y)
+    {
+        KernelSelector<Block, X, Y>::type::mv(A, x, y);
+    }
+
+    /// \brief y += A x for a matrix block A.
+    template <class Block, class X, class Y>
+    inline void umv(const Block& A, const X& x, Y& y)
+    {
+        KernelSelector<Block, X, Y>::type::usmv(1, A, x, y);
+    }
+
+    /// \brief y -= A x for a matrix block A.
+    template <class Block, class X, class Y>
+    inline void mmv(const Block& A, const X& x, Y& y)
+    {
+        KernelSelector<Block, X, Y>::type::usmv(-1, A, x, y);
+    }
+
+    /// \brief y += alpha A x for a matrix block A.
+    template <class Block, class X, class Y>
+    inline void usmv(const typename Y::field_type alpha, const Block& A, const X& x, Y& y)
+    {
+        KernelSelector<Block, X, Y>::type::usmv(alpha, A, x, y);
+    }
+
+    /// \brief y = A x for a block-structured sparse matrix A, e.g. a Dune::BCRSMatrix.
+    template <class Matrix, class X, class Y>
+    void bcrsMv(const Matrix& A, const X& x, Y& y)
+    {
+        const auto endi = A.end();
+        for (auto row = A.begin(); row != endi; ++row) {
+            auto& yi = y[row.index()];
+            yi = 0;
+            const auto endj = (*row).end();
+            for (auto col = (*row).begin(); col != endj; ++col) {
+                umv(*col, x[col.index()], yi);
+            }
+        }
+    }
+
+    /// \brief y += alpha A x for a block-structured sparse matrix A.
+    template <class Matrix, class X, class Y>
+    void bcrsUsmv(const typename Y::field_type alpha, const Matrix& A, const X& x, Y& y)
+    {
+        const auto endi = A.end();
+        for (auto row = A.begin(); row != endi; ++row) {
+            auto& yi = y[row.index()];
+            const auto endj = (*row).end();
+            for (auto col = (*row).begin(); col != endj; ++col) {
+                usmv(alpha, *col, x[col.index()], yi);
+            }
+        }
+    }
+
+} // namespace blockkernels
+} // namespace Opm
+
+#endif // OPM_MATRIXBLOCKKERNELS_HEADER_INCLUDED
@@ -0,0 +1,255 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_MATRIXREORDERING_HEADER_INCLUDED
+#define OPM_MATRIXREORDERING_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+namespace detail
+{
+    /// \brief The symmetrized adjacency graph of the sparsity pattern of a
+    ///        matrix in compressed row storage, without the diagonal.
+    struct AdjacencyGraph
+    {
+        template <class Matrix>
+        explicit AdjacencyGraph(const Matrix& A)
+            : start_(A.N() + 1, 0)
+        {
+            // count the entries of the pattern of A + A^T
+            const auto endi = A.end();
+            for (auto row = A.begin(); row != endi; ++row) {
+                const auto endj = (*row).end();
+                for (auto col = (*row).begin(); col != endj; ++col) {
+                    if (col.index() != row.index()) {
+                        ++start_[row.index() + 1];
+                        ++start_[col.index() + 1];
+                    }
+                }
+            }
+            for (std::size_t i = 0; i < A.N(); ++i) {
+                start_[i + 1] += start_[i];
+            }
+
+            neighbours_.resize(start_.back());
+            std::vector<std::size_t> position(start_.begin(), start_.end() - 1);
+            for (auto row = A.begin(); row != endi; ++row) {
+                const auto endj = (*row).end();
+                for (auto col = (*row).begin(); col != endj; ++col) {
+                    if (col.index() != row.index()) {
+                        neighbours_[position[row.index()]++] = col.index();
+                        neighbours_[position[col.index()]++] = row.index();
+                    }
+                }
+            }
+
+            // remove the duplicates of structurally symmetric entries
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < A.N(); ++i) {
+                const auto begin = neighbours_.begin() + start_[i];
+                const auto end = neighbours_.begin() + start_[i + 1];
+                std::sort(begin, end);
+                const auto last = std::unique(begin, end);
+                start_[i] = count;
+                for (auto it = begin; it != last; ++it) {
+                    neighbours_[count++] = *it;
+                }
+            }
+            start_[A.N()] = count;
+            neighbours_.resize(count);
+        }
+
+        std::size_t size() const { return start_.size() - 1; }
+        std::size_t degree(const std::size_t i) const { return start_[i + 1] - start_[i]; }
+
+        std::vector<std::size_t> start_;
+        std::vector<std::size_t> neighbours_;
+    };
+
+    /// \brief Breadth first search from start through the nodes not yet
+    ///        numbered, the nodes are appended to order level by level.
+    /// \param sortByDegree append the neighbours of a node in order of increasing degree
+    /// \return the number of levels
+    inline std::size_t breadthFirstSearch(const AdjacencyGraph& graph, const std::size_t start,
+                                          const std::vector<bool>& numbered, const bool sortByDegree,
+                                          std::vector<std::size_t>& visitedStamp, const std::size_t stamp,
+                                          std::vector<std::size_t>& order, std::size_t& lastLevelBegin)
+    {
+        const std::size_t first = order.size();
+        order.push_back(start);
+        visitedStamp[start] = stamp;
+
+        std::size_t levels = 0;
+        std::size_t levelBegin = first;
+        while (levelBegin < order.size()) {
+            const std::size_t levelEnd = order.size();
+            lastLevelBegin = levelBegin;
+            ++levels;
+            for (std::size_t k = levelBegin; k < levelEnd; ++k) {
+                const std::size_t node = order[k];
+                const std::size_t childrenBegin = order.size();
+                for (std::size_t j = graph.start_[node]; j < graph.start_[node + 1]; ++j) {
+                    const std::size_t neighbour = graph.neighbours_[j];
+                    if (!numbered[neighbour] && visitedStamp[neighbour] != stamp) {
+                        visitedStamp[neighbour] = stamp;
+                        order.push_back(neighbour);
+                    }
+                }
+                if (sortByDegree) {
+                    std::stable_sort(order.begin() + childrenBegin, order.end(),
+                                     [&graph](const std::size_t a, const std::size_t b)
+                                     { return graph.degree(a) < graph.degree(b); });
+                }
+            }
+            levelBegin = levelEnd;
+        }
+        return levels;
+    }
+} // namespace detail
+
+/// \brief Compute the reverse Cuthill-McKee ordering of the rows of a sparse matrix.
+///
+/// The ordering reduces the bandwidth of the matrix, which improves the
+/// locality of the memory accesses of the ILU factorization and its
+/// triangular solves and often also the quality of the ILU0. The pattern of
+/// A + A^T is used, each connected component starts at a pseudo-peripheral
+/// node found by the algorithm of George and Liu.
+/// \param A The matrix, e.g. a Dune::BCRSMatrix.
+/// \return The ordering, i.e. the row of A which becomes row i of the reordered matrix.
+template <class Matrix>
+std::vector<std::size_t> reverseCuthillMcKee(const Matrix& A)
+{
+    const detail::AdjacencyGraph graph(A);
+    const std::size_t n = graph.size();
+
+    std::vector<std::size_t> ordering;
+    ordering.reserve(n);
+    std::vector<bool> numbered(n, false);
+    std::vector<std::size_t> visitedStamp(n, 0);
+    std::size_t stamp = 0;
+    std::vector<std::size_t> levelStructure;
+    levelStructure.reserve(n);
+
+    for (std::size_t seed = 0; seed < n; ++seed) {
+        if (numbered[seed]) {
+            continue;
+        }
+
+        // find a pseudo-peripheral node of the component of seed
+        std::size_t start = seed;
+        std::size_t eccentricity = 0;
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            levelStructure.clear();
+            std::size_t lastLevelBegin = 0;
+            const std::size_t levels = detail::breadthFirstSearch(graph, start, numbered, false, visitedStamp,
+                                                                  ++stamp, levelStructure, lastLevelBegin);
+            if (levels <= eccentricity) {
+                break;
+            }
+            eccentricity = levels;
+            // continue with the node of minimal degree in the last level
+            start = *std::min_element(levelStructure.begin() + lastLevelBegin, levelStructure.end(),
+                                      [&graph](const std::size_t a, const std::size_t b)
+                                      { return graph.degree(a) < graph.degree(b); });
+        }
+
+        // Cuthill-McKee numbering of the component
+        const std::size_t componentBegin = ordering.size();
+        std::size_t lastLevelBegin = 0;
+        detail::breadthFirstSearch(graph, start, numbered, true, visitedStamp, ++stamp, ordering, lastLevelBegin);
+        for (std::size_t k = componentBegin; k < ordering.size(); ++k) {
+            numbered[ordering[k]] = true;
+        }
+    }
+
+    assert(ordering.size() == n);
+    std::reverse(ordering.begin(), ordering.end());
+    return ordering;
+}
+
+/// \brief The inverse of an ordering, i.e. the new index of each row.
+inline std::vector<std::size_t> inverseOrdering(const std::vector<std::size_t>& ordering)
+{
+    std::vector<std::size_t> inverse(ordering.size());
+    for (std::size_t i = 0; i < ordering.size(); ++i) {
+        inverse[ordering[i]] = i;
+    }
+    return inverse;
+}
+
+/// \brief Copy the values of A to the reordered matrix B created by reorderMatrix().
+template <class Matrix>
+void copyReorderedValues(const Matrix& A, const std::vector<std::size_t>& ordering,
+                         const std::vector<std::size_t>& inverse, Matrix& B)
+{
+    const auto endi = B.end();
+    for (auto rowB = B.begin(); rowB != endi; ++rowB) {
+        const auto& rowA = A[ordering[rowB.index()]];
+        const auto endj = rowA.end();
+        for (auto col = rowA.begin(); col != endj; ++col) {
+            (*rowB)[inverse[col.index()]] = *col;
+        }
+    }
+}
+
+/// \brief Create the matrix B with B[i][j] = A[ordering[i]][ordering[j]].
+/// \param B A newly created matrix, e.g. a default constructed Dune::BCRSMatrix.
+template <class Matrix>
+void reorderMatrix(const Matrix& A, const std::vector<std::size_t>& ordering,
+                   const std::vector<std::size_t>& inverse, Matrix& B)
+{
+    B.setBuildMode(Matrix::row_wise);
+    B.setSize(A.N(), A.M(), A.nonzeroes());
+    for (auto rowB = B.createbegin(); rowB != B.createend(); ++rowB) {
+        const auto& rowA = A[ordering[rowB.index()]];
+        const auto endj = rowA.end();
+        for (auto col = rowA.begin(); col != endj; ++col) {
+            rowB.insert(inverse[col.index()]);
+        }
+    }
+    copyReorderedValues(A, ordering, inverse, B);
+}
+
+/// \brief y[i] = x[ordering[i]] for block vectors x and y.
+template <class X, class Y>
+void reorderVector(const X& x, const std::vector<std::size_t>& ordering, Y& y)
+{
+    for (std::size_t i = 0; i < ordering.size(); ++i) {
+        y[i] = x[ordering[i]];
+    }
+}
+
+/// \brief y[ordering[i]] = x[i] for block vectors x and y, the inverse of reorderVector().
+template <class X, class Y>
+void restoreVectorOrder(const X& x, const std::vector<std::size_t>& ordering, Y& y)
+{
+    for (std::size_t i = 0; i < ordering.size(); ++i) {
+        y[ordering[i]] = x[i];
+    }
+}
+
+} // namespace Opm
+
+#endif // OPM_MATRIXREORDERING_HEADER_INCLUDED
@@ -0,0 +1,93 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_MIXEDPRECISIONPRECONDITIONER_HEADER_INCLUDED
+#define OPM_MIXEDPRECISIONPRECONDITIONER_HEADER_INCLUDED
+
+#include <opm/autodiff/ForwardingPreconditioner.hpp>
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+
+#include <cassert>
+
+namespace Opm
+{
+    namespace detail
+    {
+        //! copy the sparsity pattern of A to the newly created matrix B
+        template <class FromMatrix, class ToMatrix>
+        void copySparsityPattern(const FromMatrix& A, ToMatrix& B)
+        {
+            B.setBuildMode( ToMatrix::row_wise );
+            B.setSize( A.N(), A.M(), A.nonzeroes() );
+            auto rowA = A.begin();
+            for( auto rowB = B.createbegin(); rowB != B.createend(); ++rowB, ++rowA )
+            {
+                const auto endj = (*rowA).end();
+                for( auto colA = (*rowA).begin(); colA != endj; ++colA )
+                {
+                    rowB.insert( colA.index() );
+                }
+            }
+        }
+
+        //! copy the values of A to B converting the field type, both
+        //! matrices need to have the same sparsity pattern
+        template <class FromMatrix, class ToMatrix>
+        void convertMatrixValues(const FromMatrix& A, ToMatrix& B)
+        {
+            auto rowB = B.begin();
+            const auto endi = A.end();
+            for( auto rowA = A.begin(); rowA != endi; ++rowA, ++rowB )
+            {
+                auto colB = (*rowB).begin();
+                const auto endj = (*rowA).end();
+                for( auto colA = (*rowA).begin(); colA != endj; ++colA, ++colB )
+                {
+                    assert( colA.index() == colB.index() );
+                    convertBlock( *colA, *colB );
+                }
+            }
+        }
+    } // end namespace detail
+
+    /// \brief Apply a preconditioner working on vectors of a lower precision,
+    ///        e.g. an AMG set up for a single precision copy of the matrix,
+    ///        within a Krylov solver working in double precision.
+    ///
+    /// The defect is rounded before and the correction is converted back after
+    /// each application. The Krylov solver is not affected as long as the
+    /// preconditioner stays a good approximation of the inverse of the matrix.
+    /// \tparam X The domain type of the solver.
+    /// \tparam Y The range type of the solver.
+    /// \tparam Precond The type of the wrapped preconditioner.
+    template <class X, class Y, class Precond>
+    class MixedPrecisionPreconditioner : public ForwardingPreconditioner<X, Y, Precond>
+    {
+    public:
+        /// \brief Constructor.
+        /// \param precond The preconditioner to wrap, it has to outlive this object.
+        explicit MixedPrecisionPreconditioner(Precond& precond)
+            : ForwardingPreconditioner<X, Y, Precond>( precond )
+        {
+        }
+    };
+
+} // end namespace Opm
+
+#endif // OPM_MIXEDPRECISIONPRECONDITIONER_HEADER_INCLUDED
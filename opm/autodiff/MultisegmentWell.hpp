@@ -24,6 +24,7 @@
 
 
 #include <opm/autodiff/WellInterface.hpp>
+#include <opm/autodiff/MSWellHelpers.hpp>
 
 namespace Opm
 {
@@ -154,6 +155,10 @@ namespace Opm
 
         int numberOfPerforations() const;
 
+        /// the coupled segment equations make the well more expensive than
+        /// a standard well with the same number of perforations
+        virtual double computationalCost() const;
+
     protected:
         int number_segments_;
 
@@ -219,6 +224,8 @@ namespace Opm
         mutable OffDiagMatWell duneC_;
         // diagonal matrix for the well
         mutable DiagMatWell duneD_;
+        // the factorization of duneD_, computed once after each assembly
+        mutable mswellhelpers::CachedUMFPack<DiagMatWell> duneD_solver_;
 
         // residuals of the well equations
         mutable BVectorWell resWell_;
@@ -266,6 +273,9 @@ namespace Opm
         // xw = inv(D)*(rw - C*x)
         void recoverSolutionWell(const BVector& x, BVectorWell& xw) const;
 
+        // obtain duneD_^-1 * x, factorizing duneD_ if it has been assembled since the last solve
+        BVectorWell invDX(const BVectorWell& x) const;
+
         // updating the well_state based on well solution dwells
         void updateWellState(const BVectorWell& dwells,
                              const bool inner_iteration,
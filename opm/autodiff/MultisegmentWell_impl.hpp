@@ -497,7 +497,7 @@ namespace Opm
         duneB_.mv(x, Bx);
 
         // invDBx = duneD^-1 * Bx_
-        const BVectorWell invDBx = mswellhelpers::invDXDirect(duneD_, Bx);
+        const BVectorWell invDBx = invDX(Bx);
 
         // Ax = Ax - duneC_^T * invDBx
         duneC_.mmtv(invDBx,Ax);
@@ -513,7 +513,7 @@ namespace Opm
     apply(BVector& r) const
     {
         // invDrw_ = duneD^-1 * resWell_
-        const BVectorWell invDrw = mswellhelpers::invDXDirect(duneD_, resWell_);
+        const BVectorWell invDrw = invDX(resWell_);
         // r = r - duneC_^T * invDrw
         duneC_.mmtv(invDrw, r);
     }
@@ -631,7 +631,22 @@ namespace Opm
         // resWell = resWell - B * x
         duneB_.mmv(x, resWell);
         // xw = D^-1 * resWell
-        xw = mswellhelpers::invDXDirect(duneD_, resWell);
+        xw = invDX(resWell);
+    }
+
+
+
+
+
+    template <typename TypeTag>
+    typename MultisegmentWell<TypeTag>::BVectorWell
+    MultisegmentWell<TypeTag>::
+    invDX(const BVectorWell& x) const
+    {
+        if (!duneD_solver_.factorized()) {
+            duneD_solver_.factorize(duneD_);
+        }
+        return duneD_solver_.solve(x);
     }
 
 
@@ -645,7 +660,7 @@ namespace Opm
     {
         // We assemble the well equations, then we check the convergence,
         // which is why we do not put the assembleWellEq here.
-        const BVectorWell dx_well = mswellhelpers::invDXDirect(duneD_, resWell_);
+        const BVectorWell dx_well = invDX(resWell_);
 
         updateWellState(dx_well, false, well_state);
     }
@@ -829,6 +844,18 @@ namespace Opm
 
 
 
+    template <typename TypeTag>
+    double
+    MultisegmentWell<TypeTag>::
+    computationalCost() const
+    {
+        return double(numWellEq) * (numberOfSegments() + number_of_perforations_);
+    }
+
+
+
+
+
     template <typename TypeTag>
     WellSegment::CompPressureDropEnum
     MultisegmentWell<TypeTag>::
@@ -1709,7 +1736,7 @@ namespace Opm
 
             assembleWellEqWithoutIteration(ebosSimulator, dt, well_state, true);
 
-            const BVectorWell dx_well = mswellhelpers::invDXDirect(duneD_, resWell_);
+            const BVectorWell dx_well = invDX(resWell_);
 
             // TODO: use these small values for now, not intend to reach the convergence
             // in this stage, but, should we?
@@ -1753,6 +1780,7 @@ namespace Opm
         }
 
         duneD_ = 0.0;
+        duneD_solver_.reset();
         resWell_ = 0.0;
 
         // for the black oil cases, there will be four equations,
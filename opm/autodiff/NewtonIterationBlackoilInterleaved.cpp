@@ -29,6 +29,7 @@
 #include <opm/autodiff/DuneMatrix.hpp>
 #include <opm/autodiff/AdditionalObjectDeleter.hpp>
 #include <opm/autodiff/CPRPreconditioner.hpp>
+#include <opm/autodiff/InterleavedMatrixBuilder.hpp>
 #include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
 #include <opm/autodiff/NewtonIterationUtilities.hpp>
 #include <opm/autodiff/ParallelRestrictedAdditiveSchwarz.hpp>
@@ -48,23 +49,11 @@
 #endif
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <vector>
+
 namespace Opm
 {
 
-    namespace detail {
-        /**
-         * Simple binary operator that always returns 0.1
-         * It is used to get the sparsity pattern for our
-         * interleaved system, and is marginally faster than using
-         * operator+=.
-         */
-        template<typename Scalar> struct PointOneOp {
-            EIGEN_EMPTY_STRUCT_CTOR(PointOneOp)
-            Scalar operator()(const Scalar&, const Scalar&) const { return 0.1; }
-        };
-    }
-
-
     /// This class solves the fully implicit black-oil system by
     /// solving the reduced system (after eliminating well variables)
     /// as a block-structured matrix (one block for all cell variables) for a fixed
@@ -108,93 +97,23 @@ namespace Opm
         const boost::any& parallelInformation() const { return istlSolver_.parallelInformation(); }
 
     public:
-        void formInterleavedSystem(const std::vector<LinearisedBlackoilResidual::ADB>& eqs,
-                                   Mat& istlA) const
+        /// Form the interleaved (block structured) system from the jacobians
+        /// of the equations, see InterleavedMatrixBuilder.
+        Mat& formInterleavedSystem(const std::vector<LinearisedBlackoilResidual::ADB>& eqs) const
         {
             assert( np == int(eqs.size()) );
-            // Find sparsity structure as union of basic block sparsity structures,
-            // corresponding to the jacobians with respect to pressure.
-            // Use our custom PointOneOp to get to the union structure.
-            // As default we only iterate over the pressure derivatives.
-            Eigen::SparseMatrix<double, Eigen::ColMajor> col_major = eqs[0].derivative()[0].getSparse();
-            detail::PointOneOp<double> point_one;
-            for (int phase = 1; phase < np; ++phase) {
-                const AutoDiffMatrix::SparseRep& mat = eqs[phase].derivative()[0].getSparse();
-                col_major = col_major.binaryExpr(mat, point_one);
-            }
-            // For some cases (for instance involving Solvent flow) the reasoning for only adding
-            // the pressure derivatives fails. As getting the sparsity pattern is non-trivial, in terms
-            // of work, the full sparsity pattern is only added when required.
-            if (parameters_.require_full_sparsity_pattern_) {
-                for (int p1 = 0; p1 < np; ++p1) {
-                    for (int p2 = 1; p2 < np; ++p2) { // pressure is already added
-                        const AutoDiffMatrix::SparseRep& mat = eqs[p1].derivative()[p2].getSparse();
-                        col_major = col_major.binaryExpr(mat, point_one);
-                    }
-                }
-            }
-
-            // Automatically convert the column major structure to a row-major structure
-            Eigen::SparseMatrix<double, Eigen::RowMajor> row_major = col_major;
-
-            const int size = row_major.rows();
-            assert(size == row_major.cols());
-
-            {
-                // Create ISTL matrix with interleaved rows and columns (block structured).
-                istlA.setSize(row_major.rows(), row_major.cols(), row_major.nonZeros());
-                istlA.setBuildMode(Mat::row_wise);
-                const int* ia = row_major.outerIndexPtr();
-                const int* ja = row_major.innerIndexPtr();
-                const typename Mat::CreateIterator endrow = istlA.createend();
-                for (typename Mat::CreateIterator row = istlA.createbegin(); row != endrow; ++row) {
-                    const int ri = row.index();
-                    for (int i = ia[ri]; i < ia[ri + 1]; ++i) {
-                        row.insert(ja[i]);
-                    }
-                }
-            }
-
-            /*
-            // not neeeded since MatrixBlock initially zeros all elements during construction
-            // Set all blocks to zero.
-            for (auto row = istlA.begin(), rowend = istlA.end(); row != rowend; ++row ) {
-                for (auto col = row->begin(), colend = row->end(); col != colend; ++col ) {
-                    *col = 0.0;
-                }
-            }
-            */
-
-            /**
-             * Go through all jacobians, and insert in correct spot
-             *
-             * The straight forward way to do this would be to run through each
-             * element in the output matrix, and set all block entries by gathering
-             * from all "input matrices" (derivatives).
-             *
-             * A faster alternative is to instead run through each "input matrix" and
-             * insert its elements in the correct spot in the output matrix.
-             *
-             */
+            // Convert every jacobian to its sparse representation only once,
+            // getSparse() converts the jacobians which are not stored as sparse
+            // matrices on every call.
+            std::vector<const AutoDiffMatrix::SparseRep*> jacs(np*np);
             for (int p1 = 0; p1 < np; ++p1) {
                 for (int p2 = 0; p2 < np; ++p2) {
-                    // Note that that since these are CSC and not CSR matrices,
-                    // ja contains row numbers instead of column numbers.
-                    const AutoDiffMatrix::SparseRep& s = eqs[p1].derivative()[p2].getSparse();
-                    const int* ia = s.outerIndexPtr();
-                    const int* ja = s.innerIndexPtr();
-                    const double* sa = s.valuePtr();
-                    for (int col = 0; col < size; ++col) {
-                        for (int elem_ix = ia[col]; elem_ix < ia[col + 1]; ++elem_ix) {
-                            const int row = ja[elem_ix];
-                            istlA[row][col][p1][p2] = sa[elem_ix];
-                        }
-                    }
+                    jacs[p1*np + p2] = &eqs[p1].derivative()[p2].getSparse();
                 }
             }
+            return interleaved_.build(jacs);
         }
 
-
         /// Solve the linear system Ax = b, with A being the
         /// combined derivative matrix of the residual and b
         /// being the residual itself.
@@ -254,8 +173,7 @@ namespace Opm
             assert(pos == size_b);
 
             // Create ISTL matrix with interleaved rows and columns (block structured).
-            Mat istlA;
-            formInterleavedSystem(eqs, istlA);
+            Mat& istlA = formInterleavedSystem(eqs);
 
             // Solve reduced system.
             SolutionVector dx(SolutionVector::Zero(b.size()));
@@ -295,6 +213,9 @@ namespace Opm
     protected:
         ISTLSolverType istlSolver_;
         NewtonIterationBlackoilInterleavedParameters parameters_;
+
+        // The interleaved matrix and its structure, kept between the Newton iterations.
+        mutable InterleavedMatrixBuilder<Mat> interleaved_;
     }; // end NewtonIterationBlackoilInterleavedImpl
 
 
@@ -27,25 +27,47 @@
 
 #include <opm/autodiff/NewtonIterationBlackoilInterface.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
 
 #include <array>
 #include <memory>
+#include <string>
 
 namespace Opm
 {
     /// This class carries all parameters for the NewtonIterationBlackoilInterleaved class
     struct NewtonIterationBlackoilInterleavedParameters
     {
+        // Available policies for rebuilding the preconditioner.
+        enum PreconditionerReuse { REBUILD_ALWAYS, REBUILD_TIMESTEP, REBUILD_ON_GROWTH };
+        // Available orderings of the rows for the ILU factorization.
+        enum IluReordering { REORDER_NONE, REORDER_RCM };
+
         double linear_solver_reduction_;
         double ilu_relaxation_;
         int    linear_solver_maxiter_;
         int    linear_solver_restart_;
         int    linear_solver_verbosity_;
         int    ilu_fillin_level_;
+        int    cpr_pressure_vcycles_;
         bool   newton_use_gmres_;
-        bool   require_full_sparsity_pattern_;
         bool   ignoreConvergenceFailure_;
         bool   linear_solver_use_amg_;
+        bool   linear_solver_use_cpr_;
+        bool   cpr_use_quasiimpes_;
+        // when to set up the preconditioner from scratch instead of only
+        // refreshing the values of the previous one
+        PreconditionerReuse preconditioner_reuse_;
+        // relative growth of the linear iterations triggering a rebuild (REBUILD_ON_GROWTH)
+        double preconditioner_rebuild_growth_;
+        // store the ILU factors and the AMG hierarchy in single precision,
+        // the Krylov solver still works in double precision
+        bool   preconditioner_single_precision_;
+        // order of the rows in which the ILU factors are computed
+        IluReordering ilu_reordering_;
+        // use the Krylov solvers with fewer global reductions per iteration,
+        // pipelined BiCGStab or GMRes with a single reduction
+        bool   linear_solver_reduce_communication_;
 
         NewtonIterationBlackoilInterleavedParameters() { reset(); }
         // read values from parameter class
@@ -60,11 +82,36 @@ namespace Opm
             linear_solver_maxiter_   = param.getDefault("linear_solver_maxiter", linear_solver_maxiter_);
             linear_solver_restart_   = param.getDefault("linear_solver_restart", linear_solver_restart_);
             linear_solver_verbosity_ = param.getDefault("linear_solver_verbosity", linear_solver_verbosity_);
-            require_full_sparsity_pattern_ = param.getDefault("require_full_sparsity_pattern", require_full_sparsity_pattern_);
             ignoreConvergenceFailure_ = param.getDefault("linear_solver_ignoreconvergencefailure", ignoreConvergenceFailure_);
             linear_solver_use_amg_    = param.getDefault("linear_solver_use_amg", linear_solver_use_amg_ );
             ilu_relaxation_           = param.getDefault("ilu_relaxation", ilu_relaxation_ );
             ilu_fillin_level_         = param.getDefault("ilu_fillin_level",  ilu_fillin_level_ );
+            linear_solver_use_cpr_    = param.getDefault("linear_solver_use_cpr", linear_solver_use_cpr_ );
+            cpr_use_quasiimpes_       = param.getDefault("cpr_use_quasiimpes", cpr_use_quasiimpes_ );
+            cpr_pressure_vcycles_     = param.getDefault("cpr_pressure_vcycles", cpr_pressure_vcycles_ );
+            preconditioner_rebuild_growth_ = param.getDefault("preconditioner_rebuild_growth", preconditioner_rebuild_growth_ );
+            preconditioner_single_precision_ = param.getDefault("preconditioner_single_precision", preconditioner_single_precision_ );
+            linear_solver_reduce_communication_ = param.getDefault("linear_solver_reduce_communication", linear_solver_reduce_communication_ );
+
+            const std::string reuse = param.getDefault("preconditioner_reuse", std::string("never"));
+            if (reuse == "never") {
+                preconditioner_reuse_ = REBUILD_ALWAYS;
+            } else if (reuse == "timestep") {
+                preconditioner_reuse_ = REBUILD_TIMESTEP;
+            } else if (reuse == "iterations") {
+                preconditioner_reuse_ = REBUILD_ON_GROWTH;
+            } else {
+                OPM_THROW(std::runtime_error, "Unknown preconditioner reuse policy " << reuse);
+            }
+
+            const std::string reordering = param.getDefault("ilu_reordering", std::string("none"));
+            if (reordering == "none") {
+                ilu_reordering_ = REORDER_NONE;
+            } else if (reordering == "rcm") {
+                ilu_reordering_ = REORDER_RCM;
+            } else {
+                OPM_THROW(std::runtime_error, "Unknown ILU reordering " << reordering);
+            }
         }
 
         // set default values
@@ -75,11 +122,18 @@ namespace Opm
             linear_solver_maxiter_   = 150;
             linear_solver_restart_   = 40;
             linear_solver_verbosity_ = 0;
-            require_full_sparsity_pattern_ = false;
             ignoreConvergenceFailure_ = false;
             linear_solver_use_amg_    = false;
             ilu_fillin_level_         = 0;
             ilu_relaxation_           = 0.9;
+            linear_solver_use_cpr_    = false;
+            cpr_use_quasiimpes_       = true;
+            cpr_pressure_vcycles_     = 1;
+            preconditioner_reuse_     = REBUILD_ALWAYS;
+            preconditioner_rebuild_growth_ = 0.5;
+            preconditioner_single_precision_ = false;
+            ilu_reordering_           = REORDER_NONE;
+            linear_solver_reduce_communication_ = false;
         }
     };
 
@@ -27,6 +27,7 @@
 #include <dune/common/fmatrix.hh>
 #include <dune/istl/bcrsmatrix.hh>
 #include <memory>
+#include <vector>
 
 namespace Opm {
 
@@ -49,6 +50,8 @@ namespace Opm {
             double         relax_rel_tol_;
             int            max_iter_; // max nonlinear iterations
             int            min_iter_; // min nonlinear iterations
+            int            anderson_depth_; // number of previous updates for Anderson acceleration, 0 to disable
+            bool           use_line_search_; // cut updates which do not reduce the residual
 
             explicit SolverParameters( const ParameterGroup& param );
             SolverParameters();
@@ -151,6 +154,12 @@ namespace Opm {
         void detectOscillations(const std::vector<std::vector<double>>& residual_history,
                                 const int it, bool& oscillate, bool& stagnate) const;
 
+        /// Whether a (partial) update has to be cut since the residual after it did not
+        /// decrease sufficiently compared to the residual before the update.
+        bool rejectLineSearchStep(const std::vector<double>& residual_before,
+                                  const std::vector<double>& residual_after,
+                                  const double step) const;
+
         /// Apply a stabilization to dx, depending on dxOld and relaxation parameters.
         /// Implemention for Dune block vectors.
         template <class BVector>
@@ -174,6 +183,15 @@ namespace Opm {
         /// The minimum number of nonlinear iterations allowed.
         int minIter() const              { return param_.min_iter_; }
 
+        /// The number of previous updates used by the Anderson acceleration, 0 if disabled.
+        int andersonDepth() const        { return param_.anderson_depth_; }
+
+        /// Whether updates are cut if they do not reduce the residual.
+        bool useLineSearch() const       { return param_.use_line_search_; }
+
+        /// The smallest fraction of an update the line search cuts it to.
+        double lineSearchMinStep() const { return 0.125; }
+
         /// Set parameters to override those given at construction time.
         void setParameters(const SolverParameters& param) { param_ = param; }
 
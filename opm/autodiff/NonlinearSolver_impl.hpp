@@ -27,6 +27,8 @@
 #include <opm/common/Exceptions.hpp>
 #include <opm/common/ErrorMacros.hpp>
 
+#include <cmath>
+
 namespace Opm
 {
     template <class PhysicalModel>
@@ -186,6 +188,8 @@ namespace Opm
         relax_rel_tol_   = 0.2;
         max_iter_        = 10;
         min_iter_        = 1;
+        anderson_depth_  = 0;
+        use_line_search_ = false;
     }
 
     template <class PhysicalModel>
@@ -207,6 +211,8 @@ namespace Opm
         relax_max_   = param.getDefault("relax_max", relax_max_);
         max_iter_    = param.getDefault("max_iter", max_iter_);
         min_iter_    = param.getDefault("min_iter", min_iter_);
+        anderson_depth_  = param.getDefault("anderson_depth", anderson_depth_);
+        use_line_search_ = param.getDefault("use_line_search", use_line_search_);
 
         std::string relaxation_type = param.getDefault("relax_type", std::string("dampen"));
         if (relaxation_type == "dampen") {
@@ -255,6 +261,28 @@ namespace Opm
     }
 
 
+    template <class PhysicalModel>
+    bool
+    NonlinearSolver<PhysicalModel>::rejectLineSearchStep(const std::vector<double>& residual_before,
+                                                         const std::vector<double>& residual_after,
+                                                         const double step) const
+    {
+        // Armijo condition for the norm of the residuals of all phases, a full
+        // Newton update would reduce the residual to zero for a linear problem.
+        const double c = 1.0e-4;
+        double norm_before = 0.0;
+        double norm_after = 0.0;
+        for (std::size_t p = 0; p < residual_before.size(); ++p) {
+            norm_before += residual_before[p] * residual_before[p];
+            norm_after += residual_after[p] * residual_after[p];
+        }
+        norm_before = std::sqrt(norm_before);
+        norm_after = std::sqrt(norm_after);
+
+        return !(norm_after <= (1.0 - c * step) * norm_before);
+    }
+
+
     template <class PhysicalModel>
     template <class BVector>
     void
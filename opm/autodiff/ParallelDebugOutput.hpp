@@ -19,7 +19,10 @@
 #ifndef OPM_PARALLELDEBUGOUTPUT_HEADER_INCLUDED
 #define OPM_PARALLELDEBUGOUTPUT_HEADER_INCLUDED
 
+#include <memory>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include <opm/common/data/SimulationDataContainer.hpp>
 
@@ -256,6 +259,7 @@ namespace Opm
               eclipseState_( eclipseState ),
               schedule_(schedule),
               globalCellData_(new data::Solution),
+              globalWellsStepNumber_(-1),
               isIORank_(true),
               phaseUsage_(phaseUsage)
 
@@ -333,6 +337,7 @@ namespace Opm
                     // need an index map for each rank
                     indexMaps_.clear();
                     indexMaps_.resize( comm.size() );
+                    receivedLayouts_.resize( comm.size() );
                 }
 
                 // distribute global id's to io rank for later association of dof's
@@ -346,6 +351,36 @@ namespace Opm
             }
         }
 
+        //! \brief The order of the cell data and wells in the messages sent to the I/O rank.
+        //!
+        //! The layout is only sent along with the data when it changed since
+        //! the previous gather, otherwise the I/O rank uses the one it received
+        //! last from the same rank. Well names and data keys are thus only
+        //! serialized when the output quantities or the wells change.
+        struct MessageLayout
+        {
+            std::vector< std::string > keys;
+            std::vector< std::string > wells;
+            std::vector< int > numPerfs;
+            // false until a layout was sent or received
+            bool valid = false;
+
+            bool operator==( const MessageLayout& other ) const
+            {
+                return keys == other.keys && wells == other.wells && numPerfs == other.numPerfs;
+            }
+        };
+
+        //! \brief The layout received from a rank with the wells resolved in the global well state.
+        struct ReceivedLayout
+        {
+            MessageLayout layout;
+            // the entries of the wells in the global well map
+            std::vector< const std::vector<int>* > wellEntries;
+            // global well step the entries were resolved for
+            int wellStepNumber = -1;
+        };
+
         class PackUnPackSimulationDataContainer : public P2PCommunicatorType::DataHandleInterface
         {
             const data::Solution& localCellData_;
@@ -354,6 +389,9 @@ namespace Opm
             WellStateFullyImplicitBlackoil& globalWellState_;
             const IndexMapType& localIndexMap_;
             const IndexMapStorageType& indexMaps_;
+            MessageLayout& sentLayout_;
+            std::vector< ReceivedLayout >& receivedLayouts_;
+            const int wellStepNumber_;
 
         public:
             PackUnPackSimulationDataContainer( std::size_t numGlobalCells,
@@ -363,13 +401,19 @@ namespace Opm
                                                WellStateFullyImplicitBlackoil& globalWellState,
                                                const IndexMapType& localIndexMap,
                                                const IndexMapStorageType& indexMaps,
+                                               MessageLayout& sentLayout,
+                                               std::vector< ReceivedLayout >& receivedLayouts,
+                                               const int wellStepNumber,
                                                const bool isIORank )
             : localCellData_( localCellData ),
               globalCellData_( globalCellData ),
               localWellState_( localWellState ),
               globalWellState_( globalWellState ),
               localIndexMap_( localIndexMap ),
-              indexMaps_( indexMaps )
+              indexMaps_( indexMaps ),
+              sentLayout_( sentLayout ),
+              receivedLayouts_( receivedLayouts ),
+              wellStepNumber_( wellStepNumber )
             {
 
                 if( isIORank )
@@ -377,6 +421,15 @@ namespace Opm
                     // add missing data to global cell data
                     for (const auto& pair : localCellData_) {
                         const std::string& key = pair.first;
+                        auto it = globalCellData_.find(key);
+                        if (it != globalCellData_.end() && it->second.dim == pair.second.dim
+                            && it->second.target == pair.second.target) {
+                            assert(it->second.data.size() == numGlobalCells);
+                            continue;
+                        }
+                        if (it != globalCellData_.end()) {
+                            globalCellData_.erase(it);
+                        }
                         std::size_t container_size = numGlobalCells;
                         auto ret = globalCellData_.insert(key, pair.second.dim,
                                                 std::vector<double>(container_size),
@@ -385,10 +438,9 @@ namespace Opm
                         DUNE_UNUSED_PARAMETER(ret.second); //dummy op to prevent warning with -DNDEBUG
                     }
 
-                    MessageBufferType buffer;
-                    pack( 0, buffer );
-                    // the last index map is the local one
-                    doUnpack( indexMaps.back(), buffer );
+                    // the last index map is the local one, the data of
+                    // the I/O rank itself is copied without a buffer
+                    copyLocal( indexMaps.back() );
                 }
             }
 
@@ -400,6 +452,17 @@ namespace Opm
                     OPM_THROW(std::logic_error,"link in method pack is not 0 as execpted");
                 }
 
+                // send the layout only if it differs from the previous one
+                MessageLayout layout = currentLayout();
+                const int layoutChanged = ! sentLayout_.valid || ! ( layout == sentLayout_ );
+                buffer.write( layoutChanged );
+                if( layoutChanged )
+                {
+                    writeLayout( buffer, layout );
+                    layout.valid = true;
+                    sentLayout_ = std::move( layout );
+                }
+
                 // write all cell data registered in local state
                 for (const auto& pair : localCellData_) {
                     const auto& data = pair.second.data;
@@ -412,40 +475,183 @@ namespace Opm
                 writeWells( buffer );
             }
 
-            void doUnpack( const IndexMapType& indexMap, MessageBufferType& buffer )
+            // unpack all data associated with link
+            void unpack( const int link, MessageBufferType& buffer )
             {
-                // we loop over the data  as
-                // its order governs the order the data got received.
-                for (auto& pair : localCellData_) {
-                    const std::string& key = pair.first;
-                    auto& data = globalCellData_.data(key);
+                assert( link < int(receivedLayouts_.size()) );
+                ReceivedLayout& received = receivedLayouts_[ link ];
 
-                    //write all data from local cell data to buffer
-                    read( buffer, indexMap, data);
+                int layoutChanged = 0;
+                buffer.read( layoutChanged );
+                if( layoutChanged )
+                {
+                    readLayout( buffer, received.layout );
+                    received.layout.valid = true;
+                    received.wellStepNumber = -1;
+                }
+                else if( ! received.layout.valid )
+                {
+                    OPM_THROW(std::logic_error,"no message layout received for link " << link );
+                }
+
+                // resolve the wells of the sending rank in the global well state
+                if( received.wellStepNumber != wellStepNumber_ )
+                {
+                    resolveWells( received );
+                }
+
+                // the data is in the order of the keys of the layout
+                const IndexMapType& indexMap = indexMaps_[ link ];
+                for (const std::string& key : received.layout.keys) {
+                    read( buffer, indexMap, globalCellData_.data(key) );
                 }
 
                 // read well data from buffer
-                readWells( buffer );
+                readWells( buffer, received );
             }
 
-            // unpack all data associated with link
-            void unpack( const int link, MessageBufferType& buffer )
+        protected:
+            MessageLayout currentLayout() const
             {
-                doUnpack( indexMaps_[ link ], buffer );
+                MessageLayout layout;
+                layout.keys.reserve( localCellData_.size() );
+                for (const auto& pair : localCellData_) {
+                    layout.keys.push_back( pair.first );
+                }
+                const auto& wellMap = localWellState_.wellMap();
+                layout.wells.reserve( wellMap.size() );
+                layout.numPerfs.reserve( wellMap.size() );
+                for( const auto& well : wellMap )
+                {
+                    layout.wells.push_back( well.first );
+                    layout.numPerfs.push_back( well.second[ 2 ] );
+                }
+                return layout;
+            }
+
+            void writeLayout( MessageBufferType& buffer, const MessageLayout& layout ) const
+            {
+                const int nKeys = layout.keys.size();
+                buffer.write( nKeys );
+                for( const std::string& key : layout.keys ) {
+                    writeString( buffer, key );
+                }
+                const int nWells = layout.wells.size();
+                buffer.write( nWells );
+                for( int well = 0; well < nWells; ++well )
+                {
+                    writeString( buffer, layout.wells[ well ] );
+                    buffer.write( layout.numPerfs[ well ] );
+                }
+            }
+
+            void readLayout( MessageBufferType& buffer, MessageLayout& layout ) const
+            {
+                int nKeys = -1;
+                buffer.read( nKeys );
+                layout.keys.resize( nKeys );
+                for( std::string& key : layout.keys ) {
+                    readString( buffer, key );
+                }
+                int nWells = -1;
+                buffer.read( nWells );
+                layout.wells.resize( nWells );
+                layout.numPerfs.resize( nWells );
+                for( int well = 0; well < nWells; ++well )
+                {
+                    readString( buffer, layout.wells[ well ] );
+                    buffer.read( layout.numPerfs[ well ] );
+                }
+            }
+
+            void resolveWells( ReceivedLayout& received ) const
+            {
+                const auto& wellMap = globalWellState_.wellMap();
+                const int nWells = received.layout.wells.size();
+                received.wellEntries.resize( nWells );
+                for( int well = 0; well < nWells; ++well )
+                {
+                    const std::string& name = received.layout.wells[ well ];
+                    auto it = wellMap.find( name );
+                    if( it == wellMap.end() )
+                    {
+                        OPM_THROW(std::logic_error,"global state does not contain well " <<  name );
+                    }
+                    if( it->second[ 2 ] != received.layout.numPerfs[ well ] )
+                    {
+                        OPM_THROW(std::logic_error,"well " << name << " has a different number of perforations in the global state");
+                    }
+                    received.wellEntries[ well ] = &it->second;
+                }
+                received.wellStepNumber = wellStepNumber_;
+            }
+
+            void copyLocal( const IndexMapType& indexMap )
+            {
+                // copy cell data
+                const unsigned int size = localIndexMap_.size();
+                assert( size == indexMap.size() );
+                for (const auto& pair : localCellData_) {
+                    const auto& localData = pair.second.data;
+                    auto& globalData = globalCellData_.data( pair.first );
+                    for( unsigned int i=0; i<size; ++i )
+                    {
+                        assert( indexMap[ i ] < int(globalData.size()) );
+                        globalData[ indexMap[ i ] ] = localData[ localIndexMap_[ i ] ];
+                    }
+                }
+
+                // copy well data
+                const auto& globalWellMap = globalWellState_.wellMap();
+                for( const auto& well : localWellState_.wellMap() )
+                {
+                    auto it = globalWellMap.find( well.first );
+                    if( it == globalWellMap.end() )
+                    {
+                        OPM_THROW(std::logic_error,"global state does not contain well " <<  well.first );
+                    }
+                    copyWell( well.second, it->second );
+                }
+            }
+
+            void copyWell( const std::vector<int>& localEntry, const std::vector<int>& globalEntry )
+            {
+                const int localIdx = localEntry[ 0 ];
+                const int globalIdx = globalEntry[ 0 ];
+                globalWellState_.bhp()[ globalIdx ] = localWellState_.bhp()[ localIdx ];
+                globalWellState_.thp()[ globalIdx ] = localWellState_.thp()[ localIdx ];
+                const int numPhases = localWellState_.numPhases();
+                for( int p=0; p<numPhases; ++p ) {
+                    globalWellState_.wellRates()[ globalIdx * numPhases + p ] = localWellState_.wellRates()[ localIdx * numPhases + p ];
+                }
+                globalWellState_.currentControls()[ globalIdx ] = localWellState_.currentControls()[ localIdx ];
+
+                // The ordering of the perforations is the same for global and local state.
+                const int numPerfs = localEntry[ 2 ];
+                assert( numPerfs == globalEntry[ 2 ] );
+                const int np = localWellState_.perfPhaseRates().size() /
+                    localWellState_.perfRates().size();
+                for( int perf = 0; perf < numPerfs; ++perf )
+                {
+                    const int localCon = localEntry[ 1 ] + perf;
+                    const int globalCon = globalEntry[ 1 ] + perf;
+                    globalWellState_.perfRates()[ globalCon ] = localWellState_.perfRates()[ localCon ];
+                    globalWellState_.perfPress()[ globalCon ] = localWellState_.perfPress()[ localCon ];
+                    for( int p = 0; p < np; ++p ) {
+                        globalWellState_.perfPhaseRates()[ globalCon * np + p ] = localWellState_.perfPhaseRates()[ localCon * np + p ];
+                    }
+                }
             }
 
-        protected:
             template <class Vector>
             void write( MessageBufferType& buffer, const IndexMapType& localIndexMap,
-                        const Vector& vector,
-                        const unsigned int offset = 0, const unsigned int stride = 1 ) const
+                        const Vector& vector ) const
             {
-                unsigned int size = localIndexMap.size();
-                buffer.write( size );
-                assert( vector.size() >= stride * size );
+                // the number of entries is known to the receiver from the index map
+                const unsigned int size = localIndexMap.size();
                 for( unsigned int i=0; i<size; ++i )
                 {
-                    const unsigned int index = localIndexMap[ i ] * stride + offset;
+                    const unsigned int index = localIndexMap[ i ];
                     assert( index < vector.size() );
                     buffer.write( vector[ index ] );
                 }
@@ -454,15 +660,12 @@ namespace Opm
             template <class Vector>
             void read( MessageBufferType& buffer,
                        const IndexMapType& indexMap,
-                       Vector& vector,
-                       const unsigned int offset = 0, const unsigned int stride = 1 ) const
+                       Vector& vector ) const
             {
-                unsigned int size = 0;
-                buffer.read( size );
-                assert( size == indexMap.size() );
+                const unsigned int size = indexMap.size();
                 for( unsigned int i=0; i<size; ++i )
                 {
-                    const unsigned int index = indexMap[ i ] * stride + offset;
+                    const unsigned int index = indexMap[ i ];
                     assert( index < vector.size() );
                     buffer.read( vector[ index ] );
                 }
@@ -491,17 +694,12 @@ namespace Opm
 
             void writeWells( MessageBufferType& buffer ) const
             {
-                int nWells = localWellState_.wellMap().size();
-                buffer.write( nWells );
+                // the wells are written in the order of the layout, i.e. of the well map
                 auto end = localWellState_.wellMap().end();
                 for( auto it = localWellState_.wellMap().begin(); it != end; ++it )
                 {
-                    const std::string& name = it->first;
                     const int wellIdx = it->second[ 0 ];
 
-                    // write well name
-                    writeString( buffer, name );
-
                     // write well data
                     buffer.write( localWellState_.bhp()[ wellIdx ] );
                     buffer.write( localWellState_.thp()[ wellIdx ] );
@@ -538,24 +736,14 @@ namespace Opm
                 }
             }
 
-            void readWells( MessageBufferType& buffer )
+            void readWells( MessageBufferType& buffer, const ReceivedLayout& received )
             {
-                int nWells = -1;
-                buffer.read( nWells );
                 // unpack all wells that have been sent
-                std::string name ;
+                const int nWells = received.wellEntries.size();
                 for( int well = 0; well < nWells ; ++well )
                 {
-                    // read well name for local identification
-                    readString( buffer, name );
-
-                    // unpack values
-                    auto it = globalWellState_.wellMap().find( name );
-                    if( it == globalWellState_.wellMap().end() )
-                    {
-                        OPM_THROW(std::logic_error,"global state does not contain well " <<  name );
-                    }
-                    const int wellIdx = it->second[ 0 ];
+                    const std::vector<int>& entry = *received.wellEntries[ well ];
+                    const int wellIdx = entry[ 0 ];
 
                     buffer.read( globalWellState_.bhp()[ wellIdx ] );
                     buffer.read( globalWellState_.thp()[ wellIdx ] );
@@ -569,14 +757,14 @@ namespace Opm
                     // Read perfRates and perfPress. No need to figure out the index
                     // mapping there as the ordering of the perforations should
                     // be the same for global and local state.
-                    const int end_con = it->second[1] + it->second[2];
+                    const int end_con = entry[1] + entry[2];
 
-                    for( int con = it->second[1]; con < end_con; ++con )
+                    for( int con = entry[1]; con < end_con; ++con )
                     {
                         buffer.read( globalWellState_.perfRates()[ con ] );
                     }
 
-                    for( int con = it->second[1]; con < end_con; ++con )
+                    for( int con = entry[1]; con < end_con; ++con )
                     {
                         buffer.read( globalWellState_.perfPress()[ con ] );
                     }
@@ -585,7 +773,7 @@ namespace Opm
                     const int np = globalWellState_.perfPhaseRates().size() /
                         globalWellState_.perfRates().size();
 
-                    for( int con = it->second[1]*np; con < end_con*np; ++con )
+                    for( int con = entry[1]*np; con < end_con*np; ++con )
                     {
                         buffer.read( globalWellState_.perfPhaseRates()[ con ] );
                     }
@@ -601,41 +789,60 @@ namespace Opm
         {
             if( isIORank() )
             {
-                Dune::CpGrid& globalGrid = *grid_;
-                // TODO: make a dummy DynamicListEconLimited here for NOW for compilation and development
-                // TODO: NOT SURE whether it will cause problem for parallel running
-                // TODO: TO BE TESTED AND IMPROVED
-                const DynamicListEconLimited dynamic_list_econ_limited;
-                // Create wells and well state.
-                WellsManager wells_manager(eclipseState_,
-                                           schedule_,
-                                           wellStateStepNumber,
-                                           Opm::UgGridHelpers::numCells( globalGrid ),
-                                           Opm::UgGridHelpers::globalCell( globalGrid ),
-                                           Opm::UgGridHelpers::cartDims( globalGrid ),
-                                           Opm::UgGridHelpers::dimensions( globalGrid ),
-                                           Opm::UgGridHelpers::cell2Faces( globalGrid ),
-                                           Opm::UgGridHelpers::beginFaceCentroids( globalGrid ),
-                                           dynamic_list_econ_limited,
-                                           false,
-                                           // We need to pass the optionaly arguments
-                                           // as we get the following error otherwise
-                                           // with c++ (Debian 4.9.2-10) 4.9.2 and -std=c++11
-                                           // converting to ‘const std::unordered_set<std::basic_string<char> >’ from initializer list would use explicit constructor
-                                           std::unordered_set<std::string>());
-
-                const Wells* wells = wells_manager.c_wells();
-                globalWellState_.init(wells, *globalReservoirState_, globalWellState_, phaseUsage_ );
-                globalCellData_->clear();
+                // The wells only change with the report step, hence the
+                // global wells and the well state are only recreated then.
+                if( ! globalWellsManager_ || wellStateStepNumber != globalWellsStepNumber_ )
+                {
+                    Dune::CpGrid& globalGrid = *grid_;
+                    // TODO: make a dummy DynamicListEconLimited here for NOW for compilation and development
+                    // TODO: NOT SURE whether it will cause problem for parallel running
+                    // TODO: TO BE TESTED AND IMPROVED
+                    const DynamicListEconLimited dynamic_list_econ_limited;
+                    // Create wells and well state.
+                    globalWellsManager_.reset( new WellsManager(eclipseState_,
+                                                                schedule_,
+                                                                wellStateStepNumber,
+                                                                Opm::UgGridHelpers::numCells( globalGrid ),
+                                                                Opm::UgGridHelpers::globalCell( globalGrid ),
+                                                                Opm::UgGridHelpers::cartDims( globalGrid ),
+                                                                Opm::UgGridHelpers::dimensions( globalGrid ),
+                                                                Opm::UgGridHelpers::cell2Faces( globalGrid ),
+                                                                Opm::UgGridHelpers::beginFaceCentroids( globalGrid ),
+                                                                dynamic_list_econ_limited,
+                                                                false,
+                                                                // We need to pass the optionaly arguments
+                                                                // as we get the following error otherwise
+                                                                // with c++ (Debian 4.9.2-10) 4.9.2 and -std=c++11
+                                                                // converting to ‘const std::unordered_set<std::basic_string<char> >’ from initializer list would use explicit constructor
+                                                                std::unordered_set<std::string>()) );
+                    globalWellsStepNumber_ = wellStateStepNumber;
+
+                    const Wells* wells = globalWellsManager_->c_wells();
+                    globalWellState_.init(wells, *globalReservoirState_, globalWellState_, phaseUsage_ );
+                }
+
+                // Keep the global arrays of the previous output if the same
+                // quantities are written again, all of their values are
+                // overwritten by the gathered data.
+                for( auto it = globalCellData_->begin(); it != globalCellData_->end(); )
+                {
+                    if( localCellData.has( it->first ) ) {
+                        ++it;
+                    }
+                    else {
+                        it = globalCellData_->erase( it );
+                    }
+                }
             }
 
             PackUnPackSimulationDataContainer packUnpack( numCells(),
                                                           localCellData, *globalCellData_,
                                                           localWellState, globalWellState_,
                                                           localIndexMap_, indexMaps_,
+                                                          sentLayout_, receivedLayouts_,
+                                                          globalWellsStepNumber_,
                                                           isIORank() );
 
-            //toIORankComm_.exchangeCached( packUnpack );
             toIORankComm_.exchange( packUnpack );
 #ifndef NDEBUG
             // make sure every process is on the same page
@@ -684,10 +891,17 @@ namespace Opm
         IndexMapType                              globalIndex_;
         IndexMapType                              localIndexMap_;
         IndexMapStorageType                       indexMaps_;
+        // layout of the last message sent to the I/O rank
+        MessageLayout                             sentLayout_;
+        // layouts of the last messages received on the I/O rank, by link
+        std::vector< ReceivedLayout >             receivedLayouts_;
         std::unique_ptr<SimulationDataContainer>  globalReservoirState_;
         std::unique_ptr<data::Solution>           globalCellData_;
         // this needs to be revised
         WellStateFullyImplicitBlackoil            globalWellState_;
+        // wells of the global grid and the step they were created for
+        std::unique_ptr<WellsManager>             globalWellsManager_;
+        int                                       globalWellsStepNumber_;
         // true if we are on I/O rank
         bool                                      isIORank_;
         // Phase usage needed to convert solution to simulation data container
@@ -20,20 +20,32 @@
 #ifndef OPM_PARALLELOVERLAPPINGILU0_HEADER_INCLUDED
 #define OPM_PARALLELOVERLAPPINGILU0_HEADER_INCLUDED
 
+#include <opm/autodiff/MatrixBlockKernels.hpp>
+#include <opm/autodiff/MatrixReordering.hpp>
 #include <opm/common/Exceptions.hpp>
 
+#include <dune/common/fmatrix.hh>
 #include <dune/istl/preconditioner.hh>
 #include <dune/istl/paamg/smoother.hh>
 #include <dune/istl/paamg/pinfo.hh>
 
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace Opm
 {
 
 //template<class M, class X, class Y, class C>
 //class ParallelOverlappingILU0;
-template<class Matrix, class Domain, class Range, class ParallelInfo = Dune::Amg::SequentialInformation>
+template<class Matrix, class Domain, class Range, class ParallelInfo = Dune::Amg::SequentialInformation,
+         class StorageField = typename Matrix::field_type>
 class ParallelOverlappingILU0;
 
 } // end namespace Opm
@@ -50,20 +62,21 @@ namespace Amg
 /// \tparam Range The type of the Vector representing the range.
 /// \tparam ParallelInfo The type of the parallel information object
 ///         used, e.g. Dune::OwnerOverlapCommunication
-template<class Matrix, class Domain, class Range, class ParallelInfo>
-struct ConstructionTraits<Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo> >
+/// \tparam StorageField The field type the factors are stored in.
+template<class Matrix, class Domain, class Range, class ParallelInfo, class StorageField>
+struct ConstructionTraits<Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo,StorageField> >
 {
     typedef Dune::SeqILU0<Matrix,Domain,Range> T;
     typedef DefaultParallelConstructionArgs<T,ParallelInfo> Arguments;
     typedef ConstructionTraits<T> SeqConstructionTraits;
-    static inline Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo>* construct(Arguments& args)
+    static inline Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo,StorageField>* construct(Arguments& args)
     {
-        return new Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo>(args.getMatrix(),
+        return new Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo,StorageField>(args.getMatrix(),
                                                          args.getComm(),
                                                          args.getArgs().relaxationFactor);
     }
 
-    static inline void deconstruct(Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo>* bp)
+    static inline void deconstruct(Opm::ParallelOverlappingILU0<Matrix,Domain,Range,ParallelInfo,StorageField>* bp)
     {
         delete bp;
     }
@@ -80,6 +93,26 @@ namespace Opm
 {
     namespace detail
     {
+      //! copy a matrix block of the same type
+      template<class Block>
+      void convertBlock(const Block& from, Block& to)
+      {
+        to = from;
+      }
+
+      //! copy a matrix block, converting the entries to the field type of the target block
+      template<class FromBlock, class ToBlock>
+      void convertBlock(const FromBlock& from, ToBlock& to)
+      {
+        for( int i = 0; i < FromBlock::rows; ++i )
+        {
+          for( int j = 0; j < FromBlock::cols; ++j )
+          {
+            to[ i ][ j ] = from[ i ][ j ];
+          }
+        }
+      }
+
       //! compute ILU decomposition of A. A is overwritten by its decomposition
       template<class M, class CRS, class InvVector>
       void convertToCRS(const M& A, CRS& lower, CRS& upper, InvVector& inv )
@@ -132,7 +165,7 @@ namespace Opm
             const size_type jIndex = j.index();
             if( j.index() == iIndex )
             {
-              inv[ row ] = (*j);
+              convertBlock( (*j), inv[ row ] );
 	      break;
             }
             else if ( j.index() >= i.index() )
@@ -144,6 +177,24 @@ namespace Opm
           upper.rows_[ row+1 ] = colcount;
         }
       }
+
+      //! copy the values of A to B, both matrices need to have the same sparsity pattern
+      template<class M>
+      void copyMatrixValues(const M& A, M& B)
+      {
+        auto rowB = B.begin();
+        const auto endi = A.end();
+        for (auto rowA = A.begin(); rowA != endi; ++rowA, ++rowB)
+        {
+          auto colB = (*rowB).begin();
+          const auto endj = (*rowA).end();
+          for (auto colA = (*rowA).begin(); colA != endj; ++colA, ++colB)
+          {
+            assert( colA.index() == colB.index() );
+            *colB = *colA;
+          }
+        }
+      }
     } // end namespace detail
 
 /// \brief A two-step version of an overlapping Schwarz preconditioner using one step ILU0 as
@@ -161,7 +212,12 @@ namespace Opm
 /// \tparam Range The type of the Vector representing the range.
 /// \tparam ParallelInfo The type of the parallel information object
 ///         used, e.g. Dune::OwnerOverlapCommunication
-template<class Matrix, class Domain, class Range, class ParallelInfoT>
+/// \tparam StorageField The field type the factors are stored in. The
+///         decomposition is computed in the field type of the matrix and
+///         rounded afterwards, the triangular solves accumulate in the
+///         field type of the vectors. Storing the factors in float halves
+///         the memory traffic of apply, which dominates its cost.
+template<class Matrix, class Domain, class Range, class ParallelInfoT, class StorageField>
 class ParallelOverlappingILU0
     : public Dune::Preconditioner<Domain,Range>
 {
@@ -180,6 +236,10 @@ public:
 
     typedef typename matrix_type::block_type  block_type;
     typedef typename matrix_type::size_type   size_type;
+    //! \brief The type of the blocks of the stored factors.
+    typedef typename std::conditional< std::is_same< StorageField, typename matrix_type::field_type >::value,
+                                       block_type,
+                                       Dune::FieldMatrix< StorageField, block_type::rows, block_type::cols > >::type storage_block_type;
 
 protected:
     struct CRS
@@ -214,18 +274,39 @@ protected:
           }
       }
 
-      void push_back( const block_type& value, const size_type index )
+      template< class Block >
+      void push_back( const Block& value, const size_type index )
       {
-          values_.push_back( value );
+          values_.emplace_back();
+          detail::convertBlock( value, values_.back() );
           cols_.push_back( index );
       }
 
+      // remove all entries but keep the allocated storage
+      void clear()
+      {
+          values_.clear();
+          cols_.clear();
+      }
+
       std::vector< size_type  > rows_;
-      std::vector< block_type > values_;
+      std::vector< storage_block_type > values_;
       std::vector< size_type  > cols_;
       size_type nRows_;
     };
 
+    //! \brief The rows of a triangular factor grouped into level sets.
+    //!
+    //! The rows of one level only depend on rows of lower levels. Within a
+    //! level the rows keep their original order.
+    struct LevelSets
+    {
+      size_type levels() const { return start_.empty() ? 0 : start_.size() - 1; }
+
+      std::vector< size_type > rows_;
+      std::vector< size_type > start_;
+    };
+
 public:
     // define the category
     enum {
@@ -240,15 +321,22 @@ public:
       \param A The matrix to operate on.
       \param n ILU fill in level (for testing). This does not work in parallel.
       \param w The relaxation factor.
+      \param ordering The order in which the rows are factorized, e.g. computed
+                      by reverseCuthillMcKee(). Empty for the order of A.
     */
     template<class BlockType, class Alloc>
     ParallelOverlappingILU0 (const Dune::BCRSMatrix<BlockType,Alloc>& A,
-                             const int n, const field_type w )
+                             const int n, const field_type w,
+                             const std::vector< std::size_t >& ordering = std::vector< std::size_t >() )
         : lower_(),
           upper_(),
           inv_(),
+          useLevelSets_( false ),
+          ordering_( ordering ),
           comm_(nullptr), w_(w),
-          relaxation_( std::abs( w - 1.0 ) > 1e-15 )
+          relaxation_( std::abs( w - 1.0 ) > 1e-15 ),
+          iluIteration_( n ),
+          keepILU_( false )
     {
         // BlockMatrix is a Subclass of FieldMatrix that just adds
         // methods. Therefore this cast should be safe.
@@ -274,21 +362,56 @@ public:
       \param A      The matrix to operate on.
       \param comm   communication object, e.g. Dune::OwnerOverlapCopyCommunication
       \param w      The relaxation factor.
+      \param ordering The order in which the rows are factorized, empty for the order of A.
     */
     template<class BlockType, class Alloc>
     ParallelOverlappingILU0 (const Dune::BCRSMatrix<BlockType,Alloc>& A,
-                             const ParallelInfo& comm, const field_type w)
+                             const ParallelInfo& comm, const field_type w,
+                             const std::vector< std::size_t >& ordering = std::vector< std::size_t >() )
         : lower_(),
           upper_(),
           inv_(),
+          useLevelSets_( false ),
+          ordering_( ordering ),
           comm_(&comm), w_(w),
-          relaxation_( std::abs( w - 1.0 ) > 1e-15 )
+          relaxation_( std::abs( w - 1.0 ) > 1e-15 ),
+          iluIteration_( 0 ),
+          keepILU_( false )
     {
         // BlockMatrix is a Subclass of FieldMatrix that just adds
         // methods. Therefore this cast should be safe.
         init( reinterpret_cast<const Matrix&>(A), 0 );
     }
 
+    /*!
+      \brief Recompute the decomposition for new matrix values.
+
+      The sparsity pattern of A has to be the same as the one of the matrix
+      used for the construction. The storage of the factors is kept and only
+      the values are recomputed.
+      \param A The matrix to operate on.
+    */
+    template<class BlockType, class Alloc>
+    void update (const Dune::BCRSMatrix<BlockType,Alloc>& A)
+    {
+        // keep the copy of the matrix used for the decomposition from now on
+        keepILU_ = true;
+        init( reinterpret_cast<const Matrix&>(A), iluIteration_ );
+    }
+
+    /*!
+      \brief Recompute the decomposition for new matrix values.
+
+      \copydoc update(const Dune::BCRSMatrix<BlockType,Alloc>&)
+      \param comm communication object replacing the one passed on construction.
+    */
+    template<class BlockType, class Alloc>
+    void update (const Dune::BCRSMatrix<BlockType,Alloc>& A, const ParallelInfo& comm)
+    {
+        comm_ = &comm;
+        update( A );
+    }
+
     /*!
       \brief Prepare the preconditioner.
 
@@ -310,56 +433,136 @@ public:
         Range& md = const_cast<Range&>(d);
         copyOwnerToAll( md );
 
-        // iterator types
-        typedef typename Range ::block_type  dblock;
-        typedef typename Domain::block_type  vblock;
-
-        const size_type iEnd = lower_.rows();
-        const size_type lastRow = iEnd - 1;
-        if( iEnd != upper_.rows() )
+        if( lower_.rows() != upper_.rows() )
         {
             std::abort();
            // OPM_THROW(std::logic_error,"ILU: lower and upper rows must be the same");
         }
 
-        // lower triangular solve
-        for( size_type i=0; i<iEnd; ++ i )
+        if( ordering_.empty() )
         {
-          dblock rhs( d[ i ] );
-          const size_type rowI     = lower_.rows_[ i ];
-          const size_type rowINext = lower_.rows_[ i+1 ];
-
-          for( size_type col = rowI; col < rowINext; ++ col )
-          {
-            lower_.values_[ col ].mmv( v[ lower_.cols_[ col ] ], rhs );
-          }
-
-          v[ i ] = rhs;  // Lii = I
+            lowerSolve( v, d );
+            copyOwnerToAll( v );
+            upperSolve( v );
+        }
+        else
+        {
+            // solve in the order the factors were computed in
+            reorderVector( d, ordering_, reorderedD_ );
+            lowerSolve( reorderedV_, reorderedD_ );
+            if( comm_ )
+            {
+                restoreVectorOrder( reorderedV_, ordering_, v );
+                copyOwnerToAll( v );
+                reorderVector( v, ordering_, reorderedV_ );
+            }
+            upperSolve( reorderedV_ );
+            restoreVectorOrder( reorderedV_, ordering_, v );
         }
 
         copyOwnerToAll( v );
 
-        for( size_type i=0; i<iEnd; ++ i )
+        if( relaxation_ ) {
+            v *= w_;
+        }
+    }
+
+    //! \brief Solve the lower triangular system L v = d.
+    void lowerSolve( Domain& v, const Range& d ) const
+    {
+        if( useLevelSets_ )
+        {
+            // rows of one level are independent
+#if HAVE_OPENMP
+#pragma omp parallel
+#endif // HAVE_OPENMP
+            for( size_type level = 0; level < lowerLevels_.levels(); ++level )
+            {
+                const long levelBegin = lowerLevels_.start_[ level ];
+                const long levelEnd   = lowerLevels_.start_[ level+1 ];
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif // HAVE_OPENMP
+                for( long k = levelBegin; k < levelEnd; ++k )
+                {
+                    lowerSolveRow( v, d, lowerLevels_.rows_[ k ] );
+                }
+            }
+        }
+        else
         {
-            vblock& vBlock = v[ lastRow - i ];
-            vblock rhs ( vBlock );
-            const size_type rowI     = upper_.rows_[ i ];
-            const size_type rowINext = upper_.rows_[ i+1 ];
+            const size_type iEnd = lower_.rows();
+            for( size_type i=0; i<iEnd; ++ i )
+            {
+                lowerSolveRow( v, d, i );
+            }
+        }
+    }
 
-            for( size_type col = rowI; col < rowINext; ++ col )
+    //! \brief Solve the upper triangular system U v = v.
+    void upperSolve( Domain& v ) const
+    {
+        const size_type iEnd = upper_.rows();
+        const size_type lastRow = iEnd - 1;
+        if( useLevelSets_ )
+        {
+            // rows of one level are independent
+#if HAVE_OPENMP
+#pragma omp parallel
+#endif // HAVE_OPENMP
+            for( size_type level = 0; level < upperLevels_.levels(); ++level )
             {
-                upper_.values_[ col ].mmv( v[ upper_.cols_[ col ] ], rhs );
+                const long levelBegin = upperLevels_.start_[ level ];
+                const long levelEnd   = upperLevels_.start_[ level+1 ];
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif // HAVE_OPENMP
+                for( long k = levelBegin; k < levelEnd; ++k )
+                {
+                    upperSolveRow( v, upperLevels_.rows_[ k ], lastRow );
+                }
             }
+        }
+        else
+        {
+            for( size_type i=0; i<iEnd; ++ i )
+            {
+                upperSolveRow( v, i, lastRow );
+            }
+        }
+    }
 
-            // apply inverse and store result
-            inv_[ i ].mv( rhs, vBlock);
+    //! \brief Solve row i of the lower triangular system L v = d.
+    void lowerSolveRow( Domain& v, const Range& d, const size_type i ) const
+    {
+        typename Range::block_type rhs( d[ i ] );
+        const size_type rowI     = lower_.rows_[ i ];
+        const size_type rowINext = lower_.rows_[ i+1 ];
+
+        for( size_type col = rowI; col < rowINext; ++ col )
+        {
+            blockkernels::mmv( lower_.values_[ col ], v[ lower_.cols_[ col ] ], rhs );
         }
 
-        copyOwnerToAll( v );
+        v[ i ] = rhs;  // Lii = I
+    }
 
-        if( relaxation_ ) {
-            v *= w_;
+    //! \brief Solve row i of the upper triangular system U v = v, where the
+    //!        rows of upper_ and inv_ are stored in reverse order.
+    void upperSolveRow( Domain& v, const size_type i, const size_type lastRow ) const
+    {
+        typename Domain::block_type& vBlock = v[ lastRow - i ];
+        typename Domain::block_type rhs ( vBlock );
+        const size_type rowI     = upper_.rows_[ i ];
+        const size_type rowINext = upper_.rows_[ i+1 ];
+
+        for( size_type col = rowI; col < rowINext; ++ col )
+        {
+            blockkernels::mmv( upper_.values_[ col ], v[ upper_.cols_[ col ] ], rhs );
         }
+
+        // apply inverse and store result
+        blockkernels::mv( inv_[ i ], rhs, vBlock );
     }
 
     template <class V>
@@ -387,19 +590,41 @@ protected:
         std::string message;
         const int rank = ( comm_ ) ? comm_->communicator().rank() : 0;
 
-        std::unique_ptr< Matrix > ILU;
-
         try
         {
             if( iluIteration == 0 ) {
-                // create ILU-0 decomposition
-                ILU.reset( new Matrix( A ) );
-                bilu0_decomposition( *ILU );
+                // create ILU-0 decomposition, reuse the storage of a previous one
+                const bool reuse = ILU_ && ILU_->N() == A.N() && ILU_->nonzeroes() == A.nonzeroes();
+                if( ordering_.empty() ) {
+                    if( reuse ) {
+                        detail::copyMatrixValues( A, *ILU_ );
+                    }
+                    else {
+                        ILU_.reset( new Matrix( A ) );
+                    }
+                }
+                else {
+                    if( reuse ) {
+                        copyReorderedValues( A, ordering_, inverseOrdering_, *ILU_ );
+                    }
+                    else {
+                        inverseOrdering_ = inverseOrdering( ordering_ );
+                        ILU_.reset( new Matrix() );
+                        reorderMatrix( A, ordering_, inverseOrdering_, *ILU_ );
+                    }
+                }
+                bilu0_decomposition( *ILU_ );
             }
             else {
                 // create ILU-n decomposition
-                ILU.reset( new Matrix( A.N(), A.M(), Matrix::row_wise) );
-                bilu_decomposition( A, iluIteration, *ILU );
+                std::unique_ptr< Matrix > reordered;
+                if( ! ordering_.empty() ) {
+                    inverseOrdering_ = inverseOrdering( ordering_ );
+                    reordered.reset( new Matrix() );
+                    reorderMatrix( A, ordering_, inverseOrdering_, *reordered );
+                }
+                ILU_.reset( new Matrix( A.N(), A.M(), Matrix::row_wise) );
+                bilu_decomposition( reordered ? *reordered : A, iluIteration, *ILU_ );
             }
         }
         catch ( Dune::MatrixBlockError error )
@@ -418,19 +643,102 @@ protected:
         }
 
         // store ILU in simple CRS format
-        detail::convertToCRS( *ILU, lower_, upper_, inv_ );
+        lower_.clear();
+        upper_.clear();
+        detail::convertToCRS( *ILU_, lower_, upper_, inv_ );
+
+        if( ! keepILU_ ) {
+            ILU_.reset();
+        }
+
+        if( ! ordering_.empty() ) {
+            assert( ordering_.size() == A.N() );
+            reorderedV_.resize( A.N() );
+            reorderedD_.resize( A.N() );
+        }
+
+        // The triangular solves are only split into level sets if
+        // several threads are available to process the levels.
+        useLevelSets_ = false;
+#if HAVE_OPENMP
+        if( omp_get_max_threads() > 1 )
+        {
+            computeLevelSets( lower_, false, lowerLevels_ );
+            computeLevelSets( upper_, true, upperLevels_ );
+
+            // Levels with few rows do not pay off the synchronization.
+            const size_type minRowsPerLevel = 64;
+            const size_type maxLevels = std::max( lowerLevels_.levels(), upperLevels_.levels() );
+            useLevelSets_ = maxLevels * minRowsPerLevel <= lower_.rows();
+        }
+#endif // HAVE_OPENMP
+    }
+
+    //! \brief Compute the level sets of the triangular factor crs.
+    //! \param reversed true if the rows of crs are stored in reverse order
+    //!                 (as for the upper factor).
+    void computeLevelSets( const CRS& crs, const bool reversed, LevelSets& levelSets ) const
+    {
+        const size_type nRows = crs.rows();
+        const size_type lastRow = nRows - 1;
+
+        // a row is one level above the highest level of the rows it depends on
+        std::vector< size_type > level( nRows, 0 );
+        size_type numLevels = 0;
+        for( size_type i = 0; i < nRows; ++i )
+        {
+            size_type rowLevel = 0;
+            for( size_type col = crs.rows_[ i ]; col < crs.rows_[ i+1 ]; ++col )
+            {
+                const size_type j = reversed ? lastRow - crs.cols_[ col ] : crs.cols_[ col ];
+                assert( j < i );
+                rowLevel = std::max( rowLevel, level[ j ] + 1 );
+            }
+            level[ i ] = rowLevel;
+            numLevels = std::max( numLevels, rowLevel + 1 );
+        }
+
+        // sort the rows by level keeping the order within each level
+        levelSets.start_.assign( numLevels + 1, 0 );
+        for( size_type i = 0; i < nRows; ++i ) {
+            ++levelSets.start_[ level[ i ] + 1 ];
+        }
+        for( size_type l = 0; l < numLevels; ++l ) {
+            levelSets.start_[ l+1 ] += levelSets.start_[ l ];
+        }
+
+        std::vector< size_type > position( levelSets.start_.begin(), levelSets.start_.end() - 1 );
+        levelSets.rows_.resize( nRows );
+        for( size_type i = 0; i < nRows; ++i ) {
+            levelSets.rows_[ position[ level[ i ] ]++ ] = i;
+        }
     }
 
 protected:
     //! \brief The ILU0 decomposition of the matrix.
     CRS lower_;
     CRS upper_;
-    std::vector< block_type > inv_;
+    std::vector< storage_block_type > inv_;
+    //! \brief The level sets of the factors for the multithreaded triangular solves.
+    LevelSets lowerLevels_;
+    LevelSets upperLevels_;
+    bool useLevelSets_;
+    //! \brief The order of the rows of the factors, empty for the order of the matrix.
+    const std::vector< std::size_t > ordering_;
+    std::vector< std::size_t > inverseOrdering_;
+    //! \brief The vectors of apply in the order of the factors.
+    Domain reorderedV_;
+    Range reorderedD_;
 
     const ParallelInfo* comm_;
     //! \brief The relaxation factor to use.
     const field_type w_;
     const bool relaxation_;
+    //! \brief The ILU fill in level.
+    const int iluIteration_;
+    //! \brief The matrix holding the decomposition, only kept if it is updated.
+    std::unique_ptr< Matrix > ILU_;
+    bool keepILU_;
 
 };
 
@@ -34,6 +34,7 @@
 #include <opm/parser/eclipse/Units/Units.hpp>
 
 #include <opm/autodiff/GridHelpers.hpp>
+#include <opm/autodiff/TimerRegistry.hpp>
 
 #include <sstream>
 #include <iomanip>
@@ -265,6 +266,7 @@ namespace Opm
             int wellStateStepNumber = ( ! substep && timer.reportStepNum() > 0) ?
                 (timer.reportStepNum() - 1) : timer.reportStepNum();
             // collect all solutions to I/O rank
+            ScopedTimer gatherTimer("output_gather");
             isIORank = parallelOutput_->collectToIORank( localState, localWellState,
                                                          localCellData,
                                                          wellStateStepNumber );
@@ -321,6 +323,8 @@ namespace Opm
                         const std::map<std::string, std::vector<double>>& extraRestartData,
                         bool substep)
     {
+        ScopedTimer writeTimer("output_write");
+
         // Matlab output
         if( matlabWriter_ ) {
             matlabWriter_->writeTimeStep( timer, state, wellState, substep );
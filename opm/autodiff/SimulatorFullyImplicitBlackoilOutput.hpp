@@ -42,6 +42,7 @@
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/ThreadHandle.hpp>
 #include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/TimerRegistry.hpp>
 
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/SummaryConfig/SummaryConfig.hpp>
@@ -392,7 +393,9 @@ namespace Opm
             {
                 const bool isIORank = parallelOutput_ ? parallelOutput_->isIORank() : true;
 #if HAVE_PTHREAD
-                asyncOutput_.reset( new ThreadHandle( isIORank ) );
+                // number of report steps that may wait for being written
+                const int asyncOutputQueueSize = param.getDefault("async_output_queue_size", int(4) );
+                asyncOutput_.reset( new ThreadHandle( isIORank, std::max( asyncOutputQueueSize, 1 ) ) );
 #else
                 OPM_THROW(std::runtime_error,"Pthreads were not found, cannot enable async_output");
 #endif
@@ -993,6 +996,8 @@ namespace Opm
                   const double nextstep,
                   const SimulatorReport& simulatorReport)
     {
+        ScopedTimer outputTimer("output");
+
         data::Solution localCellData{};
         const RestartConfig& restartConfig = eclipseState_.getRestartConfig();
         const int reportStepNum = timer.reportStepNum();
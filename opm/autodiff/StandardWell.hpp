@@ -27,6 +27,7 @@
 #include <opm/autodiff/WellInterface.hpp>
 #include <opm/autodiff/ISTLSolver.hpp>
 #include <opm/autodiff/RateConverter.hpp>
+#include <opm/autodiff/StandardWellHelpers.hpp>
 
 namespace Opm
 {
@@ -142,6 +143,14 @@ namespace Opm
         /// r = r - C D^-1 Rw
         virtual void apply(BVector& r) const;
 
+        virtual bool supportsCouplingOperator() const { return true; }
+
+        /// mat = mat - C D^-1 B
+        virtual void addWellContributions(Mat& mat) const;
+
+        /// copy B, C and D^-1 of the well equations to well
+        virtual bool captureLinearSystem(LinearSystemWell& well) const;
+
         /// using the solution x to recover the solution xw for wells and applying
         /// xw to update Well State
         virtual void recoverWellSolutionAndUpdateWellState(const BVector& x,
@@ -223,6 +232,10 @@ namespace Opm
         // the saturations in the well bore under surface conditions at the beginning of the time step
         std::vector<double> F0_;
 
+        // intervals of the VFP table used in the last bhp calculation,
+        // the starting point for the table search of the next calculation
+        mutable detail::VFPInterpHint vfp_hint_;
+
         // TODO: this function should be moved to the base class.
         // while it faces chanllenges for MSWell later, since the calculation of bhp
         // based on THP is never implemented for MSWell yet.
@@ -285,13 +298,41 @@ namespace Opm
                              const double Tw, const EvalWell& bhp, const double& cdp,
                              const bool& allow_cf, std::vector<EvalWell>& cq_s) const;
 
-        // TODO: maybe we should provide a light version of computePerfRate, which does not include the
-        // calculation of the derivatives
-        void computeWellRatesWithBhp(const Simulator& ebosSimulator,
-                                     const EvalWell& bhp,
+        // the perforation rates for the given quantities of the perforation cell,
+        // Value is EvalWell for the assembly and double when no derivatives are needed
+        template <class Value>
+        void computePerfRate(const std::vector<Value>& mob_perfcells_dense,
+                             const std::vector<Value>& b_perfcells_dense,
+                             const std::vector<Value>& cmix_s,
+                             const Value& pressure, const Value& rs, const Value& rv,
+                             const double Tw, const Value& bhp, const double& cdp,
+                             const bool& allow_cf, std::vector<Value>& cq_s) const;
+
+        // the quantities of the perforations which do not depend on the bhp, they are
+        // computed once to evaluate the well rates for many bhp values without derivatives
+        struct PerforationValues
+        {
+            std::vector<std::vector<double> > mob;
+            std::vector<std::vector<double> > b;
+            std::vector<double> pressure;
+            std::vector<double> rs;
+            std::vector<double> rv;
+            std::vector<double> cmix;
+            bool allow_cf;
+        };
+
+        void computePerforationValues(const Simulator& ebosSimulator,
+                                      PerforationValues& values) const;
+
+        void computeWellRatesWithBhp(const PerforationValues& values,
+                                     const double bhp,
                                      std::vector<double>& well_flux) const;
 
-        std::vector<double> computeWellPotentialWithTHP(const Simulator& ebosSimulator,
+        // the bhp given by the THP constraints for the rates, limited by the bhp from the BHP constraints
+        double bhpFromThpConstraints(const std::vector<double>& rates,
+                                     const double bhp_limit) const;
+
+        std::vector<double> computeWellPotentialWithTHP(const PerforationValues& values,
                                                         const double initial_bhp, // bhp from BHP constraints
                                                         const std::vector<double>& initial_potential) const;
 
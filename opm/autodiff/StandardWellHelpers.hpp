@@ -0,0 +1,311 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_STANDARDWELLHELPERS_HEADER_INCLUDED
+#define OPM_STANDARDWELLHELPERS_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Opm {
+
+namespace standardwellhelpers
+{
+
+    inline double scalarValue(const double value) { return value; }
+
+    template <class Evaluation>
+    double scalarValue(const Evaluation& value) { return value.value(); }
+
+
+
+    /// The positions of the components in the perforation quantities,
+    /// -1 for the inactive phases and without solvent.
+    struct PerforationRateLayout
+    {
+        int num_components;
+        int water_pos;
+        int oil_pos;
+        int gas_pos;
+        int solvent_pos;
+        bool is_producer;
+    };
+
+
+
+    /// The surface volume rates of the components at a perforation. Value is
+    /// the evaluation with derivatives for the assembly and double when no
+    /// derivatives are needed, both give the same rates. Without crossflow,
+    /// cq_s is left unchanged for a perforation flowing against the well type.
+    template <class Value>
+    void computePerfRate(const PerforationRateLayout& layout,
+                         const std::string& well_name,
+                         const std::vector<Value>& mob_perfcells_dense,
+                         const std::vector<Value>& b_perfcells_dense,
+                         const std::vector<Value>& cmix_s,
+                         const Value& pressure, const Value& rs, const Value& rv,
+                         const double Tw, const Value& bhp, const double& cdp,
+                         const bool& allow_cf, std::vector<Value>& cq_s)
+    {
+        const int num_components = layout.num_components;
+        const bool oil_and_gas = layout.oil_pos >= 0 && layout.gas_pos >= 0;
+
+        // Pressure drawdown (also used to determine direction of flow)
+        const Value well_pressure = bhp + cdp;
+        const Value drawdown = pressure - well_pressure;
+
+        // producing perforations
+        if ( scalarValue(drawdown) > 0 )  {
+            //Do nothing if crossflow is not allowed
+            if (!allow_cf && !layout.is_producer) {
+                return;
+            }
+
+            // compute component volumetric rates at standard conditions
+            for (int componentIdx = 0; componentIdx < num_components; ++componentIdx) {
+                const Value cq_p = - Tw * (mob_perfcells_dense[componentIdx] * drawdown);
+                cq_s[componentIdx] = b_perfcells_dense[componentIdx] * cq_p;
+            }
+
+            if (oil_and_gas) {
+                const int oilpos = layout.oil_pos;
+                const int gaspos = layout.gas_pos;
+                const Value cq_sOil = cq_s[oilpos];
+                const Value cq_sGas = cq_s[gaspos];
+                cq_s[gaspos] += rs * cq_sOil;
+                cq_s[oilpos] += rv * cq_sGas;
+            }
+
+        } else {
+            //Do nothing if crossflow is not allowed
+            if (!allow_cf && layout.is_producer) {
+                return;
+            }
+
+            // Using total mobilities
+            Value total_mob_dense = mob_perfcells_dense[0];
+            for (int componentIdx = 1; componentIdx < num_components; ++componentIdx) {
+                total_mob_dense += mob_perfcells_dense[componentIdx];
+            }
+
+            // injection perforations total volume rates
+            const Value cqt_i = - Tw * (total_mob_dense * drawdown);
+
+            // compute volume ratio between connection at standard conditions
+            Value volumeRatio = 0.0;
+            if (layout.water_pos >= 0) {
+                const int watpos = layout.water_pos;
+                volumeRatio += cmix_s[watpos] / b_perfcells_dense[watpos];
+            }
+
+            if (layout.solvent_pos >= 0) {
+                const int solventpos = layout.solvent_pos;
+                volumeRatio += cmix_s[solventpos] / b_perfcells_dense[solventpos];
+            }
+
+            if (oil_and_gas) {
+                const int oilpos = layout.oil_pos;
+                const int gaspos = layout.gas_pos;
+
+                // Incorporate RS/RV factors if both oil and gas active
+                const Value d = 1.0 - rv * rs;
+
+                if (scalarValue(d) == 0.0) {
+                    OPM_THROW(Opm::NumericalProblem, "Zero d value obtained for well " << well_name << " during flux calcuation"
+                                                  << " with rs " << scalarValue(rs) << " and rv " << scalarValue(rv));
+                }
+
+                const Value tmp_oil = (cmix_s[oilpos] - rv * cmix_s[gaspos]) / d;
+                volumeRatio += tmp_oil / b_perfcells_dense[oilpos];
+
+                const Value tmp_gas = (cmix_s[gaspos] - rs * cmix_s[oilpos]) / d;
+                volumeRatio += tmp_gas / b_perfcells_dense[gaspos];
+            }
+            else {
+                if (layout.oil_pos >= 0) {
+                    const int oilpos = layout.oil_pos;
+                    volumeRatio += cmix_s[oilpos] / b_perfcells_dense[oilpos];
+                }
+                if (layout.gas_pos >= 0) {
+                    const int gaspos = layout.gas_pos;
+                    volumeRatio += cmix_s[gaspos] / b_perfcells_dense[gaspos];
+                }
+            }
+
+            // injecting connections total volumerates at standard conditions
+            Value cqt_is = cqt_i/volumeRatio;
+            for (int componentIdx = 0; componentIdx < num_components; ++componentIdx) {
+                cq_s[componentIdx] = cmix_s[componentIdx] * cqt_is;
+            }
+        }
+    }
+
+
+
+
+
+    /// Find a root of f between a and b with the Illinois variant of regula falsi,
+    /// which halves the function value of the retained end point to avoid the
+    /// one-sided convergence of regula falsi.
+    ///
+    /// \param[in]  f          Scalar function of one variable.
+    /// \param[in]  a, b       End points of the interval.
+    /// \param[in]  tolerance  The root is accepted when |f(root)| < tolerance.
+    /// \param[in]  max_iter   Maximum number of iterations after the end points.
+    /// \param[out] root       The root found.
+    /// \return false if f does not change sign between a and b or no root is
+    ///         found within max_iter iterations.
+    template <class Function>
+    bool regulaFalsiIllinois(const Function& f, double a, double b,
+                             const double tolerance, const int max_iter,
+                             double& root)
+    {
+        double f_a = f(a);
+        if (std::abs(f_a) < tolerance) {
+            root = a;
+            return true;
+        }
+
+        double f_b = f(b);
+        if (std::abs(f_b) < tolerance) {
+            root = b;
+            return true;
+        }
+
+        if (!(f_a * f_b < 0.0)) {
+            return false;
+        }
+
+        for (int iteration = 0; iteration < max_iter; ++iteration) {
+            const double x = b - f_b * (b - a) / (f_b - f_a);
+            const double f_x = f(x);
+            if (std::abs(f_x) < tolerance) {
+                root = x;
+                return true;
+            }
+
+            if (f_x * f_b < 0.0) {
+                a = b;
+                f_a = f_b;
+            } else {
+                f_a *= 0.5;
+            }
+            b = x;
+            f_b = f_x;
+        }
+
+        return false;
+    }
+
+
+
+
+
+    /// The well potentials with THP constraints are the rates q(bhp) at the bhp
+    /// which solves bhp = G(q(bhp)), where G is the bhp from the THP constraints
+    /// for the rates, limited by the bhp from the BHP constraints.
+    ///
+    /// The residual bhp - G(q(bhp)) usually changes sign between the bhp limit
+    /// and the bhp where the well stops flowing, the root is then found with
+    /// regulaFalsiIllinois(), which only needs a few rate evaluations. Otherwise,
+    /// e.g. for a VFP table which is not monotone in the rates, a damped fixed
+    /// point iteration on the potentials is used.
+    ///
+    /// \param[in]  computeRates       computeRates(bhp, q) computes the well rates q at bhp.
+    /// \param[in]  bhpFromThp         bhpFromThp(q) returns G(q).
+    /// \param[in]  bhp_limit          The bhp from the BHP constraints.
+    /// \param[in]  no_flow_bhp        The bhp where none of the perforations flows
+    ///                                in the direction of the well.
+    /// \param[in]  initial_potential  Start of the fixed point iteration.
+    /// \param[out] potentials         The well potentials.
+    /// \return false if the fixed point iteration is needed and does not converge,
+    ///         or gives potentials which are not finite.
+    template <class RateFunction, class BhpFunction>
+    bool computeWellPotentialWithTHP(const RateFunction& computeRates,
+                                     const BhpFunction& bhpFromThp,
+                                     const double bhp_limit,
+                                     const double no_flow_bhp,
+                                     const std::vector<double>& initial_potential,
+                                     std::vector<double>& potentials)
+    {
+        const double bhp_tolerance = 1000.; // 1000 pascal
+
+        auto residual = [&](const double bhp) {
+            computeRates(bhp, potentials);
+            return bhp - bhpFromThp(potentials);
+        };
+
+        double bhp = bhp_limit;
+        if (regulaFalsiIllinois(residual, bhp_limit, no_flow_bhp, bhp_tolerance, 100, bhp)) {
+            computeRates(bhp, potentials);
+            return true;
+        }
+
+        // the damped fixed point iteration
+        // TODO: pay attention to the situation that finally the potential is calculated based on the bhp control
+        // TODO: should we consider the bhp constraints during the iterative process?
+        const int np = initial_potential.size();
+        potentials = initial_potential;
+        std::vector<double> old_potentials = potentials; // keeping track of the old potentials
+
+        double old_bhp = bhp_limit;
+        const int max_iteration = 1000;
+
+        for (int iteration = 0; iteration < max_iteration; ++iteration) {
+            // for each iteration, we calculate the bhp based on the rates/potentials with thp constraints
+            // with considering the bhp value from the bhp limits.
+            bhp = bhpFromThp(potentials);
+
+            const bool converged = std::abs(old_bhp - bhp) < bhp_tolerance;
+
+            computeRates(bhp, potentials);
+
+            for (const double value : potentials) {
+                if (std::isinf(value) || std::isnan(value)) {
+                    return false;
+                }
+            }
+
+            if (converged) {
+                return true;
+            }
+
+            old_bhp = bhp;
+            for (int p = 0; p < np; ++p) {
+                // TODO: improve the interpolation, will it always be valid with the way below?
+                // TODO: finding better paramters, better iteration strategy for better convergence rate.
+                const double potential_update_damping_factor = 0.001;
+                potentials[p] = potential_update_damping_factor * potentials[p] + (1.0 - potential_update_damping_factor) * old_potentials[p];
+                old_potentials[p] = potentials[p];
+            }
+        }
+
+        return false;
+    }
+
+} // namespace standardwellhelpers
+
+} // namespace Opm
+
+#endif // OPM_STANDARDWELLHELPERS_HEADER_INCLUDED
@@ -396,7 +396,6 @@ namespace Opm
                     const double Tw, const EvalWell& bhp, const double& cdp,
                     const bool& allow_cf, std::vector<EvalWell>& cq_s) const
     {
-        const Opm::PhaseUsage& pu = phaseUsage();
         const int np = number_of_phases_;
         std::vector<EvalWell> cmix_s(num_components_,0.0);
         for (int componentIdx = 0; componentIdx < num_components_; ++componentIdx) {
@@ -416,96 +415,37 @@ namespace Opm
             b_perfcells_dense[contiSolventEqIdx] = extendEval(intQuants.solventInverseFormationVolumeFactor());
         }
 
-        // Pressure drawdown (also used to determine direction of flow)
-        const EvalWell well_pressure = bhp + cdp;
-        const EvalWell drawdown = pressure - well_pressure;
-
-        // producing perforations
-        if ( drawdown.value() > 0 )  {
-            //Do nothing if crossflow is not allowed
-            if (!allow_cf && well_type_ == INJECTOR) {
-                return;
-            }
-
-            // compute component volumetric rates at standard conditions
-            for (int componentIdx = 0; componentIdx < num_components_; ++componentIdx) {
-                const EvalWell cq_p = - Tw * (mob_perfcells_dense[componentIdx] * drawdown);
-                cq_s[componentIdx] = b_perfcells_dense[componentIdx] * cq_p;
-            }
-
-            if (active()[Oil] && active()[Gas]) {
-                const int oilpos = pu.phase_pos[Oil];
-                const int gaspos = pu.phase_pos[Gas];
-                const EvalWell cq_sOil = cq_s[oilpos];
-                const EvalWell cq_sGas = cq_s[gaspos];
-                cq_s[gaspos] += rs * cq_sOil;
-                cq_s[oilpos] += rv * cq_sGas;
-            }
-
-        } else {
-            //Do nothing if crossflow is not allowed
-            if (!allow_cf && well_type_ == PRODUCER) {
-                return;
-            }
-
-            // Using total mobilities
-            EvalWell total_mob_dense = mob_perfcells_dense[0];
-            for (int componentIdx = 1; componentIdx < num_components_; ++componentIdx) {
-                total_mob_dense += mob_perfcells_dense[componentIdx];
-            }
+        computePerfRate(mob_perfcells_dense, b_perfcells_dense, cmix_s, pressure, rs, rv,
+                        Tw, bhp, cdp, allow_cf, cq_s);
+    }
 
-            // injection perforations total volume rates
-            const EvalWell cqt_i = - Tw * (total_mob_dense * drawdown);
 
-            // compute volume ratio between connection at standard conditions
-            EvalWell volumeRatio = 0.0;
-            if (active()[Water]) {
-                const int watpos = pu.phase_pos[Water];
-                volumeRatio += cmix_s[watpos] / b_perfcells_dense[watpos];
-            }
 
-            if (has_solvent) {
-                volumeRatio += cmix_s[contiSolventEqIdx] / b_perfcells_dense[contiSolventEqIdx];
-            }
 
-            if (active()[Oil] && active()[Gas]) {
-                const int oilpos = pu.phase_pos[Oil];
-                const int gaspos = pu.phase_pos[Gas];
 
-                // Incorporate RS/RV factors if both oil and gas active
-                const EvalWell d = 1.0 - rv * rs;
-
-                if (d.value() == 0.0) {
-                    OPM_THROW(Opm::NumericalProblem, "Zero d value obtained for well " << name() << " during flux calcuation"
-                                                  << " with rs " << rs << " and rv " << rv);
-                }
-
-                const EvalWell tmp_oil = (cmix_s[oilpos] - rv * cmix_s[gaspos]) / d;
-                //std::cout << "tmp_oil " <<tmp_oil << std::endl;
-                volumeRatio += tmp_oil / b_perfcells_dense[oilpos];
+    template<typename TypeTag>
+    template<class Value>
+    void
+    StandardWell<TypeTag>::
+    computePerfRate(const std::vector<Value>& mob_perfcells_dense,
+                    const std::vector<Value>& b_perfcells_dense,
+                    const std::vector<Value>& cmix_s,
+                    const Value& pressure, const Value& rs, const Value& rv,
+                    const double Tw, const Value& bhp, const double& cdp,
+                    const bool& allow_cf, std::vector<Value>& cq_s) const
+    {
+        const Opm::PhaseUsage& pu = phaseUsage();
 
-                const EvalWell tmp_gas = (cmix_s[gaspos] - rs * cmix_s[oilpos]) / d;
-                //std::cout << "tmp_gas " <<tmp_gas << std::endl;
-                volumeRatio += tmp_gas / b_perfcells_dense[gaspos];
-            }
-            else {
-                if (active()[Oil]) {
-                    const int oilpos = pu.phase_pos[Oil];
-                    volumeRatio += cmix_s[oilpos] / b_perfcells_dense[oilpos];
-                }
-                if (active()[Gas]) {
-                    const int gaspos = pu.phase_pos[Gas];
-                    volumeRatio += cmix_s[gaspos] / b_perfcells_dense[gaspos];
-                }
-            }
+        standardwellhelpers::PerforationRateLayout layout;
+        layout.num_components = num_components_;
+        layout.water_pos = active()[Water] ? pu.phase_pos[Water] : -1;
+        layout.oil_pos = active()[Oil] ? pu.phase_pos[Oil] : -1;
+        layout.gas_pos = active()[Gas] ? pu.phase_pos[Gas] : -1;
+        layout.solvent_pos = has_solvent ? int(contiSolventEqIdx) : -1;
+        layout.is_producer = (well_type_ == PRODUCER);
 
-            // injecting connections total volumerates at standard conditions
-            EvalWell cqt_is = cqt_i/volumeRatio;
-            //std::cout << "volrat " << volumeRatio << " " << volrat_perf_[perf] << std::endl;
-            for (int componentIdx = 0; componentIdx < num_components_; ++componentIdx) {
-                cq_s[componentIdx] = cmix_s[componentIdx] * cqt_is; // * b_perfcells_dense[phase];
-            }
-        }
+        standardwellhelpers::computePerfRate(layout, name(), mob_perfcells_dense, b_perfcells_dense, cmix_s,
+                                             pressure, rs, rv, Tw, bhp, cdp, allow_cf, cq_s);
     }
 
 
@@ -1531,6 +1471,86 @@ namespace Opm
 
 
 
+    template<typename TypeTag>
+    void
+    StandardWell<TypeTag>::
+    addWellContributions(Mat& mat) const
+    {
+        // mat[cellC][cellB] -= duneC_[cellC]^T * invDuneD_ * duneB_[cellB]
+        const auto& invD = invDuneD_[0][0];
+        const auto endC = duneC_[0].end();
+        for (auto colC = duneC_[0].begin(); colC != endC; ++colC) {
+            const auto& C = *colC;
+
+            // CtInvD = duneC_[cellC]^T * invDuneD_
+            Dune::FieldMatrix<Scalar, numEq, numWellEq> CtInvD(0.0);
+            for (int i = 0; i < numEq; ++i) {
+                for (int j = 0; j < numWellEq; ++j) {
+                    for (int k = 0; k < numWellEq; ++k) {
+                        CtInvD[i][j] += C[k][i] * invD[k][j];
+                    }
+                }
+            }
+
+            auto& row = mat[colC.index()];
+            const auto endB = duneB_[0].end();
+            for (auto colB = duneB_[0].begin(); colB != endB; ++colB) {
+                const auto& B = *colB;
+                auto& block = row[colB.index()];
+                for (int i = 0; i < numEq; ++i) {
+                    for (int j = 0; j < numEq; ++j) {
+                        for (int k = 0; k < numWellEq; ++k) {
+                            block[i][j] -= CtInvD[i][k] * B[k][j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    bool
+    StandardWell<TypeTag>::
+    captureLinearSystem(LinearSystemWell& well) const
+    {
+        well.name = name();
+        well.numWellEq = numWellEq;
+        well.numEq = numEq;
+
+        auto copyBlocks = [](const OffDiagMatWell& mat, std::vector<int>& cells, std::vector<double>& values) {
+            cells.clear();
+            values.clear();
+            const auto endj = mat[0].end();
+            for (auto col = mat[0].begin(); col != endj; ++col) {
+                cells.push_back(col.index());
+                for (int i = 0; i < numWellEq; ++i) {
+                    for (int j = 0; j < numEq; ++j) {
+                        values.push_back((*col)[i][j]);
+                    }
+                }
+            }
+        };
+        copyBlocks(duneB_, well.cellsB, well.B);
+        copyBlocks(duneC_, well.cellsC, well.C);
+
+        const auto& invD = invDuneD_[0][0];
+        well.invD.clear();
+        for (int i = 0; i < numWellEq; ++i) {
+            for (int j = 0; j < numWellEq; ++j) {
+                well.invD.push_back(invD[i][j]);
+            }
+        }
+        return true;
+    }
+
+
+
+
+
     template<typename TypeTag>
     void
     StandardWell<TypeTag>::
@@ -1565,27 +1585,46 @@ namespace Opm
     template<typename TypeTag>
     void
     StandardWell<TypeTag>::
-    computeWellRatesWithBhp(const Simulator& ebosSimulator,
-                            const EvalWell& bhp,
-                            std::vector<double>& well_flux) const
+    computePerforationValues(const Simulator& ebosSimulator,
+                             PerforationValues& values) const
     {
         const int np = number_of_phases_;
-        well_flux.resize(np, 0.0);
+        const int nperf = number_of_perforations_;
 
-        const bool allow_cf = crossFlowAllowed(ebosSimulator);
+        values.mob.assign(nperf, std::vector<double>(num_components_, 0.0));
+        values.b.assign(nperf, std::vector<double>(num_components_, 0.0));
+        values.pressure.assign(nperf, 0.0);
+        values.rs.assign(nperf, 0.0);
+        values.rv.assign(nperf, 0.0);
+        values.cmix.assign(num_components_, 0.0);
+        values.allow_cf = crossFlowAllowed(ebosSimulator);
 
-        for (int perf = 0; perf < number_of_perforations_; ++perf) {
+        for (int componentIdx = 0; componentIdx < num_components_; ++componentIdx) {
+            values.cmix[componentIdx] = wellSurfaceVolumeFraction(componentIdx).value();
+        }
+
+        std::vector<EvalWell> mob(num_components_, 0.0);
+        for (int perf = 0; perf < nperf; ++perf) {
             const int cell_idx = well_cells_[perf];
             const auto& intQuants = *(ebosSimulator.model().cachedIntensiveQuantities(cell_idx, /*timeIdx=*/ 0));
-            // flux for each perforation
-            std::vector<EvalWell> cq_s(num_components_, 0.0);
-            std::vector<EvalWell> mob(num_components_, 0.0);
+            const auto& fs = intQuants.fluidState();
+
             getMobility(ebosSimulator, perf, mob);
-            computePerfRate(intQuants, mob, well_index_[perf], bhp, perf_pressure_diffs_[perf], allow_cf, cq_s);
+            for (int componentIdx = 0; componentIdx < num_components_; ++componentIdx) {
+                values.mob[perf][componentIdx] = mob[componentIdx].value();
+            }
 
-            for(int p = 0; p < np; ++p) {
-                well_flux[p] += cq_s[p].value();
+            for (int phase = 0; phase < np; ++phase) {
+                const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phase);
+                values.b[perf][phase] = fs.invB(ebosPhaseIdx).value();
             }
+            if (has_solvent) {
+                values.b[perf][contiSolventEqIdx] = intQuants.solventInverseFormationVolumeFactor().value();
+            }
+
+            values.pressure[perf] = fs.pressure(FluidSystem::oilPhaseIdx).value();
+            values.rs[perf] = fs.Rs().value();
+            values.rv[perf] = fs.Rv().value();
         }
     }
 
@@ -1594,95 +1633,114 @@ namespace Opm
 
 
     template<typename TypeTag>
-    std::vector<double>
+    void
     StandardWell<TypeTag>::
-    computeWellPotentialWithTHP(const Simulator& ebosSimulator,
-                                const double initial_bhp, // bhp from BHP constraints
-                                const std::vector<double>& initial_potential) const
+    computeWellRatesWithBhp(const PerforationValues& values,
+                            const double bhp,
+                            std::vector<double>& well_flux) const
     {
-        // TODO: pay attention to the situation that finally the potential is calculated based on the bhp control
-        // TODO: should we consider the bhp constraints during the iterative process?
         const int np = number_of_phases_;
+        well_flux.assign(np, 0.0);
 
-        assert( np == int(initial_potential.size()) );
+        std::vector<double> cq_s(num_components_, 0.0);
+        for (int perf = 0; perf < number_of_perforations_; ++perf) {
+            // flux for each perforation
+            std::fill(cq_s.begin(), cq_s.end(), 0.0);
+            computePerfRate(values.mob[perf], values.b[perf], values.cmix,
+                            values.pressure[perf], values.rs[perf], values.rv[perf],
+                            well_index_[perf], bhp, perf_pressure_diffs_[perf], values.allow_cf, cq_s);
 
-        std::vector<double> potentials = initial_potential;
-        std::vector<double> old_potentials = potentials; // keeping track of the old potentials
+            for(int p = 0; p < np; ++p) {
+                well_flux[p] += cq_s[p];
+            }
+        }
+    }
 
-        double bhp = initial_bhp;
-        double old_bhp = bhp;
 
-        bool converged = false;
-        const int max_iteration = 1000;
-        const double bhp_tolerance = 1000.; // 1000 pascal
 
-        int iteration = 0;
 
-        while ( !converged && iteration < max_iteration ) {
-            // for each iteration, we calculate the bhp based on the rates/potentials with thp constraints
-            // with considering the bhp value from the bhp limits. At the beginning of each iteration,
-            // we initialize the bhp to be the bhp value from the bhp limits. Then based on the bhp values calculated
-            // from the thp constraints, we decide the effective bhp value for well potential calculation.
-            bhp = initial_bhp;
 
-            // The number of the well controls/constraints
-            const int nwc = well_controls_get_num(well_controls_);
+    template<typename TypeTag>
+    double
+    StandardWell<TypeTag>::
+    bhpFromThpConstraints(const std::vector<double>& rates,
+                          const double bhp_limit) const
+    {
+        const Opm::PhaseUsage& pu = phaseUsage();
 
-            for (int ctrl_index = 0; ctrl_index < nwc; ++ctrl_index) {
-                if (well_controls_iget_type(well_controls_, ctrl_index) == THP) {
-                    const Opm::PhaseUsage& pu = phaseUsage();
+        std::vector<double> vfp_rates(3, 0.0);
+        if (active()[ Water ]) {
+            vfp_rates[ Water ] = rates[pu.phase_pos[ Water ] ];
+        }
+        if (active()[ Oil ]) {
+            vfp_rates[ Oil ] = rates[pu.phase_pos[ Oil ] ];
+        }
+        if (active()[ Gas ]) {
+            vfp_rates[ Gas ] = rates[pu.phase_pos[ Gas ] ];
+        }
 
-                    std::vector<double> rates(3, 0.0);
-                    if (active()[ Water ]) {
-                        rates[ Water ] = potentials[pu.phase_pos[ Water ] ];
-                    }
-                    if (active()[ Oil ]) {
-                        rates[ Oil ] = potentials[pu.phase_pos[ Oil ] ];
-                    }
-                    if (active()[ Gas ]) {
-                        rates[ Gas ] = potentials[pu.phase_pos[ Gas ] ];
-                    }
+        double bhp = bhp_limit;
 
-                    const double bhp_calculated = calculateBhpFromThp(rates, ctrl_index);
+        // The number of the well controls/constraints
+        const int nwc = well_controls_get_num(well_controls_);
 
-                    if (well_type_ == INJECTOR && bhp_calculated < bhp ) {
-                        bhp = bhp_calculated;
-                    }
+        for (int ctrl_index = 0; ctrl_index < nwc; ++ctrl_index) {
+            if (well_controls_iget_type(well_controls_, ctrl_index) == THP) {
+                const double bhp_calculated = calculateBhpFromThp(vfp_rates, ctrl_index);
 
-                    if (well_type_ == PRODUCER && bhp_calculated > bhp) {
-                        bhp = bhp_calculated;
-                    }
+                if (well_type_ == INJECTOR && bhp_calculated < bhp ) {
+                    bhp = bhp_calculated;
                 }
-            }
 
-            // there should be always some available bhp/thp constraints there
-            if (std::isinf(bhp) || std::isnan(bhp)) {
-                OPM_THROW(std::runtime_error, "Unvalid bhp value obtained during the potential calculation for well " << name());
+                if (well_type_ == PRODUCER && bhp_calculated > bhp) {
+                    bhp = bhp_calculated;
+                }
             }
+        }
 
-            converged = std::abs(old_bhp - bhp) < bhp_tolerance;
+        // there should be always some available bhp/thp constraints there
+        if (std::isinf(bhp) || std::isnan(bhp)) {
+            OPM_THROW(std::runtime_error, "Unvalid bhp value obtained during the potential calculation for well " << name());
+        }
 
-            computeWellRatesWithBhp(ebosSimulator, bhp, potentials);
+        return bhp;
+    }
 
-            // checking whether the potentials have valid values
-            for (const double value : potentials) {
-                if (std::isinf(value) || std::isnan(value)) {
-                    OPM_THROW(std::runtime_error, "Unvalid potential value obtained during the potential calculation for well " << name());
-                }
-            }
 
-            if (!converged) {
-                old_bhp = bhp;
-                for (int p = 0; p < np; ++p) {
-                    // TODO: improve the interpolation, will it always be valid with the way below?
-                    // TODO: finding better paramters, better iteration strategy for better convergence rate.
-                    const double potential_update_damping_factor = 0.001;
-                    potentials[p] = potential_update_damping_factor * potentials[p] + (1.0 - potential_update_damping_factor) * old_potentials[p];
-                    old_potentials[p] = potentials[p];
-                }
-            }
 
-            ++iteration;
+
+
+    template<typename TypeTag>
+    std::vector<double>
+    StandardWell<TypeTag>::
+    computeWellPotentialWithTHP(const PerforationValues& values,
+                                const double initial_bhp, // bhp from BHP constraints
+                                const std::vector<double>& initial_potential) const
+    {
+        // the bhp where none of the perforations is flowing in the direction of the well
+        double no_flow_bhp = values.pressure[0] - perf_pressure_diffs_[0];
+        for (int perf = 1; perf < number_of_perforations_; ++perf) {
+            const double perf_no_flow_bhp = values.pressure[perf] - perf_pressure_diffs_[perf];
+            no_flow_bhp = (well_type_ == PRODUCER) ? std::max(no_flow_bhp, perf_no_flow_bhp)
+                                                   : std::min(no_flow_bhp, perf_no_flow_bhp);
+        }
+
+        auto computeRates = [&](const double bhp, std::vector<double>& rates) {
+            computeWellRatesWithBhp(values, bhp, rates);
+        };
+        auto bhpFromThp = [&](const std::vector<double>& rates) {
+            return bhpFromThpConstraints(rates, initial_bhp);
+        };
+
+        std::vector<double> potentials;
+        const bool converged = standardwellhelpers::computeWellPotentialWithTHP(computeRates, bhpFromThp, initial_bhp, no_flow_bhp,
+                                                                                initial_potential, potentials);
+
+        // checking whether the potentials have valid values
+        for (const double value : potentials) {
+            if (std::isinf(value) || std::isnan(value)) {
+                OPM_THROW(std::runtime_error, "Unvalid potential value obtained during the potential calculation for well " << name());
+            }
         }
 
         if (!converged) {
@@ -1706,10 +1764,14 @@ namespace Opm
         updatePrimaryVariables(well_state);
         computeWellConnectionPressures(ebosSimulator, well_state);
 
-        // initialize the primary variables in Evaluation, which is used in computePerfRate for computeWellPotentials
-        // TODO: for computeWellPotentials, no derivative is required actually
+        // initialize the primary variables in Evaluation, which is used in crossFlowAllowed
         initPrimaryVariablesEvaluation();
 
+        // the quantities of the perforations do not depend on the bhp, the rates
+        // for the different bhp values are computed from them without derivatives
+        PerforationValues values;
+        computePerforationValues(ebosSimulator, values);
+
         const int np = number_of_phases_;
         well_potentials.resize(np, 0.0);
 
@@ -1720,7 +1782,7 @@ namespace Opm
         if ( !wellHasTHPConstraints() ) {
             assert(std::abs(bhp) != std::numeric_limits<double>::max());
 
-            computeWellRatesWithBhp(ebosSimulator, bhp, well_potentials);
+            computeWellRatesWithBhp(values, bhp, well_potentials);
         } else {
             // the well has a THP related constraint
             // checking whether a well is newly added, it only happens at the beginning of the report step
@@ -1732,7 +1794,7 @@ namespace Opm
                 }
             } else {
                 // We need to generate a reasonable rates to start the iteration process
-                computeWellRatesWithBhp(ebosSimulator, bhp, well_potentials);
+                computeWellRatesWithBhp(values, bhp, well_potentials);
                 for (double& value : well_potentials) {
                     // make the value a little safer in case the BHP limits are default ones
                     // TODO: a better way should be a better rescaling based on the investigation of the VFP table.
@@ -1741,7 +1803,7 @@ namespace Opm
                 }
             }
 
-            well_potentials = computeWellPotentialWithTHP(ebosSimulator, bhp, well_potentials);
+            well_potentials = computeWellPotentialWithTHP(values, bhp, well_potentials);
         }
     }
 
@@ -1870,14 +1932,14 @@ namespace Opm
 
             const double dp = wellhelpers::computeHydrostaticCorrection(ref_depth_, vfp_ref_depth, rho, gravity_);
 
-            bhp = vfp_properties_->getInj()->bhp(vfp, aqua, liquid, vapour, thp) - dp;
+            bhp = vfp_properties_->getInj()->bhp(vfp, aqua, liquid, vapour, thp, vfp_hint_) - dp;
          }
          else if (well_type_ == PRODUCER) {
              const double vfp_ref_depth = vfp_properties_->getProd()->getTable(vfp)->getDatumDepth();
 
              const double dp = wellhelpers::computeHydrostaticCorrection(ref_depth_, vfp_ref_depth, rho, gravity_);
 
-             bhp = vfp_properties_->getProd()->bhp(vfp, aqua, liquid, vapour, thp, alq) - dp;
+             bhp = vfp_properties_->getProd()->bhp(vfp, aqua, liquid, vapour, thp, alq, vfp_hint_) - dp;
          }
          else {
              OPM_THROW(std::logic_error, "Expected INJECTOR or PRODUCER well");
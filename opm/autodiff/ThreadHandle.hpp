@@ -3,10 +3,17 @@
 
 #include <cassert>
 #include <dune/common/exceptions.hh>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/OpmLog/OpmLog.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <queue>
+#include <string>
 
 namespace Opm
 {
@@ -49,77 +56,105 @@ namespace Opm
     protected:
       std::queue< std::unique_ptr< ObjectInterface > > objQueue_;
       std::mutex  mutex_;
+      // signaled when an object was inserted
+      std::condition_variable notEmpty_;
+      // signaled when an object was removed
+      std::condition_variable notFull_;
+      // max number of objects waiting to be executed
+      const size_t maxQueueSize_;
+      // first exception thrown by an executed object
+      std::exception_ptr exception_;
 
       // no copying
       ThreadHandleQueue( const ThreadHandleQueue& ) = delete;
 
-      // wait duration of 10 milli seconds
-      void wait() const
+    public:
+      //! constructor creating object that is executed by thread
+      //! \param maxQueueSize  number of objects that may wait for execution
+      //!                      before push_back blocks
+      explicit ThreadHandleQueue( const size_t maxQueueSize )
+        : objQueue_(), mutex_(), notEmpty_(), notFull_(),
+          maxQueueSize_( std::max( maxQueueSize, size_t(1) ) ),
+          exception_()
       {
-          std::this_thread::sleep_for( std::chrono::milliseconds(10) );
       }
 
-    public:
-      //! constructor creating object that is executed by thread
-      ThreadHandleQueue()
-        : objQueue_(), mutex_()
+      //! insert object into threads queue, blocks while the queue is full
+      void push_back( std::unique_ptr< ObjectInterface >&& obj )
       {
+        {
+          std::unique_lock< std::mutex > lock( mutex_ );
+          // the end marker is always accepted to avoid dead locks on termination
+          if( ! obj->isEndMarker() ) {
+            notFull_.wait( lock, [this] { return objQueue_.size() < maxQueueSize_; } );
+          }
+          objQueue_.emplace( std::move(obj) );
+        }
+        notEmpty_.notify_one();
       }
 
-      ~ThreadHandleQueue()
+      //! rethrow the first exception thrown by an executed object, if any
+      void rethrowException()
       {
-        // wait until all objects have been written.
-        while( ! objQueue_.empty() )
+        std::exception_ptr exception;
         {
-            wait();
+          std::lock_guard< std::mutex > lock( mutex_ );
+          std::swap( exception, exception_ );
+        }
+        if( exception ) {
+          std::rethrow_exception( exception );
         }
       }
 
-      //! insert object into threads queue
-      void push_back( std::unique_ptr< ObjectInterface >&& obj )
+      //! log the first exception thrown by an executed object, if any,
+      //! where it can not be rethrown
+      void logException()
       {
-        // lock mutex to make sure objPtr is not used
-        mutex_.lock();
-        objQueue_.emplace( std::move(obj) );
-        mutex_.unlock();
+        try {
+          rethrowException();
+        }
+        catch( const std::exception& e ) {
+          OpmLog::error("Error in the output thread: " + std::string( e.what() ));
+        }
+        catch( ... ) {
+          OpmLog::error("Unknown error in the output thread");
+        }
       }
 
       //! do the work until the queue received an end object
       void run()
       {
-        // wait until objects have been pushed to the queue
-        while( objQueue_.empty() )
-        {
-          // sleep one second
-          wait();
-        }
-
+        while( true )
         {
-            // lock mutex for access to objQueue_
-            mutex_.lock();
+          std::unique_ptr< ObjectInterface > obj;
+          {
+            // wait until objects have been pushed to the queue
+            std::unique_lock< std::mutex > lock( mutex_ );
+            notEmpty_.wait( lock, [this] { return ! objQueue_.empty(); } );
 
             // get next object from queue
-            std::unique_ptr< ObjectInterface > obj( objQueue_.front().release() );
-            // remove object from queue
+            obj = std::move( objQueue_.front() );
             objQueue_.pop();
 
-            // unlock mutex for access to objQueue_
-            mutex_.unlock();
-
             // if object is end marker terminate thread
-            if( obj->isEndMarker() ){
-                if( ! objQueue_.empty() ) {
-                    OPM_THROW(std::logic_error,"ThreadHandleQueue: not all queued objects were executed");
-                }
-                return;
+            if( obj->isEndMarker() ) {
+              assert( objQueue_.empty() );
+              return;
             }
+          }
+          notFull_.notify_one();
 
-            // execute object action
+          // execute object action, errors are reported to the dispatching thread
+          try {
             obj->run();
+          }
+          catch( ... ) {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            if( ! exception_ ) {
+              exception_ = std::current_exception();
+            }
+          }
         }
-
-        // keep thread running
-        run();
       }
     }; // end ThreadHandleQueue
 
@@ -142,16 +177,17 @@ namespace Opm
 
   public:
     //! constructor creating ThreadHandle
-    //! \param isIORank  if true thread is created
-    ThreadHandle( const bool createThread )
-      : threadObjectQueue_(),
+    //! \param isIORank      if true thread is created
+    //! \param maxQueueSize  number of objects that may wait for execution
+    //!                      before dispatch blocks, this bounds the memory
+    //!                      used when the thread is slower than the producer
+    ThreadHandle( const bool createThread, const size_t maxQueueSize = 4 )
+      : threadObjectQueue_( maxQueueSize ),
         thread_()
     {
         if( createThread )
         {
            thread_.reset( new std::thread( startThread, &threadObjectQueue_ ) );
-           // detach thread into nirvana
-           thread_->detach();
         }
     } // end constructor
 
@@ -161,6 +197,9 @@ namespace Opm
     {
         if( thread_ )
         {
+            // report errors of previously dispatched objects
+            threadObjectQueue_.rethrowException();
+
             typedef ObjectWrapper< Object >  ObjectPointer;
             ObjectInterface* objPtr = new ObjectPointer( std::move(obj) );
 
@@ -173,13 +212,18 @@ namespace Opm
         }
     }
 
-    //! destructor terminating the thread
+    //! destructor terminating the thread after all objects have been executed
     ~ThreadHandle()
     {
         if( thread_ )
         {
             // dispatch end object which will terminate the thread
             threadObjectQueue_.push_back( std::unique_ptr< ObjectInterface > (new EndObject()) ) ;
+            thread_->join();
+
+            // the destructor can not rethrow the errors of the last objects,
+            // which are only known once they have been executed
+            threadObjectQueue_.logException();
         }
     }
   };
@@ -0,0 +1,297 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <opm/autodiff/TimerRegistry.hpp>
+
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace Opm
+{
+
+namespace
+{
+    // Separates the names of the timers in the paths, it sorts before all
+    // printable characters such that sorted paths list the children of a
+    // timer right after it.
+    const char pathSeparator = '\x1f';
+
+    // the total calls and seconds of the timers of all threads of this rank, by path
+    typedef std::map<std::string, std::pair<double, double> > TimerTotals;
+
+    std::string escapeJson(const std::string& s)
+    {
+        std::string escaped;
+        for (const char c : s) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+} // anonymous namespace
+
+
+
+TimerRegistry& TimerRegistry::instance()
+{
+    static TimerRegistry registry;
+    return registry;
+}
+
+
+
+TimerRegistry::TimerRegistry()
+    : enabled_(false)
+    , maxTraceEvents_(0)
+    , epoch_(Clock::now())
+{
+}
+
+
+
+void TimerRegistry::enable(const std::size_t maxTraceEvents)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxTraceEvents_ = maxTraceEvents;
+    epoch_ = Clock::now();
+    enabled_.store(true);
+}
+
+
+
+TimerRegistry::ThreadData& TimerRegistry::threadData()
+{
+    // the data of each thread is only touched by the thread itself while recording
+    thread_local ThreadData* data = nullptr;
+    if (!data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.emplace_back(new ThreadData());
+        data = threads_.back().get();
+        data->index = threads_.size() - 1;
+        data->current = -1;
+        data->droppedEvents = 0;
+    }
+    return *data;
+}
+
+
+
+int TimerRegistry::start(const char* name)
+{
+    ThreadData& data = threadData();
+
+    // the timers within a parent are few, a linear search is fastest
+    int node = -1;
+    if (data.current >= 0) {
+        for (const int child : data.nodes[data.current].children) {
+            if (std::strcmp(data.nodes[child].name.c_str(), name) == 0) {
+                node = child;
+                break;
+            }
+        }
+    }
+    else {
+        for (std::size_t n = 0; n < data.nodes.size(); ++n) {
+            if (data.nodes[n].parent < 0 && std::strcmp(data.nodes[n].name.c_str(), name) == 0) {
+                node = n;
+                break;
+            }
+        }
+    }
+
+    if (node < 0) {
+        node = data.nodes.size();
+        data.nodes.push_back(Node{ name, data.current, std::vector<int>(), 0, 0.0 });
+        if (data.current >= 0) {
+            data.nodes[data.current].children.push_back(node);
+        }
+    }
+
+    data.current = node;
+    return node;
+}
+
+
+
+void TimerRegistry::stop(const int node, const Clock::time_point& startTime)
+{
+    const Clock::time_point stopTime = Clock::now();
+    ThreadData& data = threadData();
+    const double seconds = std::chrono::duration<double>(stopTime - startTime).count();
+
+    Node& n = data.nodes[node];
+    ++n.calls;
+    n.seconds += seconds;
+    data.current = n.parent;
+
+    if (data.events.size() < maxTraceEvents_) {
+        const double start = std::chrono::duration<double>(startTime - epoch_).count();
+        data.events.push_back(TraceEvent{ node, start, seconds });
+    }
+    else if (maxTraceEvents_ > 0) {
+        ++data.droppedEvents;
+    }
+}
+
+
+
+std::string TimerRegistry::path(const ThreadData& data, int node)
+{
+    std::string result = data.nodes[node].name;
+    for (node = data.nodes[node].parent; node >= 0; node = data.nodes[node].parent) {
+        result = data.nodes[node].name + pathSeparator + result;
+    }
+    return result;
+}
+
+
+
+void TimerRegistry::report(std::ostream& os, const Communication& cc) const
+{
+    TimerTotals totals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& data : threads_) {
+            for (std::size_t n = 0; n < data->nodes.size(); ++n) {
+                auto& total = totals[path(*data, n)];
+                total.first += data->nodes[n].calls;
+                total.second += data->nodes[n].seconds;
+            }
+        }
+    }
+
+    // the union of the timers of all ranks, in the same order on all ranks
+    std::set<std::string> paths;
+    for (const auto& total : totals) {
+        paths.insert(total.first);
+    }
+    if (cc.size() > 1) {
+        std::vector<char> local;
+        for (const auto& total : totals) {
+            local.insert(local.end(), total.first.begin(), total.first.end());
+            local.push_back('\n');
+        }
+        int length = local.size();
+        std::vector<int> lengths(cc.size());
+        cc.allgather(&length, 1, lengths.data());
+        std::vector<int> displ(cc.size() + 1, 0);
+        std::partial_sum(lengths.begin(), lengths.end(), displ.begin() + 1);
+        std::vector<char> all(std::max(displ.back(), 1));
+        cc.allgatherv(local.data(), length, all.data(), lengths.data(), displ.data());
+
+        std::istringstream is(std::string(all.data(), displ.back()));
+        std::string timer;
+        while (std::getline(is, timer)) {
+            paths.insert(timer);
+        }
+    }
+
+    const int numTimers = paths.size();
+    std::vector<double> calls(numTimers, 0.0), minimum(numTimers, 0.0);
+    int i = 0;
+    for (const auto& timer : paths) {
+        const auto total = totals.find(timer);
+        if (total != totals.end()) {
+            calls[i] = total->second.first;
+            minimum[i] = total->second.second;
+        }
+        ++i;
+    }
+    std::vector<double> maximum(minimum), sum(minimum);
+    if (numTimers > 0) {
+        cc.sum(calls.data(), numTimers);
+        cc.min(minimum.data(), numTimers);
+        cc.max(maximum.data(), numTimers);
+        cc.sum(sum.data(), numTimers);
+    }
+
+    if (cc.rank() != 0) {
+        return;
+    }
+
+    os << std::left << std::setw(44) << "Timer" << std::right
+       << std::setw(10) << "calls" << std::setw(13) << "min [s]" << std::setw(13) << "avg [s]"
+       << std::setw(13) << "max [s]" << std::setw(10) << "max/avg" << "\n";
+    i = 0;
+    for (const auto& timer : paths) {
+        const int depth = std::count(timer.begin(), timer.end(), pathSeparator);
+        const std::string name = std::string(2 * depth, ' ') + timer.substr(timer.rfind(pathSeparator) + 1);
+        const double average = sum[i] / cc.size();
+        os << std::left << std::setw(44) << name << std::right << std::fixed
+           << std::setw(10) << std::setprecision(0) << calls[i] / cc.size() << std::setprecision(3)
+           << std::setw(13) << minimum[i] << std::setw(13) << average << std::setw(13) << maximum[i]
+           << std::setw(10) << std::setprecision(2) << (average > 0.0 ? maximum[i] / average : 1.0) << "\n";
+        ++i;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+
+
+void TimerRegistry::writeTrace(const std::string& filename, const Communication& cc) const
+{
+    std::string file = filename;
+    if (cc.size() > 1) {
+        const std::size_t dot = file.rfind('.');
+        const std::string rank = "." + std::to_string(cc.rank());
+        if (dot == std::string::npos || file.find('/', dot) != std::string::npos) {
+            file += rank;
+        } else {
+            file.insert(dot, rank);
+        }
+    }
+
+    std::ofstream os(file);
+    if (!os) {
+        OPM_THROW(std::runtime_error, "Could not open the timer trace file " << file);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << cc.rank()
+       << ",\"args\":{\"name\":\"rank " << cc.rank() << "\"}}";
+    os << std::fixed << std::setprecision(3);
+    std::size_t dropped = 0;
+    for (const auto& data : threads_) {
+        for (const TraceEvent& event : data->events) {
+            // the trace event format expects microseconds
+            os << ",\n{\"name\":\"" << escapeJson(data->nodes[event.node].name)
+               << "\",\"ph\":\"X\",\"pid\":" << cc.rank() << ",\"tid\":" << data->index
+               << ",\"ts\":" << 1.0e6 * event.start << ",\"dur\":" << 1.0e6 * event.duration << "}";
+        }
+        dropped += data->droppedEvents;
+    }
+    os << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+}
+
+} // namespace Opm
@@ -0,0 +1,171 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_TIMERREGISTRY_HEADER_INCLUDED
+#define OPM_TIMERREGISTRY_HEADER_INCLUDED
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// \brief Registry of the hierarchical timers of a run.
+    ///
+    /// The timers are started and stopped by ScopedTimer objects, a timer
+    /// started while another timer of the same thread is running becomes its
+    /// child. Each thread records into a tree of its own, without locking,
+    /// timers of threads other than the main thread are reported at the top
+    /// level. At the end of a run report() gives the minimum, average and
+    /// maximum time of each timer over the MPI ranks, and writeTrace() writes
+    /// the individual timer intervals in the trace event format of Chrome
+    /// (chrome://tracing), which shows the timelines of all threads.
+    ///
+    /// Nothing is recorded until the registry is enabled.
+    class TimerRegistry
+    {
+    public:
+        /// \brief The type of the collective communication used.
+        typedef Dune::CollectiveCommunication<typename Dune::MPIHelper::MPICommunicator>
+        Communication;
+
+        typedef std::chrono::steady_clock Clock;
+
+        /// \brief The registry of the process.
+        static TimerRegistry& instance();
+
+        /// \brief Start recording, the times of the trace are relative to this call.
+        /// \param maxTraceEvents The number of timer intervals kept for the trace per
+        ///                       thread, the intervals beyond are dropped. Zero
+        ///                       disables the trace.
+        void enable(const std::size_t maxTraceEvents = 0);
+
+        /// \brief Whether the timers are recorded.
+        bool enabled() const
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        /// \brief Start a timer of the calling thread.
+        /// \return The index of the timer, to be passed to stop().
+        int start(const char* name);
+
+        /// \brief Stop the timer of the calling thread started at the given time.
+        void stop(const int node, const Clock::time_point& startTime);
+
+        /// \brief Write the calls and the minimum, average and maximum time of the
+        ///        timers over the ranks of cc to os on rank 0.
+        ///
+        /// This is a collective operation.
+        void report(std::ostream& os,
+                    const Communication& cc = Dune::MPIHelper::getCollectiveCommunication()) const;
+
+        /// \brief Write the trace of the timers of this rank in the trace event format.
+        ///
+        /// In parallel runs each rank writes a file of its own, the rank is
+        /// inserted before the extension of the file name.
+        void writeTrace(const std::string& filename,
+                        const Communication& cc = Dune::MPIHelper::getCollectiveCommunication()) const;
+
+    private:
+        struct Node
+        {
+            std::string name;
+            int parent;
+            std::vector<int> children;
+            std::size_t calls;
+            double seconds;
+        };
+
+        struct TraceEvent
+        {
+            int node;
+            double start;    // seconds since enable()
+            double duration;
+        };
+
+        struct ThreadData
+        {
+            int index;
+            int current;     // the running timer, -1 at the top level
+            std::vector<Node> nodes;
+            std::vector<TraceEvent> events;
+            std::size_t droppedEvents;
+        };
+
+        TimerRegistry();
+
+        ThreadData& threadData();
+
+        // the path of the node from the top level
+        static std::string path(const ThreadData& data, int node);
+
+        std::atomic<bool> enabled_;
+        std::size_t maxTraceEvents_;
+        Clock::time_point epoch_;
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<ThreadData> > threads_;
+    };
+
+
+
+    /// \brief A timer of the TimerRegistry running for the lifetime of the object.
+    ///
+    /// The name should identify the code region among the other timers started
+    /// within the same parent, e.g. "assembly" or "preconditioner_setup".
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(const char* name)
+            : node_(-1)
+        {
+            TimerRegistry& registry = TimerRegistry::instance();
+            if (registry.enabled()) {
+                node_ = registry.start(name);
+                start_ = TimerRegistry::Clock::now();
+            }
+        }
+
+        ~ScopedTimer()
+        {
+            if (node_ >= 0) {
+                TimerRegistry::instance().stop(node_, start_);
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        int node_;
+        TimerRegistry::Clock::time_point start_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_TIMERREGISTRY_HEADER_INCLUDED
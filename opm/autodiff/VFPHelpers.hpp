@@ -28,6 +28,10 @@
 #include <opm/material/densead/Math.hpp>
 #include <opm/material/densead/Evaluation.hpp>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 /**
  * This file contains a set of helper functions used by VFPProd / VFPInj.
  */
@@ -201,13 +205,31 @@ struct InterpData {
 
 
 
+/**
+ * Indices of the intervals used in the last interpolation in a VFP table,
+ * one per axis. Since the well rates and pressures change little between
+ * two evaluations for the same well, these are good starting points for
+ * the search of the next evaluation.
+ */
+struct VFPInterpHint {
+    VFPInterpHint() : flo(0), thp(0), wfr(0), gfr(0), alq(0) {}
+    int flo;
+    int thp;
+    int wfr;
+    int gfr;
+    int alq;
+};
+
 /**
  * Helper function to find indices etc. for linear interpolation and extrapolation
  *  @param value Value to find in values
  *  @param values Sorted list of values to search for value in.
+ *  @param hint Index of the interval used for the last value. The interval
+ *              is checked first, and a binary search is only done if the value
+ *              is outside it. On return it holds the interval found.
  *  @return Data required to find the interpolated value
  */
-inline InterpData findInterpData(const double& value, const std::vector<double>& values) {
+inline InterpData findInterpData(const double& value, const std::vector<double>& values, int& hint) {
     InterpData retval;
 
     const int nvalues = values.size();
@@ -232,15 +254,18 @@ inline InterpData findInterpData(const double& value, const std::vector<double>&
             retval.ind_[1] = nvalues-1;
         }
         else {
-            //Search internal intervals
-            for (int i=1; i<nvalues; ++i) {
-                if (values[i] >= value) {
-                    retval.ind_[0] = i-1;
-                    retval.ind_[1] = i;
-                    break;
-                }
+            //Search internal intervals for the first element greater than or
+            //equal to value, starting with the interval of the last search
+            int i = hint + 1;
+            const bool hint_valid = i >= 1 && i < nvalues
+                && values[i] >= value && (i == 1 || values[i-1] < value);
+            if (!hint_valid) {
+                i = std::lower_bound(values.begin() + 1, values.end(), value) - values.begin();
             }
+            retval.ind_[0] = i-1;
+            retval.ind_[1] = i;
         }
+        hint = retval.ind_[0];
 
         const double start = values[retval.ind_[0]];
         const double end   = values[retval.ind_[1]];
@@ -261,6 +286,17 @@ inline InterpData findInterpData(const double& value, const std::vector<double>&
     return retval;
 }
 
+/**
+ * Helper function to find indices etc. for linear interpolation and extrapolation
+ *  @param value Value to find in values
+ *  @param values Sorted list of values to search for value in.
+ *  @return Data required to find the interpolated value
+ */
+inline InterpData findInterpData(const double& value, const std::vector<double>& values) {
+    int hint = 0;
+    return findInterpData(value, values, hint);
+}
+
 
 
 
@@ -518,7 +554,8 @@ inline VFPEvaluation bhp(const VFPProdTable* table,
         const double& liquid,
         const double& vapour,
         const double& thp,
-        const double& alq) {
+        const double& alq,
+        VFPInterpHint& hint) {
     //Find interpolation variables
     double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
     double wfr = detail::getWFR(aqua, liquid, vapour, table->getWFRType());
@@ -526,11 +563,11 @@ inline VFPEvaluation bhp(const VFPProdTable* table,
 
     //First, find the values to interpolate between
     //Recall that flo is negative in Opm, so switch sign.
-    auto flo_i = detail::findInterpData(-flo, table->getFloAxis());
-    auto thp_i = detail::findInterpData( thp, table->getTHPAxis());
-    auto wfr_i = detail::findInterpData( wfr, table->getWFRAxis());
-    auto gfr_i = detail::findInterpData( gfr, table->getGFRAxis());
-    auto alq_i = detail::findInterpData( alq, table->getALQAxis());
+    auto flo_i = detail::findInterpData(-flo, table->getFloAxis(), hint.flo);
+    auto thp_i = detail::findInterpData( thp, table->getTHPAxis(), hint.thp);
+    auto wfr_i = detail::findInterpData( wfr, table->getWFRAxis(), hint.wfr);
+    auto gfr_i = detail::findInterpData( gfr, table->getGFRAxis(), hint.gfr);
+    auto alq_i = detail::findInterpData( alq, table->getALQAxis(), hint.alq);
 
     detail::VFPEvaluation retval = detail::interpolate(table->getTable(), flo_i, thp_i, wfr_i, gfr_i, alq_i);
 
@@ -539,19 +576,32 @@ inline VFPEvaluation bhp(const VFPProdTable* table,
 
 
 
+inline VFPEvaluation bhp(const VFPProdTable* table,
+        const double& aqua,
+        const double& liquid,
+        const double& vapour,
+        const double& thp,
+        const double& alq) {
+    VFPInterpHint hint;
+    return detail::bhp(table, aqua, liquid, vapour, thp, alq, hint);
+}
+
+
+
 
 
 inline VFPEvaluation bhp(const VFPInjTable* table,
         const double& aqua,
         const double& liquid,
         const double& vapour,
-        const double& thp) {
+        const double& thp,
+        VFPInterpHint& hint) {
     //Find interpolation variables
     double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
 
     //First, find the values to interpolate between
-    auto flo_i = detail::findInterpData(flo, table->getFloAxis());
-    auto thp_i = detail::findInterpData(thp, table->getTHPAxis());
+    auto flo_i = detail::findInterpData(flo, table->getFloAxis(), hint.flo);
+    auto thp_i = detail::findInterpData(thp, table->getTHPAxis(), hint.thp);
 
     //Then perform the interpolation itself
     detail::VFPEvaluation retval = detail::interpolate(table->getTable(), flo_i, thp_i);
@@ -561,6 +611,17 @@ inline VFPEvaluation bhp(const VFPInjTable* table,
 
 
 
+inline VFPEvaluation bhp(const VFPInjTable* table,
+        const double& aqua,
+        const double& liquid,
+        const double& vapour,
+        const double& thp) {
+    VFPInterpHint hint;
+    return detail::bhp(table, aqua, liquid, vapour, thp, hint);
+}
+
+
+
 
 
 
@@ -570,7 +631,7 @@ inline VFPEvaluation bhp(const VFPInjTable* table,
  * Returns the table from the map if found, or throws an exception
  */
 template <typename T>
-const T* getTable(const std::map<int, T*> tables, int table_id) {
+const T* getTable(const std::map<int, T*>& tables, int table_id) {
     auto entry = tables.find(table_id);
     if (entry == tables.end()) {
         OPM_THROW(std::invalid_argument, "Nonexistent table " << table_id << " referenced.");
@@ -968,6 +1029,87 @@ inline double findTHP(
 
 
 
+/**
+ * Linear interpolation of thp as a function of the rates and the bhp
+ * for production tables.
+ * @param hint Intervals of the last evaluation, updated on return. The THP
+ *             interval is not used, since the bhp is evaluated for all THP values.
+ */
+inline double thp(const VFPProdTable* table,
+        const double& aqua,
+        const double& liquid,
+        const double& vapour,
+        const double& bhp,
+        const double& alq,
+        VFPInterpHint& hint) {
+    const VFPProdTable::array_type& data = table->getTable();
+
+    //Find interpolation variables
+    double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
+    double wfr = detail::getWFR(aqua, liquid, vapour, table->getWFRType());
+    double gfr = detail::getGFR(aqua, liquid, vapour, table->getGFRType());
+
+    const std::vector<double>& thp_array = table->getTHPAxis();
+    int nthp = thp_array.size();
+
+    /**
+     * Find the function bhp_array(thp) by creating a 1D view of the data
+     * by interpolating for every value of thp. This might be somewhat
+     * expensive, but let us assome that nthp is small
+     * Recall that flo is negative in Opm, so switch the sign
+     */
+    auto flo_i = detail::findInterpData(-flo, table->getFloAxis(), hint.flo);
+    auto wfr_i = detail::findInterpData( wfr, table->getWFRAxis(), hint.wfr);
+    auto gfr_i = detail::findInterpData( gfr, table->getGFRAxis(), hint.gfr);
+    auto alq_i = detail::findInterpData( alq, table->getALQAxis(), hint.alq);
+    std::vector<double> bhp_array(nthp);
+    for (int i=0; i<nthp; ++i) {
+        auto thp_i = detail::findInterpData(thp_array[i], thp_array);
+        bhp_array[i] = detail::interpolate(data, flo_i, thp_i, wfr_i, gfr_i, alq_i).value;
+    }
+
+    return detail::findTHP(bhp_array, thp_array, bhp);
+}
+
+
+
+/**
+ * Linear interpolation of thp as a function of the rates and the bhp
+ * for injection tables.
+ * @param hint Intervals of the last evaluation, updated on return. The THP
+ *             interval is not used, since the bhp is evaluated for all THP values.
+ */
+inline double thp(const VFPInjTable* table,
+        const double& aqua,
+        const double& liquid,
+        const double& vapour,
+        const double& bhp,
+        VFPInterpHint& hint) {
+    const VFPInjTable::array_type& data = table->getTable();
+
+    //Find interpolation variables
+    double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
+
+    const std::vector<double>& thp_array = table->getTHPAxis();
+    int nthp = thp_array.size();
+
+    /**
+     * Find the function bhp_array(thp) by creating a 1D view of the data
+     * by interpolating for every value of thp. This might be somewhat
+     * expensive, but let us assome that nthp is small
+     */
+    auto flo_i = detail::findInterpData(flo, table->getFloAxis(), hint.flo);
+    std::vector<double> bhp_array(nthp);
+    for (int i=0; i<nthp; ++i) {
+        auto thp_i = detail::findInterpData(thp_array[i], thp_array);
+        bhp_array[i] = detail::interpolate(data, flo_i, thp_i).value;
+    }
+
+    return detail::findTHP(bhp_array, thp_array, bhp);
+}
+
+
+
 
 
 
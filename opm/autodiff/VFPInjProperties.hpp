@@ -117,6 +117,24 @@ public:
                  const EvalWell& liquid,
                  const EvalWell& vapour,
                  const double& thp) const {
+        detail::VFPInterpHint hint;
+        return bhp(table_id, aqua, liquid, vapour, thp, hint);
+    }
+
+    /**
+     * Linear interpolation of bhp as a function of the input parameters given as
+     * Evaluation, starting the search in the table at the intervals of the last
+     * evaluation for the same well.
+     * @param hint Intervals of the last evaluation, updated on return.
+     * @see bhp(const int, const EvalWell&, const EvalWell&, const EvalWell&, const double&)
+     */
+    template <class EvalWell>
+    EvalWell bhp(const int table_id,
+                 const EvalWell& aqua,
+                 const EvalWell& liquid,
+                 const EvalWell& vapour,
+                 const double& thp,
+                 detail::VFPInterpHint& hint) const {
 
         //Get the table
         const VFPInjTable* table = detail::getTable(m_tables, table_id);
@@ -129,8 +147,8 @@ public:
         if (table != nullptr) {
             //First, find the values to interpolate between
             //Value of FLO is negative in OPM for producers, but positive in VFP table
-            auto flo_i = detail::findInterpData(flo.value(), table->getFloAxis());
-            auto thp_i = detail::findInterpData( thp, table->getTHPAxis()); // assume constant
+            auto flo_i = detail::findInterpData(flo.value(), table->getFloAxis(), hint.flo);
+            auto thp_i = detail::findInterpData( thp, table->getTHPAxis(), hint.thp); // assume constant
 
             detail::VFPEvaluation bhp_val = detail::interpolate(table->getTable(), flo_i, thp_i);
 
@@ -160,6 +178,42 @@ public:
                const double& vapour,
                const double& thp) const;
 
+    /**
+     * Linear interpolation of bhp as a function of the input parameters,
+     * starting the search in the table at the intervals of the last
+     * evaluation for the same well.
+     * @param hint Intervals of the last evaluation, updated on return.
+     */
+    double bhp(int table_id,
+               const double& aqua,
+               const double& liquid,
+               const double& vapour,
+               const double& thp,
+               detail::VFPInterpHint& hint) const;
+
+    /**
+     * Linear interpolation of bhp and its derivatives for a set of wells in one pass.
+     * Each entry of the input vectors corresponds to one well.
+     * @param table_id Table number to use. A negative entry (e.g., -1)
+     *                 will indicate that no table is used, and the corresponding
+     *                 BHP will be calculated as a constant -1e100.
+     * @param aqua Water phase
+     * @param liquid Oil phase
+     * @param vapour Gas phase
+     * @param thp Tubing head pressure
+     * @param hints Intervals of the last evaluation of each well, updated on return.
+     *              Resized to the number of wells if needed.
+     * @param result The bottom hole pressures and their derivatives with respect to
+     *               the table axes.
+     */
+    void bhp(const std::vector<int>& table_id,
+             const std::vector<double>& aqua,
+             const std::vector<double>& liquid,
+             const std::vector<double>& vapour,
+             const std::vector<double>& thp,
+             std::vector<detail::VFPInterpHint>& hints,
+             std::vector<detail::VFPEvaluation>& result) const;
+
 
     /**
      * Linear interpolation of thp as a function of the input parameters
@@ -178,6 +232,25 @@ public:
                const double& vapour,
                const double& bhp) const;
 
+    /**
+     * Linear interpolation of thp for a set of wells in one pass.
+     * Each entry of the input vectors corresponds to one well.
+     * @param table_id Table number to use. A negative entry (e.g., -1)
+     *                 will indicate that no table is used, and the corresponding
+     *                 THP will be calculated as a constant -1e100.
+     * @param hints Intervals of the last evaluation of each well, updated on return.
+     *              Resized to the number of wells if needed.
+     * @param result The tubing head pressures.
+     * @see thp(int, const double&, const double&, const double&, const double&)
+     */
+    void thp(const std::vector<int>& table_id,
+             const std::vector<double>& aqua,
+             const std::vector<double>& liquid,
+             const std::vector<double>& vapour,
+             const std::vector<double>& bhp,
+             std::vector<detail::VFPInterpHint>& hints,
+             std::vector<double>& result) const;
+
     /**
      * Returns the table associated with the ID, or throws an exception if
      * the table does not exist
@@ -181,49 +181,111 @@ double VFPProdProperties::bhp(int table_id,
         const double& vapour,
         const double& thp_arg,
         const double& alq) const {
+    detail::VFPInterpHint hint;
+    return bhp(table_id, aqua, liquid, vapour, thp_arg, alq, hint);
+}
+
+
+
+double VFPProdProperties::bhp(int table_id,
+        const double& aqua,
+        const double& liquid,
+        const double& vapour,
+        const double& thp_arg,
+        const double& alq,
+        detail::VFPInterpHint& hint) const {
     const VFPProdTable* table = detail::getTable(m_tables, table_id);
 
-    detail::VFPEvaluation retval = detail::bhp(table, aqua, liquid, vapour, thp_arg, alq);
+    detail::VFPEvaluation retval = detail::bhp(table, aqua, liquid, vapour, thp_arg, alq, hint);
     return retval.value;
 }
 
 
 
+void VFPProdProperties::bhp(const std::vector<int>& table_id,
+        const std::vector<double>& aqua,
+        const std::vector<double>& liquid,
+        const std::vector<double>& vapour,
+        const std::vector<double>& thp_arg,
+        const std::vector<double>& alq,
+        std::vector<detail::VFPInterpHint>& hints,
+        std::vector<detail::VFPEvaluation>& result) const {
+    const int nw = table_id.size();
+
+    assert(static_cast<int>(aqua.size())    == nw);
+    assert(static_cast<int>(liquid.size())  == nw);
+    assert(static_cast<int>(vapour.size())  == nw);
+    assert(static_cast<int>(thp_arg.size()) == nw);
+    assert(static_cast<int>(alq.size())     == nw);
+
+    hints.resize(nw);
+    result.resize(nw);
+
+    //Wells using the same table are usually adjacent, so only look up a new table
+    //when the table number changes
+    int last_id = -1;
+    const VFPProdTable* table = nullptr;
+    for (int i=0; i<nw; ++i) {
+        if (table_id[i] < 0) {
+            result[i] = detail::VFPEvaluation();
+            result[i].value = -1e100; //Signal that this value has not been calculated properly, due to "missing" table
+            continue;
+        }
+        if (table_id[i] != last_id) {
+            table = detail::getTable(m_tables, table_id[i]);
+            last_id = table_id[i];
+        }
+        result[i] = detail::bhp(table, aqua[i], liquid[i], vapour[i], thp_arg[i], alq[i], hints[i]);
+    }
+}
+
+
+
 double VFPProdProperties::thp(int table_id,
         const double& aqua,
         const double& liquid,
         const double& vapour,
         const double& bhp_arg,
         const double& alq) const {
+    detail::VFPInterpHint hint;
     const VFPProdTable* table = detail::getTable(m_tables, table_id);
-    const VFPProdTable::array_type& data = table->getTable();
-
-    //Find interpolation variables
-    double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
-    double wfr = detail::getWFR(aqua, liquid, vapour, table->getWFRType());
-    double gfr = detail::getGFR(aqua, liquid, vapour, table->getGFRType());
-
-    const std::vector<double> thp_array = table->getTHPAxis();
-    int nthp = thp_array.size();
-
-    /**
-     * Find the function bhp_array(thp) by creating a 1D view of the data
-     * by interpolating for every value of thp. This might be somewhat
-     * expensive, but let us assome that nthp is small
-     * Recall that flo is negative in Opm, so switch the sign
-     */
-    auto flo_i = detail::findInterpData(-flo, table->getFloAxis());
-    auto wfr_i = detail::findInterpData( wfr, table->getWFRAxis());
-    auto gfr_i = detail::findInterpData( gfr, table->getGFRAxis());
-    auto alq_i = detail::findInterpData( alq, table->getALQAxis());
-    std::vector<double> bhp_array(nthp);
-    for (int i=0; i<nthp; ++i) {
-        auto thp_i = detail::findInterpData(thp_array[i], thp_array);
-        bhp_array[i] = detail::interpolate(data, flo_i, thp_i, wfr_i, gfr_i, alq_i).value;
-    }
+    return detail::thp(table, aqua, liquid, vapour, bhp_arg, alq, hint);
+}
 
-    double retval = detail::findTHP(bhp_array, thp_array, bhp_arg);
-    return retval;
+
+
+void VFPProdProperties::thp(const std::vector<int>& table_id,
+        const std::vector<double>& aqua,
+        const std::vector<double>& liquid,
+        const std::vector<double>& vapour,
+        const std::vector<double>& bhp_arg,
+        const std::vector<double>& alq,
+        std::vector<detail::VFPInterpHint>& hints,
+        std::vector<double>& result) const {
+    const int nw = table_id.size();
+
+    assert(static_cast<int>(aqua.size())    == nw);
+    assert(static_cast<int>(liquid.size())  == nw);
+    assert(static_cast<int>(vapour.size())  == nw);
+    assert(static_cast<int>(bhp_arg.size()) == nw);
+    assert(static_cast<int>(alq.size())     == nw);
+
+    hints.resize(nw);
+    result.resize(nw);
+
+    int last_id = -1;
+    const VFPProdTable* table = nullptr;
+    for (int i=0; i<nw; ++i) {
+        if (table_id[i] < 0) {
+            result[i] = -1e100; //Signal that this value has not been calculated properly, due to "missing" table
+            continue;
+        }
+        if (table_id[i] != last_id) {
+            table = detail::getTable(m_tables, table_id[i]);
+            last_id = table_id[i];
+        }
+        result[i] = detail::thp(table, aqua[i], liquid[i], vapour[i], bhp_arg[i], alq[i], hints[i]);
+    }
 }
 
 
@@ -128,6 +128,25 @@ public:
                  const EvalWell& vapour,
                  const double& thp,
                  const double& alq) const {
+        detail::VFPInterpHint hint;
+        return bhp(table_id, aqua, liquid, vapour, thp, alq, hint);
+    }
+
+    /**
+     * Linear interpolation of bhp as a function of the input parameters given as
+     * Evalutions, starting the search in the table at the intervals of the last
+     * evaluation for the same well.
+     * @param hint Intervals of the last evaluation, updated on return.
+     * @see bhp(const int, const EvalWell&, const EvalWell&, const EvalWell&, const double&, const double&)
+     */
+    template <class EvalWell>
+    EvalWell bhp(const int table_id,
+                 const EvalWell& aqua,
+                 const EvalWell& liquid,
+                 const EvalWell& vapour,
+                 const double& thp,
+                 const double& alq,
+                 detail::VFPInterpHint& hint) const {
 
         //Get the table
         const VFPProdTable* table = detail::getTable(m_tables, table_id);
@@ -142,11 +161,11 @@ public:
         if (table != nullptr) {
             //First, find the values to interpolate between
             //Value of FLO is negative in OPM for producers, but positive in VFP table
-            auto flo_i = detail::findInterpData(-flo.value(), table->getFloAxis());
-            auto thp_i = detail::findInterpData( thp, table->getTHPAxis()); // assume constant
-            auto wfr_i = detail::findInterpData( wfr.value(), table->getWFRAxis());
-            auto gfr_i = detail::findInterpData( gfr.value(), table->getGFRAxis());
-            auto alq_i = detail::findInterpData( alq, table->getALQAxis()); //assume constant
+            auto flo_i = detail::findInterpData(-flo.value(), table->getFloAxis(), hint.flo);
+            auto thp_i = detail::findInterpData( thp, table->getTHPAxis(), hint.thp); // assume constant
+            auto wfr_i = detail::findInterpData( wfr.value(), table->getWFRAxis(), hint.wfr);
+            auto gfr_i = detail::findInterpData( gfr.value(), table->getGFRAxis(), hint.gfr);
+            auto alq_i = detail::findInterpData( alq, table->getALQAxis(), hint.alq); //assume constant
 
             detail::VFPEvaluation bhp_val = detail::interpolate(table->getTable(), flo_i, thp_i, wfr_i, gfr_i, alq_i);
 
@@ -178,6 +197,45 @@ public:
             const double& thp,
             const double& alq) const;
 
+    /**
+     * Linear interpolation of bhp as a function of the input parameters,
+     * starting the search in the table at the intervals of the last
+     * evaluation for the same well.
+     * @param hint Intervals of the last evaluation, updated on return.
+     */
+    double bhp(int table_id,
+            const double& aqua,
+            const double& liquid,
+            const double& vapour,
+            const double& thp,
+            const double& alq,
+            detail::VFPInterpHint& hint) const;
+
+    /**
+     * Linear interpolation of bhp and its derivatives for a set of wells in one pass.
+     * Each entry of the input vectors corresponds to one well.
+     * @param table_id Table number to use. A negative entry (e.g., -1)
+     *                 will indicate that no table is used, and the corresponding
+     *                 BHP will be calculated as a constant -1e100.
+     * @param aqua Water phase
+     * @param liquid Oil phase
+     * @param vapour Gas phase
+     * @param thp Tubing head pressure
+     * @param alq Artificial lift or other parameter
+     * @param hints Intervals of the last evaluation of each well, updated on return.
+     *              Resized to the number of wells if needed.
+     * @param result The bottom hole pressures and their derivatives with respect to
+     *               the table axes.
+     */
+    void bhp(const std::vector<int>& table_id,
+             const std::vector<double>& aqua,
+             const std::vector<double>& liquid,
+             const std::vector<double>& vapour,
+             const std::vector<double>& thp,
+             const std::vector<double>& alq,
+             std::vector<detail::VFPInterpHint>& hints,
+             std::vector<detail::VFPEvaluation>& result) const;
+
     /**
      * Linear interpolation of thp as a function of the input parameters
      * @param table_id Table number to use
@@ -197,6 +255,26 @@ public:
             const double& bhp,
             const double& alq) const;
 
+    /**
+     * Linear interpolation of thp for a set of wells in one pass.
+     * Each entry of the input vectors corresponds to one well.
+     * @param table_id Table number to use. A negative entry (e.g., -1)
+     *                 will indicate that no table is used, and the corresponding
+     *                 THP will be calculated as a constant -1e100.
+     * @param hints Intervals of the last evaluation of each well, updated on return.
+     *              Resized to the number of wells if needed.
+     * @param result The tubing head pressures.
+     * @see thp(int, const double&, const double&, const double&, const double&, const double&)
+     */
+    void thp(const std::vector<int>& table_id,
+             const std::vector<double>& aqua,
+             const std::vector<double>& liquid,
+             const std::vector<double>& vapour,
+             const std::vector<double>& bhp,
+             const std::vector<double>& alq,
+             std::vector<detail::VFPInterpHint>& hints,
+             std::vector<double>& result) const;
+
     /**
      * Returns the table associated with the ID, or throws an exception if
      * the table does not exist
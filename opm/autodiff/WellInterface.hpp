@@ -38,6 +38,7 @@
 #include <opm/autodiff/WellHelpers.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
+#include <opm/autodiff/LinearSystemIO.hpp>
 #include <opm/autodiff/RateConverter.hpp>
 
 #include <opm/simulators/WellSwitchingLogger.hpp>
@@ -188,6 +189,21 @@ namespace Opm
         /// r = r - C D^-1 Rw
         virtual void apply(BVector& r) const = 0;
 
+        /// whether the well can add its contributions to the reservoir system
+        /// to a matrix by addWellContributions()
+        virtual bool supportsCouplingOperator() const { return false; }
+
+        /// mat = mat - C D^-1 B, mat needs to contain the couplings between
+        /// all the perforated cells of the well
+        virtual void addWellContributions(Mat& /* mat */) const
+        {
+            OPM_THROW(std::logic_error, "well " << name() << " can not add its contributions to a matrix");
+        }
+
+        /// copy B, C and D^-1 of the well equations to well for the capture of
+        /// the linear system, returns false if the well does not store D^-1
+        virtual bool captureLinearSystem(LinearSystemWell& /* well */) const { return false; }
+
         // TODO: before we decide to put more information under mutable, this function is not const
         virtual void computeWellPotentials(const Simulator& ebosSimulator,
                                            const WellState& well_state,
@@ -203,6 +219,10 @@ namespace Opm
         virtual void calculateExplicitQuantities(const Simulator& ebosSimulator,
                                                  const WellState& well_state) = 0; // should be const?
 
+        /// estimated relative cost of assembling and applying the well equations,
+        /// used to balance the load when the wells are processed concurrently
+        virtual double computationalCost() const { return number_of_perforations_; }
+
     protected:
 
         // to indicate a invalid connection
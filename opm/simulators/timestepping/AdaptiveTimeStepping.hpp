@@ -132,6 +132,7 @@ namespace Opm {
         bool full_timestep_initially_;        //!< beginning with the size of the time step from data file
         double timestep_after_event_;         //!< suggested size of timestep after an event
         bool use_newton_iteration_;           //!< use newton iteration count for adaptive time step control
+        bool restart_from_last_iterate_;      //!< restart chopped sub steps from the last Newton iterate if the model supports it
     };
 }
 
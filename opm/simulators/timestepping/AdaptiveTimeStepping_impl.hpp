@@ -59,6 +59,84 @@ namespace Opm {
             }
         };
 
+        /// Checkpoint of the state of the last accepted sub step. For models
+        /// that do not keep this state themselves copies of the state objects
+        /// are stored. The buffers are allocated once per report step and
+        /// reused for all sub steps.
+        template <class Solver, class State, class WState, class = void>
+        class StateCheckpoint
+        {
+            State  state_;
+            WState well_state_;
+        public:
+            StateCheckpoint( Solver& /* solver */, const State& state, const WState& well_state )
+              : state_( state ),
+                well_state_( well_state )
+            {}
+
+            /// the models state cannot be restored partially
+            static bool canKeepLastIterate() { return false; }
+
+            /// store the state of an accepted sub step
+            void store( const State& state, const WState& well_state )
+            {
+                state_      = state;
+                well_state_ = well_state;
+            }
+
+            /// restore the state of the last accepted sub step
+            void restore( State& state, WState& well_state, const bool /* keepLastIterate */ )
+            {
+                state      = state_;
+                well_state = well_state_;
+            }
+
+            /// the state of the last accepted sub step
+            const State& previousState( const State& /* current */ ) const { return state_; }
+        };
+
+        /// Checkpoint for models providing rollbackState(), i.e. models which
+        /// keep the state of the last accepted sub step themselves. Nothing is
+        /// copied here, a failed sub step is undone by the model in place.
+        template <class Solver, class State, class WState>
+        class StateCheckpoint< Solver, State, WState,
+                               decltype( std::declval< Solver& >().model().rollbackState( true ) ) >
+        {
+            Solver& solver_;
+        public:
+            StateCheckpoint( Solver& solver, const State& /* state */, const WState& /* well_state */ )
+              : solver_( solver )
+            {}
+
+            static bool canKeepLastIterate() { return true; }
+
+            void store( const State& /* state */, const WState& /* well_state */ )
+            {
+                // the model checkpoints itself at the end of each time step
+            }
+
+            void restore( State& /* state */, WState& /* well_state */, const bool keepLastIterate )
+            {
+                solver_.model().rollbackState( keepLastIterate );
+            }
+
+            const State& previousState( const State& current ) const { return current; }
+        };
+
+        /// convergence of the Newton iterations of the last step, if provided by the model
+        template <class Solver>
+        auto convergenceInfo( const Solver& solver, int )
+            -> decltype( solver.model().convergenceInfo() )
+        {
+            return solver.model().convergenceInfo();
+        }
+
+        template <class Solver>
+        NonlinearConvergenceInfo convergenceInfo( const Solver& /* solver */, long )
+        {
+            return NonlinearConvergenceInfo();
+        }
+
         template<class E>
         void logException(const E& exception, bool verbose)
         {
@@ -91,6 +169,7 @@ namespace Opm {
         , full_timestep_initially_( param.getDefault("full_timestep_initially", bool(false) ) )
         , timestep_after_event_( tuning.getTMAXWC(time_step))
         , use_newton_iteration_(false)
+        , restart_from_last_iterate_( param.getDefault("solver.restart_from_last_iterate", bool(false) ) )
     {
         init(param);
 
@@ -111,6 +190,7 @@ namespace Opm {
         , full_timestep_initially_( param.getDefault("full_timestep_initially", bool(false) ) )
         , timestep_after_event_( unit::convert::from(param.getDefault("timestep.timestep_in_days_after_event", -1.0 ), unit::day))
         , use_newton_iteration_(false)
+        , restart_from_last_iterate_( param.getDefault("solver.restart_from_last_iterate", bool(false) ) )
     {
         init(param);
     }
@@ -118,7 +198,7 @@ namespace Opm {
     inline void AdaptiveTimeStepping::
     init(const ParameterGroup& param)
     {
-        // valid are "pid" and "pid+iteration"
+        // valid are "pid", "pid+iteration", "pid+newtoniteration", "pid+prediction" and "hardcoded"
         std::string control = param.getDefault("timestep.control", std::string("pid") );
         // iterations is the accumulation of all linear iterations over all newton steops per time step
         const int defaultTargetIterations = 30;
@@ -139,6 +219,12 @@ namespace Opm {
             timeStepControl_ = TimeStepControlType( new PIDAndIterationCountTimeStepControl( iterations, tol ) );
             use_newton_iteration_ = true;
         }
+        else if ( control == "pid+prediction" )
+        {
+            const int iterations   = param.getDefault("timestep.control.targetiteration", defaultTargetNewtonIterations );
+            timeStepControl_ = TimeStepControlType( new PredictiveTimeStepControl( iterations, tol ) );
+            use_newton_iteration_ = true;
+        }
         else if ( control == "iterationcount" )
         {
             const int iterations    = param.getDefault("timestep.control.targetiteration", defaultTargetIterations );
@@ -207,9 +293,8 @@ namespace Opm {
         // create adaptive step timer with previously used sub step size
         AdaptiveSimulatorTimer substepTimer( simulatorTimer, suggested_next_timestep_, max_time_step_ );
 
-        // copy states in case solver has to be restarted (to be revised)
-        State  last_state( state );
-        WState last_well_state( well_state );
+        // checkpoint of the states in case solver has to be restarted
+        detail::StateCheckpoint< Solver, State, WState > checkpoint( solver, state, well_state );
 
         // reset the statistics for the failed substeps
         failureReport_ = SimulatorReport();
@@ -232,6 +317,8 @@ namespace Opm {
 
             SimulatorReport substepReport;
             std::string cause_of_failure = "";
+            // only an exceeded iteration limit leaves a usable iterate behind
+            bool keepLastIterate = false;
             try {
                 substepReport = solver.step( substepTimer, state, well_state);
                 report += substepReport;
@@ -244,6 +331,7 @@ namespace Opm {
             catch (const Opm::TooManyIterations& e) {
                 substepReport += solver.failureReport();
                 cause_of_failure = "Solver convergence failure - Iteration limit reached";
+                keepLastIterate = restart_from_last_iterate_ && checkpoint.canKeepLastIterate();
 
                 detail::logException(e, solver_verbose_);
                 // since linearIterations is < 0 this will restart the solver
@@ -288,7 +376,7 @@ namespace Opm {
 
                 // create object to compute the time error, simply forwards the call to the model
                 detail::SolutionTimeErrorSolverWrapper< Solver, State >
-                    relativeChange( solver, last_state, state );
+                    relativeChange( solver, checkpoint.previousState( state ), state );
 
                 // compute new time step estimate
                 const int iterations = use_newton_iteration_ ? substepReport.total_newton_iterations
@@ -341,8 +429,7 @@ namespace Opm {
                 substepTimer.provideTimeStepEstimate( dtEstimate );
 
                 // update states
-                last_state      = state ;
-                last_well_state = well_state;
+                checkpoint.store( state, well_state );
 
                 report.converged = substepTimer.done();
                 substepTimer.setLastStepFailed(false);
@@ -364,8 +451,9 @@ namespace Opm {
                     OPM_THROW_NOLOG(Opm::NumericalProblem, msg);
                 }
 
-                const double newTimeStep = restart_factor_ * dt;
-                // we need to revise this
+                NonlinearConvergenceInfo convergence = detail::convergenceInfo( solver, 0 );
+                convergence.iterations = substepReport.total_newton_iterations;
+                const double newTimeStep = timeStepControl_->computeRestartTimeStepSize( dt, restart_factor_, convergence );
                 substepTimer.provideTimeStepEstimate( newTimeStep );
                 if( solver_verbose_ ) {
                     std::string msg;
@@ -374,8 +462,7 @@ namespace Opm {
                     OpmLog::problem(msg);
                 }
                 // reset states
-                state      = last_state;
-                well_state = last_well_state;
+                checkpoint.restore( state, well_state, keepLastIterate );
 
                 ++restarts;
             }
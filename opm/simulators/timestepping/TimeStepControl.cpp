@@ -19,8 +19,10 @@
   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <config.h>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -193,4 +195,114 @@ namespace Opm
         return std::min(dtEstimatePID, dtEstimateIter);
     }
 
+
+
+    ////////////////////////////////////////////////////////////
+    //
+    //  PredictiveTimeStepControl  Implementation
+    //
+    ////////////////////////////////////////////////////////////
+
+    namespace
+    {
+        // weight of the older steps in the accumulated iteration counts
+        const double iterationHistoryWeight = 0.9;
+        // fraction of the size of the last failed step used by the following steps
+        const double failedStepSafety = 0.9;
+        // relaxation of the failed step limit per accepted step without wasted work
+        const double failedStepLimitGrowth = 1.25;
+        // largest factor to chop a failed step with
+        const double maxRestartFactor = 0.9;
+    }
+
+    PredictiveTimeStepControl::
+    PredictiveTimeStepControl( const int target_iterations,
+                               const double tol,
+                               const bool verbose)
+        : BaseType( target_iterations, tol, verbose )
+        , failedStepLimit_( std::numeric_limits<double>::infinity() )
+        , failedIterations_( 0.0 )
+        , totalIterations_( 0.0 )
+    {}
+
+    double PredictiveTimeStepControl::
+    wastedFraction() const
+    {
+        return totalIterations_ > 0.0 ? failedIterations_ / totalIterations_ : 0.0;
+    }
+
+    double PredictiveTimeStepControl::
+    computeTimeStepSize( const double dt, const int iterations, const RelativeChangeInterface& relChange, const double simulationTimeElapsed ) const
+    {
+        failedIterations_ *= iterationHistoryWeight;
+        totalIterations_ = iterationHistoryWeight * totalIterations_ + iterations;
+
+        // relax the limit from the failed steps, the more work was wasted recently the slower
+        const double growth = 1.0 + (failedStepLimitGrowth - 1.0) * (1.0 - wastedFraction());
+        failedStepLimit_ *= growth;
+
+        const double dtEstimate = BaseType::computeTimeStepSize( dt, iterations, relChange, simulationTimeElapsed );
+        return std::min( dtEstimate, failedStepSafety * failedStepLimit_ );
+    }
+
+    double PredictiveTimeStepControl::
+    computeRestartTimeStepSize( const double dt, const double restartFactor, const NonlinearConvergenceInfo& convergence ) const
+    {
+        // chop harder if most of the recent work was wasted
+        double factor = restartFactor * (1.0 - 0.5 * wastedFraction());
+
+        failedIterations_ += convergence.iterations;
+        totalIterations_ += convergence.iterations;
+        failedStepLimit_ = std::min( failedStepLimit_, dt );
+
+        // if the Newton iterations were converging, too slowly though, estimate the number of
+        // iterations needed from the rate of convergence and choose the step size for which the
+        // target iterations suffice, assuming that the number of iterations scales with the step size
+        if( convergence.rate > 0.0 && convergence.rate < 1.0 && convergence.residual > 1.0 )
+        {
+            const double remaining = std::log( convergence.residual ) / -std::log( convergence.rate );
+            const double required  = convergence.iterations + remaining;
+            factor = std::max( double(target_iterations_) / required, restartFactor );
+            factor = std::min( factor, maxRestartFactor );
+        }
+
+        const double newDt = factor * dt;
+        if( verbose_ )
+            std::cout << "Computed restart step size: " << unit::convert::to( newDt, unit::day ) << " (days)" << std::endl;
+        return newDt;
+    }
+
+    NonlinearConvergenceInfo
+    estimateNonlinearConvergence( const std::vector<double>& cnvResiduals,
+                                  const std::vector<double>& mbResiduals,
+                                  const int maxStrictIter )
+    {
+        assert( cnvResiduals.size() == mbResiduals.size() );
+
+        NonlinearConvergenceInfo info;
+        const int numResiduals = cnvResiduals.size();
+        info.iterations = std::max( numResiduals - 1, 0 );
+        if( numResiduals < 2 ) {
+            return info;
+        }
+
+        // the CNV residual does not count after maxStrictIter iterations
+        const int last = numResiduals - 1;
+        const bool strict = last < maxStrictIter;
+        const auto residual = [&]( const int iteration ) {
+            return strict ? std::max( cnvResiduals[ iteration ], mbResiduals[ iteration ] )
+                          : mbResiduals[ iteration ];
+        };
+
+        // Newton's method tends to converge faster as it approaches the solution
+        const int first = std::max( last - 2, 0 );
+        const double residualFirst = residual( first );
+        const double residualLast = residual( last );
+        if( residualFirst > 0.0 && std::isfinite( residualFirst ) && std::isfinite( residualLast ) ) {
+            info.rate = std::pow( residualLast / residualFirst, 1.0 / ( last - first ) );
+            info.residual = residualLast;
+        }
+        return info;
+    }
+
 } // end namespace Opm
@@ -117,6 +117,60 @@ namespace Opm
         const int     target_iterations_;
     };
 
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///
+    ///  PID and Newton iteration count based time step control as above that in addition
+    ///  learns from failed steps. The size of the last failed step limits the following
+    ///  steps, this limit is relaxed with every accepted step, the slower the more work
+    ///  was wasted in failed steps recently. A failed step is retried with the step size
+    ///  for which the rate of convergence of its Newton iterations predicts that the
+    ///  target number of iterations suffices, instead of a fixed fraction.
+    //
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class PredictiveTimeStepControl : public PIDAndIterationCountTimeStepControl
+    {
+        typedef PIDAndIterationCountTimeStepControl BaseType;
+    public:
+        /// \brief constructor
+        /// \param target_iterations  number of desired Newton iterations per time step
+        /// \param tol        tolerance for the relative changes of the numerical solution to be accepted
+        ///                   in one time step (default is 1e-3)
+        /// \param verbose    if true get some output (default = false)
+        PredictiveTimeStepControl( const int target_iterations = 8,
+                                   const double tol = 1e-3,
+                                   const bool verbose = false);
+
+        /// \brief \copydoc TimeStepControlInterface::computeTimeStepSize
+        double computeTimeStepSize( const double dt, const int iterations, const RelativeChangeInterface& relativeChange, const double simulationTimeElapsed ) const;
+
+        /// \brief \copydoc TimeStepControlInterface::computeRestartTimeStepSize
+        double computeRestartTimeStepSize( const double dt, const double restartFactor, const NonlinearConvergenceInfo& convergence ) const;
+
+    protected:
+        /// fraction of the recent Newton iterations spent in failed steps
+        double wastedFraction() const;
+
+        // step size limit from the failed steps
+        mutable double failedStepLimit_;
+        // exponentially weighted Newton iterations of failed and of all steps
+        mutable double failedIterations_;
+        mutable double totalIterations_;
+    };
+
+    /// \brief Estimate the convergence of the Newton iterations of a time step from
+    ///        the residuals after each iteration.
+    ///
+    /// The rate is taken over the last two iterations at most, measured by the
+    /// criterion that decided the convergence of the last iteration: the CNV and
+    /// the mass balance residual within the first maxStrictIter iterations, only
+    /// the mass balance residual afterwards.
+    /// \param cnvResiduals   largest CNV residual of each iteration relative to its tolerance
+    /// \param mbResiduals    largest mass balance residual of each iteration relative to its tolerance
+    /// \param maxStrictIter  number of iterations in which the CNV residual has to converge
+    NonlinearConvergenceInfo estimateNonlinearConvergence( const std::vector<double>& cnvResiduals,
+                                                           const std::vector<double>& mbResiduals,
+                                                           const int maxStrictIter );
+
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ///
     ///  HardcodedTimeStepControl
@@ -40,6 +40,23 @@ namespace Opm
         virtual ~RelativeChangeInterface() {}
     };
 
+    ///////////////////////////////////////////////////////////////////
+    ///
+    ///  NonlinearConvergenceInfo
+    ///
+    ///////////////////////////////////////////////////////////////////
+    struct NonlinearConvergenceInfo
+    {
+        /// number of Newton iterations of the step
+        int iterations = 0;
+        /// estimated factor by which the residual is reduced per Newton iteration
+        /// in the last iterations, negative if unknown
+        double rate = -1.0;
+        /// residual after the last iteration relative to the convergence tolerance,
+        /// negative if unknown
+        double residual = -1.0;
+    };
+
     ///////////////////////////////////////////////////////////////////
     ///
     ///  TimeStepControlInterface
@@ -58,6 +75,17 @@ namespace Opm
         /// \return suggested time step size for the next step
         virtual double computeTimeStepSize( const double dt, const int iterations, const RelativeChangeInterface& relativeChange , const double simulationTimeElapsed) const = 0;
 
+        /// compute the time step size to retry a failed step with
+        /// \param dt             time step size of the failed step
+        /// \param restartFactor  default factor to chop the time step with
+        /// \param convergence    convergence behaviour of the failed step
+        ///
+        /// \return time step size for the retry
+        virtual double computeRestartTimeStepSize( const double dt, const double restartFactor, const NonlinearConvergenceInfo& /* convergence */ ) const
+        {
+            return restartFactor * dt;
+        }
+
         /// virtual destructor (empty)
         virtual ~TimeStepControlInterface () {}
     };
@@ -0,0 +1,168 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE AndersonAccelerationTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/AndersonAcceleration.hpp>
+
+#include <dune/common/fvector.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cmath>
+
+namespace
+{
+    const int blockSize = 2;
+
+    typedef Dune::BlockVector<Dune::FieldVector<double, blockSize> > Vector;
+
+    struct InnerProduct
+    {
+        double dot(const Vector& a, const Vector& b) const { return a.dot(b); }
+    };
+
+    // Residual of a weakly coupled nonlinear system,
+    // F(x)_i = 4 x_i - x_{i-1} - x_{i+1} + 0.5 x_i^3 - 1.
+    Vector residual(const Vector& x)
+    {
+        const int n = x.size();
+        Vector r(n);
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < blockSize; ++k) {
+                const double left  = i > 0     ? x[i - 1][k] : 0.0;
+                const double right = i < n - 1 ? x[i + 1][k] : 0.0;
+                r[i][k] = 4.0 * x[i][k] - left - right + 0.5 * std::pow(x[i][k], 3) - 1.0 - k;
+            }
+        }
+        return r;
+    }
+
+    // Solve F(x) = 0 with the updates f = D^-1 F(x) using only the diagonal
+    // of the linear part, i.e. an inexact Newton method converging linearly.
+    // The accelerated update may be chopped before it is applied, and the
+    // chopped update recorded as the one applied.
+    int solve(Opm::AndersonAcceleration<Vector>& acceleration,
+              const double maxChange = 1.0e10,
+              const bool recordApplied = false)
+    {
+        const int n = 50;
+        Vector x(n);
+        x = 0.0;
+        for (int it = 0; it < 200; ++it) {
+            Vector dx = residual(x);
+            if (dx.two_norm() < 1e-10) {
+                return it;
+            }
+            for (int i = 0; i < n; ++i) {
+                dx[i][0] /= 4.0;
+                dx[i][1] /= 4.0;
+            }
+            acceleration.apply(dx, InnerProduct());
+            for (int i = 0; i < n; ++i) {
+                for (int k = 0; k < blockSize; ++k) {
+                    dx[i][k] = std::max(std::min(dx[i][k], maxChange), -maxChange);
+                }
+            }
+            if (recordApplied) {
+                acceleration.setAppliedUpdate(dx);
+            }
+            x -= dx;
+        }
+        return -1;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NoAcceleration)
+{
+    // depth zero leaves the updates unchanged
+    Opm::AndersonAcceleration<Vector> acceleration(0);
+    const int iterations = solve(acceleration);
+    BOOST_CHECK_GT(iterations, 20);
+    BOOST_CHECK_EQUAL(acceleration.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(FewerIterations)
+{
+    Opm::AndersonAcceleration<Vector> none(0);
+    const int plainIterations = solve(none);
+
+    for (const int depth : { 1, 3, 5 }) {
+        Opm::AndersonAcceleration<Vector> acceleration(depth);
+        const int iterations = solve(acceleration);
+        BOOST_CHECK_GT(iterations, 0);
+        BOOST_CHECK_LT(iterations, plainIterations);
+        BOOST_CHECK_EQUAL(acceleration.size(), depth);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Reset)
+{
+    Opm::AndersonAcceleration<Vector> acceleration(3);
+    Vector dx(4);
+    dx = 1.0;
+
+    // the first update is not modified
+    Vector update(dx);
+    acceleration.apply(update, InnerProduct());
+    BOOST_CHECK_EQUAL(acceleration.size(), 0);
+    Vector diff(update);
+    diff -= dx;
+    BOOST_CHECK_SMALL(diff.two_norm(), 1e-14);
+
+    dx = 0.5;
+    update = dx;
+    acceleration.apply(update, InnerProduct());
+    BOOST_CHECK_EQUAL(acceleration.size(), 1);
+
+    acceleration.reset();
+    BOOST_CHECK_EQUAL(acceleration.size(), 0);
+    update = dx;
+    acceleration.apply(update, InnerProduct());
+    diff = update;
+    diff -= dx;
+    BOOST_CHECK_SMALL(diff.two_norm(), 1e-14);
+}
+
+BOOST_AUTO_TEST_CASE(ChoppedUpdates)
+{
+    // the first updates are chopped
+    const double maxChange = 0.1;
+    Opm::AndersonAcceleration<Vector> none(0);
+    const int plainIterations = solve(none, maxChange);
+    BOOST_CHECK_GT(plainIterations, 0);
+
+    // with the update actually applied in the history the chopping does
+    // not spoil the acceleration
+    Opm::AndersonAcceleration<Vector> acceleration(3);
+    const int iterations = solve(acceleration, maxChange, true);
+    BOOST_CHECK_GT(iterations, 0);
+    BOOST_CHECK_LT(iterations, plainIterations);
+
+    // recording makes no difference without chopping
+    Opm::AndersonAcceleration<Vector> recorded(3);
+    Opm::AndersonAcceleration<Vector> notRecorded(3);
+    BOOST_CHECK_EQUAL(solve(recorded, 1.0e10, true), solve(notRecorded));
+}
@@ -369,3 +369,108 @@ BOOST_AUTO_TEST_CASE(Pow)
 }
 
 
+
+namespace {
+    // Jacobian of a function coupling neighbouring cells, with the same
+    // sparsity pattern for all scalings.
+    Eigen::SparseMatrix<double> couplingJacobian(const int n, const double scale)
+    {
+        Eigen::SparseMatrix<double> J(n, n);
+        for (int i = 0; i < n; ++i) {
+            if (i > 0) {
+                J.insert(i, i - 1) = -scale;
+            }
+            J.insert(i, i) = scale * (2.0 + i);
+            if (i < n - 1) {
+                J.insert(i, i + 1) = -0.5 * scale;
+            }
+        }
+        J.makeCompressed();
+        return J;
+    }
+
+    Eigen::MatrixXd dense(const AutoDiffMatrix& m)
+    {
+        Eigen::SparseMatrix<double> s;
+        m.toSparse(s);
+        return Eigen::MatrixXd(s);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ProductAndQuotient)
+{
+    typedef AutoDiffBlock<double> ADB;
+    const int n = 5;
+
+    ADB::V vu(n), vv(n);
+    vu << 0.2, 1.2, 13.4, -2.0, 0.7;
+    vv << 1.0, 2.2, 3.4, 0.5, -1.5;
+
+    // u and v share the sparsity pattern, w only has the diagonal.
+    std::vector<ADB::M> ju{ ADB::M(couplingJacobian(n, 1.0)), ADB::M(n, n) };
+    std::vector<ADB::M> jv{ ADB::M(couplingJacobian(n, 3.0)), ADB::M::createIdentity(n) };
+    const ADB u = ADB::function(vu, ju);
+    const ADB v = ADB::function(vv, jv);
+    const ADB w = ADB::variable(0, vv, { n, n });
+
+    const double tolerance = 1e-14;
+    const Eigen::MatrixXd Du = vu.matrix().asDiagonal();
+    const Eigen::MatrixXd Dv = vv.matrix().asDiagonal();
+    const Eigen::MatrixXd Dinv = (1.0 / vv).matrix().asDiagonal();
+    const Eigen::MatrixXd Dinv2 = (1.0 / (vv * vv)).matrix().asDiagonal();
+
+    for (const ADB* rhs : { &v, &w }) {
+        const ADB prod = u * (*rhs);
+        const ADB quot = u / (*rhs);
+        BOOST_CHECK(prod.value().isApprox(vu * vv, tolerance));
+        BOOST_CHECK(quot.value().isApprox(vu / vv, tolerance));
+        for (int block = 0; block < 2; ++block) {
+            const Eigen::MatrixXd Ju = dense(u.derivative()[block]);
+            const Eigen::MatrixXd Jr = dense(rhs->derivative()[block]);
+            BOOST_CHECK(dense(prod.derivative()[block]).isApprox(Dv * Ju + Du * Jr, tolerance));
+            BOOST_CHECK(dense(quot.derivative()[block]).isApprox(Dinv * Ju - Du * Dinv2 * Jr, tolerance));
+        }
+    }
+
+    // Scaling with constants.
+    const ADB scaled = vv * u;
+    const ADB divided = u / vv;
+    for (int block = 0; block < 2; ++block) {
+        const Eigen::MatrixXd Ju = dense(u.derivative()[block]);
+        BOOST_CHECK(dense(scaled.derivative()[block]).isApprox(Dv * Ju, tolerance));
+        BOOST_CHECK(dense(divided.derivative()[block]).isApprox(Dinv * Ju, tolerance));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SparseStorageReuse)
+{
+    typedef AutoDiffBlock<double> ADB;
+    const int n = 50;
+
+    ADB::V vu = ADB::V::LinSpaced(n, 1.0, 2.0);
+    ADB::V vv = ADB::V::LinSpaced(n, 3.0, 0.5);
+    std::vector<ADB::M> ju{ ADB::M(couplingJacobian(n, 1.0)) };
+    std::vector<ADB::M> jv{ ADB::M(couplingJacobian(n, 2.0)) };
+    const ADB u = ADB::function(vu, ju);
+    const ADB v = ADB::function(vv, jv);
+
+    const ADB reference = (u * v + u / v) * vv;
+
+    SparseStorageArena arena;
+    for (int iteration = 0; iteration < 3; ++iteration) {
+        SparseStorageArena::Scope scope(arena);
+        // The temporaries of the previous evaluation are recycled.
+        const ADB result = (u * v + u / v) * vv;
+        checkClose(result, reference, 0.0);
+        BOOST_CHECK_EQUAL(dense(result.derivative()[0]), dense(reference.derivative()[0]));
+    }
+    BOOST_CHECK_GT(arena.numStored(), 0);
+    BOOST_CHECK_LE(arena.numStored(), 256);
+
+    // Without an active arena the storage is released as usual.
+    const int stored = arena.numStored();
+    {
+        const ADB result = u * v;
+    }
+    BOOST_CHECK_EQUAL(arena.numStored(), stored);
+}
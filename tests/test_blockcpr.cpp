@@ -0,0 +1,237 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE BlockCPRPreconditionerTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/BlockCPRPreconditioner.hpp>
+#include <opm/autodiff/MixedPrecisionPreconditioner.hpp>
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <cmath>
+#include <memory>
+
+namespace
+{
+    const int numEq = 2;
+    const int pressureIndex = 0;
+
+    typedef Dune::FieldMatrix<double, numEq, numEq> Block;
+    typedef Dune::BCRSMatrix<Block>                 Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, numEq> > Vector;
+    typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    typedef Opm::BlockCPRPreconditioner<Operator, ILU, pressureIndex> CPR;
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector,
+                                         Dune::Amg::SequentialInformation, float> FloatILU;
+    typedef Opm::BlockCPRPreconditioner<Operator, FloatILU, pressureIndex> FloatCPR;
+
+    // One-dimensional system with a strongly coupled (elliptic) pressure
+    // and a weakly coupled (hyperbolic) second unknown.
+    Matrix createMatrix(const int n)
+    {
+        Matrix A(n, n, 3*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index();
+            if (i > 0) {
+                row.insert(i - 1);
+            }
+            row.insert(i);
+            if (i < n - 1) {
+                row.insert(i + 1);
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Block& diag = A[i][i];
+            diag[0][0] = 2.0e3;
+            diag[0][1] = 5.0;
+            diag[1][0] = 1.0e2;
+            diag[1][1] = 1.0 + 0.1*i;
+            if (i > 0) {
+                A[i][i-1] = 0.0;
+                A[i][i-1][0][0] = -1.0e3;
+                A[i][i-1][1][0] = -5.0e1;
+                A[i][i-1][1][1] = -0.5;
+            }
+            if (i < n - 1) {
+                A[i][i+1] = 0.0;
+                A[i][i+1][0][0] = -1.0e3;
+                A[i][i+1][1][0] = -5.0e1;
+            }
+        }
+        return A;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(QuasiImpesWeights)
+{
+    const Matrix A = createMatrix(10);
+    Operator op(A);
+    std::unique_ptr<ILU> ilu(new ILU(A, 0, 1.0));
+    CPR cpr(op, std::move(ilu), 1, true);
+
+    // the decoupled pressure equation does not depend on the
+    // non-pressure unknowns of the cell itself
+    for (int i = 0; i < 10; ++i) {
+        const auto& w = cpr.weights()[i];
+        double coupling = 0.0;
+        for (int eq = 0; eq < numEq; ++eq) {
+            coupling += w[eq] * A[i][i][eq][1];
+        }
+        BOOST_CHECK_SMALL(coupling, 1e-12);
+        BOOST_CHECK_GT(cpr.pressureMatrix()[i][i], 0.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SolveWithCPR)
+{
+    const int n = 200;
+    const Matrix A = createMatrix(n);
+    Operator op(A);
+
+    Vector x(n), b(n), r(n);
+    for (int i = 0; i < n; ++i) {
+        x[i][0] = 1.0 + 0.01*i;
+        x[i][1] = 0.5;
+    }
+    A.mv(x, b);
+
+    for (const bool quasiImpes : { true, false }) {
+        std::unique_ptr<ILU> ilu(new ILU(A, 0, 1.0));
+        CPR cpr(op, std::move(ilu), 1, quasiImpes);
+        Dune::SeqScalarProduct<Vector> sp;
+        Dune::BiCGSTABSolver<Vector> solver(op, sp, cpr, 1e-10, 100, 0);
+
+        Vector sol(n), rhs(b);
+        sol = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(sol, rhs, result);
+
+        BOOST_CHECK(result.converged);
+        r = b;
+        A.mmv(sol, r);
+        BOOST_CHECK_SMALL(r.two_norm() / b.two_norm(), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SolveWithSinglePrecisionPreconditioners)
+{
+    const int n = 200;
+    const Matrix A = createMatrix(n);
+    Operator op(A);
+
+    Vector x(n), b(n), r(n);
+    for (int i = 0; i < n; ++i) {
+        x[i][0] = 1.0 + 0.01*i;
+        x[i][1] = 0.5;
+    }
+    A.mv(x, b);
+
+    // the accuracy of the solution does not depend on the precision of the preconditioner
+    auto solveAndCheck = [&](Dune::Preconditioner<Vector, Vector>& precond) {
+        Dune::SeqScalarProduct<Vector> sp;
+        Dune::BiCGSTABSolver<Vector> solver(op, sp, precond, 1e-10, 200, 0);
+
+        Vector sol(n), rhs(b);
+        sol = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(sol, rhs, result);
+
+        BOOST_CHECK(result.converged);
+        r = b;
+        A.mmv(sol, r);
+        BOOST_CHECK_SMALL(r.two_norm() / b.two_norm(), 1e-8);
+    };
+
+    // block ILU0 with the factors stored in single precision
+    FloatILU floatILU(A, 0, 1.0);
+    solveAndCheck(floatILU);
+
+    // ... as second stage of CPR
+    std::unique_ptr<FloatILU> smoother(new FloatILU(A, 0, 1.0));
+    FloatCPR cpr(op, std::move(smoother), 1, true);
+    solveAndCheck(cpr);
+
+    // preconditioner for a single precision copy of the matrix
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<float, numEq, numEq> > FloatMatrix;
+    typedef Dune::BlockVector<Dune::FieldVector<float, numEq> > FloatVector;
+    FloatMatrix floatA;
+    Opm::detail::copySparsityPattern(A, floatA);
+    Opm::detail::convertMatrixValues(A, floatA);
+    BOOST_CHECK_EQUAL(floatA.nonzeroes(), A.nonzeroes());
+    BOOST_CHECK_CLOSE(floatA[3][2][1][0], A[3][2][1][0], 1e-5);
+
+    typedef Dune::SeqILU0<FloatMatrix, FloatVector, FloatVector> SeqFloatILU;
+    SeqFloatILU seqFloatILU(floatA, 1.0);
+    Opm::MixedPrecisionPreconditioner<Vector, Vector, SeqFloatILU> mixed(seqFloatILU);
+    solveAndCheck(mixed);
+}
+
+BOOST_AUTO_TEST_CASE(UpdatedPreconditionerMatchesRebuilt)
+{
+    const int n = 200;
+    Matrix A = createMatrix(n);
+    Dune::Amg::SequentialInformation info;
+    Operator op(A);
+    std::unique_ptr<ILU> ilu(new ILU(A, 0, 1.0));
+    CPR cpr(op, std::move(ilu), 1, true, info);
+
+    // new values with the same sparsity pattern, which change the pressure
+    // matrix, and a new operator as for every solve
+    for (int i = 0; i < n; ++i) {
+        A[i][i] *= 2.0;
+    }
+    Operator newOp(A);
+    cpr.update(newOp, info);
+
+    const Matrix B(A);
+    Operator opB(B);
+    std::unique_ptr<ILU> iluB(new ILU(B, 0, 1.0));
+    CPR rebuilt(opB, std::move(iluB), 1, true, info);
+
+    Vector d(n);
+    for (int i = 0; i < n; ++i) {
+        d[i][0] = std::sin(0.1*i);
+        d[i][1] = 1.0;
+    }
+
+    auto applyPrecond = [&](CPR& precond) {
+        Vector v(n), rhs(d);
+        v = 0.0;
+        precond.pre(v, rhs);
+        precond.apply(v, d);
+        precond.post(v);
+        return v;
+    };
+    const Vector reference = applyPrecond(rebuilt);
+    Vector difference = applyPrecond(cpr);
+    difference -= reference;
+    BOOST_CHECK_SMALL(difference.two_norm() / reference.two_norm(), 1e-10);
+}
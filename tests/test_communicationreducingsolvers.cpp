@@ -0,0 +1,292 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE CommunicationReducingSolversTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/CommunicationReducingSolvers.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/pinfo.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/scalarproducts.hh>
+#include <dune/istl/solvers.hh>
+
+#if HAVE_MPI
+#include <dune/istl/owneroverlapcopy.hh>
+#include <dune/istl/schwarz.hh>
+#endif // HAVE_MPI
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    struct MPIFixture
+    {
+        MPIFixture()
+        {
+            auto& suite = boost::unit_test::framework::master_test_suite();
+            Dune::MPIHelper::instance(suite.argc, suite.argv);
+        }
+    };
+
+    const int numEq = 2;
+    typedef Dune::FieldMatrix<double, numEq, numEq> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, numEq> > Vector;
+
+    // upwind discretization of a convection-diffusion problem with two
+    // coupled equations, the matrix is not symmetric
+    Matrix createMatrix(const int n)
+    {
+        Matrix A(n, n, 3*n - 2, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index();
+            if (i > 0)     row.insert(i - 1);
+            row.insert(i);
+            if (i < n - 1) row.insert(i + 1);
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                Block& block = *col;
+                block = 0.0;
+                const int i = row.index();
+                const int j = col.index();
+                for (int p = 0; p < numEq; ++p) {
+                    if (i == j) {
+                        block[p][p] = 5.0 + p;
+                        block[p][1 - p] = 0.5;
+                    } else {
+                        block[p][p] = (j < i) ? -2.5 : -1.0;
+                    }
+                }
+            }
+        }
+        return A;
+    }
+
+    Vector createRhs(const int n)
+    {
+        Vector b(n);
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < numEq; ++k) {
+                b[i][k] = std::sin(0.1 * (numEq*i + k)) + 1.0;
+            }
+        }
+        return b;
+    }
+
+    double relativeResidual(const Matrix& A, const Vector& x, const Vector& b)
+    {
+        Vector r(b);
+        A.mmv(x, r);
+        return r.two_norm() / b.two_norm();
+    }
+
+    template <class Solver>
+    void checkSolve(Solver& solver, const Matrix& A, const Vector& b, const double reduction)
+    {
+        Vector x(b.size()), rhs(b);
+        x = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(x, rhs, result);
+        BOOST_CHECK(result.converged);
+        BOOST_CHECK(result.iterations > 0);
+        BOOST_CHECK_LE(result.reduction, reduction);
+        // the true residual has been reduced, not only the recursive one
+        BOOST_CHECK_LE(relativeResidual(A, x, b), reduction);
+    }
+
+    // Solve op x = b from x = 0 with a solver and the dune-istl solver it
+    // replaces. Both take about the same number of iterations and reach the
+    // reduction of the true residual, such that the solutions agree.
+    template <class Solver, class DuneSolver, class Norm>
+    void checkSameAsDune(Solver& solver, DuneSolver& duneSolver, const Dune::LinearOperator<Vector, Vector>& op,
+                         const Vector& b, const Norm& norm, const double reduction, const int maxIterationDifference)
+    {
+        Vector x(b.size()), rhs(b);
+        x = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(x, rhs, result);
+
+        Vector reference(b.size());
+        reference = 0.0;
+        rhs = b;
+        Dune::InverseOperatorResult referenceResult;
+        duneSolver.apply(reference, rhs, referenceResult);
+
+        BOOST_CHECK(result.converged);
+        BOOST_CHECK(referenceResult.converged);
+        BOOST_CHECK_LE(std::abs(result.iterations - referenceResult.iterations), maxIterationDifference);
+
+        Vector r(b);
+        op.applyscaleadd(-1.0, x, r);
+        BOOST_CHECK_LE(norm(r), reduction * norm(b));
+
+        r = x;
+        r -= reference;
+        BOOST_CHECK_LE(norm(r), 1.0e-7 * norm(reference));
+    }
+}
+
+BOOST_GLOBAL_FIXTURE(MPIFixture);
+
+BOOST_AUTO_TEST_CASE(PipelinedBiCGSTABSolves)
+{
+    const int n = 200;
+    const Matrix A = createMatrix(n);
+    const Vector b = createRhs(n);
+    Dune::MatrixAdapter<Matrix, Vector, Vector> op(A);
+    Dune::SeqJac<Matrix, Vector, Vector> prec(A, 1, 1.0);
+    Dune::Amg::SequentialInformation info;
+
+    Opm::PipelinedBiCGSTABSolver<Vector> solver(op, prec, info, 1.0e-10, 500, 0);
+    checkSolve(solver, A, b, 1.0e-10);
+
+    // the solve stops unconverged at the maximum number of iterations
+    Opm::PipelinedBiCGSTABSolver<Vector> limited(op, prec, info, 1.0e-10, 1, 0);
+    Vector x(n), rhs(b);
+    x = 0.0;
+    Dune::InverseOperatorResult result;
+    limited.apply(x, rhs, result);
+    BOOST_CHECK(!result.converged);
+    BOOST_CHECK_EQUAL(result.iterations, 1);
+}
+
+BOOST_AUTO_TEST_CASE(SingleReductionGMResSolves)
+{
+    const int n = 200;
+    const Matrix A = createMatrix(n);
+    const Vector b = createRhs(n);
+    Dune::MatrixAdapter<Matrix, Vector, Vector> op(A);
+    Dune::SeqJac<Matrix, Vector, Vector> prec(A, 1, 1.0);
+    Dune::Amg::SequentialInformation info;
+
+    // a short restart length to pass through several cycles
+    Opm::SingleReductionGMResSolver<Vector> solver(op, prec, info, 1.0e-10, 10, 1000, 0);
+    checkSolve(solver, A, b, 1.0e-10);
+
+    Opm::SingleReductionGMResSolver<Vector> fullSolver(op, prec, info, 1.0e-10, 400, 400, 0);
+    checkSolve(fullSolver, A, b, 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(SequentialSolvesMatchDune)
+{
+    const int n = 200;
+    const double reduction = 1.0e-10;
+    const Matrix A = createMatrix(n);
+    const Vector b = createRhs(n);
+    Dune::MatrixAdapter<Matrix, Vector, Vector> op(A);
+    Dune::SeqScalarProduct<Vector> sp;
+    Dune::Amg::SequentialInformation info;
+    auto norm = [](const Vector& v) { return v.two_norm(); };
+
+    // the pipelined recurrences may need an iteration more than the classical ones
+    Dune::SeqJac<Matrix, Vector, Vector> jac(A, 1, 1.0);
+    Opm::PipelinedBiCGSTABSolver<Vector> bicgstab(op, jac, info, reduction, 500, 0);
+    Dune::BiCGSTABSolver<Vector> duneBicgstab(op, sp, jac, reduction, 500, 0);
+    checkSameAsDune(bicgstab, duneBicgstab, op, b, norm, reduction, 2);
+
+    // Dune::RestartedGMResSolver preconditions from the left, without a
+    // preconditioner both minimize the same residual over the same spaces
+    Dune::Richardson<Vector, Vector> identity(1.0);
+    Opm::SingleReductionGMResSolver<Vector> gmres(op, identity, info, reduction, 10, 1000, 0);
+    Dune::RestartedGMResSolver<Vector> duneGmres(op, sp, identity, reduction, 10, 1000, 0);
+    checkSameAsDune(gmres, duneGmres, op, b, norm, reduction, 1);
+}
+
+#if HAVE_MPI
+BOOST_AUTO_TEST_CASE(ParallelSolvesMatchDune)
+{
+    typedef Dune::OwnerOverlapCopyCommunication<int, int> Comm;
+    const int n = 200;
+    const double reduction = 1.0e-10;
+    const Matrix globalA = createMatrix(n);
+    const Vector globalB = createRhs(n);
+
+    // Each process owns a contiguous range of the cells, the cells next to
+    // it are copies of the cells of the neighbouring processes.
+    Comm comm(MPI_COMM_WORLD);
+    const int rank = comm.communicator().rank();
+    const int size = comm.communicator().size();
+    const int begin = (rank * n) / size;
+    const int end = ((rank + 1) * n) / size;
+    const int first = std::max(begin - 1, 0);
+    const int last = std::min(end + 1, n);
+
+    auto& indexSet = comm.indexSet();
+    indexSet.beginResize();
+    for (int cell = first; cell < last; ++cell) {
+        const auto attribute = (cell >= begin && cell < end) ? Dune::OwnerOverlapCopyAttributeSet::owner
+                                                             : Dune::OwnerOverlapCopyAttributeSet::copy;
+        indexSet.add(cell, Comm::ParallelIndexSet::LocalIndex(cell - first, attribute, true));
+    }
+    indexSet.endResize();
+    comm.remoteIndices().rebuild<false>();
+
+    // the rows of the local cells restricted to the local cells
+    const int numLocal = last - first;
+    Matrix A(numLocal, numLocal, 3*numLocal, Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        const auto& globalRow = globalA[first + row.index()];
+        for (auto col = globalRow.begin(); col != globalRow.end(); ++col) {
+            const int cell = col.index();
+            if (cell >= first && cell < last) {
+                row.insert(cell - first);
+            }
+        }
+    }
+    Vector b(numLocal);
+    for (int i = 0; i < numLocal; ++i) {
+        for (auto col = A[i].begin(); col != A[i].end(); ++col) {
+            *col = globalA[first + i][first + col.index()];
+        }
+        b[i] = globalB[first + i];
+    }
+
+    Dune::OverlappingSchwarzOperator<Matrix, Vector, Vector, Comm> op(A, comm);
+    Dune::OverlappingSchwarzScalarProduct<Vector, Comm> sp(comm);
+    auto norm = [&comm](const Vector& v) { return comm.norm(v); };
+
+    Dune::SeqJac<Matrix, Vector, Vector> jac(A, 1, 1.0);
+    Dune::BlockPreconditioner<Vector, Vector, Comm> parallelJac(jac, comm);
+    Opm::PipelinedBiCGSTABSolver<Vector> bicgstab(op, parallelJac, comm, reduction, 500, 0);
+    Dune::BiCGSTABSolver<Vector> duneBicgstab(op, sp, parallelJac, reduction, 500, 0);
+    checkSameAsDune(bicgstab, duneBicgstab, op, b, norm, reduction, 2);
+
+    Dune::Richardson<Vector, Vector> identity(1.0);
+    Dune::BlockPreconditioner<Vector, Vector, Comm> parallelIdentity(identity, comm);
+    Opm::SingleReductionGMResSolver<Vector> gmres(op, parallelIdentity, comm, reduction, 10, 1000, 0);
+    Dune::RestartedGMResSolver<Vector> duneGmres(op, sp, parallelIdentity, reduction, 10, 1000, 0);
+    checkSameAsDune(gmres, duneGmres, op, b, norm, reduction, 1);
+}
+#endif // HAVE_MPI
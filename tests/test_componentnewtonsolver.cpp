@@ -0,0 +1,216 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ComponentNewtonSolverTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/ComponentNewtonSolver.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    struct Vector : public std::vector<double>
+    {
+        Vector() = default;
+        explicit Vector(const int n) : std::vector<double>(n, 0.0) {}
+
+        Vector& operator*=(const double factor)
+        {
+            for (double& value : *this) {
+                value *= factor;
+            }
+            return *this;
+        }
+    };
+
+    typedef std::vector<Vector> Matrix;
+
+    // Saturation equations of a component of three cells with a cyclic flux
+    // 0 -> 1 -> 2 -> 0 and a source in cell 0, i.e. implicit upwind transport
+    //     s_i - s0_i + c (f(s_i) - f(s_{i-1})) - q_i = 0.
+    // The updates are chopped to keep the saturations in [0, 1].
+    class CyclicSystem
+    {
+    public:
+        explicit CyclicSystem(const double coupling)
+            : s_{ 0.2, 0.5, 0.8 }
+            , s0_(s_)
+            , q_{ 0.1, 0.0, 0.0 }
+            , c_(coupling)
+            , saves_(0)
+            , failSolve_(false)
+        {
+        }
+
+        void assemble(Vector& res, Matrix& jac)
+        {
+            const int n = s_.size();
+            res = Vector(n);
+            jac.assign(n, Vector(n));
+            for (int i = 0; i < n; ++i) {
+                const int up = (i + n - 1) % n;
+                res[i] = s_[i] - s0_[i] + c_ * (f(s_[i]) - f(s_[up])) - q_[i];
+                jac[i][i] = 1.0 + c_ * df(s_[i]);
+                jac[i][up] = -c_ * df(s_[up]);
+            }
+        }
+
+        bool converged(const Vector& res)
+        {
+            return std::all_of(res.begin(), res.end(),
+                               [](const double r) { return std::abs(r) < 1e-12; });
+        }
+
+        Vector solve(const Matrix& jac, const Vector& res)
+        {
+            if (failSolve_) {
+                OPM_THROW(Opm::NumericalProblem, "Singular Jacobian");
+            }
+            // Gaussian elimination without pivoting, the matrix is diagonally dominant
+            Matrix a = jac;
+            Vector x = res;
+            const int n = x.size();
+            for (int k = 0; k < n; ++k) {
+                for (int i = k + 1; i < n; ++i) {
+                    const double factor = a[i][k] / a[k][k];
+                    for (int j = k; j < n; ++j) {
+                        a[i][j] -= factor * a[k][j];
+                    }
+                    x[i] -= factor * x[k];
+                }
+            }
+            for (int i = n - 1; i >= 0; --i) {
+                for (int j = i + 1; j < n; ++j) {
+                    x[i] -= a[i][j] * x[j];
+                }
+                x[i] /= a[i][i];
+            }
+            return x;
+        }
+
+        void update(const Vector& dx)
+        {
+            for (std::size_t i = 0; i < s_.size(); ++i) {
+                s_[i] = std::max(std::min(s_[i] - dx[i], 1.0), 0.0);
+            }
+        }
+
+        void saveState()
+        {
+            saved_ = s_;
+            ++saves_;
+        }
+
+        void restoreState()
+        {
+            s_ = saved_;
+        }
+
+        // fractional flow with equal viscosities
+        static double f(const double s)
+        {
+            return s * s / (s * s + (1.0 - s) * (1.0 - s));
+        }
+
+        static double df(const double s)
+        {
+            const double d = s * s + (1.0 - s) * (1.0 - s);
+            return 2.0 * s * (1.0 - s) / (d * d);
+        }
+
+        std::vector<double> s_;
+        const std::vector<double> s0_;
+        const std::vector<double> q_;
+        const double c_;
+        std::vector<double> saved_;
+        int saves_;
+        bool failSolve_;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(CoupledNewtonConverges)
+{
+    CyclicSystem system(5.0);
+    Vector res;
+    Matrix jac;
+    BOOST_CHECK(Opm::solveComponentNewton(system, res, jac, 100));
+    BOOST_CHECK_EQUAL(system.saves_, 1);
+
+    // the cyclic flux redistributes the fluid, the source is conserved
+    Vector check;
+    system.assemble(check, jac);
+    double mass = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        BOOST_CHECK_SMALL(check[i], 1e-12);
+        mass += system.s_[i] - system.s0_[i];
+    }
+    BOOST_CHECK_CLOSE(mass, 0.1, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(FailedNewtonRestoresState)
+{
+    // Newton does not converge for the stronger coupling, the state before
+    // the first iteration is restored for the cell by cell fallback
+    {
+        CyclicSystem system(10.0);
+        Vector res;
+        Matrix jac;
+        BOOST_CHECK(!Opm::solveComponentNewton(system, res, jac, 100));
+        BOOST_CHECK(system.s_ == system.s0_);
+    }
+
+    // the same if it runs out of iterations
+    {
+        CyclicSystem system(5.0);
+        Vector res;
+        Matrix jac;
+        BOOST_CHECK(!Opm::solveComponentNewton(system, res, jac, 1));
+        BOOST_CHECK(system.s_ == system.s0_);
+    }
+
+    // a failing linear solver restores the state as well
+    {
+        CyclicSystem system(10.0);
+        system.failSolve_ = true;
+        Vector res;
+        Matrix jac;
+        BOOST_CHECK(!Opm::solveComponentNewton(system, res, jac, 100));
+        BOOST_CHECK(system.s_ == system.s0_);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Relaxation)
+{
+    BOOST_CHECK_EQUAL(Opm::reorderingNewtonRelaxation(0), 1.0);
+    BOOST_CHECK_EQUAL(Opm::reorderingNewtonRelaxation(10), 1.0);
+    BOOST_CHECK_EQUAL(Opm::reorderingNewtonRelaxation(11), 0.85);
+    BOOST_CHECK_EQUAL(Opm::reorderingNewtonRelaxation(31), 0.25);
+    BOOST_CHECK_EQUAL(Opm::reorderingNewtonRelaxation(1000), 0.25);
+}
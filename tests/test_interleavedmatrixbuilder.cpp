@@ -0,0 +1,147 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE InterleavedMatrixBuilderTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/InterleavedMatrixBuilder.hpp>
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <Eigen/Sparse>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <vector>
+
+namespace
+{
+    const int np = 2;
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<double, np, np> > Mat;
+    typedef Eigen::SparseMatrix<double> Sparse;
+
+    // Jacobians of two equations on a 1D grid of n cells, the derivatives
+    // with respect to the second unknowns have a wider stencil to the left,
+    // unless the well in the last cell connects it to the first cell.
+    std::vector<Sparse> createJacobians(const int n, const double shift, const bool well)
+    {
+        std::vector<Sparse> jacs(np*np, Sparse(n, n));
+        for (int p1 = 0; p1 < np; ++p1) {
+            for (int p2 = 0; p2 < np; ++p2) {
+                std::vector<Eigen::Triplet<double> > entries;
+                for (int i = 0; i < n; ++i) {
+                    const double value = shift + 10*p1 + p2 + 0.01*i;
+                    entries.emplace_back(i, i, value);
+                    if (i > 0) {
+                        entries.emplace_back(i, i - 1, -value);
+                    }
+                    if (p2 == 1 && i > 1) {
+                        entries.emplace_back(i, i - 2, 0.5*value);
+                    }
+                }
+                if (well && p1 == 0) {
+                    entries.emplace_back(n - 1, 0, shift + p2);
+                }
+                jacs[p1*np + p2].setFromTriplets(entries.begin(), entries.end());
+                jacs[p1*np + p2].makeCompressed();
+            }
+        }
+        return jacs;
+    }
+
+    std::vector<const Sparse*> pointers(const std::vector<Sparse>& jacs)
+    {
+        std::vector<const Sparse*> result;
+        for (const Sparse& jac : jacs) {
+            result.push_back(&jac);
+        }
+        return result;
+    }
+
+    // Check the matrix entry by entry against the jacobians.
+    void checkMatrix(const Mat& A, const std::vector<Sparse>& jacs)
+    {
+        const int n = jacs[0].rows();
+        BOOST_REQUIRE_EQUAL(int(A.N()), n);
+        int nnz = 0;
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                ++nnz;
+                for (int p1 = 0; p1 < np; ++p1) {
+                    for (int p2 = 0; p2 < np; ++p2) {
+                        BOOST_CHECK_EQUAL((*col)[p1][p2], jacs[p1*np + p2].coeff(row.index(), col.index()));
+                    }
+                }
+            }
+        }
+        // the union of the patterns: the wider stencil of the second unknowns
+        // and the well connection of the first equation
+        int expected = 0;
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                bool nonzero = false;
+                for (const Sparse& jac : jacs) {
+                    nonzero = nonzero || jac.coeff(i, j) != 0.0;
+                }
+                expected += nonzero;
+            }
+        }
+        BOOST_CHECK_EQUAL(nnz, expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UnionOfPatterns)
+{
+    const std::vector<Sparse> jacs = createJacobians(6, 1.0, true);
+    Opm::InterleavedMatrixBuilder<Mat> builder;
+    const Mat& A = builder.build(pointers(jacs));
+    checkMatrix(A, jacs);
+    BOOST_CHECK_EQUAL(builder.structureCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(StructureIsReused)
+{
+    Opm::InterleavedMatrixBuilder<Mat> builder;
+    const std::vector<Sparse> first = createJacobians(6, 1.0, false);
+    const Mat* A = &builder.build(pointers(first));
+
+    // new values in the same pattern are scattered into the same matrix
+    const std::vector<Sparse> second = createJacobians(6, 2.0, false);
+    BOOST_CHECK(&builder.build(pointers(second)) == A);
+    BOOST_CHECK_EQUAL(builder.structureCount(), 1);
+    checkMatrix(*A, second);
+
+    // a changed pattern, e.g. a well opening, creates a new structure
+    const std::vector<Sparse> third = createJacobians(6, 3.0, true);
+    checkMatrix(builder.build(pointers(third)), third);
+    BOOST_CHECK_EQUAL(builder.structureCount(), 2);
+
+    // as does a different number of cells
+    const std::vector<Sparse> fourth = createJacobians(8, 4.0, true);
+    checkMatrix(builder.build(pointers(fourth)), fourth);
+    BOOST_CHECK_EQUAL(builder.structureCount(), 3);
+}
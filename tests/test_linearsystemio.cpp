@@ -0,0 +1,207 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE LinearSystemIOTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/LinearSystemIO.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int numEq = 3;
+    typedef Dune::FieldMatrix<double, numEq, numEq> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, numEq> > Vector;
+
+    // tridiagonal matrix of n rows
+    Matrix createMatrix(const int n)
+    {
+        Matrix A(n, n, 3*n - 2, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index();
+            if (i > 0)     row.insert(i - 1);
+            row.insert(i);
+            if (i < n - 1) row.insert(i + 1);
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                for (int p = 0; p < numEq; ++p) {
+                    for (int q = 0; q < numEq; ++q) {
+                        (*col)[p][q] = std::sin(1.0 + 7*row.index() + 3*col.index() + 2*p + q);
+                    }
+                }
+            }
+        }
+        return A;
+    }
+
+    // a well with two equations perforating the cells 1 and 3
+    Opm::LinearSystemWell createWell()
+    {
+        Opm::LinearSystemWell well;
+        well.name = "PROD1";
+        well.numWellEq = 2;
+        well.numEq = numEq;
+        well.cellsB = { 1, 3 };
+        well.cellsC = { 1, 3 };
+        for (int k = 0; k < 2 * well.numWellEq * numEq; ++k) {
+            well.B.push_back(0.1 * (k + 1));
+            well.C.push_back(0.2 * std::cos(1.0 * k));
+        }
+        well.invD = { 2.0, 0.5, -0.25, 1.0 };
+        return well;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WriteAndReadLinearSystem)
+{
+    const Matrix A = createMatrix(5);
+    Vector b(A.N());
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        for (int k = 0; k < numEq; ++k) {
+            b[i][k] = std::cos(1.0 + numEq*i + k);
+        }
+    }
+    const std::vector<Opm::LinearSystemWell> wells = { createWell() };
+
+    Opm::LinearSystemInfo info;
+    info.reportStep = 4;
+    info.subStep = 2;
+    info.iteration = 1;
+    const std::string file = "test_linearsystemio.bin";
+    Opm::writeLinearSystem(file, info, A, b, wells);
+
+    const Opm::LinearSystemInfo header = Opm::readLinearSystemInfo(file);
+    BOOST_CHECK_EQUAL(header.blockSize, numEq);
+    BOOST_CHECK_EQUAL(header.reportStep, 4);
+    BOOST_CHECK_EQUAL(header.subStep, 2);
+    BOOST_CHECK_EQUAL(header.iteration, 1);
+
+    Matrix A2;
+    Vector b2;
+    std::vector<Opm::LinearSystemWell> wells2;
+    Opm::readLinearSystem(file, A2, b2, wells2);
+    std::remove(file.c_str());
+
+    BOOST_REQUIRE_EQUAL(A2.N(), A.N());
+    BOOST_REQUIRE_EQUAL(A2.nonzeroes(), A.nonzeroes());
+    auto row2 = A2.begin();
+    for (auto row = A.begin(); row != A.end(); ++row, ++row2) {
+        auto col2 = (*row2).begin();
+        for (auto col = (*row).begin(); col != (*row).end(); ++col, ++col2) {
+            BOOST_CHECK_EQUAL(col.index(), col2.index());
+            for (int p = 0; p < numEq; ++p) {
+                for (int q = 0; q < numEq; ++q) {
+                    BOOST_CHECK_EQUAL((*col)[p][q], (*col2)[p][q]);
+                }
+            }
+        }
+    }
+    BOOST_REQUIRE_EQUAL(b2.size(), b.size());
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        for (int k = 0; k < numEq; ++k) {
+            BOOST_CHECK_EQUAL(b2[i][k], b[i][k]);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(wells2.size(), 1u);
+    BOOST_CHECK_EQUAL(wells2[0].name, "PROD1");
+    BOOST_CHECK_EQUAL(wells2[0].numWellEq, 2);
+    BOOST_CHECK(wells2[0].cellsB == wells[0].cellsB);
+    BOOST_CHECK(wells2[0].B == wells[0].B);
+    BOOST_CHECK(wells2[0].C == wells[0].C);
+    BOOST_CHECK(wells2[0].invD == wells[0].invD);
+
+    // a system of a different block size can not be read
+    Opm::writeLinearSystem(file, info, A, b, wells);
+    Dune::BCRSMatrix<Dune::FieldMatrix<double, 2, 2> > A3;
+    Dune::BlockVector<Dune::FieldVector<double, 2> > b3;
+    BOOST_CHECK_THROW(Opm::readLinearSystem(file, A3, b3, wells2), std::runtime_error);
+    std::remove(file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(OperatorEliminatesTheWells)
+{
+    const Matrix A = createMatrix(5);
+    const std::vector<Opm::LinearSystemWell> wells = { createWell() };
+    const Opm::LinearSystemWell& well = wells[0];
+    Opm::LinearSystemOperator<Matrix, Vector, Vector> op(A, wells);
+
+    Vector x(A.N()), y(A.N());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        for (int k = 0; k < numEq; ++k) {
+            x[i][k] = 1.0 + i - 0.5*k;
+        }
+    }
+    op.apply(x, y);
+
+    // A x - C^T D^-1 B x computed by hand
+    Vector expected(A.N());
+    A.mv(x, expected);
+    double Bx[2] = { 0.0, 0.0 };
+    for (int perf = 0; perf < 2; ++perf) {
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < numEq; ++j) {
+                Bx[i] += well.B[(perf*2 + i)*numEq + j] * x[well.cellsB[perf]][j];
+            }
+        }
+    }
+    const double invDBx[2] = { well.invD[0]*Bx[0] + well.invD[1]*Bx[1],
+                               well.invD[2]*Bx[0] + well.invD[3]*Bx[1] };
+    for (int perf = 0; perf < 2; ++perf) {
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < numEq; ++j) {
+                expected[well.cellsC[perf]][j] -= well.C[(perf*2 + i)*numEq + j] * invDBx[i];
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < y.size(); ++i) {
+        for (int k = 0; k < numEq; ++k) {
+            BOOST_CHECK_CLOSE(y[i][k], expected[i][k], 1.0e-12);
+        }
+    }
+
+    // y + alpha (A - C^T D^-1 B) x
+    Vector z(A.N());
+    z = 1.0;
+    op.applyscaleadd(-2.0, x, z);
+    for (std::size_t i = 0; i < z.size(); ++i) {
+        for (int k = 0; k < numEq; ++k) {
+            BOOST_CHECK_CLOSE(z[i][k], 1.0 - 2.0*expected[i][k], 1.0e-10);
+        }
+    }
+}
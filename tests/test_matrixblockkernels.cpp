@@ -0,0 +1,163 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MatrixBlockKernelsTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/MatrixBlockKernels.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace
+{
+    template <class Block>
+    Block createBlock(const double shift)
+    {
+        Block A;
+        for (int i = 0; i < Block::rows; ++i) {
+            for (int j = 0; j < Block::cols; ++j) {
+                A[i][j] = std::sin(1.0 + shift + 3*i + j);
+            }
+        }
+        return A;
+    }
+
+    template <class Vector>
+    Vector createVector(const double shift)
+    {
+        Vector x;
+        for (int i = 0; i < Vector::dimension; ++i) {
+            x[i] = std::cos(shift + i);
+        }
+        return x;
+    }
+
+    // compare the kernels with the plain loops for an n x n block
+    template <class K, int n>
+    void checkKernels()
+    {
+        typedef Dune::FieldMatrix<K, n, n> Block;
+        typedef Dune::FieldVector<double, n> Vector;
+
+        const double tol = std::is_same<K, float>::value ? 1e-6 : 1e-14;
+        const Block A = createBlock<Block>(0.5);
+        const Vector x = createVector<Vector>(0.25);
+        const Vector y0 = createVector<Vector>(2.0);
+        const double alpha = -0.75;
+
+        Vector ax(0.0);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                ax[i] += A[i][j] * x[j];
+            }
+        }
+
+        Vector y(y0);
+        Opm::blockkernels::mv(A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_SMALL(y[i] - ax[i], tol);
+        }
+
+        y = y0;
+        Opm::blockkernels::umv(A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_SMALL(y[i] - (y0[i] + ax[i]), tol);
+        }
+
+        y = y0;
+        Opm::blockkernels::mmv(A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_SMALL(y[i] - (y0[i] - ax[i]), tol);
+        }
+
+        y = y0;
+        Opm::blockkernels::usmv(alpha, A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_SMALL(y[i] - (y0[i] + alpha * ax[i]), tol);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BlockProducts)
+{
+    checkKernels<double, 1>();
+    checkKernels<double, 2>();
+    checkKernels<double, 3>();
+    checkKernels<double, 4>();
+    checkKernels<double, 5>();
+
+    // single precision blocks applied to double vectors
+    checkKernels<float, 2>();
+    checkKernels<float, 3>();
+    checkKernels<float, 4>();
+}
+
+BOOST_AUTO_TEST_CASE(SparseProducts)
+{
+    const int n = 10;
+    const int blockSize = 4;
+    typedef Dune::FieldMatrix<double, blockSize, blockSize> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, blockSize> > Vector;
+
+    Matrix A(n, n, 3*n, Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        const int i = row.index();
+        for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); ++j) {
+            row.insert(j);
+        }
+    }
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+            *col = createBlock<Block>(row.index() + 0.1 * col.index());
+        }
+    }
+
+    Vector x(n), y(n), yRef(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = createVector<Dune::FieldVector<double, blockSize> >(i);
+    }
+
+    A.mv(x, yRef);
+    y = 1.0;
+    Opm::blockkernels::bcrsMv(A, x, y);
+    yRef -= y;
+    BOOST_CHECK_SMALL(yRef.two_norm(), 1e-13);
+
+    const double alpha = 0.3;
+    y = 1.0;
+    yRef = 1.0;
+    A.usmv(alpha, x, yRef);
+    Opm::blockkernels::bcrsUsmv(alpha, A, x, y);
+    yRef -= y;
+    BOOST_CHECK_SMALL(yRef.two_norm(), 1e-13);
+}
@@ -0,0 +1,179 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MatrixReorderingTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/MatrixReordering.hpp>
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/solvers.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+    const int blockSize = 2;
+
+    typedef Dune::FieldMatrix<double, blockSize, blockSize> Block;
+    typedef Dune::BCRSMatrix<Block>                         Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, blockSize> > Vector;
+
+    // Five point stencil on a nx x ny grid with the cells numbered in
+    // a scattered order, as for grids with many inactive cells.
+    Matrix createMatrix(const int nx, const int ny)
+    {
+        const int n = nx * ny;
+        std::vector<int> index(n);
+        for (int c = 0; c < n; ++c) {
+            index[c] = (7 * c) % n;
+        }
+
+        Matrix A(n, n, 5*n, Matrix::row_wise);
+        std::vector<std::vector<int> > neighbours(n);
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                auto& nb = neighbours[index[j*nx + i]];
+                nb.push_back(index[j*nx + i]);
+                if (i > 0)      nb.push_back(index[j*nx + i - 1]);
+                if (i < nx - 1) nb.push_back(index[j*nx + i + 1]);
+                if (j > 0)      nb.push_back(index[(j - 1)*nx + i]);
+                if (j < ny - 1) nb.push_back(index[(j + 1)*nx + i]);
+            }
+        }
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            for (const int col : neighbours[row.index()]) {
+                row.insert(col);
+            }
+        }
+
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                *col = 0.0;
+                const double value = col.index() == row.index() ? 4.0 : -1.0;
+                (*col)[0][0] = 100.0 * value;
+                (*col)[1][1] = value + (col.index() == row.index() ? 0.1 : 0.0);
+                (*col)[1][0] = 10.0 * value;
+            }
+        }
+        return A;
+    }
+
+    std::size_t bandwidth(const Matrix& A, const std::vector<std::size_t>& newIndex)
+    {
+        std::size_t result = 0;
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                const std::size_t i = newIndex[row.index()];
+                const std::size_t j = newIndex[col.index()];
+                result = std::max(result, i > j ? i - j : j - i);
+            }
+        }
+        return result;
+    }
+
+    void solve(const Matrix& A, const std::vector<std::size_t>& ordering)
+    {
+        typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+        typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+
+        Operator op(A);
+        ILU ilu(A, 0, 1.0, ordering);
+        Dune::SeqScalarProduct<Vector> sp;
+        Dune::BiCGSTABSolver<Vector> solver(op, sp, ilu, 1e-10, 500, 0);
+
+        Vector x(A.N()), b(A.N());
+        x = 1.0;
+        A.mv(x, b);
+        Vector sol(A.N());
+        sol = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(sol, b, result);
+
+        BOOST_CHECK(result.converged);
+        sol -= x;
+        BOOST_CHECK_SMALL(sol.two_norm() / x.two_norm(), 1e-7);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReverseCuthillMcKee)
+{
+    const int nx = 30;
+    const Matrix A = createMatrix(nx, 20);
+
+    const std::vector<std::size_t> ordering = Opm::reverseCuthillMcKee(A);
+    BOOST_REQUIRE_EQUAL(ordering.size(), A.N());
+
+    // the ordering is a permutation
+    std::vector<std::size_t> sorted(ordering);
+    std::sort(sorted.begin(), sorted.end());
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        BOOST_CHECK_EQUAL(sorted[i], i);
+    }
+
+    std::vector<std::size_t> identity(A.N());
+    for (std::size_t i = 0; i < identity.size(); ++i) {
+        identity[i] = i;
+    }
+    const std::vector<std::size_t> inverse = Opm::inverseOrdering(ordering);
+    BOOST_CHECK_GT(bandwidth(A, identity), 10 * nx);
+    BOOST_CHECK_LE(bandwidth(A, inverse), 2 * nx);
+
+    // the reordered matrix has the entries of A
+    Matrix B;
+    Opm::reorderMatrix(A, ordering, inverse, B);
+    BOOST_CHECK_EQUAL(B.nonzeroes(), A.nonzeroes());
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+            const Block& b = B[inverse[row.index()]][inverse[col.index()]];
+            BOOST_CHECK_EQUAL(b[1][0], (*col)[1][0]);
+            BOOST_CHECK_EQUAL(b[1][1], (*col)[1][1]);
+        }
+    }
+
+    Vector x(A.N()), y(A.N()), z(A.N());
+    for (std::size_t i = 0; i < A.N(); ++i) {
+        x[i] = i;
+    }
+    Opm::reorderVector(x, ordering, y);
+    Opm::restoreVectorOrder(y, ordering, z);
+    z -= x;
+    BOOST_CHECK_EQUAL(z.two_norm(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(ReorderedILU)
+{
+    // the solution does not depend on the order of the factorization
+    const Matrix A = createMatrix(30, 20);
+    solve(A, std::vector<std::size_t>());
+    solve(A, Opm::reverseCuthillMcKee(A));
+}
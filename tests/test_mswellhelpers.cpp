@@ -0,0 +1,150 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MSWellHelpersTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/common/Exceptions.hpp>
+#include <opm/autodiff/MSWellHelpers.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+namespace
+{
+    const int blockSize = 4;
+
+    typedef Dune::FieldMatrix<double, blockSize, blockSize> Block;
+    typedef Dune::BCRSMatrix<Block>                         Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, blockSize> > Vector;
+
+    // Segments of a well, each coupled to its outlet segment.
+    Matrix createMatrix(const int nseg, const double scale)
+    {
+        Matrix D(nseg, nseg, 2*nseg - 1, Matrix::row_wise);
+        for (auto row = D.createbegin(); row != D.createend(); ++row) {
+            const int seg = row.index();
+            if (seg > 0) {
+                row.insert(seg - 1);
+            }
+            row.insert(seg);
+        }
+
+        for (int seg = 0; seg < nseg; ++seg) {
+            Block& diag = D[seg][seg];
+            for (int i = 0; i < blockSize; ++i) {
+                for (int j = 0; j < blockSize; ++j) {
+                    diag[i][j] = scale * (i == j ? 10.0 + seg : 1.0 / (1.0 + i + j));
+                }
+            }
+            if (seg > 0) {
+                D[seg][seg - 1] = 0.0;
+                for (int i = 0; i < blockSize; ++i) {
+                    D[seg][seg - 1][i][i] = -scale;
+                }
+            }
+        }
+        return D;
+    }
+
+    Vector createVector(const int nseg)
+    {
+        Vector x(nseg);
+        for (int seg = 0; seg < nseg; ++seg) {
+            for (int i = 0; i < blockSize; ++i) {
+                x[seg][i] = 1.0 + 0.1 * seg - 0.2 * i;
+            }
+        }
+        return x;
+    }
+
+    double relativeResidual(const Matrix& D, const Vector& y, const Vector& x)
+    {
+        Vector r(x);
+        D.mmv(y, r);
+        return r.two_norm() / x.two_norm();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(IterativeSolve)
+{
+    const int nseg = 20;
+    const Matrix D = createMatrix(nseg, 1.0);
+    const Vector x = createVector(nseg);
+
+    const Vector y = Opm::mswellhelpers::invDX(D, x);
+    BOOST_CHECK_SMALL(relativeResidual(D, y, x), 1e-7);
+}
+
+#if HAVE_UMFPACK
+BOOST_AUTO_TEST_CASE(CachedFactorization)
+{
+    const int nseg = 20;
+    const Vector x = createVector(nseg);
+
+    Opm::mswellhelpers::CachedUMFPack<Matrix> solver;
+    BOOST_CHECK(!solver.factorized());
+
+    // the symbolic factorization is reused for new values with the same pattern
+    for (const double scale : { 1.0, 2.5, 0.1 }) {
+        const Matrix D = createMatrix(nseg, scale);
+        solver.factorize(D);
+        BOOST_CHECK(solver.factorized());
+
+        // repeated solves with the same factors
+        for (int k = 0; k < 2; ++k) {
+            const Vector y = solver.solve(x);
+            BOOST_CHECK_SMALL(relativeResidual(D, y, x), 1e-12);
+
+            const Vector yDirect = Opm::mswellhelpers::invDXDirect(D, x);
+            Vector diff(y);
+            diff -= yDirect;
+            BOOST_CHECK_SMALL(diff.two_norm(), 1e-12 * y.two_norm());
+        }
+    }
+
+    // a different number of segments requires a new symbolic factorization
+    const Matrix D = createMatrix(nseg + 5, 1.0);
+    const Vector x2 = createVector(nseg + 5);
+    solver.factorize(D);
+    BOOST_CHECK_SMALL(relativeResidual(D, solver.solve(x2), x2), 1e-12);
+
+    solver.reset();
+    BOOST_CHECK(!solver.factorized());
+}
+
+BOOST_AUTO_TEST_CASE(SingularMatrix)
+{
+    const int nseg = 5;
+    Matrix D = createMatrix(nseg, 1.0);
+    D[2] = 0.0;
+
+    Opm::mswellhelpers::CachedUMFPack<Matrix> solver;
+    solver.factorize(D);
+    BOOST_CHECK_THROW(solver.solve(createVector(nseg)), Opm::NumericalProblem);
+}
+#endif // HAVE_UMFPACK
@@ -0,0 +1,88 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE NonlinearSolverTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/NonlinearSolver.hpp>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // the line search criterion does not need a physical model
+    struct DummyModel
+    {
+        typedef int ReservoirState;
+        typedef int WellState;
+    };
+
+    typedef Opm::NonlinearSolver<DummyModel> Solver;
+
+    Solver createSolver()
+    {
+        Solver::SolverParameters param;
+        param.use_line_search_ = true;
+        return Solver(param, std::unique_ptr<DummyModel>(new DummyModel()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LineSearchAcceptsDecrease)
+{
+    const Solver solver = createSolver();
+    const std::vector<double> before = { 1.0, 2.0, 0.5 };
+    const std::vector<double> after = { 0.5, 1.0, 0.25 };
+    BOOST_CHECK(!solver.rejectLineSearchStep(before, after, 1.0));
+    BOOST_CHECK(!solver.rejectLineSearchStep(before, after, solver.lineSearchMinStep()));
+
+    // the norm of all phases counts, not every single phase
+    const std::vector<double> mixed = { 1.5, 0.1, 0.1 };
+    BOOST_CHECK(!solver.rejectLineSearchStep(before, mixed, 1.0));
+}
+
+BOOST_AUTO_TEST_CASE(LineSearchRejectsInsufficientDecrease)
+{
+    const Solver solver = createSolver();
+    const std::vector<double> before = { 3.0, 4.0 };
+
+    // growing and stagnating residuals
+    BOOST_CHECK(solver.rejectLineSearchStep(before, { 3.0, 4.5 }, 1.0));
+    BOOST_CHECK(solver.rejectLineSearchStep(before, before, 1.0));
+    BOOST_CHECK(solver.rejectLineSearchStep(before, before, solver.lineSearchMinStep()));
+
+    // Armijo condition, the required decrease is proportional to the step:
+    // a decrease of the norm by 0.5e-4 is too small for the full update,
+    // but sufficient for a quarter of it
+    const double factor = 1.0 - 0.5e-4;
+    const std::vector<double> after = { 3.0 * factor, 4.0 * factor };
+    BOOST_CHECK(solver.rejectLineSearchStep(before, after, 1.0));
+    BOOST_CHECK(!solver.rejectLineSearchStep(before, after, 0.25));
+
+    // non-finite residuals are always rejected
+    BOOST_CHECK(solver.rejectLineSearchStep(before, { 3.0, std::nan("") }, 1.0));
+}
@@ -0,0 +1,176 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ParallelOverlappingILU0Test
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const int blockSize = 2;
+
+    typedef Dune::FieldMatrix<double, blockSize, blockSize> Block;
+    typedef Dune::BCRSMatrix<Block>                         Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, blockSize> > Vector;
+
+    // gives access to whether the triangular solves use level sets
+    class ILU : public Opm::ParallelOverlappingILU0<Matrix, Vector, Vector>
+    {
+    public:
+        explicit ILU(const Matrix& A)
+            : Opm::ParallelOverlappingILU0<Matrix, Vector, Vector>(A, 0, 1.0)
+        {
+        }
+
+        bool usesLevelSets() const
+        {
+            return this->useLevelSets_;
+        }
+    };
+
+    // Upwind five point stencil on a nx x ny grid with two coupled unknowns
+    // per cell. The rows of the factors on the anti-diagonals of the grid
+    // are independent, i.e. there are nx + ny - 1 level sets.
+    Matrix createMatrix(const int nx, const int ny)
+    {
+        const int n = nx * ny;
+        Matrix A(n, n, 5*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int c = row.index();
+            const int i = c % nx;
+            const int j = c / nx;
+            if (j > 0)      row.insert(c - nx);
+            if (i > 0)      row.insert(c - 1);
+            row.insert(c);
+            if (i < nx - 1) row.insert(c + 1);
+            if (j < ny - 1) row.insert(c + nx);
+        }
+
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = (*row).begin(); col != (*row).end(); ++col) {
+                Block& block = *col;
+                block = 0.0;
+                const int c = row.index();
+                if (col.index() == row.index()) {
+                    block[0][0] = 8.0 + std::sin(0.1 * c);
+                    block[0][1] = 0.3;
+                    block[1][0] = 0.7;
+                    block[1][1] = 5.0;
+                }
+                else {
+                    const double upwind = (int(col.index()) < c) ? -1.5 : -0.5;
+                    block[0][0] = upwind;
+                    block[1][1] = 0.5 * upwind;
+                    block[1][0] = 0.1 * upwind;
+                }
+            }
+        }
+        return A;
+    }
+
+    Vector createRhs(const int n)
+    {
+        Vector d(n);
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < blockSize; ++k) {
+                d[i][k] = std::cos(0.01 * (blockSize*i + k)) + 0.5;
+            }
+        }
+        return d;
+    }
+}
+
+#if HAVE_OPENMP
+
+BOOST_AUTO_TEST_CASE(LevelScheduledSolveIsBitwiseSequential)
+{
+    const int nx = 128;
+    const Matrix A = createMatrix(nx, nx);
+    const Vector d = createRhs(A.N());
+    const int maxThreads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    ILU sequential(A);
+    BOOST_CHECK(!sequential.usesLevelSets());
+    Vector reference(A.N()), rhs(d);
+    reference = 0.0;
+    sequential.apply(reference, rhs);
+
+    for (const int threads : { 2, 3, 4, 8 }) {
+        omp_set_num_threads(threads);
+        ILU ilu(A);
+        BOOST_CHECK(ilu.usesLevelSets());
+
+        // repeated applications give the same result as well
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            Vector v(A.N());
+            rhs = d;
+            v = 0.0;
+            ilu.apply(v, rhs);
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                for (int k = 0; k < blockSize; ++k) {
+                    BOOST_REQUIRE_EQUAL(v[i][k], reference[i][k]);
+                }
+            }
+        }
+    }
+
+    omp_set_num_threads(maxThreads);
+}
+
+BOOST_AUTO_TEST_CASE(FewRowsPerLevelAreSolvedSequentially)
+{
+    // the synchronization of the levels of a narrow grid does not pay off
+    const Matrix A = createMatrix(200, 2);
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    ILU ilu(A);
+    BOOST_CHECK(!ilu.usesLevelSets());
+    omp_set_num_threads(maxThreads);
+}
+
+#else
+
+BOOST_AUTO_TEST_CASE(SequentialWithoutOpenMP)
+{
+    const Matrix A = createMatrix(128, 128);
+    ILU ilu(A);
+    BOOST_CHECK(!ilu.usesLevelSets());
+}
+
+#endif // HAVE_OPENMP
@@ -0,0 +1,223 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE StandardWellHelpersTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/StandardWellHelpers.hpp>
+#include <opm/material/densead/Evaluation.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Opm::DenseAd::Evaluation<double, 3> Eval;
+
+    // water, oil, gas and solvent
+    Opm::standardwellhelpers::PerforationRateLayout layout(const bool is_producer)
+    {
+        Opm::standardwellhelpers::PerforationRateLayout layout;
+        layout.num_components = 4;
+        layout.water_pos = 0;
+        layout.oil_pos = 1;
+        layout.gas_pos = 2;
+        layout.solvent_pos = 3;
+        layout.is_producer = is_producer;
+        return layout;
+    }
+
+    // the rates of a perforation computed without and with derivatives
+    void checkSameRates(const bool is_producer, const double bhp, const bool allow_cf)
+    {
+        const std::vector<double> mob = { 0.3, 1.2, 4.0, 2.5 };
+        const std::vector<double> b = { 1.01, 0.85, 120.0, 95.0 };
+        const std::vector<double> cmix = { 0.1, 0.2, 0.6, 0.1 };
+        const double pressure = 250.0e5;
+        const double rs = 80.0;
+        const double rv = 1.0e-4;
+        const double Tw = 1.0e-12;
+        const double cdp = 2.0e5;
+
+        std::vector<double> cq_s(4, -1.0);
+        Opm::standardwellhelpers::computePerfRate(layout(is_producer), "W", mob, b, cmix, pressure, rs, rv,
+                                                  Tw, bhp, cdp, allow_cf, cq_s);
+
+        // derivatives with respect to the pressure, the bhp and the oil mobility
+        std::vector<Eval> mob_eval, b_eval, cmix_eval;
+        for (int comp = 0; comp < 4; ++comp) {
+            mob_eval.push_back(comp == 1 ? Eval::createVariable(mob[comp], 2) : Eval(mob[comp]));
+            b_eval.push_back(Eval(b[comp]));
+            cmix_eval.push_back(Eval(cmix[comp]));
+        }
+        std::vector<Eval> cq_s_eval(4, Eval(-1.0));
+        Opm::standardwellhelpers::computePerfRate(layout(is_producer), "W", mob_eval, b_eval, cmix_eval,
+                                                  Eval::createVariable(pressure, 0), Eval(rs), Eval(rv),
+                                                  Tw, Eval::createVariable(bhp, 1), cdp, allow_cf, cq_s_eval);
+
+        for (int comp = 0; comp < 4; ++comp) {
+            BOOST_CHECK_CLOSE(cq_s_eval[comp].value(), cq_s[comp], 1.0e-12);
+        }
+    }
+
+    // a producer with a linear inflow and the bhp from the THP constraint given by vfp,
+    // limited by the bhp limit
+    const double reservoirPressure = 300.0e5;
+    const double productivity = 1.0e-9;
+    const double bhpLimit = 100.0e5;
+
+    void computeRates(const double bhp, std::vector<double>& rates)
+    {
+        rates.assign(1, -productivity * (reservoirPressure - bhp));
+    }
+
+    template <class Vfp>
+    double bhpFromThp(const Vfp& vfp, const std::vector<double>& rates)
+    {
+        return std::max(bhpLimit, vfp(rates[0]));
+    }
+
+    template <class Vfp>
+    bool wellPotential(const Vfp& vfp, std::vector<double>& potentials, int& evaluations)
+    {
+        evaluations = 0;
+        auto rates = [&](const double bhp, std::vector<double>& q) {
+            ++evaluations;
+            computeRates(bhp, q);
+        };
+        auto thp = [&](const std::vector<double>& q) { return bhpFromThp(vfp, q); };
+
+        std::vector<double> initial_potential;
+        computeRates(bhpLimit, initial_potential);
+        return Opm::standardwellhelpers::computeWellPotentialWithTHP(rates, thp, bhpLimit, reservoirPressure,
+                                                                     initial_potential, potentials);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DoubleAndEvaluationRatesAgree)
+{
+    for (const bool is_producer : { true, false }) {
+        for (const bool allow_cf : { true, false }) {
+            // producing and injecting perforations
+            checkSameRates(is_producer, 200.0e5, allow_cf);
+            checkSameRates(is_producer, 300.0e5, allow_cf);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PerfRateWithoutCrossflow)
+{
+    // an injecting perforation of a producer without crossflow leaves the rates unchanged
+    const std::vector<double> mob(4, 1.0), b(4, 1.0), cmix(4, 0.25);
+    std::vector<double> cq_s(4, -1.0);
+    Opm::standardwellhelpers::computePerfRate(layout(true), "W", mob, b, cmix, 100.0e5, 0.0, 0.0,
+                                              1.0e-12, 200.0e5, 0.0, false, cq_s);
+    for (const double rate : cq_s) {
+        BOOST_CHECK_EQUAL(rate, -1.0);
+    }
+
+    // zero d value
+    BOOST_CHECK_THROW(Opm::standardwellhelpers::computePerfRate(layout(true), "W", mob, b, cmix, 100.0e5, 1.0, 1.0,
+                                                                1.0e-12, 200.0e5, 0.0, true, cq_s),
+                      Opm::NumericalProblem);
+}
+
+BOOST_AUTO_TEST_CASE(RegulaFalsiIllinois)
+{
+    // plain regula falsi converges one-sided and slowly for a convex function
+    int evaluations = 0;
+    auto f = [&](const double x) { ++evaluations; return std::exp(x) - 10.0; };
+    double root = 0.0;
+    BOOST_CHECK(Opm::standardwellhelpers::regulaFalsiIllinois(f, 0.0, 5.0, 1.0e-10, 100, root));
+    BOOST_CHECK_CLOSE(root, std::log(10.0), 1.0e-8);
+    BOOST_CHECK_LT(evaluations, 20);
+
+    // the end points are accepted
+    BOOST_CHECK(Opm::standardwellhelpers::regulaFalsiIllinois(f, std::log(10.0), 5.0, 1.0e-10, 100, root));
+    BOOST_CHECK_EQUAL(root, std::log(10.0));
+
+    // no sign change
+    auto g = [](const double x) { return x * x + 1.0; };
+    BOOST_CHECK(!Opm::standardwellhelpers::regulaFalsiIllinois(g, -1.0, 2.0, 1.0e-10, 100, root));
+
+    // too few iterations
+    BOOST_CHECK(!Opm::standardwellhelpers::regulaFalsiIllinois(f, 0.0, 5.0, 1.0e-10, 2, root));
+}
+
+BOOST_AUTO_TEST_CASE(WellPotentialBracketed)
+{
+    // the root of bhp = 150 bar + 4e13 q^2 is bracketed by the bhp limit and the reservoir pressure
+    auto vfp = [](const double q) { return 150.0e5 + 4.0e13 * q * q; };
+    std::vector<double> potentials;
+    int evaluations = 0;
+    BOOST_CHECK(wellPotential(vfp, potentials, evaluations));
+    BOOST_REQUIRE_EQUAL(potentials.size(), 1u);
+
+    const double bhp = reservoirPressure + potentials[0] / productivity;
+    BOOST_CHECK_SMALL(bhp - bhpFromThp(vfp, potentials), 1000.0);
+    BOOST_CHECK_LT(potentials[0], 0.0);
+    BOOST_CHECK_LT(evaluations, 20);
+}
+
+BOOST_AUTO_TEST_CASE(WellPotentialFlatVfp)
+{
+    // a bhp independent of the rates
+    auto vfp = [](const double) { return 200.0e5; };
+    std::vector<double> potentials;
+    int evaluations = 0;
+    BOOST_CHECK(wellPotential(vfp, potentials, evaluations));
+    BOOST_REQUIRE_EQUAL(potentials.size(), 1u);
+    BOOST_CHECK_CLOSE(potentials[0], -productivity * 100.0e5, 1.0e-6);
+
+    // a flat curve below the bhp limit gives the rates at the bhp limit
+    auto low = [](const double) { return 50.0e5; };
+    BOOST_CHECK(wellPotential(low, potentials, evaluations));
+    BOOST_CHECK_CLOSE(potentials[0], -productivity * (reservoirPressure - bhpLimit), 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(WellPotentialFallback)
+{
+    // the bhp at zero rate is above the reservoir pressure, there is no sign change
+    // between the bhp limit and the reservoir pressure and the fixed point iteration is used
+    auto vfp = [](const double q) { return 350.0e5 - 1.0e7 * q; };
+    auto residual = [&](const double bhp) {
+        std::vector<double> rates;
+        computeRates(bhp, rates);
+        return bhp - bhpFromThp(vfp, rates);
+    };
+    double root = 0.0;
+    BOOST_CHECK(!Opm::standardwellhelpers::regulaFalsiIllinois(residual, bhpLimit, reservoirPressure, 1000.0, 100, root));
+
+    std::vector<double> potentials;
+    int evaluations = 0;
+    BOOST_CHECK(wellPotential(vfp, potentials, evaluations));
+    BOOST_REQUIRE_EQUAL(potentials.size(), 1u);
+    BOOST_CHECK(std::isfinite(potentials[0]));
+    // the well can not produce against the THP constraint
+    BOOST_CHECK_GT(potentials[0], 0.0);
+    // the end points of the bracketing and at least one fixed point iteration
+    BOOST_CHECK_GT(evaluations, 2);
+}
@@ -0,0 +1,137 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ThreadHandleTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/ThreadHandle.hpp>
+#include <opm/common/OpmLog/CounterLog.hpp>
+#include <opm/common/OpmLog/LogUtil.hpp>
+#include <opm/common/OpmLog/OpmLog.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+namespace
+{
+    struct CountingObject
+    {
+        std::atomic<int>& executed_;
+        std::atomic<int>& alive_;
+        int& maxAlive_;
+
+        CountingObject(std::atomic<int>& executed, std::atomic<int>& alive, int& maxAlive)
+            : executed_(executed), alive_(alive), maxAlive_(maxAlive)
+        {
+            maxAlive_ = std::max(maxAlive_, ++alive_);
+        }
+
+        CountingObject(CountingObject&& other)
+            : executed_(other.executed_), alive_(other.alive_), maxAlive_(other.maxAlive_)
+        {
+            ++alive_;
+        }
+
+        ~CountingObject()
+        {
+            --alive_;
+        }
+
+        void run()
+        {
+            // simulate slow output
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            ++executed_;
+        }
+    };
+
+    struct ThrowingObject
+    {
+        void run()
+        {
+            throw std::runtime_error("write failed");
+        }
+    };
+}
+
+BOOST_AUTO_TEST_CASE(AllObjectsExecutedWithBoundedQueue)
+{
+    std::atomic<int> executed(0);
+    std::atomic<int> alive(0);
+    int maxAlive = 0;
+    const int numObjects = 50;
+    const size_t maxQueueSize = 3;
+    {
+        Opm::ThreadHandle handle(true, maxQueueSize);
+        for (int i = 0; i < numObjects; ++i) {
+            handle.dispatch(CountingObject(executed, alive, maxAlive));
+        }
+        // the destructor waits for all objects
+    }
+    BOOST_CHECK_EQUAL(executed.load(), numObjects);
+    BOOST_CHECK_EQUAL(alive.load(), 0);
+    // queued objects, the one being executed and the one being dispatched
+    BOOST_CHECK_LE(maxAlive, int(maxQueueSize) + 3);
+}
+
+BOOST_AUTO_TEST_CASE(ExceptionIsReportedOnDispatch)
+{
+    Opm::ThreadHandle handle(true, 1);
+    handle.dispatch(ThrowingObject());
+
+    bool thrown = false;
+    for (int i = 0; i < 100 && !thrown; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        try {
+            handle.dispatch(ThrowingObject());
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+    }
+    BOOST_CHECK(thrown);
+}
+
+BOOST_AUTO_TEST_CASE(ExceptionOfLastObjectIsLogged)
+{
+    auto counter = std::make_shared<Opm::CounterLog>();
+    Opm::OpmLog::addBackend("counter", counter);
+    {
+        Opm::ThreadHandle handle(true, 1);
+        handle.dispatch(ThrowingObject());
+        // the destructor can not rethrow the error
+    }
+    BOOST_CHECK_EQUAL(counter->numMessages(Opm::Log::MessageType::Error), 1u);
+    Opm::OpmLog::removeBackend("counter");
+}
+
+BOOST_AUTO_TEST_CASE(DispatchWithoutThread)
+{
+    Opm::ThreadHandle handle(false);
+    BOOST_CHECK_THROW(handle.dispatch(ThrowingObject()), std::logic_error);
+}
@@ -0,0 +1,153 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE TimerRegistryTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/TimerRegistry.hpp>
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    struct MPIFixture
+    {
+        MPIFixture()
+        {
+            auto& suite = boost::unit_test::framework::master_test_suite();
+            Dune::MPIHelper::instance(suite.argc, suite.argv);
+        }
+    };
+
+    void nestedTimers()
+    {
+        Opm::ScopedTimer outer("outer");
+        for (int i = 0; i < 3; ++i) {
+            Opm::ScopedTimer inner("inner");
+        }
+    }
+
+    std::size_t count(const std::string& s, const std::string& pattern)
+    {
+        std::size_t n = 0;
+        for (std::size_t pos = s.find(pattern); pos != std::string::npos; pos = s.find(pattern, pos + 1)) {
+            ++n;
+        }
+        return n;
+    }
+}
+
+BOOST_GLOBAL_FIXTURE(MPIFixture);
+
+BOOST_AUTO_TEST_CASE(TimersAreRecordedWhenEnabled)
+{
+    Opm::TimerRegistry& registry = Opm::TimerRegistry::instance();
+
+    // nothing is recorded before the registry is enabled
+    nestedTimers();
+    {
+        std::ostringstream os;
+        registry.report(os);
+        BOOST_CHECK_EQUAL(count(os.str(), "outer"), 0);
+    }
+
+    registry.enable(10);
+    BOOST_CHECK(registry.enabled());
+    nestedTimers();
+    nestedTimers();
+    {
+        // a timer started outside of "outer" is a different timer
+        Opm::ScopedTimer inner("inner");
+    }
+
+    std::ostringstream os;
+    registry.report(os);
+    const std::string report = os.str();
+    if (Dune::MPIHelper::getCollectiveCommunication().rank() == 0) {
+        std::istringstream is(report);
+        std::string line;
+        std::getline(is, line);
+        BOOST_CHECK_EQUAL(line.find("Timer"), 0);
+
+        // the timers are listed by path with the children after their parent
+        std::getline(is, line);
+        std::istringstream inner(line);
+        std::string name;
+        int calls;
+        inner >> name >> calls;
+        BOOST_CHECK_EQUAL(name, "inner");
+        BOOST_CHECK_EQUAL(calls, 1);
+
+        std::getline(is, line);
+        std::istringstream outer(line);
+        outer >> name >> calls;
+        BOOST_CHECK_EQUAL(name, "outer");
+        BOOST_CHECK_EQUAL(calls, 2);
+
+        std::getline(is, line);
+        BOOST_CHECK_EQUAL(line.find("  inner"), 0);
+        std::istringstream nested(line);
+        nested >> name >> calls;
+        BOOST_CHECK_EQUAL(calls, 6);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TraceIsLimitedToMaxEvents)
+{
+    auto cc = Dune::MPIHelper::getCollectiveCommunication();
+    const std::string file = "test_timerregistry_trace.json";
+    Opm::TimerRegistry::instance().writeTrace(file, cc);
+
+    std::string written = file;
+    if (cc.size() > 1) {
+        written = "test_timerregistry_trace." + std::to_string(cc.rank()) + ".json";
+    }
+    std::ifstream is(written);
+    BOOST_REQUIRE(is);
+    const std::string trace((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    is.close();
+    std::remove(written.c_str());
+
+    // 9 intervals were recorded, up to 10 are kept for the trace
+    BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"X\""), 9);
+    BOOST_CHECK_EQUAL(count(trace, "\"droppedEvents\":0"), 1);
+
+    for (int i = 0; i < 2; ++i) {
+        Opm::ScopedTimer timer("extra");
+    }
+    Opm::TimerRegistry::instance().writeTrace(file, cc);
+    is.open(written);
+    const std::string trace2((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    is.close();
+    std::remove(written.c_str());
+    BOOST_CHECK_EQUAL(count(trace2, "\"ph\":\"X\""), 10);
+    BOOST_CHECK_EQUAL(count(trace2, "\"droppedEvents\":1"), 1);
+}
@@ -0,0 +1,156 @@
+/*
+  Copyright 2018 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE TimeStepControlTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/simulators/timestepping/TimeStepControl.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    struct ConstantRelativeChange : public Opm::RelativeChangeInterface
+    {
+        double relativeChange() const { return 1.0e-3; }
+    };
+
+    Opm::NonlinearConvergenceInfo convergence(const int iterations, const double rate, const double residual)
+    {
+        Opm::NonlinearConvergenceInfo info;
+        info.iterations = iterations;
+        info.rate = rate;
+        info.residual = residual;
+        return info;
+    }
+
+    const double restartFactor = 0.33;
+}
+
+BOOST_AUTO_TEST_CASE(RestartStepFromConvergenceRate)
+{
+    const int targetIterations = 8;
+    const double dt = 100.0;
+
+    // 3 more iterations at a rate of 0.5 reduce the residual of 8 times the tolerance,
+    // the 13 iterations needed are scaled down to the target
+    {
+        Opm::PredictiveTimeStepControl control(targetIterations);
+        const double newDt = control.computeRestartTimeStepSize(dt, restartFactor, convergence(10, 0.5, 8.0));
+        BOOST_CHECK_CLOSE(newDt, dt * targetIterations / 13.0, 1.0e-10);
+    }
+
+    // close to convergence the step is not cut by more than the largest restart factor
+    {
+        Opm::PredictiveTimeStepControl control(targetIterations);
+        const double newDt = control.computeRestartTimeStepSize(dt, restartFactor, convergence(2, 0.1, 1.5));
+        BOOST_CHECK_CLOSE(newDt, 0.9 * dt, 1.0e-10);
+    }
+
+    // very slow convergence does not cut the step by more than the restart factor
+    {
+        Opm::PredictiveTimeStepControl control(targetIterations);
+        const double newDt = control.computeRestartTimeStepSize(dt, restartFactor, convergence(10, 0.99, 1.0e3));
+        BOOST_CHECK_CLOSE(newDt, restartFactor * dt, 1.0e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RestartStepWithoutPrediction)
+{
+    const double dt = 100.0;
+
+    // no rate, a growing residual or a converged residual fall back to the restart factor
+    const std::vector<Opm::NonlinearConvergenceInfo> infos = {
+        Opm::NonlinearConvergenceInfo(),
+        convergence(10, 1.5, 20.0),
+        convergence(10, 0.5, 0.5)
+    };
+    for (const auto& info : infos) {
+        Opm::PredictiveTimeStepControl control(8);
+        BOOST_CHECK_CLOSE(control.computeRestartTimeStepSize(dt, restartFactor, info), restartFactor * dt, 1.0e-10);
+    }
+
+    // repeated failures chop harder
+    Opm::PredictiveTimeStepControl control(8);
+    control.computeRestartTimeStepSize(dt, restartFactor, convergence(10, -1.0, -1.0));
+    const double newDt = control.computeRestartTimeStepSize(dt, restartFactor, convergence(10, -1.0, -1.0));
+    BOOST_CHECK_CLOSE(newDt, 0.5 * restartFactor * dt, 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(FailedStepLimitsFollowingSteps)
+{
+    Opm::PredictiveTimeStepControl control(8);
+    const ConstantRelativeChange relativeChange;
+    const double failedDt = 10.0;
+    control.computeRestartTimeStepSize(failedDt, restartFactor, convergence(10, -1.0, -1.0));
+
+    // a step with very few iterations would grow a lot without the limit
+    const double newDt = control.computeTimeStepSize(5.0, 1, relativeChange, 0.0);
+    BOOST_CHECK_LE(newDt, 0.9 * 1.25 * failedDt);
+}
+
+BOOST_AUTO_TEST_CASE(ConvergenceFromCnvResiduals)
+{
+    // CNV dominates within the strict iterations
+    std::vector<double> cnv, mb;
+    for (int i = 0; i < 5; ++i) {
+        cnv.push_back(100.0 * std::pow(0.25, i));
+        mb.push_back(0.1);
+    }
+    const Opm::NonlinearConvergenceInfo info = Opm::estimateNonlinearConvergence(cnv, mb, 8);
+    BOOST_CHECK_EQUAL(info.iterations, 4);
+    BOOST_CHECK_CLOSE(info.rate, 0.25, 1.0e-10);
+    BOOST_CHECK_CLOSE(info.residual, cnv.back(), 1.0e-10);
+
+    // a single residual gives no rate
+    const Opm::NonlinearConvergenceInfo single =
+        Opm::estimateNonlinearConvergence(std::vector<double>(1, 10.0), std::vector<double>(1, 10.0), 8);
+    BOOST_CHECK_EQUAL(single.iterations, 0);
+    BOOST_CHECK_LT(single.rate, 0.0);
+    BOOST_CHECK_LT(single.residual, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(ConvergenceAfterStrictIterations)
+{
+    // A step failing after max_iter = 10 iterations with max_strict_iter = 8 has 11
+    // residuals. Only the mass balance residual counts in the last iterations, the
+    // CNV residual stagnates.
+    std::vector<double> cnv, mb;
+    for (int i = 0; i <= 10; ++i) {
+        cnv.push_back(50.0);
+        mb.push_back(4000.0 * std::pow(0.5, i));
+    }
+    const Opm::NonlinearConvergenceInfo info = Opm::estimateNonlinearConvergence(cnv, mb, 8);
+    BOOST_CHECK_EQUAL(info.iterations, 10);
+    BOOST_CHECK_CLOSE(info.rate, 0.5, 1.0e-10);
+    BOOST_CHECK_CLOSE(info.residual, mb.back(), 1.0e-10);
+
+    // the prediction reaches the controller
+    Opm::PredictiveTimeStepControl control(8);
+    const double dt = 100.0;
+    const double required = 10.0 + std::log(mb.back()) / -std::log(0.5);
+    BOOST_CHECK_CLOSE(control.computeRestartTimeStepSize(dt, restartFactor, info), dt * 8.0 / required, 1.0e-10);
+}
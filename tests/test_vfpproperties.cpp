@@ -108,6 +108,34 @@ BOOST_AUTO_TEST_CASE(findInterpData)
     BOOST_CHECK_EQUAL(eval5.factor_, 1.0);
 }
 
+BOOST_AUTO_TEST_CASE(findInterpDataWithHint)
+{
+    std::vector<double> values = {1, 5, 7, 9, 11, 15};
+    std::vector<double> samples = {-1, 1, 2, 5, 6, 7, 8.5, 9, 9, 10, 15, 19, 3, 12, 1, 6};
+
+    //The search starting at the last interval has to give the same
+    //result as the search without hint, independent of the hint
+    int hint = 0;
+    for (const double value : samples) {
+        Opm::detail::InterpData ref = Opm::detail::findInterpData(value, values);
+        Opm::detail::InterpData eval = Opm::detail::findInterpData(value, values, hint);
+
+        BOOST_CHECK_EQUAL(eval.ind_[0], ref.ind_[0]);
+        BOOST_CHECK_EQUAL(eval.ind_[1], ref.ind_[1]);
+        BOOST_CHECK_EQUAL(eval.factor_, ref.factor_);
+        BOOST_CHECK_EQUAL(hint, ref.ind_[0]);
+    }
+
+    //Invalid hints, e.g. from a different table, are ignored
+    for (const int invalid : {-3, 4, 17}) {
+        hint = invalid;
+        Opm::detail::InterpData eval = Opm::detail::findInterpData(6.0, values, hint);
+        BOOST_CHECK_EQUAL(eval.ind_[0], 1);
+        BOOST_CHECK_EQUAL(eval.ind_[1], 2);
+        BOOST_CHECK_EQUAL(eval.factor_, 0.5);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END() // HelperTests
 
 
@@ -981,6 +1009,57 @@ BOOST_AUTO_TEST_CASE(THPToBHPAndBackNonTrivial)
 
 
 
+BOOST_AUTO_TEST_CASE(BatchedEvaluation)
+{
+    fillDataRandom();
+    initProperties();
+
+    const int nw = 5;
+    const std::vector<int> ids = {1, 1, -1, 1, 1};
+    const std::vector<double> aqua   = {-0.5, -0.1, -0.3, -0.8, -0.2};
+    const std::vector<double> liquid = {-0.9, -0.3, -0.2, -0.4, -0.7};
+    const std::vector<double> vapour = {-0.1, -0.6, -0.9, -0.2, -0.4};
+    const std::vector<double> thp    = {0.5, 0.1, 0.3, 0.9, 1.3};
+    const std::vector<double> alq    = {0.3, 0.0, 0.2, 0.7, 0.5};
+
+    std::vector<Opm::detail::VFPInterpHint> hints;
+    std::vector<VFPEvaluation> bhp;
+    std::vector<double> thp_back;
+
+    //Evaluate twice to also use the intervals of the first evaluation
+    for (int pass = 0; pass < 2; ++pass) {
+        properties->bhp(ids, aqua, liquid, vapour, thp, alq, hints, bhp);
+        BOOST_REQUIRE_EQUAL(bhp.size(), static_cast<size_t>(nw));
+        BOOST_REQUIRE_EQUAL(hints.size(), static_cast<size_t>(nw));
+
+        std::vector<double> bhp_values(nw);
+        for (int w = 0; w < nw; ++w) {
+            bhp_values[w] = bhp[w].value;
+        }
+        properties->thp(ids, aqua, liquid, vapour, bhp_values, alq, hints, thp_back);
+        BOOST_REQUIRE_EQUAL(thp_back.size(), static_cast<size_t>(nw));
+
+        for (int w = 0; w < nw; ++w) {
+            if (ids[w] < 0) {
+                BOOST_CHECK_EQUAL(bhp[w].value, -1e100);
+                BOOST_CHECK_EQUAL(thp_back[w], -1e100);
+                continue;
+            }
+            const VFPEvaluation ref = Opm::detail::bhp(&table, aqua[w], liquid[w], vapour[w], thp[w], alq[w]);
+            BOOST_CHECK_EQUAL(bhp[w].value, ref.value);
+            BOOST_CHECK_EQUAL(bhp[w].dthp, ref.dthp);
+            BOOST_CHECK_EQUAL(bhp[w].dwfr, ref.dwfr);
+            BOOST_CHECK_EQUAL(bhp[w].dgfr, ref.dgfr);
+            BOOST_CHECK_EQUAL(bhp[w].dalq, ref.dalq);
+            BOOST_CHECK_EQUAL(bhp[w].dflo, ref.dflo);
+            BOOST_CHECK_EQUAL(bhp[w].value, properties->bhp(1, aqua[w], liquid[w], vapour[w], thp[w], alq[w]));
+            BOOST_CHECK_CLOSE(thp_back[w], thp[w], max_d_tol);
+        }
+    }
+}
+
+
+
 
 BOOST_AUTO_TEST_SUITE_END() // Trivial tests
 